@@ -55,6 +55,10 @@
 #define CAN_INT_PIN             21        // Interrupt (must be interrupt-capable)
 #define CAN_RESET_PIN           22        // Reset pin (optional)
 
+// On-chip TWAI controller (external transceiver, e.g. SN65HVD230)
+#define CAN_TX_PIN              25        // TWAI TX to transceiver TXD
+#define CAN_RX_PIN              26        // TWAI RX from transceiver RXD
+
 // Default SPI pins (VSPI)
 #define SPI_MOSI_PIN            23        // Master Out Slave In
 #define SPI_MISO_PIN            19        // Master In Slave Out  
@@ -247,5 +251,3 @@ struct HardwareCapabilities {
     static constexpr uint8_t dac_channels = 2;
     static constexpr uint8_t pwm_channels = 16;
 };
-
-#endif // HARDWARE_CONFIG_H
\ No newline at end of file
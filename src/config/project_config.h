@@ -61,6 +61,160 @@
 #define CAN_RETRY_COUNT           3
 #define CAN_FILTER_ENABLE         true
 
+// Static CAN queue sizes (power of two, allocated once inside CANInterface)
+#ifndef CAN_RX_RING_SIZE
+#define CAN_RX_RING_SIZE          128
+#endif
+
+#ifndef CAN_TX_RING_SIZE
+#define CAN_TX_RING_SIZE          32
+#endif
+
+// Receive load shedding: RX ring depth at which each class is dropped
+// (responses to our own requests use the space above the subscribed level)
+#ifndef CAN_RX_SHED_BACKGROUND_LEVEL
+#define CAN_RX_SHED_BACKGROUND_LEVEL  (CAN_RX_RING_SIZE / 2)
+#endif
+
+#ifndef CAN_RX_SHED_SUBSCRIBED_LEVEL
+#define CAN_RX_SHED_SUBSCRIBED_LEVEL  (CAN_RX_RING_SIZE - CAN_RX_RING_SIZE / 8)
+#endif
+
+// Frames on the OBD2 response IDs rank as responses this long after a request
+#ifndef CAN_RX_RESPONSE_WINDOW_MS
+#define CAN_RX_RESPONSE_WINDOW_MS     250
+#endif
+
+#ifndef CAN_RX_RESPONSE_PENDING_MS
+#define CAN_RX_RESPONSE_PENDING_MS    5000    // After NRC 0x78 (P2* extended)
+#endif
+
+// TWAI driver queue depths (IDF default is 5, too shallow for bursts)
+#ifndef CAN_DRIVER_RX_QUEUE_LEN
+#define CAN_DRIVER_RX_QUEUE_LEN   32
+#endif
+
+#ifndef CAN_DRIVER_TX_QUEUE_LEN
+#define CAN_DRIVER_TX_QUEUE_LEN   8
+#endif
+
+// Frames the transmit scheduler hands to the driver at once. Nothing can
+// overtake a frame in the driver FIFO, so this bounds priority inversion;
+// 2 keeps the bus busy while the next frame is picked.
+#ifndef CAN_TX_IN_FLIGHT
+#define CAN_TX_IN_FLIGHT          2
+#endif
+
+// MCP2515 backend (CANMCP2515Transport): crystal on the module and the
+// software queues in front of its two RX buffers and single TX buffer
+#ifndef CAN_MCP2515_CLOCK_HZ
+#define CAN_MCP2515_CLOCK_HZ      8000000   // 8 MHz modules cannot do 1 Mbit/s
+#endif
+
+#ifndef CAN_MCP2515_RX_RING_SIZE
+#define CAN_MCP2515_RX_RING_SIZE  32        // Power of two
+#endif
+
+#define CAN_MCP2515_TX_QUEUE_MAX  16        // Upper bound for txQueueLength
+
+// Dedicated receive task (core 1 keeps it off the Bluetooth controller core)
+#ifndef CAN_RX_TASK_CORE
+#define CAN_RX_TASK_CORE          1
+#endif
+
+#ifndef CAN_RX_TASK_PRIORITY
+#define CAN_RX_TASK_PRIORITY      (TASK_PRIORITY_HIGH + 2)  // Above loop and app tasks
+#endif
+
+#define CAN_RX_BURST_SIZE         16     // Frames drained per wakeup
+#define CAN_RX_TASK_POLL_MS       100    // Max block before checking for stop
+
+// Bus-off recovery (delay doubles per bus-off within the stable period)
+#ifndef CAN_RECOVERY_BASE_DELAY_MS
+#define CAN_RECOVERY_BASE_DELAY_MS  50
+#endif
+
+#ifndef CAN_RECOVERY_MAX_DELAY_MS
+#define CAN_RECOVERY_MAX_DELAY_MS   2000
+#endif
+
+#define CAN_RECOVERY_TIMEOUT_MS     500    // Wait for BUS_RECOVERED before reinstalling
+#define CAN_RECOVERY_STABLE_MS      10000  // Bus-on time that resets the backoff
+#define CAN_RECOVERY_POLL_MS        10     // Receive task wakeup while bus-off
+
+// Automatic bitrate detection (listen-only sweep, probe only on a silent bus)
+#ifndef CAN_AUTOBAUD_DWELL_MS
+#define CAN_AUTOBAUD_DWELL_MS       40     // Listen window per candidate bitrate
+#endif
+
+#ifndef CAN_AUTOBAUD_TIMEOUT_MS
+#define CAN_AUTOBAUD_TIMEOUT_MS     1000
+#endif
+
+#define CAN_AUTOBAUD_PROBE_DWELL_MS 10     // Wait for a probe ACK per candidate
+#define CAN_AUTOBAUD_MIN_FRAMES     2      // Clean frames that lock before the window ends
+#define CAN_AUTOBAUD_POLL_MS        2      // Alert wait while detecting
+
+// CAN status lines (longer lines are truncated)
+#ifndef CAN_LOG_LINE_SIZE
+#define CAN_LOG_LINE_SIZE         160
+#endif
+
+// Per-ID arrival statistics (power of two; IDs beyond this are only counted)
+#ifndef CAN_ID_STATS_SIZE
+#define CAN_ID_STATS_SIZE         64
+#endif
+
+// Latest frame per ID (power of two; IDs beyond this are only counted)
+#ifndef CAN_LATEST_TABLE_SIZE
+#define CAN_LATEST_TABLE_SIZE     64
+#endif
+
+// Zero-copy fan-out of received frames (queue depth is a power of two)
+#ifndef CAN_FANOUT_MAX_CONSUMERS
+#define CAN_FANOUT_MAX_CONSUMERS  4
+#endif
+
+#ifndef CAN_FANOUT_QUEUE_DEPTH
+#define CAN_FANOUT_QUEUE_DEPTH    64
+#endif
+
+// Per-ID frame dispatch (handlers per table; 29-bit IDs per table)
+#ifndef CAN_DISPATCH_MAX_HANDLERS
+#define CAN_DISPATCH_MAX_HANDLERS 32
+#endif
+
+#ifndef CAN_DISPATCH_MAX_EXTENDED
+#define CAN_DISPATCH_MAX_EXTENDED 32
+#endif
+
+// Broadcast signal decoder (listen-only vehicle data)
+#ifndef CAN_BROADCAST_MAX_SIGNALS
+#define CAN_BROADCAST_MAX_SIGNALS 32
+#endif
+
+// Binary trace recorder (two blocks of 16-byte records are buffered)
+#ifndef CAN_TRACE_BLOCK_RECORDS
+#define CAN_TRACE_BLOCK_RECORDS   256
+#endif
+
+#ifndef CAN_TRACE_INDEX_ENTRIES
+#define CAN_TRACE_INDEX_ENTRIES   256    // Interval doubles when full
+#endif
+
+#define CAN_TRACE_INDEX_INTERVAL_MS 1000
+
+// SLCAN (Lawicel) serial gateway
+#ifndef SLCAN_SERIAL_BAUD
+#define SLCAN_SERIAL_BAUD         921600
+#endif
+
+#ifndef SLCAN_OUTPUT_BUFFER_SIZE
+#define SLCAN_OUTPUT_BUFFER_SIZE  512    // Lines batched per serial write
+#endif
+
+#define SLCAN_LINE_SIZE           32     // Longest host command ("T" frame + CR)
+
 // Vehicle-specific settings
 #define VEHICLE_MANUFACTURER      "Husqvarna"
 #define VEHICLE_MODEL             "Svartpilen 401"
@@ -73,6 +227,30 @@
 #define OBD2_RESPONSE_TIMEOUT_MS  200
 #define OBD2_MAX_RETRIES          2
 
+// ISO-TP (ISO 15765-2) transport
+#ifndef ISOTP_MAX_MESSAGE_SIZE
+#define ISOTP_MAX_MESSAGE_SIZE    512    // Per-session RX/TX buffer (VIN, DTC lists, UDS)
+#endif
+
+#ifndef ISOTP_MAX_SESSIONS
+#define ISOTP_MAX_SESSIONS        8      // One per OBD2 ECU address
+#endif
+
+#define ISOTP_TIMEOUT_MS          1000   // N_Bs / N_Cr
+#define ISOTP_RX_BLOCK_SIZE       0      // Block size we advertise (0 = no further FC)
+#define ISOTP_RX_STMIN            0      // STmin we advertise (raw ISO-TP byte)
+#define ISOTP_MAX_WAIT_FRAMES     10     // FC.WAIT frames tolerated per block
+#define ISOTP_PADDING_BYTE        0x55
+
+// Pipelined OBD2 request scheduler
+#ifndef OBD2_REQUEST_SLOTS
+#define OBD2_REQUEST_SLOTS        32     // Pending + in-flight requests (max 256)
+#endif
+
+#define OBD2_MAX_IN_FLIGHT        8      // One per physical ECU address
+#define OBD2_WHEEL_SLOTS          64     // Deadline timer wheel size (power of two)
+#define OBD2_WHEEL_TICK_MS        5      // Timer wheel resolution
+
 // ELM327 Emulation Settings
 #define ELM327_VERSION            "1.5"
 #define ELM327_DEVICE_ID          "ELM327"
@@ -191,5 +369,3 @@
 // ===== RUNTIME ENVIRONMENT DETECTION =====
 #define IS_DEVELOPMENT_BUILD     (TEST_MODE || ENABLE_DEBUG_LOGGING)
 #define IS_PRODUCTION_BUILD      (!TEST_MODE && !ENABLE_DEBUG_LOGGING)
-
-#endif // PROJECT_CONFIG_H
\ No newline at end of file
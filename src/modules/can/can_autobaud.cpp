@@ -0,0 +1,144 @@
+/**
+ * @file can_autobaud.cpp
+ * @brief Automatic CAN bitrate detection implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_autobaud.h"
+
+// Most bikes and every OBD2 port run 500k; 1M is rarest on two wheels
+static const CANSpeed SWEEP_ORDER[CANAutoBaud::CANDIDATE_COUNT] = {
+    CANSpeed::CAN_500KBPS, CANSpeed::CAN_250KBPS, CANSpeed::CAN_1MBPS, CANSpeed::CAN_125KBPS
+};
+
+CANAutoBaud::CANAutoBaud(uint32_t dwellMs, uint32_t probeDwellMs, uint8_t minFrames)
+    : dwellMs(dwellMs), probeDwellMs(probeDwellMs), minFrames(minFrames > 0 ? minFrames : 1) {
+    for (uint8_t i = 0; i < CANDIDATE_COUNT; i++) {
+        candidates[i] = SWEEP_ORDER[i];
+    }
+    begin(0, SWEEP_ORDER[0], 0, false);
+    state = CANAutoBaudState::FAILED;   // Idle until begin()
+}
+
+void CANAutoBaud::begin(uint32_t nowMs, CANSpeed preferred, uint32_t timeoutMs, bool allowProbe) {
+    // Preferred bitrate first, the rest in sweep order
+    candidates[0] = preferred;
+    uint8_t count = 1;
+    for (uint8_t i = 0; i < CANDIDATE_COUNT; i++) {
+        if (SWEEP_ORDER[i] != preferred) {
+            candidates[count++] = SWEEP_ORDER[i];
+        }
+    }
+
+    state = CANAutoBaudState::LISTENING;
+    index = 0;
+    this->allowProbe = allowProbe;
+    configured = false;
+    probeSent = false;
+    acknowledged = false;
+    heard = false;
+    frames = 0;
+    errors = 0;
+    switches = 0;
+    listenDwellMs = dwellMs;
+    startMs = nowMs;
+    windowStart = nowMs;
+    deadline = nowMs + timeoutMs;
+    lockTimeMs = 0;
+}
+
+CANAutoBaudAction CANAutoBaud::poll(uint32_t nowMs) {
+    if (state == CANAutoBaudState::LOCKED || state == CANAutoBaudState::FAILED) {
+        return CANAutoBaudAction::DONE;
+    }
+    if (!configured) {
+        return CANAutoBaudAction::CONFIGURE;
+    }
+
+    // Evidence first: a frame that arrived just before the timeout still counts
+    bool probing = state == CANAutoBaudState::PROBING;
+    if (errors == 0 && (acknowledged || frames >= (probing ? 1 : minFrames))) {
+        return lock(nowMs);
+    }
+    if (reached(nowMs, deadline)) {
+        state = CANAutoBaudState::FAILED;
+        return CANAutoBaudAction::DONE;
+    }
+    if (errors > 0) {
+        nextCandidate();
+        return CANAutoBaudAction::CONFIGURE;
+    }
+    if (probing && !probeSent) {
+        probeSent = true;
+        return CANAutoBaudAction::PROBE;
+    }
+    if (reached(nowMs, windowStart + (probing ? probeDwellMs : listenDwellMs))) {
+        // A quiet bus may only send one frame per window; clean is clean
+        if (frames > 0) {
+            return lock(nowMs);
+        }
+        nextCandidate();
+        return CANAutoBaudAction::CONFIGURE;
+    }
+    return CANAutoBaudAction::NONE;
+}
+
+void CANAutoBaud::onConfigured(uint32_t nowMs) {
+    configured = true;
+    windowStart = nowMs;
+}
+
+void CANAutoBaud::onFrame() {
+    if (frames < UINT16_MAX) {
+        frames++;
+    }
+    heard = true;
+}
+
+void CANAutoBaud::onBusError() {
+    if (errors < UINT16_MAX) {
+        errors++;
+    }
+    if (state == CANAutoBaudState::LISTENING) {
+        heard = true;               // Our own failed probes say nothing about the bus
+    }
+}
+
+void CANAutoBaud::onProbeAcknowledged() {
+    if (state == CANAutoBaudState::PROBING) {
+        acknowledged = true;
+    }
+}
+
+// ===== INTERNAL METHODS =====
+
+void CANAutoBaud::nextCandidate() {
+    index++;
+    if (index == CANDIDATE_COUNT) {
+        index = 0;
+        // A silent listen sweep is the only reason to transmit
+        if (state == CANAutoBaudState::LISTENING && !heard && allowProbe) {
+            state = CANAutoBaudState::PROBING;
+        } else {
+            // Traffic but no lock: frames are sparser than the window
+            if (state == CANAutoBaudState::LISTENING && heard && listenDwellMs < dwellMs * 8) {
+                listenDwellMs *= 2;
+            }
+            state = CANAutoBaudState::LISTENING;
+        }
+        heard = false;
+    }
+    configured = false;
+    probeSent = false;
+    acknowledged = false;
+    frames = 0;
+    errors = 0;
+    switches++;
+}
+
+CANAutoBaudAction CANAutoBaud::lock(uint32_t nowMs) {
+    state = CANAutoBaudState::LOCKED;
+    lockTimeMs = nowMs - startMs;
+    return CANAutoBaudAction::DONE;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+/**
+ * @file can_autobaud.h
+ * @brief Automatic CAN bitrate detection
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Sweeps the CANSpeed candidates in LISTEN_ONLY mode, so a wrong guess never
+ * puts error frames on the bike's bus. A candidate is dropped on the first
+ * bus error (a wrong bitrate shows one within a frame of traffic) and locked
+ * once it has received clean frames; if a sweep hears traffic but locks
+ * nothing, the next sweep listens longer. Only when a whole sweep hears nothing
+ * does the detector switch to NORMAL mode and send a probe request, locking
+ * on the bitrate at which an ECU acknowledges it. The detector only tracks
+ * time and evidence; CANInterface::detectSpeed() drives the driver.
+ */
+
+#include <stdint.h>
+#include "../../config/project_config.h"
+#include "can_types.h"
+
+/**
+ * @brief Detection progress
+ */
+enum class CANAutoBaudState : uint8_t {
+    LISTENING = 0,      // Listen-only sweep
+    PROBING,            // Silent bus, active probe sweep
+    LOCKED,             // Bitrate found
+    FAILED              // Timed out
+};
+
+/**
+ * @brief Driver operation requested by poll()
+ */
+enum class CANAutoBaudAction : uint8_t {
+    NONE = 0,           // Keep collecting alerts
+    CONFIGURE,          // Reinstall the driver at getCandidate()/getCandidateMode(), then onConfigured()
+    PROBE,              // Send one probe frame (single shot)
+    DONE                // LOCKED or FAILED
+};
+
+/**
+ * @class CANAutoBaud
+ * @brief Bitrate detection state machine (millisecond clock, wrap safe)
+ */
+class CANAutoBaud {
+public:
+    static constexpr uint8_t CANDIDATE_COUNT = 4;
+
+    /**
+     * @brief Constructor
+     * @param dwellMs Listen window per candidate
+     * @param probeDwellMs Wait for an acknowledgement per probed candidate
+     * @param minFrames Clean frames that lock a candidate before its window ends
+     */
+    explicit CANAutoBaud(uint32_t dwellMs = CAN_AUTOBAUD_DWELL_MS,
+                         uint32_t probeDwellMs = CAN_AUTOBAUD_PROBE_DWELL_MS,
+                         uint8_t minFrames = CAN_AUTOBAUD_MIN_FRAMES);
+
+    /**
+     * @brief Start a detection
+     * @param nowMs Current time
+     * @param preferred Candidate tried first (last known bitrate)
+     * @param timeoutMs Give up after this long
+     * @param allowProbe Transmit probes when the bus is silent
+     */
+    void begin(uint32_t nowMs, CANSpeed preferred, uint32_t timeoutMs, bool allowProbe = true);
+
+    /**
+     * @brief Next driver operation due at nowMs
+     */
+    CANAutoBaudAction poll(uint32_t nowMs);
+
+    /**
+     * @brief Driver now runs at the current candidate; starts its window
+     */
+    void onConfigured(uint32_t nowMs);
+
+    // Evidence for the current candidate
+    void onFrame();
+    void onBusError();
+    void onProbeAcknowledged();
+
+    CANAutoBaudState getState() const { return state; }
+    CANSpeed getCandidate() const { return candidates[index]; }
+    CANMode getCandidateMode() const {
+        return state == CANAutoBaudState::PROBING ? CANMode::NORMAL : CANMode::LISTEN_ONLY;
+    }
+    CANSpeed getLockedSpeed() const { return candidates[index]; }
+    uint32_t getLockTimeMs() const { return lockTimeMs; }
+    uint16_t getSwitches() const { return switches; }
+
+private:
+    uint32_t dwellMs;
+    uint32_t listenDwellMs;         // Doubles after each sweep that heard traffic but no clean frame
+    uint32_t probeDwellMs;
+    uint8_t minFrames;
+
+    CANSpeed candidates[CANDIDATE_COUNT];
+    CANAutoBaudState state;
+    uint8_t index;
+    bool allowProbe;
+    bool configured;
+    bool probeSent;
+    bool acknowledged;
+    bool heard;                     // Any frame or error during this sweep
+    uint16_t frames;
+    uint16_t errors;
+    uint16_t switches;
+    uint32_t startMs;
+    uint32_t windowStart;
+    uint32_t deadline;
+    uint32_t lockTimeMs;
+
+    void nextCandidate();
+    CANAutoBaudAction lock(uint32_t nowMs);
+
+    static bool reached(uint32_t nowMs, uint32_t time) {
+        return static_cast<int32_t>(nowMs - time) >= 0;
+    }
+};
@@ -0,0 +1,167 @@
+/**
+ * @file can_bus_load.cpp
+ * @brief Sliding-window CAN bus utilization meter implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_bus_load.h"
+#include <string.h>
+
+namespace {
+    // Frame layout in bits (ISO 11898-1 classic CAN)
+    // Standard: SOF 1, ID 11, RTR 1, IDE 1, r0 1, DLC 4, CRC 15 = 34 stuffable
+    // Extended: SOF 1, ID 11, SRR 1, IDE 1, ID 18, RTR 1, r1 1, r0 1, DLC 4, CRC 15 = 54 stuffable
+    // Both: CRC delimiter 1, ACK 2, EOF 7, intermission 3 = 13 unstuffed
+    const uint16_t STUFFABLE_STANDARD = 34;
+    const uint16_t STUFFABLE_EXTENDED = 54;
+    const uint16_t TRAILER_BITS = 13;
+
+    const uint32_t WINDOW_US[CANBusLoadMeter::WINDOW_COUNT] = {100000, 1000000, 10000000};
+    const uint32_t MAX_LATE_US = 10000000;     // Longest window
+}
+
+CANBusLoadMeter::CANBusLoadMeter(uint32_t bitrate, CANStuffingModel model)
+    : bitrate(bitrate ? bitrate : 500000), stuffingModel(model), started(false) {
+    for (uint8_t i = 0; i < WINDOW_COUNT; i++) {
+        windows[i].bucketUs = WINDOW_US[i] / BUCKETS;
+    }
+    reset(0);
+    started = false;    // Windows start at the first recorded frame
+}
+
+uint16_t CANBusLoadMeter::frameBits(bool extended, uint8_t dlc, bool rtr, CANStuffingModel model) {
+    uint8_t dataBytes = rtr ? 0 : (dlc > 8 ? 8 : dlc);
+    uint16_t stuffable = (extended ? STUFFABLE_EXTENDED : STUFFABLE_STANDARD) + 8 * dataBytes;
+
+    uint16_t stuffBits = 0;
+    switch (model) {
+        case CANStuffingModel::NONE:
+            break;
+        case CANStuffingModel::EXPECTED:
+            stuffBits = (stuffable + 15) / 30;  // Random bits: one per 2^5 - 2
+            break;
+        case CANStuffingModel::WORST_CASE:
+            stuffBits = (stuffable - 1) / 4;    // 1 after the first 5, then 1 per 4
+            break;
+    }
+    return stuffable + stuffBits + TRAILER_BITS;
+}
+
+void CANBusLoadMeter::recordFrame(const CANMessage& message, uint32_t nowUs) {
+    recordBits(frameBits(message.extd, message.dlc, message.rtr, stuffingModel), nowUs);
+}
+
+void CANBusLoadMeter::recordFrame(const CANFrame& frame, uint32_t nowUs) {
+    recordBits(frameBits(frame.isExtended(), frame.dlc, frame.isRemote(), stuffingModel), nowUs);
+}
+
+void CANBusLoadMeter::recordBits(uint32_t bits, uint32_t nowUs) {
+    if (!started) {
+        reset(nowUs);
+    }
+    for (uint8_t i = 0; i < WINDOW_COUNT; i++) {
+        Window& w = windows[i];
+        advance(w, nowUs);
+        w.buckets[w.current] += bits;
+        w.total += bits;
+    }
+}
+
+float CANBusLoadMeter::getLoad(CANLoadWindow window, uint32_t nowUs) {
+    Window& w = windows[static_cast<uint8_t>(window)];
+    if (!started) {
+        return 0.0f;
+    }
+    advance(w, nowUs);
+
+    // The ring holds the current bucket and the BUCKETS - 1 before it;
+    // before the window first fills, divide by the time actually covered
+    uint32_t partial = nowUs - w.bucketStart;
+    uint32_t fullBuckets = w.filled < BUCKETS - 1 ? w.filled : BUCKETS - 1;
+    return percent(w.total, fullBuckets * w.bucketUs + partial);
+}
+
+float CANBusLoadMeter::getPeak(CANLoadWindow window) const {
+    return windows[static_cast<uint8_t>(window)].peak;
+}
+
+uint32_t CANBusLoadMeter::availableBitsPerSecond(float targetPercent, uint32_t nowUs) {
+    float load = getLoad(CANLoadWindow::WINDOW_1S, nowUs);
+    if (load >= targetPercent) {
+        return 0;
+    }
+    return static_cast<uint32_t>((targetPercent - load) / 100.0f * bitrate);
+}
+
+void CANBusLoadMeter::setBitrate(uint32_t newBitrate) {
+    if (newBitrate != 0 && newBitrate != bitrate) {
+        bitrate = newBitrate;
+        reset(0);
+        started = false;    // Old bit counts belong to another bit time
+    }
+}
+
+void CANBusLoadMeter::resetPeaks() {
+    for (uint8_t i = 0; i < WINDOW_COUNT; i++) {
+        windows[i].peak = 0.0f;
+    }
+}
+
+void CANBusLoadMeter::reset(uint32_t nowUs) {
+    for (uint8_t i = 0; i < WINDOW_COUNT; i++) {
+        Window& w = windows[i];
+        memset(w.buckets, 0, sizeof(w.buckets));
+        w.bucketStart = nowUs;
+        w.total = 0;
+        w.current = 0;
+        w.filled = 0;
+        w.peak = 0.0f;
+    }
+    started = true;
+}
+
+// ===== INTERNAL METHODS =====
+
+void CANBusLoadMeter::advance(Window& w, uint32_t nowUs) {
+    // A timestamp a little behind the current bucket comes from a late
+    // caller; anything else is forward, however long the idle gap was
+    uint32_t elapsed = nowUs - w.bucketStart;
+    if (w.bucketStart - nowUs <= MAX_LATE_US || elapsed < w.bucketUs) {
+        return;
+    }
+
+    // After BUCKETS steps every bucket is empty, so a long idle gap only
+    // needs that many to visit each boundary that could still set a peak
+    uint32_t steps = elapsed / w.bucketUs;
+    if (steps > BUCKETS) {
+        w.bucketStart += (steps - BUCKETS) * w.bucketUs;
+        steps = BUCKETS;
+    }
+
+    for (uint32_t s = 0; s < steps; s++) {
+        // Current bucket completes: a full window ends on this boundary
+        if (w.filled < BUCKETS) {
+            w.filled++;
+        }
+        if (w.filled >= BUCKETS) {
+            float load = percent(w.total, BUCKETS * w.bucketUs);
+            if (load > w.peak) {
+                w.peak = load;
+            }
+        }
+
+        w.current = (w.current + 1) % BUCKETS;
+        w.total -= w.buckets[w.current];
+        w.buckets[w.current] = 0;
+        w.bucketStart += w.bucketUs;
+    }
+}
+
+float CANBusLoadMeter::percent(uint32_t bits, uint32_t spanUs) const {
+    if (spanUs == 0) {
+        return 0.0f;
+    }
+    float load = bits * 100.0f / (static_cast<float>(bitrate) * spanUs / 1000000.0f);
+    return load > 100.0f ? 100.0f : load;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+/**
+ * @file can_bus_load.h
+ * @brief Sliding-window CAN bus utilization meter
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Charges every frame its on-wire bit cost (ID type, DLC, stuffing, EOF and
+ * intermission) and sums the cost over 100 ms, 1 s and 10 s windows. Each
+ * window is a ring of fixed-width buckets, so recording a frame is O(1) and
+ * needs no heap; the window slides in steps of one bucket.
+ */
+
+#include <stdint.h>
+#include "can_types.h"
+#include "can_frame.h"
+
+/**
+ * @brief Bit stuffing estimate used for frame cost
+ */
+enum class CANStuffingModel : uint8_t {
+    NONE = 0,           // Unstuffed frame length
+    EXPECTED,           // Average for random payloads (1 stuff bit per 30 bits)
+    WORST_CASE          // Maximum stuff bits the frame can carry
+};
+
+/**
+ * @brief Measurement windows
+ */
+enum class CANLoadWindow : uint8_t {
+    WINDOW_100MS = 0,
+    WINDOW_1S,
+    WINDOW_10S
+};
+
+/**
+ * @class CANBusLoadMeter
+ * @brief Bus utilization over sliding windows with peak tracking
+ *
+ * Not thread safe; the owner serializes record and query calls.
+ */
+class CANBusLoadMeter {
+public:
+    static constexpr uint8_t WINDOW_COUNT = 3;
+    static constexpr uint8_t BUCKETS = 20;          // Per window
+
+    /**
+     * @brief Constructor
+     * @param bitrate Bus bitrate in bit/s
+     * @param model Stuffing estimate
+     */
+    explicit CANBusLoadMeter(uint32_t bitrate = 500000,
+                             CANStuffingModel model = CANStuffingModel::EXPECTED);
+
+    /**
+     * @brief On-wire bits of one data or remote frame including intermission
+     * @param extended 29-bit identifier
+     * @param dlc Data length code (0-8)
+     * @param rtr Remote frame (no data field)
+     * @param model Stuffing estimate
+     * @return Frame cost in bits
+     */
+    static uint16_t frameBits(bool extended, uint8_t dlc, bool rtr, CANStuffingModel model);
+
+    /**
+     * @brief Charge a frame seen on the bus (received or transmitted)
+     * @param message Frame
+     * @param nowUs Monotonic microsecond time
+     */
+    void recordFrame(const CANMessage& message, uint32_t nowUs);
+    void recordFrame(const CANFrame& frame, uint32_t nowUs);
+
+    /**
+     * @brief Charge raw bits (error frames, overload frames)
+     * @param bits Bits on the wire
+     * @param nowUs Monotonic microsecond time
+     */
+    void recordBits(uint32_t bits, uint32_t nowUs);
+
+    /**
+     * @brief Utilization over a window ending now
+     * @param window Window length
+     * @param nowUs Monotonic microsecond time
+     * @return Load in percent (0-100)
+     */
+    float getLoad(CANLoadWindow window, uint32_t nowUs);
+
+    /**
+     * @brief Highest load of a window since the last peak reset
+     * @param window Window length
+     * @return Peak load in percent, measured on bucket boundaries
+     */
+    float getPeak(CANLoadWindow window) const;
+
+    /**
+     * @brief Headroom left under a target load over the 1 s window
+     * @param targetPercent Load the bus should stay under
+     * @param nowUs Monotonic microsecond time
+     * @return Bits per second still available (0 if at or above target)
+     */
+    uint32_t availableBitsPerSecond(float targetPercent, uint32_t nowUs);
+
+    void setBitrate(uint32_t bitrate);
+    uint32_t getBitrate() const { return bitrate; }
+    void setStuffingModel(CANStuffingModel model) { stuffingModel = model; }
+    CANStuffingModel getStuffingModel() const { return stuffingModel; }
+
+    /**
+     * @brief Clear peaks only
+     */
+    void resetPeaks();
+
+    /**
+     * @brief Clear all windows and peaks
+     * @param nowUs Start of the new measurement
+     */
+    void reset(uint32_t nowUs);
+
+private:
+    struct Window {
+        uint32_t bucketUs;              // Bucket width
+        uint32_t bucketStart;           // Start of the current bucket
+        uint32_t buckets[BUCKETS];      // Bits per bucket
+        uint32_t total;                 // Sum of all buckets
+        uint8_t current;                // Bucket being filled
+        uint8_t filled;                 // Completed buckets since reset (saturates)
+        float peak;
+    };
+
+    Window windows[WINDOW_COUNT];
+    uint32_t bitrate;
+    CANStuffingModel stuffingModel;
+    bool started;
+
+    void advance(Window& w, uint32_t nowUs);
+    float percent(uint32_t bits, uint32_t spanUs) const;
+};
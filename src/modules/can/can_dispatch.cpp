@@ -0,0 +1,131 @@
+/**
+ * @file can_dispatch.cpp
+ * @brief Per-identifier frame dispatch implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_dispatch.h"
+#include <string.h>
+
+// ===== IDENTIFIER INDEX =====
+
+CANIdIndex::CANIdIndex() {
+    clear();
+}
+
+void CANIdIndex::clear() {
+    memset(standard, 0, sizeof(standard));
+    extendedCount = 0;
+}
+
+size_t CANIdIndex::lowerBound(uint32_t key) const {
+    size_t low = 0;
+    size_t high = extendedCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (extendedKeys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+uint8_t CANIdIndex::findExtended(uint32_t key) const {
+    size_t position = lowerBound(key);
+    if (position < extendedCount && extendedKeys[position] == key) {
+        return extendedSlots[position];
+    }
+    return 0;
+}
+
+bool CANIdIndex::set(uint32_t key, uint8_t slot) {
+    if (key & ~(CANFrame::ID_MASK | CANFrame::FLAG_EXTENDED)) {
+        return false;
+    }
+    if (!(key & CANFrame::FLAG_EXTENDED)) {
+        if (key >= STANDARD_IDS) {
+            return false;
+        }
+        standard[key] = slot;
+        return true;
+    }
+
+    size_t position = lowerBound(key);
+    bool present = position < extendedCount && extendedKeys[position] == key;
+    if (slot == 0) {
+        if (present) {
+            memmove(&extendedKeys[position], &extendedKeys[position + 1],
+                    (extendedCount - position - 1) * sizeof(extendedKeys[0]));
+            memmove(&extendedSlots[position], &extendedSlots[position + 1],
+                    extendedCount - position - 1);
+            extendedCount--;
+        }
+        return true;
+    }
+    if (present) {
+        extendedSlots[position] = slot;
+        return true;
+    }
+    if (extendedCount >= EXTENDED_CAPACITY) {
+        return false;
+    }
+    memmove(&extendedKeys[position + 1], &extendedKeys[position],
+            (extendedCount - position) * sizeof(extendedKeys[0]));
+    memmove(&extendedSlots[position + 1], &extendedSlots[position], extendedCount - position);
+    extendedKeys[position] = key;
+    extendedSlots[position] = slot;
+    extendedCount++;
+    return true;
+}
+
+// ===== DISPATCH TABLE =====
+
+CANDispatchTable::CANDispatchTable() : count(0) {
+}
+
+bool CANDispatchTable::add(uint32_t id, bool extended, CANFrameHandler handler, void* context) {
+    if (handler == nullptr || id > (extended ? CANFrame::ID_MASK : 0x7FFUL)) {
+        return false;
+    }
+    uint32_t key = CANIdIndex::makeKey(id, extended);
+    uint8_t slot = index.find(key);
+    if (slot != 0) {
+        bindings[slot - 1].handler = handler;
+        bindings[slot - 1].context = context;
+        return true;
+    }
+    if (count >= MAX_HANDLERS || !index.set(key, static_cast<uint8_t>(count + 1))) {
+        return false;
+    }
+    bindings[count].handler = handler;
+    bindings[count].context = context;
+    bindings[count].key = key;
+    count++;
+    return true;
+}
+
+bool CANDispatchTable::remove(uint32_t id, bool extended) {
+    uint32_t key = CANIdIndex::makeKey(id, extended);
+    uint8_t slot = index.find(key);
+    if (slot == 0) {
+        return false;
+    }
+    index.set(key, 0);
+
+    // Keep bindings dense: the last one moves into the freed slot
+    size_t last = count - 1;
+    if (slot - 1u != last) {
+        bindings[slot - 1] = bindings[last];
+        index.set(bindings[last].key, slot);
+    }
+    count--;
+    return true;
+}
+
+void CANDispatchTable::clear() {
+    index.clear();
+    count = 0;
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+/**
+ * @file can_dispatch.h
+ * @brief Per-identifier frame dispatch
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Routes each received frame to the handler registered for its identifier,
+ * so consumers stop re-checking IDs behind one catch-all callback. Lookup
+ * is keyed like the generated DBC headers (identifier | FLAG_EXTENDED):
+ * 11-bit IDs index a flat 2 KB array of handler slots, 29-bit IDs are
+ * found by binary search in a small sorted table. A standard data frame's
+ * idFlags is its own index, so the common case is one compare and one load.
+ *
+ * CANDispatchTable binds handlers at run time (function pointer plus
+ * context) and plugs into CANInterface::setDispatchTable().
+ * CANStaticDispatch binds them at compile time: the route list is a
+ * template parameter, the slot selects the route in a switch the compiler
+ * generates, and each handler is called directly and can be inlined.
+ *
+ * Remote and error frames are never dispatched; they fall through to the
+ * frame handler and message callback.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+
+/**
+ * @brief Compact-frame handler, e.g. a generated DBC dispatch()
+ * @return true if the frame was consumed (later handlers are skipped)
+ */
+typedef bool (*CANFrameHandler)(const CANFrame& frame, void* context);
+
+/**
+ * @class CANIdIndex
+ * @brief Identifier key to handler slot (1-255, 0 = none)
+ */
+class CANIdIndex {
+public:
+    static constexpr size_t STANDARD_IDS = 2048;
+    static constexpr size_t EXTENDED_CAPACITY = CAN_DISPATCH_MAX_EXTENDED;
+
+    CANIdIndex();
+
+    /**
+     * @brief Slot of a received frame (0 if none, remote or error frame)
+     */
+    uint8_t find(const CANFrame& frame) const {
+        uint32_t key = frame.idFlags;
+        if (key < STANDARD_IDS) {
+            return standard[key];       // Standard data frame: no flag bits set
+        }
+        if (key & (CANFrame::FLAG_REMOTE | CANFrame::FLAG_ERROR)) {
+            return 0;
+        }
+        return findExtended(key);
+    }
+
+    /**
+     * @brief Slot of a key (identifier | FLAG_EXTENDED)
+     */
+    uint8_t find(uint32_t key) const {
+        return key < STANDARD_IDS ? standard[key] : findExtended(key);
+    }
+
+    /**
+     * @brief Point a key at a slot (0 removes it)
+     * @return false if the key is malformed or the 29-bit table is full
+     */
+    bool set(uint32_t key, uint8_t slot);
+
+    void clear();
+
+    size_t getExtendedCount() const { return extendedCount; }
+
+    /**
+     * @brief Lookup key of an identifier
+     */
+    static uint32_t makeKey(uint32_t id, bool extended) {
+        return (id & CANFrame::ID_MASK) | (extended ? CANFrame::FLAG_EXTENDED : 0);
+    }
+
+private:
+    uint8_t standard[STANDARD_IDS];
+    uint32_t extendedKeys[EXTENDED_CAPACITY];   // Sorted
+    uint8_t extendedSlots[EXTENDED_CAPACITY];
+    size_t extendedCount;
+
+    uint8_t findExtended(uint32_t key) const;
+    size_t lowerBound(uint32_t key) const;
+};
+
+/**
+ * @class CANDispatchTable
+ * @brief Run-time registry of per-identifier handlers
+ *
+ * One handler per identifier; adding an identifier again replaces its
+ * handler. Not thread safe: change it only while no frame is dispatched
+ * (before the interface starts, or from the consumer task that receives).
+ */
+class CANDispatchTable {
+public:
+    static constexpr size_t MAX_HANDLERS = CAN_DISPATCH_MAX_HANDLERS;
+
+    CANDispatchTable();
+
+    /**
+     * @brief Register a handler for one identifier
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param handler Returns true for frames it consumed
+     * @param context Passed back to the handler
+     * @return false if the table is full or the identifier is invalid
+     */
+    bool add(uint32_t id, bool extended, CANFrameHandler handler, void* context = nullptr);
+
+    /**
+     * @brief Unregister an identifier
+     * @return false if it had no handler
+     */
+    bool remove(uint32_t id, bool extended);
+
+    void clear();
+
+    /**
+     * @brief Call the handler of the frame's identifier
+     * @return true if a handler consumed the frame
+     */
+    bool dispatch(const CANFrame& frame) const {
+        uint8_t slot = index.find(frame);
+        if (slot == 0) {
+            return false;
+        }
+        const Binding& binding = bindings[slot - 1];
+        return binding.handler(frame, binding.context);
+    }
+
+    /**
+     * @brief Check whether an identifier has a handler
+     */
+    bool contains(uint32_t id, bool extended) const {
+        return index.find(CANIdIndex::makeKey(id, extended)) != 0;
+    }
+
+    size_t size() const { return count; }
+
+private:
+    static_assert(MAX_HANDLERS >= 1 && MAX_HANDLERS <= 255, "slots are 8 bits");
+
+    struct Binding {
+        CANFrameHandler handler;
+        void* context;
+        uint32_t key;               // Needed to repoint the index when slots move
+    };
+
+    CANIdIndex index;
+    Binding bindings[MAX_HANDLERS];
+    size_t count;
+};
+
+// ===== COMPILE-TIME DISPATCH =====
+
+/**
+ * @brief Route adapter: a free function bound to one identifier key
+ *
+ * A route is any type with
+ *   static constexpr uint32_t KEY;        // identifier | CANFrame::FLAG_EXTENDED
+ *   static bool handle(const CANFrame& frame, Context& context);
+ * Generated DBC message types supply KEY, e.g.
+ *   CANRoute<ExampleBike::EngineStatus::KEY, Dashboard, &onEngineStatus>
+ */
+template <uint32_t Key, typename Context, bool (*Handler)(const CANFrame&, Context&)>
+struct CANRoute {
+    static constexpr uint32_t KEY = Key;
+
+    static bool handle(const CANFrame& frame, Context& context) {
+        return Handler(frame, context);
+    }
+};
+
+namespace CANDispatchDetail {
+
+template <typename... Routes>
+struct Routing;
+
+template <>
+struct Routing<> {
+    static constexpr size_t EXTENDED = 0;
+
+    static constexpr bool hasKey(uint32_t key) {
+        return (void)key, false;
+    }
+
+    static constexpr bool unique() {
+        return true;
+    }
+
+    static constexpr bool wellFormed() {
+        return true;
+    }
+
+    static void registerAll(CANIdIndex& index, uint8_t slot) {
+        (void)index;
+        (void)slot;
+    }
+
+    template <typename Context>
+    static bool call(uint8_t slot, uint8_t first, const CANFrame& frame, Context& context) {
+        (void)slot;
+        (void)first;
+        (void)frame;
+        (void)context;
+        return false;
+    }
+};
+
+template <typename Route, typename... Rest>
+struct Routing<Route, Rest...> {
+    static constexpr size_t EXTENDED = (Route::KEY >= CANIdIndex::STANDARD_IDS ? 1 : 0) +
+                                       Routing<Rest...>::EXTENDED;
+
+    static constexpr bool hasKey(uint32_t key) {
+        return Route::KEY == key || Routing<Rest...>::hasKey(key);
+    }
+
+    static constexpr bool unique() {
+        return !Routing<Rest...>::hasKey(Route::KEY) && Routing<Rest...>::unique();
+    }
+
+    // Identifier and extended flag only; standard keys fit 11 bits
+    static constexpr bool wellFormed() {
+        return (Route::KEY & ~(CANFrame::ID_MASK | CANFrame::FLAG_EXTENDED)) == 0 &&
+               (Route::KEY < CANIdIndex::STANDARD_IDS || (Route::KEY & CANFrame::FLAG_EXTENDED) != 0) &&
+               Routing<Rest...>::wellFormed();
+    }
+
+    static void registerAll(CANIdIndex& index, uint8_t slot) {
+        index.set(Route::KEY, slot);
+        Routing<Rest...>::registerAll(index, slot + 1);
+    }
+
+    // Unrolled compare chain on constant slots; the compiler turns it into a jump table
+    template <typename Context>
+    static bool call(uint8_t slot, uint8_t first, const CANFrame& frame, Context& context) {
+        if (slot == first) {
+            return Route::handle(frame, context);
+        }
+        return Routing<Rest...>::call(slot, first + 1, frame, context);
+    }
+};
+
+} // namespace CANDispatchDetail
+
+/**
+ * @class CANStaticDispatch
+ * @brief Per-identifier dispatch with routes fixed at compile time
+ *
+ * Usage:
+ *   typedef CANStaticDispatch<Dashboard,
+ *       CANRoute<0x0CF, Dashboard, &onEngine>,
+ *       CANRoute<0x1A0, Dashboard, &onWheels>> Routes;
+ *   static Routes routes;
+ *   while (can.receiveFrame(frame, 10)) routes.dispatch(frame, dashboard);
+ *
+ * Duplicate keys and too many 29-bit routes are compile errors.
+ */
+template <typename Context, typename... Routes>
+class CANStaticDispatch {
+public:
+    static constexpr size_t ROUTES = sizeof...(Routes);
+
+    CANStaticDispatch() {
+        Table::registerAll(index, 1);
+    }
+
+    /**
+     * @brief Call the route of the frame's identifier
+     * @return true if a route consumed the frame
+     */
+    bool dispatch(const CANFrame& frame, Context& context) const {
+        uint8_t slot = index.find(frame);
+        return slot != 0 && Table::call(slot, 1, frame, context);
+    }
+
+    /**
+     * @brief Check whether an identifier has a route
+     */
+    bool contains(uint32_t id, bool extended) const {
+        return index.find(CANIdIndex::makeKey(id, extended)) != 0;
+    }
+
+private:
+    typedef CANDispatchDetail::Routing<Routes...> Table;
+
+    static_assert(ROUTES >= 1 && ROUTES <= 255, "slots are 8 bits");
+    static_assert(Table::wellFormed(), "route KEY must be identifier | FLAG_EXTENDED");
+    static_assert(Table::unique(), "each identifier may have only one route");
+    static_assert(Table::EXTENDED <= CANIdIndex::EXTENDED_CAPACITY,
+                  "more 29-bit routes than CAN_DISPATCH_MAX_EXTENDED");
+
+    CANIdIndex index;
+};
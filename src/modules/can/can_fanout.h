@@ -0,0 +1,222 @@
+#pragma once
+
+/**
+ * @file can_fanout.h
+ * @brief Zero-copy fan-out of received frames to several consumers
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * The OBD poller, trace recorder and Bluetooth gateway each want every
+ * frame. Instead of one copy per consumer, the RX path stores a frame once
+ * in a pool slot whose reference count is the number of subscribers, and
+ * pushes the slot's 16-bit handle into each subscriber's own SPSC ring.
+ * A consumer reads the frame in place and releases it; the last release
+ * frees the slot.
+ *
+ * A subscriber whose ring is full drops that frame for itself only. The
+ * pool holds every ring's worth of frames plus one in use per consumer and
+ * one being filled, so it cannot run dry and a stalled consumer never
+ * delays the RX path or the other consumers.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+#include "can_ring_buffer.h"
+
+/**
+ * @brief Per-consumer delivery counters
+ */
+struct CANFanoutStats {
+    const char* name;               // Name given to subscribe()
+    uint32_t delivered;             // Frames the consumer acquired
+    uint32_t dropped;               // Frames lost to its full queue
+    uint32_t lag;                   // Frames queued for it now
+    uint32_t peakLag;               // Highest queue depth since reset
+};
+
+/**
+ * @class CANFramePool
+ * @brief Fixed frame slots with atomic reference counts
+ *
+ * One context allocates (the publisher); any context may release. A slot
+ * is reusable once its count drops to zero, so allocation scans from a
+ * rotating cursor and normally takes the first slot it looks at.
+ */
+template <size_t Capacity>
+class CANFramePool {
+    static_assert(Capacity >= 2 && Capacity < 0xFFFF, "handles are 16 bits");
+
+public:
+    static constexpr uint16_t INVALID = 0xFFFF;
+
+    CANFramePool() : cursor(0) {
+        for (size_t i = 0; i < Capacity; i++) {
+            refs[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    CANFramePool(const CANFramePool&) = delete;
+    CANFramePool& operator=(const CANFramePool&) = delete;
+
+    /**
+     * @brief Claim a free slot (publisher only)
+     * @param references Initial reference count (at least 1)
+     * @return Handle, or INVALID if every slot is referenced
+     */
+    uint16_t allocate(uint8_t references) {
+        for (size_t scanned = 0; scanned < Capacity; scanned++) {
+            size_t slot = cursor;
+            cursor = cursor + 1 == Capacity ? 0 : cursor + 1;
+            // Acquire: the last reader's loads happen before the slot is rewritten
+            if (refs[slot].load(std::memory_order_acquire) == 0) {
+                refs[slot].store(references, std::memory_order_relaxed);
+                return static_cast<uint16_t>(slot);
+            }
+        }
+        return INVALID;
+    }
+
+    CANFrame& frame(uint16_t handle) { return frames[handle]; }
+    const CANFrame& frame(uint16_t handle) const { return frames[handle]; }
+
+    /**
+     * @brief Drop one reference (any context)
+     */
+    void release(uint16_t handle) {
+        refs[handle].fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Slots currently referenced (snapshot)
+     */
+    size_t inUse() const {
+        size_t used = 0;
+        for (size_t i = 0; i < Capacity; i++) {
+            used += refs[i].load(std::memory_order_relaxed) != 0 ? 1 : 0;
+        }
+        return used;
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    CANFrame frames[Capacity];
+    std::atomic<uint8_t> refs[Capacity];
+    size_t cursor;                  // Publisher owned
+};
+
+/**
+ * @class CANFrameFanout
+ * @brief Publishes each frame once to every subscriber's handle queue
+ *
+ * One publisher context (the CANInterface RX path). Each subscriber is
+ * served from one consumer context of its own. Subscribe and unsubscribe
+ * while nothing is published, e.g. before CANInterface::setFanout().
+ *
+ * Consumer loop:
+ *   const CANFrame* frame;
+ *   while ((frame = fanout.acquire(id)) != nullptr) { use(*frame); }
+ *   fanout.release(id);            // Or keep it until the next acquire()
+ */
+class CANFrameFanout {
+public:
+    static constexpr size_t MAX_CONSUMERS = CAN_FANOUT_MAX_CONSUMERS;
+    static constexpr size_t QUEUE_DEPTH = CAN_FANOUT_QUEUE_DEPTH;
+    // Full queues, one frame held per consumer, one being published
+    static constexpr size_t POOL_SIZE = MAX_CONSUMERS * (QUEUE_DEPTH + 1) + 1;
+
+    CANFrameFanout();
+
+    CANFrameFanout(const CANFrameFanout&) = delete;
+    CANFrameFanout& operator=(const CANFrameFanout&) = delete;
+
+    // ===== SETUP =====
+
+    /**
+     * @brief Add a consumer
+     * @param name Label for statistics (not copied)
+     * @return Consumer id, or -1 if all slots are taken
+     */
+    int subscribe(const char* name);
+
+    /**
+     * @brief Remove a consumer and release its queued frames
+     */
+    void unsubscribe(int consumer);
+
+    size_t getConsumerCount() const { return consumerCount; }
+
+    // ===== PUBLISHER =====
+
+    /**
+     * @brief Store a frame once and queue it for every consumer
+     * @return Number of consumers that received it
+     */
+    size_t publish(const CANFrame& frame);
+
+    // ===== CONSUMER =====
+
+    /**
+     * @brief Next frame for a consumer (releases the one acquired before)
+     * @return Frame valid until the next acquire() or release(), or nullptr
+     */
+    const CANFrame* acquire(int consumer);
+
+    /**
+     * @brief Release the frame last acquired by a consumer
+     */
+    void release(int consumer);
+
+    /**
+     * @brief Frames waiting for a consumer
+     */
+    size_t pending(int consumer) const;
+
+    // ===== STATISTICS =====
+
+    /**
+     * @brief Delivery counters of a consumer
+     * @return false if the id is not subscribed
+     */
+    bool getStats(int consumer, CANFanoutStats& stats) const;
+
+    /**
+     * @brief Reset delivered/dropped/peak counters (consumer context)
+     */
+    void resetStats(int consumer);
+
+    /**
+     * @brief Frames published to nobody because the pool was empty (stays 0)
+     */
+    uint32_t getPoolExhausted() const { return poolExhausted.load(std::memory_order_relaxed); }
+
+    size_t getPoolInUse() const { return pool.inUse(); }
+
+private:
+    static constexpr uint16_t NONE = CANFramePool<POOL_SIZE>::INVALID;
+
+    struct Consumer {
+        CANRingBuffer<uint16_t, QUEUE_DEPTH> queue;     // Handles; overflows are drops
+        const char* name;
+        bool subscribed;
+        uint16_t held;                                  // Consumer owned
+        std::atomic<uint32_t> delivered;                // Consumer owned
+        std::atomic<uint32_t> peakLag;                  // Publisher owned
+        std::atomic<uint32_t> droppedBase;              // Overflow count at last reset
+    };
+
+    static_assert(MAX_CONSUMERS >= 1 && MAX_CONSUMERS <= 255, "reference counts are 8 bits");
+
+    CANFramePool<POOL_SIZE> pool;
+    Consumer consumers[MAX_CONSUMERS];
+    size_t consumerCount;
+    std::atomic<uint32_t> poolExhausted;
+
+    bool valid(int consumer) const {
+        return consumer >= 0 && static_cast<size_t>(consumer) < MAX_CONSUMERS &&
+               consumers[consumer].subscribed;
+    }
+};
@@ -0,0 +1,295 @@
+/**
+ * @file can_filter_engine.cpp
+ * @brief Precompiled CAN receive filter implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_filter_engine.h"
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t STD_ID_MAX = 0x7FF;
+    constexpr uint32_t EXT_ID_MAX = 0x1FFFFFFF;
+}
+
+// ===== CONSTRUCTOR =====
+
+CANFilterEngine::CANFilterEngine() :
+    hasAcceptRules(false),
+    extendedMask(0),
+    extendedDefault(DECISION_ACCEPT)
+{
+    compile();
+}
+
+// ===== RULE BUILDING =====
+
+void CANFilterEngine::clear() {
+    rules.clear();
+    predicates.clear();
+    hasAcceptRules = false;
+}
+
+void CANFilterEngine::accept(uint32_t id) {
+    addRule(RULE_ACCEPT, id, id, true);
+}
+
+void CANFilterEngine::accept(const std::vector<uint32_t>& ids) {
+    for (uint32_t id : ids) {
+        accept(id);
+    }
+}
+
+void CANFilterEngine::reject(uint32_t id) {
+    addRule(RULE_REJECT, id, id, true);
+}
+
+void CANFilterEngine::reject(const std::vector<uint32_t>& ids) {
+    for (uint32_t id : ids) {
+        reject(id);
+    }
+}
+
+void CANFilterEngine::acceptRange(uint32_t first, uint32_t last) {
+    addRule(RULE_ACCEPT, first, last, false);
+}
+
+void CANFilterEngine::rejectRange(uint32_t first, uint32_t last) {
+    addRule(RULE_REJECT, first, last, false);
+}
+
+void CANFilterEngine::requirePredicate(uint32_t first, uint32_t last, Predicate predicate) {
+    if (!predicate) {
+        return;
+    }
+    predicates.push_back(predicate);
+    addRule(RULE_PREDICATE, first, last, false, predicates.size() - 1);
+}
+
+void CANFilterEngine::loadFilter(const CANFilter& filter) {
+    clear();
+    if (!filter.enabled) {
+        return;
+    }
+
+    switch (filter.type) {
+        case CANFilterType::WHITELIST:
+            accept(filter.whitelist);
+            if (filter.whitelist.empty()) {
+                rejectRange(0, EXT_ID_MAX); // Empty whitelist accepts nothing
+            }
+            break;
+        case CANFilterType::BLACKLIST:
+            reject(filter.blacklist);
+            break;
+        case CANFilterType::RANGE:
+            if (filter.rangeStart <= filter.rangeEnd) {
+                acceptRange(filter.rangeStart, filter.rangeEnd);
+            } else {
+                rejectRange(0, EXT_ID_MAX);
+            }
+            break;
+        case CANFilterType::CUSTOM:
+            requirePredicate(0, EXT_ID_MAX, filter.customFilter);
+            break;
+        case CANFilterType::ACCEPT_ALL:
+        default:
+            break;
+    }
+}
+
+void CANFilterEngine::addRule(RuleKind kind, uint32_t first, uint32_t last, bool singleId,
+                              size_t predicateIndex) {
+    if (first > last) {
+        std::swap(first, last);
+    }
+    Rule rule;
+    rule.kind = kind;
+    rule.first = first & EXT_ID_MAX;
+    rule.last = std::min(last, EXT_ID_MAX);
+    rule.singleId = singleId;
+    rule.predicateIndex = predicateIndex;
+    rules.push_back(rule);
+
+    if (kind == RULE_ACCEPT) {
+        hasAcceptRules = true;
+    }
+}
+
+// ===== COMPILATION =====
+
+uint8_t CANFilterEngine::evaluate(uint32_t id, bool standard, bool includeSingleIds) const {
+    bool accepted = !hasAcceptRules;
+    bool rejected = false;
+    bool predicate = false;
+
+    for (const Rule& rule : rules) {
+        if (id < rule.first || id > rule.last) {
+            continue;
+        }
+        if (rule.singleId) {
+            // Single IDs bind to one frame format; see class documentation
+            bool ruleIsStandard = rule.first <= STD_ID_MAX;
+            if (!includeSingleIds || ruleIsStandard != standard) {
+                continue;
+            }
+        }
+        switch (rule.kind) {
+            case RULE_ACCEPT:
+                accepted = true;
+                break;
+            case RULE_REJECT:
+                rejected = true;
+                break;
+            case RULE_PREDICATE:
+                predicate = true;
+                break;
+        }
+    }
+
+    if (rejected || !accepted) {
+        return 0;
+    }
+    return DECISION_ACCEPT | (predicate ? DECISION_PREDICATE : 0);
+}
+
+void CANFilterEngine::compile() {
+    // 11-bit bitmap: evaluate every ID once
+    memset(standardAccept, 0, sizeof(standardAccept));
+    memset(standardPredicate, 0, sizeof(standardPredicate));
+    for (uint32_t id = 0; id <= STD_ID_MAX; id++) {
+        uint8_t decision = evaluate(id, true, true);
+        if (decision & DECISION_ACCEPT) {
+            standardAccept[id >> 5] |= 1UL << (id & 31);
+        }
+        if (decision & DECISION_PREDICATE) {
+            standardPredicate[id >> 5] |= 1UL << (id & 31);
+        }
+    }
+
+    // 29-bit elementary intervals from range rule boundaries
+    std::vector<uint32_t> boundaries;
+    for (const Rule& rule : rules) {
+        if (rule.singleId) {
+            continue;
+        }
+        boundaries.push_back(rule.first);
+        if (rule.last < EXT_ID_MAX) {
+            boundaries.push_back(rule.last + 1);
+        }
+    }
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+    extendedDefault = hasAcceptRules ? 0 : DECISION_ACCEPT;
+    extendedIntervals.clear();
+    for (uint32_t start : boundaries) {
+        ExtendedInterval interval;
+        interval.first = start;
+        interval.decision = evaluate(start, false, false);
+        // Merge neighbours with identical decisions
+        if (extendedIntervals.empty() ? interval.decision != extendedDefault
+                                      : interval.decision != extendedIntervals.back().decision) {
+            extendedIntervals.push_back(interval);
+        }
+    }
+
+    // 29-bit single IDs: open addressing hash at <= 50% load
+    std::vector<uint32_t> singleIds;
+    for (const Rule& rule : rules) {
+        if (rule.singleId && rule.first > STD_ID_MAX) {
+            singleIds.push_back(rule.first);
+        }
+    }
+    std::sort(singleIds.begin(), singleIds.end());
+    singleIds.erase(std::unique(singleIds.begin(), singleIds.end()), singleIds.end());
+
+    size_t capacity = 8;
+    while (capacity < singleIds.size() * 2) {
+        capacity <<= 1;
+    }
+    extendedKeys.assign(capacity, EMPTY_SLOT);
+    extendedDecisions.assign(capacity, 0);
+    extendedMask = capacity - 1;
+    for (uint32_t id : singleIds) {
+        uint32_t slot = hashId(id) & extendedMask;
+        while (extendedKeys[slot] != EMPTY_SLOT) {
+            slot = (slot + 1) & extendedMask;
+        }
+        extendedKeys[slot] = id;
+        extendedDecisions[slot] = evaluate(id, false, true);
+    }
+}
+
+// ===== EVALUATION =====
+
+uint8_t CANFilterEngine::lookupExtended(uint32_t id) const {
+    uint32_t slot = hashId(id) & extendedMask;
+    while (extendedKeys[slot] != EMPTY_SLOT) {
+        if (extendedKeys[slot] == id) {
+            return extendedDecisions[slot];
+        }
+        slot = (slot + 1) & extendedMask;
+    }
+
+    if (extendedIntervals.empty() || id < extendedIntervals.front().first) {
+        return extendedDefault;
+    }
+
+    // Last interval starting at or before id
+    auto it = std::upper_bound(extendedIntervals.begin(), extendedIntervals.end(), id,
+                               [](uint32_t value, const ExtendedInterval& interval) {
+                                   return value < interval.first;
+                               });
+    return (it - 1)->decision;
+}
+
+bool CANFilterEngine::evaluatePredicates(const CANMessage& message) const {
+    for (const Rule& rule : rules) {
+        if (rule.kind != RULE_PREDICATE || message.id < rule.first || message.id > rule.last) {
+            continue;
+        }
+        if (!predicates[rule.predicateIndex](message)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ===== INTROSPECTION =====
+
+bool CANFilterEngine::acceptedIdSet(std::vector<uint32_t>& ids) const {
+    ids.clear();
+    if (!hasAcceptRules || !predicates.empty()) {
+        return false;
+    }
+    for (const ExtendedInterval& interval : extendedIntervals) {
+        if (interval.decision & DECISION_ACCEPT) {
+            return false; // Open 29-bit range
+        }
+    }
+
+    for (uint32_t id = 0; id <= STD_ID_MAX; id++) {
+        if (standardAccept[id >> 5] & (1UL << (id & 31))) {
+            ids.push_back(id);
+        }
+    }
+    for (size_t slot = 0; slot < extendedKeys.size(); slot++) {
+        if (extendedKeys[slot] != EMPTY_SLOT && (extendedDecisions[slot] & DECISION_ACCEPT)) {
+            ids.push_back(extendedKeys[slot]);
+        }
+    }
+    return true;
+}
+
+uint32_t CANFilterEngine::standardAcceptedCount() const {
+    uint32_t count = 0;
+    for (uint32_t word : standardAccept) {
+        while (word) {
+            word &= word - 1;
+            count++;
+        }
+    }
+    return count;
+}
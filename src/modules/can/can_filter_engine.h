@@ -0,0 +1,243 @@
+#pragma once
+
+/**
+ * @file can_filter_engine.h
+ * @brief Precompiled constant-time CAN receive filter
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Whitelist, blacklist, range and predicate rules are composed into one
+ * decision structure: a 2048-bit bitmap for 11-bit IDs and an open
+ * addressing hash table for 29-bit IDs. The per-frame cost no longer
+ * depends on how many IDs are watched.
+ */
+
+#include <stdint.h>
+#include <vector>
+#include <functional>
+#include "can_types.h"
+#include "can_frame.h"
+
+/**
+ * @class CANFilterEngine
+ * @brief Composable rule set compiled into bitmap/hash lookups
+ *
+ * Rule semantics:
+ * - If any accept rule (ID or range) exists, IDs default to rejected,
+ *   otherwise they default to accepted.
+ * - Reject rules always win over accept rules.
+ * - Predicate rules additionally gate accepted frames in their ID range on
+ *   the frame contents; only frames with those IDs pay for the call.
+ *
+ * IDs up to 0x7FF given to accept()/reject() apply to 11-bit frames, larger
+ * IDs to 29-bit frames. Ranges apply to both frame formats.
+ */
+class CANFilterEngine {
+public:
+    typedef std::function<bool(const CANMessage&)> Predicate;
+
+    /**
+     * @brief Constructor (empty rule set accepts everything)
+     */
+    CANFilterEngine();
+
+    // ===== RULE BUILDING =====
+
+    /**
+     * @brief Remove all rules (accept everything after compile)
+     */
+    void clear();
+
+    /**
+     * @brief Accept a single ID
+     * @param id CAN identifier
+     */
+    void accept(uint32_t id);
+
+    /**
+     * @brief Accept a list of IDs
+     * @param ids CAN identifiers
+     */
+    void accept(const std::vector<uint32_t>& ids);
+
+    /**
+     * @brief Reject a single ID (overrides accept rules)
+     * @param id CAN identifier
+     */
+    void reject(uint32_t id);
+
+    /**
+     * @brief Reject a list of IDs
+     * @param ids CAN identifiers
+     */
+    void reject(const std::vector<uint32_t>& ids);
+
+    /**
+     * @brief Accept an inclusive ID range
+     * @param first First ID of range
+     * @param last Last ID of range
+     */
+    void acceptRange(uint32_t first, uint32_t last);
+
+    /**
+     * @brief Reject an inclusive ID range
+     * @param first First ID of range
+     * @param last Last ID of range
+     */
+    void rejectRange(uint32_t first, uint32_t last);
+
+    /**
+     * @brief Gate frames in an ID range on a content predicate
+     * @param first First ID of range
+     * @param last Last ID of range
+     * @param predicate Returns true to keep the frame
+     */
+    void requirePredicate(uint32_t first, uint32_t last, Predicate predicate);
+
+    /**
+     * @brief Load rules equivalent to a legacy CANFilter
+     * @param filter Filter configuration
+     *
+     * Whitelist and blacklist IDs follow accept()/reject(): IDs up to 0x7FF
+     * match 11-bit frames only. The old linear filter compared the number
+     * alone, so a 29-bit frame 0x00000123 used to match whitelist {0x123};
+     * it no longer does, as the TWAI acceptance filter compiled from the
+     * same whitelist never passed it either. Ranges still cover both formats.
+     */
+    void loadFilter(const CANFilter& filter);
+
+    /**
+     * @brief Build lookup tables from the current rules
+     */
+    void compile();
+
+    // ===== EVALUATION =====
+
+    /**
+     * @brief Decide whether a frame passes the filter (hot path)
+     * @param message Received frame
+     * @return true if frame is accepted
+     */
+    bool accepts(const CANMessage& message) const {
+        if (!message.extd && message.id <= 0x7FF) {
+            const uint32_t word = message.id >> 5;
+            const uint32_t bit = 1UL << (message.id & 31);
+            if (!(standardAccept[word] & bit)) {
+                return false;
+            }
+            if (!(standardPredicate[word] & bit)) {
+                return true;
+            }
+        } else {
+            const uint8_t decision = lookupExtended(message.id);
+            if (!(decision & DECISION_ACCEPT)) {
+                return false;
+            }
+            if (!(decision & DECISION_PREDICATE)) {
+                return true;
+            }
+        }
+        return evaluatePredicates(message);
+    }
+
+    /**
+     * @brief Decide whether a compact frame passes the filter (hot path)
+     * @param frame Received frame
+     * @return true if frame is accepted
+     *
+     * Only frames in a predicate range are expanded to CANMessage.
+     */
+    bool accepts(const CANFrame& frame) const {
+        const uint32_t id = frame.id();
+        if (!frame.isExtended() && id <= 0x7FF) {
+            const uint32_t word = id >> 5;
+            const uint32_t bit = 1UL << (id & 31);
+            if (!(standardAccept[word] & bit)) {
+                return false;
+            }
+            if (!(standardPredicate[word] & bit)) {
+                return true;
+            }
+        } else {
+            const uint8_t decision = lookupExtended(id);
+            if (!(decision & DECISION_ACCEPT)) {
+                return false;
+            }
+            if (!(decision & DECISION_PREDICATE)) {
+                return true;
+            }
+        }
+        CANMessage message;
+        frame.toMessage(message);
+        return evaluatePredicates(message);
+    }
+
+    // ===== INTROSPECTION =====
+
+    /**
+     * @brief Get the finite set of accepted IDs, if there is one
+     * @param ids Output list of accepted IDs
+     * @return false if ranges, predicates or default-accept make the set open
+     */
+    bool acceptedIdSet(std::vector<uint32_t>& ids) const;
+
+    /**
+     * @brief Number of 11-bit IDs accepted by the compiled bitmap
+     */
+    uint32_t standardAcceptedCount() const;
+
+    /**
+     * @brief Number of rules currently defined
+     */
+    size_t ruleCount() const { return rules.size(); }
+
+private:
+    enum RuleKind : uint8_t {
+        RULE_ACCEPT,
+        RULE_REJECT,
+        RULE_PREDICATE
+    };
+
+    struct Rule {
+        RuleKind kind;
+        uint32_t first;
+        uint32_t last;
+        bool singleId;              // Created by accept()/reject() of one ID
+        size_t predicateIndex;      // RULE_PREDICATE only
+    };
+
+    struct ExtendedInterval {
+        uint32_t first;             // Interval start (inclusive)
+        uint8_t decision;           // Decision for IDs from first up to next interval
+    };
+
+    static constexpr uint8_t DECISION_ACCEPT    = 0x01;
+    static constexpr uint8_t DECISION_PREDICATE = 0x02;
+    static constexpr uint32_t EMPTY_SLOT        = 0xFFFFFFFF;
+
+    // Rule set
+    std::vector<Rule> rules;
+    std::vector<Predicate> predicates;
+    bool hasAcceptRules;
+
+    // Compiled 11-bit tables (2048 bits each)
+    uint32_t standardAccept[64];
+    uint32_t standardPredicate[64];
+
+    // Compiled 29-bit tables
+    std::vector<uint32_t> extendedKeys;       // Open addressing, power of two
+    std::vector<uint8_t> extendedDecisions;
+    uint32_t extendedMask;
+    std::vector<ExtendedInterval> extendedIntervals; // Sorted by first
+    uint8_t extendedDefault;
+
+    uint8_t evaluate(uint32_t id, bool standard, bool includeSingleIds) const;
+    uint8_t lookupExtended(uint32_t id) const;
+    bool evaluatePredicates(const CANMessage& message) const;
+    void addRule(RuleKind kind, uint32_t first, uint32_t last, bool singleId,
+                 size_t predicateIndex = 0);
+
+    static uint32_t hashId(uint32_t id) {
+        return (id * 2654435761UL) >> 7;      // Knuth multiplicative hash
+    }
+};
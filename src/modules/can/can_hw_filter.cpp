@@ -0,0 +1,336 @@
+/**
+ * @file can_hw_filter.cpp
+ * @brief TWAI acceptance filter compiler implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Register layout (ESP-IDF TWAI / SJA1000 PeliCAN):
+ *   Single, 11-bit: [31:21] ID, [20] RTR, [15:0] data bytes 1-2
+ *   Single, 29-bit: [31:3] ID, [2] RTR
+ *   Dual,   11-bit: filter 1 [31:21] ID, [20] RTR, [19:16]+[3:0] data byte 1
+ *                   filter 2 [15:5] ID, [4] RTR
+ *   Dual,   29-bit: filter 1 [31:16] ID[28:13], filter 2 [15:0] ID[28:13]
+ */
+
+#include "can_hw_filter.h"
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t STD_ID_MASK      = 0x7FF;
+    constexpr uint32_t EXT_ID_MASK      = 0x1FFFFFFF;
+    constexpr uint32_t EXT_DUAL_MASK    = 0xFFFF;      // ID[28:13]
+    constexpr uint32_t EXT_DUAL_SHIFT   = 13;
+    constexpr uint32_t EXT_DUAL_SPAN    = 1UL << EXT_DUAL_SHIFT;
+    constexpr size_t   EXHAUSTIVE_SPLIT_LIMIT = 12;    // 2^11 partitions max
+
+    uint32_t popcount32(uint32_t value) {
+        uint32_t count = 0;
+        while (value) {
+            value &= value - 1;
+            count++;
+        }
+        return count;
+    }
+
+    void sortUnique(std::vector<uint32_t>& ids) {
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    }
+}
+
+// ===== PUBLIC API =====
+
+CANAcceptanceFilter CANFilterCompiler::compile(const CANFilter& filter) {
+    if (!filter.enabled) {
+        return CANAcceptanceFilter();
+    }
+
+    switch (filter.type) {
+        case CANFilterType::WHITELIST:
+            if (filter.whitelist.empty()) {
+                return CANAcceptanceFilter(); // Nothing to match, software rejects all
+            }
+            return compileIds(filter.whitelist);
+
+        case CANFilterType::RANGE:
+            return compileRange(filter.rangeStart, filter.rangeEnd);
+
+        case CANFilterType::ACCEPT_ALL:
+        case CANFilterType::BLACKLIST:  // Exclusion cannot be expressed in code/mask
+        case CANFilterType::CUSTOM:     // Payload dependent, software only
+        default:
+            return CANAcceptanceFilter();
+    }
+}
+
+CANAcceptanceFilter CANFilterCompiler::compileIds(const std::vector<uint32_t>& ids) {
+    std::vector<uint32_t> standardIds;
+    std::vector<uint32_t> extendedIds;
+    for (uint32_t id : ids) {
+        if (id <= STD_ID_MASK) {
+            standardIds.push_back(id);
+        } else {
+            extendedIds.push_back(id & EXT_ID_MASK);
+        }
+    }
+    sortUnique(standardIds);
+    sortUnique(extendedIds);
+
+    CANAcceptanceFilter result;
+    result.requestedIds = standardIds.size() + extendedIds.size();
+
+    if (standardIds.empty() && extendedIds.empty()) {
+        return result;
+    }
+
+    // Standard IDs only
+    if (extendedIds.empty()) {
+        Cover single = coverOf(standardIds.data(), standardIds.size(), STD_ID_MASK);
+        uint32_t singleAccepted = coverSize(single);
+
+        Cover first, second;
+        uint32_t dualAccepted = 0;
+        bool dualAvailable = bestSplit(standardIds, STD_ID_MASK, first, second, dualAccepted);
+
+        if (dualAvailable && dualAccepted < singleAccepted) {
+            result.singleFilter = false;
+            result.acceptanceCode = (first.code << 21) | (second.code << 5);
+            result.acceptanceMask = (first.dontCare << 21) | 0x001F000F |
+                                    (second.dontCare << 5) | 0x00000010;
+            result.hardwareAcceptedIds = dualAccepted;
+        } else {
+            result.singleFilter = true;
+            result.acceptanceCode = single.code << 21;
+            result.acceptanceMask = (single.dontCare << 21) | 0x001FFFFF;
+            result.hardwareAcceptedIds = singleAccepted;
+        }
+        result.extended = false;
+        result.exact = (result.hardwareAcceptedIds == result.requestedIds);
+        return result;
+    }
+
+    // Extended IDs only
+    if (standardIds.empty()) {
+        Cover single = coverOf(extendedIds.data(), extendedIds.size(), EXT_ID_MASK);
+        uint32_t singleAccepted = coverSize(single);
+
+        std::vector<uint32_t> upperIds;
+        for (uint32_t id : extendedIds) {
+            upperIds.push_back(id >> EXT_DUAL_SHIFT);
+        }
+        sortUnique(upperIds);
+
+        Cover first, second;
+        uint32_t dualUpper = 0;
+        bool dualAvailable = bestSplit(upperIds, EXT_DUAL_MASK, first, second, dualUpper);
+        uint32_t dualAccepted = dualUpper * EXT_DUAL_SPAN;
+
+        if (dualAvailable && dualAccepted < singleAccepted) {
+            result.singleFilter = false;
+            result.acceptanceCode = (first.code << 16) | second.code;
+            result.acceptanceMask = (first.dontCare << 16) | second.dontCare;
+            result.hardwareAcceptedIds = dualAccepted;
+        } else {
+            result.singleFilter = true;
+            result.acceptanceCode = single.code << 3;
+            result.acceptanceMask = (single.dontCare << 3) | 0x00000007;
+            result.hardwareAcceptedIds = singleAccepted;
+        }
+        result.extended = true;
+        result.exact = (result.hardwareAcceptedIds == result.requestedIds);
+        return result;
+    }
+
+    // Mixed: filter 1 takes the 11-bit IDs, filter 2 the upper bits of the 29-bit IDs.
+    // Each half also matches some frames of the other format, so never exact.
+    Cover standardCover = coverOf(standardIds.data(), standardIds.size(), STD_ID_MASK);
+    std::vector<uint32_t> upperIds;
+    for (uint32_t id : extendedIds) {
+        upperIds.push_back(id >> EXT_DUAL_SHIFT);
+    }
+    sortUnique(upperIds);
+    Cover extendedCover = coverOf(upperIds.data(), upperIds.size(), EXT_DUAL_MASK);
+    extendedCover.dontCare |= 0x0000000F;   // Shared with filter 1 data nibble
+    extendedCover.code &= ~extendedCover.dontCare;
+
+    result.singleFilter = false;
+    result.acceptanceCode = (standardCover.code << 21) | extendedCover.code;
+    result.acceptanceMask = (standardCover.dontCare << 21) | 0x001F0000 | extendedCover.dontCare;
+    result.hardwareAcceptedIds = coverSize(standardCover) + coverSize(extendedCover) * EXT_DUAL_SPAN;
+    result.extended = false;
+    result.exact = false;
+    return result;
+}
+
+bool CANFilterCompiler::hardwareAccepts(const CANAcceptanceFilter& filter, uint32_t id,
+                                        bool extended, bool rtr) {
+    const uint32_t code = filter.acceptanceCode;
+    const uint32_t care = ~filter.acceptanceMask;
+    const uint32_t rtrBit = rtr ? 1 : 0;
+
+    // Data bytes are modelled as zero; compiled filters never care about them
+    if (filter.singleFilter) {
+        uint32_t frameBits;
+        uint32_t relevant;
+        if (extended) {
+            frameBits = ((id & EXT_ID_MASK) << 3) | (rtrBit << 2);
+            relevant = 0xFFFFFFFC;
+        } else {
+            frameBits = ((id & STD_ID_MASK) << 21) | (rtrBit << 20);
+            relevant = 0xFFF0FFFF;
+        }
+        return ((frameBits ^ code) & care & relevant) == 0;
+    }
+
+    if (extended) {
+        uint32_t upper = (id & EXT_ID_MASK) >> EXT_DUAL_SHIFT;
+        bool filter1 = (((upper << 16) ^ code) & care & 0xFFFF0000) == 0;
+        bool filter2 = ((upper ^ code) & care & 0x0000FFFF) == 0;
+        return filter1 || filter2;
+    }
+
+    uint32_t filter1Bits = ((id & STD_ID_MASK) << 21) | (rtrBit << 20);
+    uint32_t filter2Bits = ((id & STD_ID_MASK) << 5) | (rtrBit << 4);
+    bool filter1 = ((filter1Bits ^ code) & care & 0xFFFF000F) == 0;
+    bool filter2 = ((filter2Bits ^ code) & care & 0x0000FFF0) == 0;
+    return filter1 || filter2;
+}
+
+// ===== INTERNAL METHODS =====
+
+CANFilterCompiler::Cover CANFilterCompiler::coverOf(const uint32_t* ids, size_t count,
+                                                    uint32_t widthMask) {
+    Cover cover;
+    cover.code = ids[0] & widthMask;
+    cover.dontCare = 0;
+    for (size_t i = 1; i < count; i++) {
+        cover.dontCare |= (ids[i] ^ ids[0]) & widthMask;
+    }
+    cover.code &= ~cover.dontCare;
+    return cover;
+}
+
+uint32_t CANFilterCompiler::coverSize(const Cover& cover) {
+    return 1UL << popcount32(cover.dontCare);
+}
+
+uint32_t CANFilterCompiler::unionSize(const Cover& a, const Cover& b) {
+    uint32_t total = coverSize(a) + coverSize(b);
+    uint32_t mustMatch = ~a.dontCare & ~b.dontCare;
+    if (((a.code ^ b.code) & mustMatch) == 0) {
+        total -= 1UL << popcount32(a.dontCare & b.dontCare); // Overlap
+    }
+    return total;
+}
+
+bool CANFilterCompiler::bestSplit(const std::vector<uint32_t>& ids, uint32_t widthMask,
+                                  Cover& first, Cover& second, uint32_t& accepted) {
+    const size_t count = ids.size();
+    if (count < 2) {
+        return false;
+    }
+
+    std::vector<uint32_t> groupA;
+    std::vector<uint32_t> groupB;
+    groupA.reserve(count);
+    groupB.reserve(count);
+    bool found = false;
+
+    auto consider = [&]() {
+        if (groupA.empty() || groupB.empty()) {
+            return;
+        }
+        Cover a = coverOf(groupA.data(), groupA.size(), widthMask);
+        Cover b = coverOf(groupB.data(), groupB.size(), widthMask);
+        uint32_t size = unionSize(a, b);
+        if (!found || size < accepted) {
+            first = a;
+            second = b;
+            accepted = size;
+            found = true;
+        }
+    };
+
+    if (count <= EXHAUSTIVE_SPLIT_LIMIT) {
+        // ids[0] always in group A; enumerate membership of the rest
+        const uint32_t partitions = 1UL << (count - 1);
+        for (uint32_t selection = 1; selection < partitions; selection++) {
+            groupA.assign(1, ids[0]);
+            groupB.clear();
+            for (size_t i = 1; i < count; i++) {
+                if (selection & (1UL << (i - 1))) {
+                    groupB.push_back(ids[i]);
+                } else {
+                    groupA.push_back(ids[i]);
+                }
+            }
+            consider();
+        }
+        return found;
+    }
+
+    // Large sets: try every split point of the sorted list...
+    for (size_t split = 1; split < count; split++) {
+        groupA.assign(ids.begin(), ids.begin() + split);
+        groupB.assign(ids.begin() + split, ids.end());
+        consider();
+    }
+
+    // ...and every single-bit partition
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        if (!(widthMask & (1UL << bit))) {
+            continue;
+        }
+        groupA.clear();
+        groupB.clear();
+        for (uint32_t id : ids) {
+            (id & (1UL << bit) ? groupB : groupA).push_back(id);
+        }
+        consider();
+    }
+
+    return found;
+}
+
+CANAcceptanceFilter CANFilterCompiler::compileRange(uint32_t start, uint32_t end) {
+    if (start > end) {
+        return CANAcceptanceFilter();
+    }
+
+    // Small ranges go through the exact ID-set path
+    if (end - start < 4096 && (end <= STD_ID_MASK || start > STD_ID_MASK)) {
+        std::vector<uint32_t> ids;
+        ids.reserve(end - start + 1);
+        for (uint32_t id = start; id <= end; id++) {
+            ids.push_back(id);
+        }
+        return compileIds(ids);
+    }
+
+    // Ranges that straddle 11/29-bit space are left to software
+    if (start <= STD_ID_MASK) {
+        return CANAcceptanceFilter();
+    }
+
+    // Large 29-bit range: common prefix of the bounds
+    uint32_t first = start & EXT_ID_MASK;
+    uint32_t last = end & EXT_ID_MASK;
+    Cover cover;
+    cover.dontCare = 0;
+    uint32_t differing = first ^ last;
+    while (differing) {
+        cover.dontCare = (cover.dontCare << 1) | 1;
+        differing >>= 1;
+    }
+    cover.code = first & ~cover.dontCare;
+
+    CANAcceptanceFilter result;
+    result.singleFilter = true;
+    result.extended = true;
+    result.acceptanceCode = cover.code << 3;
+    result.acceptanceMask = (cover.dontCare << 3) | 0x00000007;
+    result.requestedIds = last - first + 1;
+    result.hardwareAcceptedIds = coverSize(cover);
+    result.exact = (result.hardwareAcceptedIds == result.requestedIds);
+    return result;
+}
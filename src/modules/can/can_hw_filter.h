@@ -0,0 +1,84 @@
+#pragma once
+
+/**
+ * @file can_hw_filter.h
+ * @brief Compiles CANFilter into TWAI (SJA1000) acceptance code/mask
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * The TWAI controller can drop frames before they reach the driver queue,
+ * but only through one 32-bit code/mask pair (single filter mode) or two
+ * 16-bit pairs (dual filter mode). This module picks the layout that lets
+ * the fewest unwanted IDs through; whatever the hardware cannot express is
+ * still rejected by the software filter in CANInterface.
+ */
+
+#include <stdint.h>
+#include "can_types.h"
+
+/**
+ * @brief Compiled hardware acceptance filter
+ *
+ * Mask bits follow the TWAI convention: 1 = don't care, 0 = must match.
+ */
+struct CANAcceptanceFilter {
+    uint32_t acceptanceCode;        // TWAI acceptance code register value
+    uint32_t acceptanceMask;        // TWAI acceptance mask register value
+    bool singleFilter;              // true = single filter mode, false = dual
+    bool extended;                  // Compiled for 29-bit frame layout
+    bool exact;                     // Hardware passes exactly the requested IDs
+    uint32_t requestedIds;          // IDs the software filter wants
+    uint32_t hardwareAcceptedIds;   // IDs the hardware lets through
+
+    // Constructor (accept all)
+    CANAcceptanceFilter() : acceptanceCode(0), acceptanceMask(0xFFFFFFFF),
+                            singleFilter(true), extended(false), exact(false),
+                            requestedIds(0), hardwareAcceptedIds(0) {}
+
+    bool acceptsAll() const { return singleFilter && acceptanceMask == 0xFFFFFFFF; }
+};
+
+/**
+ * @class CANFilterCompiler
+ * @brief Converts a CANFilter into the tightest TWAI acceptance filter
+ */
+class CANFilterCompiler {
+public:
+    /**
+     * @brief Compile software filter into hardware acceptance filter
+     * @param filter Software filter configuration
+     * @return Best single or dual filter; accept-all if not expressible
+     */
+    static CANAcceptanceFilter compile(const CANFilter& filter);
+
+    /**
+     * @brief Compile an explicit ID set
+     * @param ids Accepted IDs (values above 0x7FF are treated as 29-bit)
+     * @return Best single or dual filter
+     */
+    static CANAcceptanceFilter compileIds(const std::vector<uint32_t>& ids);
+
+    /**
+     * @brief Evaluate the TWAI acceptance logic for an ID (register model)
+     * @param filter Compiled filter
+     * @param id Frame identifier
+     * @param extended Frame uses 29-bit identifier
+     * @param rtr Frame is a remote frame
+     * @return true if the controller would accept the frame
+     */
+    static bool hardwareAccepts(const CANAcceptanceFilter& filter, uint32_t id,
+                                bool extended, bool rtr = false);
+
+private:
+    struct Cover {
+        uint32_t code;      // Common bit values
+        uint32_t dontCare;  // Bits that differ between members
+    };
+
+    static Cover coverOf(const uint32_t* ids, size_t count, uint32_t widthMask);
+    static uint32_t coverSize(const Cover& cover);
+    static uint32_t unionSize(const Cover& a, const Cover& b);
+    static bool bestSplit(const std::vector<uint32_t>& ids, uint32_t widthMask,
+                          Cover& first, Cover& second, uint32_t& accepted);
+    static CANAcceptanceFilter compileRange(uint32_t start, uint32_t end);
+};
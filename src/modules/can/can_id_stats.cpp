@@ -0,0 +1,97 @@
+/**
+ * @file can_id_stats.cpp
+ * @brief Per-ID arrival statistics implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_id_stats.h"
+#include <math.h>
+#include <string.h>
+
+static_assert((CAN_ID_STATS_SIZE & (CAN_ID_STATS_SIZE - 1)) == 0,
+              "CAN_ID_STATS_SIZE must be a power of two");
+
+float CANIdStatistics::jitter() const {
+    return count > 2 ? sqrtf(periodM2 / (count - 1)) : 0.0f;
+}
+
+CANIdStatsTable::CANIdStatsTable() {
+    clear();
+}
+
+const CANIdStatistics* CANIdStatsTable::update(uint32_t id, bool extended, uint64_t timestampUs) {
+    size_t slot = probe(id, extended);
+    if (slot == CAPACITY) {
+        untrackedFrames++;
+        return nullptr;
+    }
+
+    CANIdStatistics& s = entries[slot];
+    if (!occupied[slot]) {
+        occupied[slot] = true;
+        used++;
+        memset(&s, 0, sizeof(s));
+        s.id = id;
+        s.extended = extended;
+        s.minPeriod = UINT32_MAX;
+        s.count = 1;
+        s.lastTimestamp = timestampUs;
+        return &s;
+    }
+
+    uint64_t delta = timestampUs > s.lastTimestamp ? timestampUs - s.lastTimestamp : 0;
+    uint32_t period = delta > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(delta);
+    s.count++;
+    s.lastTimestamp = timestampUs;
+    s.lastPeriod = period;
+    if (period < s.minPeriod) {
+        s.minPeriod = period;
+    }
+    if (period > s.maxPeriod) {
+        s.maxPeriod = period;
+    }
+
+    // Welford over count - 1 periods
+    uint32_t periods = s.count - 1;
+    float diff = period - s.meanPeriod;
+    s.meanPeriod += diff / periods;
+    s.periodM2 += diff * (period - s.meanPeriod);
+    return &s;
+}
+
+const CANIdStatistics* CANIdStatsTable::find(uint32_t id, bool extended) const {
+    size_t slot = probe(id, extended);
+    return slot != CAPACITY && occupied[slot] ? &entries[slot] : nullptr;
+}
+
+size_t CANIdStatsTable::snapshot(CANIdStatistics* out, size_t maxEntries) const {
+    size_t copied = 0;
+    for (size_t i = 0; i < CAPACITY && copied < maxEntries; i++) {
+        if (occupied[i]) {
+            out[copied++] = entries[i];
+        }
+    }
+    return copied;
+}
+
+void CANIdStatsTable::clear() {
+    memset(occupied, 0, sizeof(occupied));
+    used = 0;
+    untrackedFrames = 0;
+}
+
+// ===== INTERNAL METHODS =====
+
+size_t CANIdStatsTable::probe(uint32_t id, bool extended) const {
+    // Linear probing; returns the entry's slot, the first free slot, or
+    // CAPACITY when the ID is absent and the table is full
+    size_t slot = hashId(id, extended) & (CAPACITY - 1);
+    for (size_t i = 0; i < CAPACITY; i++) {
+        if (!occupied[slot] || (entries[slot].id == id && entries[slot].extended == extended)) {
+            return slot;
+        }
+        slot = (slot + 1) & (CAPACITY - 1);
+    }
+    return CAPACITY;
+}
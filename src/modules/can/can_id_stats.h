@@ -0,0 +1,97 @@
+#pragma once
+
+/**
+ * @file can_id_stats.h
+ * @brief Per-ID arrival statistics for received CAN traffic
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Tracks, for every identifier seen on the bus, how often it arrives and how
+ * regular it is. Mean and jitter (standard deviation of the period) use
+ * Welford's update, so each frame costs one table probe and a few float
+ * operations; no sample history is kept.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../config/project_config.h"
+
+/**
+ * @brief Arrival statistics of one CAN identifier
+ */
+struct CANIdStatistics {
+    uint32_t id;
+    bool extended;
+    uint32_t count;                 // Frames received
+    uint64_t lastTimestamp;         // Microseconds
+    uint32_t lastPeriod;            // Microseconds between the last two frames
+    uint32_t minPeriod;
+    uint32_t maxPeriod;
+    float meanPeriod;               // Microseconds
+    float periodM2;                 // Welford sum of squared deviations
+
+    /**
+     * @brief Period standard deviation in microseconds
+     */
+    float jitter() const;
+
+    /**
+     * @brief Mean arrival rate in Hz (0 until two frames were seen)
+     */
+    float rateHz() const {
+        return meanPeriod > 0.0f ? 1000000.0f / meanPeriod : 0.0f;
+    }
+};
+
+/**
+ * @class CANIdStatsTable
+ * @brief Fixed-capacity open addressing table of CANIdStatistics
+ *
+ * Not thread safe; the owner serializes update and query calls. Once full,
+ * frames of new IDs are only counted in untracked().
+ */
+class CANIdStatsTable {
+public:
+    static constexpr size_t CAPACITY = CAN_ID_STATS_SIZE;
+
+    CANIdStatsTable();
+
+    /**
+     * @brief Record a received frame
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param timestampUs Reception time in microseconds
+     * @return Updated entry, or nullptr if the table is full
+     */
+    const CANIdStatistics* update(uint32_t id, bool extended, uint64_t timestampUs);
+
+    /**
+     * @brief Look up an identifier
+     * @return Entry, or nullptr if the ID was never seen
+     */
+    const CANIdStatistics* find(uint32_t id, bool extended) const;
+
+    /**
+     * @brief Copy out all tracked entries
+     * @param out Destination array
+     * @param maxEntries Capacity of out
+     * @return Number of entries copied
+     */
+    size_t snapshot(CANIdStatistics* out, size_t maxEntries) const;
+
+    size_t size() const { return used; }
+    uint32_t untracked() const { return untrackedFrames; }
+    void clear();
+
+private:
+    CANIdStatistics entries[CAPACITY];
+    bool occupied[CAPACITY];
+    size_t used;
+    uint32_t untrackedFrames;
+
+    size_t probe(uint32_t id, bool extended) const;
+
+    static uint32_t hashId(uint32_t id, bool extended) {
+        return ((id | (extended ? 0x80000000UL : 0)) * 2654435761UL) >> 7;  // Knuth multiplicative hash
+    }
+};
@@ -7,6 +7,26 @@
 
 #include "can_interface.h"
 #include <Arduino.h>
+#include "esp_timer.h"
+#include "slcan.h"
+#include "can_log.h"
+
+namespace {
+
+esp_err_t toEspError(CANTransportResult result) {
+    switch (result) {
+        case CANTransportResult::OK:
+            return ESP_OK;
+        case CANTransportResult::TIMEOUT:
+            return ESP_ERR_TIMEOUT;
+        case CANTransportResult::NOT_RUNNING:
+            return ESP_ERR_INVALID_STATE;
+        default:
+            return ESP_FAIL;
+    }
+}
+
+} // namespace
 
 // ===== CONSTRUCTOR & DESTRUCTOR =====
 
@@ -15,69 +35,61 @@ CANInterface::CANInterface() :
     currentMode(CANMode::NORMAL),
     interfaceEnabled(false),
     busOff(false),
+    transport(&twaiTransport),
+    hardwareEnforced(false),
     interfaceStartTime(0),
+    fanout(nullptr),
     messageCallback(nullptr),
-    errorCallback(nullptr)
+    dispatchTable(nullptr),
+    frameHandler(nullptr),
+    frameHandlerContext(nullptr),
+    errorCallback(nullptr),
+    receiveTaskHandle(nullptr),
+    notifyTaskHandle(nullptr),
+    filterLock(nullptr),
+    receiveTaskExit(nullptr),
+    receiveTaskRunning(false),
+    receiveTaskCore(CAN_RX_TASK_CORE),
+    receiveTaskPriority(CAN_RX_TASK_PRIORITY),
+    driverRxQueueLength(CAN_DRIVER_RX_QUEUE_LEN),
+    driverTxQueueLength(CAN_DRIVER_TX_QUEUE_LEN)
 {
     // Initialize statistics
     statistics = CANStatistics();
+    statsLock = portMUX_INITIALIZER_UNLOCKED;
+    txLock = portMUX_INITIALIZER_UNLOCKED;
 }
 
 CANInterface::~CANInterface() {
     stop();
+    if (filterLock != nullptr) {
+        vSemaphoreDelete(filterLock);
+    }
+    if (receiveTaskExit != nullptr) {
+        vSemaphoreDelete(receiveTaskExit);
+    }
 }
 
 // ===== INITIALIZATION =====
 
 bool CANInterface::initialize(CANSpeed speed, CANMode mode) {
-    Serial.println(F("[CAN] Initializing CAN interface..."));
+    CANLog::printf("[CAN] Initializing CAN interface...\n");
     
     currentSpeed = speed;
     currentMode = mode;
+    busLoad.setBitrate(getSpeedBPS(speed));
     
-    // Get timing configuration for the specified speed
-    twai_timing_config_t timing_config;
-    if (!getTimingConfig(speed, timing_config)) {
-        Serial.println(F("[CAN] ERROR: Invalid CAN speed configuration"));
-        return false;
-    }
-    
-    // Configure CAN controller
-    twai_general_config_t general_config = TWAI_GENERAL_CONFIG_DEFAULT(
-        static_cast<gpio_num_t>(CAN_TX_PIN), 
-        static_cast<gpio_num_t>(CAN_RX_PIN), 
-        TWAI_MODE_NORMAL
-    );
-    
-    // Set mode based on configuration
-    switch (mode) {
-        case CANMode::LISTEN_ONLY:
-            general_config.mode = TWAI_MODE_LISTEN_ONLY;
-            break;
-        case CANMode::SELF_TEST:
-            general_config.mode = TWAI_MODE_SELF_TEST;
-            break;
-        case CANMode::NO_ACK:
-            general_config.mode = TWAI_MODE_NO_ACK;
-            break;
-        default:
-            general_config.mode = TWAI_MODE_NORMAL;
-            break;
-    }
-    
-    // Configure filter to accept all messages initially
-    twai_filter_config_t filter_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
-    
-    // Install TWAI driver
-    esp_err_t result = twai_driver_install(&general_config, &timing_config, &filter_config);
-    if (result != ESP_OK) {
-        Serial.printf("[CAN] ERROR: Failed to install TWAI driver: %s\n", esp_err_to_name(result));
+    if (!installDriver()) {
         return false;
     }
     
     // Initialize queues
-    while (!receiveQueue.empty()) receiveQueue.pop();
-    while (!transmitQueue.empty()) transmitQueue.pop();
+    receiveQueue.clear();
+    portENTER_CRITICAL(&txLock);
+    transmitQueue.clear();
+    transmitQueue.onDriverReset();
+    portEXIT_CRITICAL(&txLock);
+    latestFrames.clear();
     
     // Reset statistics
     resetStatistics();
@@ -85,19 +97,19 @@ bool CANInterface::initialize(CANSpeed speed, CANMode mode) {
     interfaceEnabled = true;
     interfaceStartTime = millis();
     
-    Serial.printf("[CAN] Interface initialized at %d bps, mode: ", getSpeedBPS(speed));
+    CANLog::printf("[CAN] Interface initialized at %d bps, mode: ", getSpeedBPS(speed));
     switch (mode) {
         case CANMode::NORMAL:
-            Serial.println("NORMAL");
+            CANLog::printf("NORMAL\n");
             break;
         case CANMode::LISTEN_ONLY:
-            Serial.println("LISTEN_ONLY");
+            CANLog::printf("LISTEN_ONLY\n");
             break;
         case CANMode::SELF_TEST:
-            Serial.println("SELF_TEST");
+            CANLog::printf("SELF_TEST\n");
             break;
         case CANMode::NO_ACK:
-            Serial.println("NO_ACK");
+            CANLog::printf("NO_ACK\n");
             break;
     }
     
@@ -106,19 +118,18 @@ bool CANInterface::initialize(CANSpeed speed, CANMode mode) {
 
 bool CANInterface::start() {
     if (!interfaceEnabled) {
-        Serial.println(F("[CAN] ERROR: Interface not initialized"));
+        CANLog::printf("[CAN] ERROR: Interface not initialized\n");
         return false;
     }
     
-    // Start TWAI driver
-    esp_err_t result = twai_start();
-    if (result != ESP_OK) {
-        Serial.printf("[CAN] ERROR: Failed to start TWAI driver: %s\n", esp_err_to_name(result));
+    if (!transport->start()) {
+        CANLog::printf("[CAN] ERROR: Failed to start %s transport\n", transport->getName());
         return false;
     }
     
     busOff = false;
-    Serial.println(F("[CAN] Interface started successfully"));
+    recovery.reset();
+    CANLog::printf("[CAN] Interface started successfully\n");
     return true;
 }
 
@@ -127,29 +138,39 @@ void CANInterface::stop() {
         return;
     }
     
-    // Stop TWAI driver
-    twai_stop();
+    // Receive task must not block on a driver that is going away
+    stopReceiveTask();
     
-    // Uninstall driver
-    twai_driver_uninstall();
+    // Stop and release the controller
+    transport->uninstall();
+    portENTER_CRITICAL(&txLock);
+    transmitQueue.onDriverReset();
+    portEXIT_CRITICAL(&txLock);
     
     interfaceEnabled = false;
     busOff = false;
+    recovery.reset();
     
-    Serial.println(F("[CAN] Interface stopped"));
+    CANLog::printf("[CAN] Interface stopped\n");
 }
 
 bool CANInterface::reset() {
-    Serial.println(F("[CAN] Resetting interface..."));
+    CANLog::printf("[CAN] Resetting interface...\n");
     
     bool wasEnabled = interfaceEnabled;
+    bool hadReceiveTask = receiveTaskRunning;
     CANSpeed oldSpeed = currentSpeed;
     CANMode oldMode = currentMode;
     
     stop();
     
     if (wasEnabled) {
-        return initialize(oldSpeed, oldMode) && start();
+        if (!initialize(oldSpeed, oldMode) || !start()) {
+            return false;
+        }
+        if (hadReceiveTask) {
+            return startReceiveTask(receiveTaskCore, receiveTaskPriority);
+        }
     }
     
     return true;
@@ -159,16 +180,213 @@ bool CANInterface::isInitialized() const {
     return interfaceEnabled;
 }
 
+bool CANInterface::setDriverQueueLengths(uint32_t rxLength, uint32_t txLength) {
+    if (interfaceEnabled) {
+        CANLog::printf("[CAN] Cannot change driver queues while interface is active\n");
+        return false;
+    }
+    if (rxLength == 0 || txLength == 0) {
+        return false;
+    }
+    
+    driverRxQueueLength = rxLength;
+    driverTxQueueLength = txLength;
+    CANLog::printf("[CAN] Driver queues set to RX %u / TX %u\n", rxLength, txLength);
+    return true;
+}
+
+bool CANInterface::setTransport(CANTransport* backend) {
+    if (interfaceEnabled) {
+        CANLog::printf("[CAN] Cannot change transport while interface is active\n");
+        return false;
+    }
+    
+    transport = backend != nullptr ? backend : &twaiTransport;
+    CANLog::printf("[CAN] Transport set to %s\n", transport->getName());
+    return true;
+}
+
+CANTransport* CANInterface::getTransport() const {
+    return transport;
+}
+
+// ===== RECEIVE TASK =====
+
+bool CANInterface::startReceiveTask(int core, UBaseType_t priority) {
+    if (!interfaceEnabled) {
+        CANLog::printf("[CAN] ERROR: Interface not initialized\n");
+        return false;
+    }
+    if (receiveTaskRunning) {
+        return true;
+    }
+    
+    if (filterLock == nullptr) {
+        filterLock = xSemaphoreCreateMutex();
+        if (filterLock == nullptr) {
+            CANLog::printf("[CAN] ERROR: Failed to create filter lock\n");
+            return false;
+        }
+    }
+    if (receiveTaskExit == nullptr) {
+        receiveTaskExit = xSemaphoreCreateBinary();
+        if (receiveTaskExit == nullptr) {
+            CANLog::printf("[CAN] ERROR: Failed to create receive task exit signal\n");
+            return false;
+        }
+    }
+    
+    receiveTaskCore = core;
+    receiveTaskPriority = priority;
+    receiveTaskRunning = true;
+    
+    BaseType_t created = xTaskCreatePinnedToCore(receiveTaskEntry, "can_rx", STACK_SIZE_CAN,
+                                                 this, priority, &receiveTaskHandle, core);
+    if (created != pdPASS) {
+        receiveTaskRunning = false;
+        receiveTaskHandle = nullptr;
+        CANLog::printf("[CAN] ERROR: Failed to create receive task\n");
+        return false;
+    }
+    
+    CANLog::printf("[CAN] Receive task started on core %d, priority %u\n", core, priority);
+    return true;
+}
+
+void CANInterface::stopReceiveTask() {
+    if (!receiveTaskRunning) {
+        return;
+    }
+    
+    receiveTaskRunning = false;
+    
+    // Task exits within one driver poll period. It is never deleted from
+    // here: it could be holding filterLock, which would then stay taken.
+    if (xSemaphoreTake(receiveTaskExit, pdMS_TO_TICKS(CAN_RX_TASK_POLL_MS * 3)) != pdTRUE) {
+        CANLog::printf("[CAN] WARNING: Receive task slow to exit, waiting\n");
+        xSemaphoreTake(receiveTaskExit, portMAX_DELAY);
+    }
+    
+    CANLog::printf("[CAN] Receive task stopped\n");
+}
+
+bool CANInterface::isReceiveTaskRunning() const {
+    return receiveTaskRunning;
+}
+
+void CANInterface::setReceiveNotifyTask(TaskHandle_t task) {
+    notifyTaskHandle = task;
+}
+
+bool CANInterface::waitForMessages(uint32_t timeout) {
+    if (!receiveQueue.empty()) {
+        return true;
+    }
+    if (!receiveTaskRunning) {
+        CANFrame frame;
+        if (readFromDriver(frame, timeout)) {
+            queueReceived(frame, millis());
+        }
+        return !receiveQueue.empty();
+    }
+    
+    if (notifyTaskHandle == nullptr) {
+        notifyTaskHandle = xTaskGetCurrentTaskHandle();
+    }
+    
+    // A notification given before this call is still pending, so no frame is missed
+    if (notifyTaskHandle == xTaskGetCurrentTaskHandle()) {
+        // One left over from frames already popped wakes early; wait out the rest
+        unsigned long startTime = millis();
+        unsigned long elapsed = 0;
+        do {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeout - elapsed));
+            elapsed = millis() - startTime;
+        } while (receiveQueue.empty() && elapsed < timeout);
+    } else {
+        // Not the notified consumer: fall back to short sleeps
+        unsigned long startTime = millis();
+        while (receiveQueue.empty() && (millis() - startTime) < timeout) {
+            vTaskDelay(1);
+        }
+    }
+    
+    return !receiveQueue.empty();
+}
+
+void CANInterface::receiveTaskEntry(void* parameter) {
+    static_cast<CANInterface*>(parameter)->receiveTaskLoop();
+}
+
+void CANInterface::receiveTaskLoop() {
+    CANFrame burst[CAN_RX_BURST_SIZE];
+    
+    while (receiveTaskRunning) {
+        // Sleep until the transport raises an event; poll faster while a recovery is pending
+        uint32_t wait = recovery.isBusOff() ? CAN_RECOVERY_POLL_MS : CAN_RX_TASK_POLL_MS;
+        uint32_t alerts = transport->readEvents(wait);
+    
+        if (alerts & (CANTransportEvent::RX_DATA | CANTransportEvent::RX_OVERFLOW)) {
+            // Drain the transport a burst at a time (frames arrive timestamped)
+            size_t count;
+            do {
+                count = 0;
+                while (count < CAN_RX_BURST_SIZE &&
+                       transport->receive(burst[count], 0) == CANTransportResult::OK) {
+                    count++;
+                }
+    
+                size_t queued = 0;
+                uint32_t now = millis();
+                lockFilter();
+                for (size_t i = 0; i < count; i++) {
+                    // Latest values and fan-out stay current even when frames are shed
+                    if (acceptReceived(burst[i]) && queueReceived(burst[i], now)) {
+                        queued++;
+                    }
+                }
+                unlockFilter();
+                
+                if (queued > 0 && notifyTaskHandle != nullptr) {
+                    xTaskNotifyGive(notifyTaskHandle);
+                }
+            } while (count == CAN_RX_BURST_SIZE);
+        }
+        
+        if (alerts != 0) {
+            handleAlerts(alerts);
+        }
+        serviceRecovery();
+    }
+    
+    // Outside filterLock; the interface may be gone once the signal is given
+    receiveTaskHandle = nullptr;
+    xSemaphoreGive(receiveTaskExit);
+    vTaskDelete(nullptr);
+}
+
+void CANInterface::lockFilter() {
+    if (filterLock != nullptr) {
+        xSemaphoreTake(filterLock, portMAX_DELAY);
+    }
+}
+
+void CANInterface::unlockFilter() {
+    if (filterLock != nullptr) {
+        xSemaphoreGive(filterLock);
+    }
+}
+
 // ===== CONFIGURATION =====
 
 bool CANInterface::setSpeed(CANSpeed speed) {
     if (interfaceEnabled) {
-        Serial.println(F("[CAN] Cannot change speed while interface is active"));
+        CANLog::printf("[CAN] Cannot change speed while interface is active\n");
         return false;
     }
     
     currentSpeed = speed;
-    Serial.printf("[CAN] Speed set to %d bps\n", getSpeedBPS(speed));
+    CANLog::printf("[CAN] Speed set to %d bps\n", getSpeedBPS(speed));
     return true;
 }
 
@@ -176,26 +394,115 @@ CANSpeed CANInterface::getSpeed() const {
     return currentSpeed;
 }
 
+bool CANInterface::detectSpeed(CANSpeed& detected, uint32_t timeoutMs, bool allowProbe) {
+    bool wasEnabled = interfaceEnabled;
+    bool hadReceiveTask = receiveTaskRunning;
+    CANSpeed oldSpeed = currentSpeed;
+    CANMode oldMode = currentMode;
+    
+    // Take the controller over; queues, filters and statistics are left alone
+    stop();
+    
+    CANAutoBaud autoBaud;
+    autoBaud.begin(millis(), oldSpeed, timeoutMs, allowProbe);
+    bool installed = false;
+    
+    while (true) {
+        CANAutoBaudAction action = autoBaud.poll(millis());
+        if (action == CANAutoBaudAction::DONE) {
+            break;
+        }
+        
+        if (action == CANAutoBaudAction::CONFIGURE) {
+            if (installed) {
+                transport->uninstall();
+            }
+            currentSpeed = autoBaud.getCandidate();
+            currentMode = autoBaud.getCandidateMode();
+            installed = installDriver();
+            if (!installed || !transport->start()) {
+                break;
+            }
+            autoBaud.onConfigured(millis());
+            continue;
+        }
+        
+        if (action == CANAutoBaudAction::PROBE) {
+            // Supported PIDs request; single shot so a missing ACK fails fast
+            CANFrame probe;
+            probe.setId(OBD2CAN::FUNCTIONAL_REQUEST_ID, false);
+            probe.dlc = 8;
+            memset(probe.data, 0, sizeof(probe.data));
+            probe.data[0] = 0x02;
+            probe.data[1] = 0x01;
+            transport->transmit(probe, 0, true);
+        }
+    
+        uint32_t alerts = transport->readEvents(CAN_AUTOBAUD_POLL_MS);
+        if (alerts & CANTransportEvent::RX_DATA) {
+            CANFrame frame;
+            while (transport->receive(frame, 0) == CANTransportResult::OK) {
+                autoBaud.onFrame();
+            }
+        }
+        if (alerts & (CANTransportEvent::BUS_ERROR | CANTransportEvent::TX_FAILED |
+                      CANTransportEvent::BUS_OFF)) {
+            autoBaud.onBusError();
+        }
+        if (alerts & CANTransportEvent::TX_SUCCESS) {
+            autoBaud.onProbeAcknowledged();
+        }
+    }
+    
+    if (installed) {
+        transport->uninstall();
+    }
+    
+    bool locked = autoBaud.getState() == CANAutoBaudState::LOCKED;
+    currentSpeed = locked ? autoBaud.getLockedSpeed() : oldSpeed;
+    currentMode = oldMode;
+    busLoad.setBitrate(getSpeedBPS(currentSpeed));
+    
+    if (locked) {
+        detected = currentSpeed;
+        CANLog::printf("[CAN] Detected %d bps in %u ms (%u switches)\n", getSpeedBPS(currentSpeed),
+                      autoBaud.getLockTimeMs(), autoBaud.getSwitches());
+    } else {
+        CANLog::printf("[CAN] Bitrate detection failed\n");
+    }
+    
+    if (wasEnabled) {
+        if (!installDriver() || !transport->start()) {
+            return false;
+        }
+        interfaceEnabled = true;
+        if (hadReceiveTask && !startReceiveTask(receiveTaskCore, receiveTaskPriority)) {
+            return false;
+        }
+    }
+    return locked;
+}
+
 bool CANInterface::setMode(CANMode mode) {
     if (interfaceEnabled) {
-        Serial.println(F("[CAN] Cannot change mode while interface is active"));
+        CANLog::printf("[CAN] Cannot change mode while interface is active\n");
         return false;
     }
     
     currentMode = mode;
-    Serial.print(F("[CAN] Mode set to: "));
+    CANLog::printf("[CAN] Mode set to: ");
     switch (mode) {
         case CANMode::NORMAL:
-            Serial.println("NORMAL");
+            CANLog::printf("NORMAL\n");
             break;
         case CANMode::LISTEN_ONLY:
-            Serial.println("LISTEN_ONLY");
+            CANLog::printf("LISTEN_ONLY\n");
             break;
         case CANMode::SELF_TEST:
-            Serial.println("SELF_TEST");
+            CANLog::printf("SELF_TEST\n");
             break;
         case CANMode::NO_ACK:
-            Serial.println("NO_ACK");
+            CANLog::printf("NO_ACK\n");
             break;
     }
     return true;
@@ -223,20 +530,21 @@ uint32_t CANInterface::getSpeedBPS(CANSpeed speed) {
 // ===== MESSAGE TRANSMISSION =====
 
 bool CANInterface::sendMessage(const CANMessage& message, uint32_t timeout) {
+    return sendFrame(CANFrame::fromMessage(message), timeout);
+}
+
+bool CANInterface::sendFrame(const CANFrame& frame, uint32_t timeout) {
     if (!interfaceEnabled || busOff) {
         return false;
     }
     
-    // Convert to TWAI message
-    twai_message_t twai_msg;
-    convertToTWAI(message, twai_msg);
-    
-    // Send message
-    esp_err_t result = twai_transmit(&twai_msg, pdMS_TO_TICKS(timeout));
+    // Before transmitting: the answer can arrive before transmit() returns
+    receiveAdmission.noteTransmit(frame, millis());
+    esp_err_t result = toEspError(transport->transmit(frame, timeout));
     
     if (result == ESP_OK) {
         statistics.messagesSent++;
-        updateStatistics();
+        recordBusLoad(frame);
         return true;
     } else {
         if (result == ESP_ERR_TIMEOUT) {
@@ -247,20 +555,43 @@ bool CANInterface::sendMessage(const CANMessage& message, uint32_t timeout) {
     }
 }
 
+size_t CANInterface::sendFrames(const CANFrame* frames, size_t count, uint32_t timeout) {
+    if (!interfaceEnabled || busOff) {
+        return 0;
+    }
+    
+    size_t sent = 0;
+    while (sent < count) {
+        receiveAdmission.noteTransmit(frames[sent], millis());
+        esp_err_t result = toEspError(transport->transmit(frames[sent], timeout));
+        if (result != ESP_OK) {
+            if (result == ESP_ERR_TIMEOUT) {
+                statistics.transmitTimeout++;
+            }
+            handleCANError(result);
+            return sent;
+        }
+        statistics.messagesSent++;
+        recordBusLoad(frames[sent]);
+        sent++;
+    }
+    return sent;
+}
+
 bool CANInterface::sendMessage(uint32_t id, const uint8_t* data, uint8_t length, 
                               bool extended, uint32_t timeout) {
     if (length > 8) {
         return false;
     }
     
-    CANMessage message;
-    message.id = id;
-    message.dlc = length;
-    message.extd = extended;
-    message.type = extended ? CANMessageType::EXTENDED : CANMessageType::STANDARD;
-    memcpy(message.data, data, length);
+    CANFrame frame;
+    frame.setId(id, extended);
+    frame.dlc = length;
+    memcpy(frame.data, data, length);
+    memset(frame.data + length, 0, 8 - length);
+    frame.timestamp = 0;
     
-    return sendMessage(message, timeout);
+    return sendFrame(frame, timeout);
 }
 
 bool CANInterface::sendOBD2Request(uint16_t pid, uint8_t mode) {
@@ -269,241 +600,478 @@ bool CANInterface::sendOBD2Request(uint16_t pid, uint8_t mode) {
     return sendMessage(OBD2CAN::FUNCTIONAL_REQUEST_ID, data, 8, false, 1000);
 }
 
-bool CANInterface::queueMessage(const CANMessage& message) {
-    if (transmitQueue.size() >= maxQueueSize) {
-        return false; // Queue full
+int CANInterface::sendOBD2BatchRequest(const uint8_t* pids, uint8_t count) {
+    uint8_t requests[8][1 + OBD2Batch::MAX_PIDS_PER_REQUEST];
+    uint8_t lengths[8];
+    int sent = 0;
+    
+    // 36-PID chunks pack into at most 7 requests even when support PIDs
+    // need their own, so the stack buffer never truncates a chunk
+    for (uint8_t offset = 0; offset < count; ) {
+        uint8_t chunk = count - offset < 6 * OBD2Batch::MAX_PIDS_PER_REQUEST ?
+                        count - offset : 6 * OBD2Batch::MAX_PIDS_PER_REQUEST;
+        size_t requestCount = OBD2Batch::pack(&pids[offset], chunk, requests, lengths, 8);
+        for (size_t i = 0; i < requestCount; i++) {
+            uint8_t data[8] = {lengths[i], 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55};
+            memcpy(&data[1], requests[i], lengths[i]);
+            if (!sendMessage(OBD2CAN::FUNCTIONAL_REQUEST_ID, data, 8, false, 1000)) {
+                return sent;
+            }
+            sent++;
+        }
+        offset += chunk;
     }
-    
-    transmitQueue.push(message);
-    return true;
+    return sent;
+}
+
+bool CANInterface::queueMessage(const CANMessage& message, CANTxPriority priority, uint32_t lifetimeMs) {
+    return queueFrame(CANFrame::fromMessage(message), priority, lifetimeMs);
+}
+
+bool CANInterface::queueFrame(const CANFrame& frame, CANTxPriority priority, uint32_t lifetimeMs) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&txLock);
+    bool queued = transmitQueue.push(frame, priority, lifetimeMs, now);
+    portEXIT_CRITICAL(&txLock);
+    return queued;
 }
 
 int CANInterface::processTransmitQueue() {
-    int messagesSent = 0;
-    
-    while (!transmitQueue.empty() && messagesSent < 10) { // Limit to prevent blocking
-        CANMessage message = transmitQueue.front();
-        
-        if (sendMessage(message, 10)) { // Short timeout for queued messages
-            transmitQueue.pop();
-            messagesSent++;
-        } else {
-            break; // Stop if transmission fails
-        }
-    }
+    processAlerts(0);   // Settles completions and bus-off recovery in polled mode
     
-    return messagesSent;
+    // Frames stay queued while the bus is off and go out once it recovers
+    return pumpTransmitQueue();
+}
+
+CANTxSchedulerStatistics CANInterface::getTransmitStatistics() const {
+    portENTER_CRITICAL(&txLock);
+    CANTxSchedulerStatistics stats = transmitQueue.getStatistics();
+    portEXIT_CRITICAL(&txLock);
+    return stats;
 }
 
 // ===== MESSAGE RECEPTION =====
 
 bool CANInterface::receiveMessage(CANMessage& message, uint32_t timeout) {
+    CANFrame frame;
+    if (!receiveFrame(frame, timeout)) {
+        return false;
+    }
+    frame.toMessage(message);
+    return true;
+}
+
+bool CANInterface::receiveFrame(CANFrame& frame, uint32_t timeout) {
     if (!interfaceEnabled) {
         return false;
     }
     
+    if (receiveTaskRunning) {
+        // Receive task owns the driver; frames arrive through the queue only
+        if (!receiveQueue.pop(frame)) {
+            if (timeout == 0 || !waitForMessages(timeout) || !receiveQueue.pop(frame)) {
+                return false;
+            }
+        }
+        
+        // Callbacks run here, in the consumer's context
+        deliverToCallback(frame);
+        return true;
+    }
+    
     // Check local queue first
-    if (!receiveQueue.empty()) {
-        message = receiveQueue.front();
-        receiveQueue.pop();
+    if (receiveQueue.pop(frame)) {
         return true;
     }
     
-    // Try to receive from TWAI driver
-    twai_message_t twai_msg;
-    esp_err_t result = twai_receive(&twai_msg, pdMS_TO_TICKS(timeout));
+    return readFromDriver(frame, timeout);
+}
+
+size_t CANInterface::receiveFrames(CANFrame* frames, size_t maxFrames) {
+    if (!interfaceEnabled) {
+        return 0;
+    }
     
-    if (result == ESP_OK) {
-        convertFromTWAI(twai_msg, message);
-        message.timestamp = millis();
-        
-        // Apply filter
-        if (applyMessageFilter(message)) {
-            statistics.messagesReceived++;
-            statistics.lastMessageTime = message.timestamp;
-            
-            // Call callback if set
-            if (messageCallback) {
-                messageCallback(message);
-            }
-            
-            updateStatistics();
-            return true;
-        } else {
-            statistics.filterRejects++;
-            return false;
+    size_t count = receiveQueue.popBatch(frames, maxFrames);
+    if (receiveTaskRunning) {
+        for (size_t i = 0; i < count; i++) {
+            deliverToCallback(frames[i]);
         }
     }
+    return count;
+}
+
+void CANInterface::deliverToCallback(const CANFrame& frame) {
+    if (dispatchTable != nullptr && dispatchTable->dispatch(frame)) {
+        return;
+    }
+    if (frameHandler != nullptr && frameHandler(frame, frameHandlerContext)) {
+        return;
+    }
+    if (messageCallback) {
+        CANMessage message;
+        frame.toMessage(message);
+        messageCallback(message);
+    }
+}
+
+bool CANInterface::readFromDriver(CANFrame& frame, uint32_t timeout) {
+    // Try to receive from the transport
+    if (transport->receive(frame, timeout) == CANTransportResult::OK && acceptReceived(frame)) {
+        // Call callback if set
+        deliverToCallback(frame);
+        return true;
+    }
     
     return false;
 }
 
+bool CANInterface::acceptReceived(const CANFrame& frame) {
+    // Bus view: counted whether or not the filter keeps the frame
+    portENTER_CRITICAL(&statsLock);
+    busLoad.recordFrame(frame, static_cast<uint32_t>(frame.timestamp));
+    idStatistics.update(frame.id(), frame.isExtended(), frame.timestamp);
+    portEXIT_CRITICAL(&statsLock);
+    
+    // Apply filter
+    if (applyMessageFilter(frame)) {
+        statistics.messagesReceived++;
+        statistics.lastMessageTime = frame.timestamp;
+        latestFrames.update(frame);
+        if (fanout != nullptr) {
+            fanout->publish(frame);
+        }
+        return true;
+    }
+    
+    statistics.filterRejects++;
+    return false;
+}
+
+bool CANInterface::queueReceived(const CANFrame& frame, uint32_t now) {
+    // Admission keeps headroom for higher classes; a shed frame is an overflow too
+    CANRxClass rxClass = receiveAdmission.classify(frame, now);
+    if (!receiveAdmission.admit(rxClass, receiveQueue.size())) {
+        receiveQueue.countOverflow();
+        return false;
+    }
+    return receiveQueue.push(frame);
+}
+
+bool CANInterface::readLatest(uint32_t id, bool extended, CANLatestValue& value) const {
+    return latestFrames.read(id, extended, value);
+}
+
+bool CANInterface::readLatestIfChanged(uint32_t id, bool extended, uint32_t& seenChanges,
+                                       CANLatestValue& value) const {
+    return latestFrames.readIfChanged(id, extended, seenChanges, value);
+}
+
 int CANInterface::availableMessages() const {
     return receiveQueue.size();
 }
 
 int CANInterface::processReceiveQueue() {
     int messagesProcessed = 0;
-    CANMessage message;
+    int framesRead = 0;
+    CANFrame frame;
+    
+    if (!interfaceEnabled || receiveTaskRunning) {
+        return 0; // Receive task already drains the driver
+    }
     
-    // Process up to 20 messages to prevent blocking
-    while (messagesProcessed < 20 && receiveMessage(message, 0)) {
-        if (receiveQueue.size() < maxQueueSize) {
-            receiveQueue.push(message);
+    processAlerts(0);
+    
+    // Read up to 20 frames to prevent blocking; keep reading past shed ones
+    // so a response behind a storm of broadcasts still gets in
+    uint32_t now = millis();
+    while (framesRead < 20 && readFromDriver(frame, 0)) {
+        framesRead++;
+        if (queueReceived(frame, now)) {
             messagesProcessed++;
-        } else {
-            statistics.receiveOverflow++;
-            break;
         }
     }
     
     return messagesProcessed;
 }
 
+uint32_t CANInterface::processAlerts(uint32_t timeout) {
+    if (!interfaceEnabled || receiveTaskRunning) {
+        return 0; // Receive task owns the alerts
+    }
+    
+    uint32_t alerts = transport->readEvents(timeout);
+    if (alerts != 0) {
+        handleAlerts(alerts);
+    }
+    serviceRecovery();
+    return alerts;
+}
+
 void CANInterface::flushReceiveQueue() {
-    while (!receiveQueue.empty()) {
-        receiveQueue.pop();
+    receiveQueue.clear();
+    
+    if (receiveTaskRunning) {
+        return; // Driver queue belongs to the receive task
     }
     
-    // Also flush TWAI driver queue
-    twai_message_t dummy_msg;
-    while (twai_receive(&dummy_msg, 0) == ESP_OK) {
-        // Discard messages
+    // Also flush the transport's queue
+    CANFrame discarded;
+    while (transport->receive(discarded, 0) == CANTransportResult::OK) {
+        // Discard frames
     }
 }
 
+bool CANInterface::subscribeBroadcast(uint32_t id, bool extended) {
+    lockFilter();
+    bool added = receiveAdmission.subscribe(id, extended);
+    unlockFilter();
+    return added;
+}
+
+bool CANInterface::unsubscribeBroadcast(uint32_t id, bool extended) {
+    lockFilter();
+    bool removed = receiveAdmission.unsubscribe(id, extended);
+    unlockFilter();
+    return removed;
+}
+
+bool CANInterface::setReceiveShedLevels(size_t backgroundLevel, size_t subscribedLevel) {
+    lockFilter();
+    bool applied = receiveAdmission.setLevels(backgroundLevel, subscribedLevel);
+    unlockFilter();
+    return applied;
+}
+
+CANRxAdmissionStatistics CANInterface::getReceiveAdmissionStatistics() const {
+    return receiveAdmission.getStatistics();
+}
+
 void CANInterface::setMessageCallback(CANMessageCallback callback) {
     messageCallback = callback;
 }
 
+void CANInterface::setFrameHandler(CANFrameHandler handler, void* context) {
+    frameHandler = handler;
+    frameHandlerContext = context;
+}
+
+void CANInterface::setDispatchTable(const CANDispatchTable* table) {
+    dispatchTable = table;
+}
+
+void CANInterface::setFanout(CANFrameFanout* frameFanout) {
+    fanout = frameFanout;
+}
+
 // ===== FILTERING =====
 
-void CANInterface::setMessageFilter(const CANFilter& filter) {
+bool CANInterface::setMessageFilter(const CANFilter& filter) {
+    lockFilter();
     messageFilter = filter;
-    Serial.print(F("[CAN] Message filter set to: "));
+    filterEngine.loadFilter(filter);
+    filterEngine.compile();
+    hardwareFilter.exact = false;           // Until the controller holds the new filter
+    unlockFilter();
+    bool reloaded = updateHardwareFilter();
+    CANLog::printf("[CAN] Message filter set to: ");
     
     switch (filter.type) {
         case CANFilterType::ACCEPT_ALL:
-            Serial.println("ACCEPT_ALL");
+            CANLog::printf("ACCEPT_ALL\n");
             break;
         case CANFilterType::WHITELIST:
-            Serial.printf("WHITELIST (%d IDs)\n", filter.whitelist.size());
+            CANLog::printf("WHITELIST (%d IDs)\n", filter.whitelist.size());
             break;
         case CANFilterType::BLACKLIST:
-            Serial.printf("BLACKLIST (%d IDs)\n", filter.blacklist.size());
+            CANLog::printf("BLACKLIST (%d IDs)\n", filter.blacklist.size());
             break;
         case CANFilterType::RANGE:
-            Serial.printf("RANGE (0x%X - 0x%X)\n", filter.rangeStart, filter.rangeEnd);
+            CANLog::printf("RANGE (0x%X - 0x%X)\n", filter.rangeStart, filter.rangeEnd);
             break;
         case CANFilterType::CUSTOM:
-            Serial.println("CUSTOM");
+            CANLog::printf("CUSTOM\n");
             break;
     }
+    return reloaded;
 }
 
-void CANInterface::setAcceptAllFilter() {
+bool CANInterface::setAcceptAllFilter() {
     CANFilter filter;
     filter.type = CANFilterType::ACCEPT_ALL;
-    setMessageFilter(filter);
+    return setMessageFilter(filter);
 }
 
-void CANInterface::setWhitelistFilter(const std::vector<uint32_t>& ids) {
+bool CANInterface::setWhitelistFilter(const std::vector<uint32_t>& ids) {
     CANFilter filter;
     filter.type = CANFilterType::WHITELIST;
     filter.whitelist = ids;
-    setMessageFilter(filter);
+    return setMessageFilter(filter);
 }
 
-void CANInterface::setBlacklistFilter(const std::vector<uint32_t>& ids) {
+bool CANInterface::setBlacklistFilter(const std::vector<uint32_t>& ids) {
     CANFilter filter;
     filter.type = CANFilterType::BLACKLIST;
     filter.blacklist = ids;
-    setMessageFilter(filter);
+    return setMessageFilter(filter);
 }
 
-void CANInterface::setRangeFilter(uint32_t startId, uint32_t endId) {
+bool CANInterface::setRangeFilter(uint32_t startId, uint32_t endId) {
     CANFilter filter;
     filter.type = CANFilterType::RANGE;
     filter.rangeStart = startId;
     filter.rangeEnd = endId;
-    setMessageFilter(filter);
+    return setMessageFilter(filter);
 }
 
-void CANInterface::setCustomFilter(std::function<bool(const CANMessage&)> filterFunc) {
+bool CANInterface::setCustomFilter(std::function<bool(const CANMessage&)> filterFunc) {
     CANFilter filter;
     filter.type = CANFilterType::CUSTOM;
     filter.customFilter = filterFunc;
-    setMessageFilter(filter);
+    return setMessageFilter(filter);
+}
+
+bool CANInterface::setFilterRules(const CANFilterEngine& rules) {
+    lockFilter();
+    messageFilter = CANFilter();
+    messageFilter.type = CANFilterType::CUSTOM;
+    filterEngine = rules;
+    filterEngine.compile();
+    hardwareFilter.exact = false;
+    unlockFilter();
+    CANLog::printf("[CAN] Message filter set to: RULES (%u rules)\n",
+                  static_cast<unsigned>(filterEngine.ruleCount()));
+    return updateHardwareFilter();
 }
 
-void CANInterface::setFilterEnabled(bool enabled) {
+bool CANInterface::setFilterEnabled(bool enabled) {
+    lockFilter();
     messageFilter.enabled = enabled;
-    Serial.printf("[CAN] Message filter %s\n", enabled ? "ENABLED" : "DISABLED");
+    hardwareFilter.exact = false;
+    unlockFilter();
+    CANLog::printf("[CAN] Message filter %s\n", enabled ? "ENABLED" : "DISABLED");
+    return updateHardwareFilter();
 }
 
-bool CANInterface::applyMessageFilter(const CANMessage& message) {
-    if (!messageFilter.enabled) {
+CANAcceptanceFilter CANInterface::getHardwareFilter() const {
+    return hardwareFilter;
+}
+
+bool CANInterface::isHardwareFilterExact() const {
+    return hardwareEnforced && hardwareFilter.exact;
+}
+
+bool CANInterface::updateHardwareFilter() {
+    CANAcceptanceFilter compiled = CANFilterCompiler::compile(messageFilter);
+    
+    // Composed rules that reduce to a finite ID set can still use hardware
+    std::vector<uint32_t> ids;
+    if (compiled.acceptsAll() && messageFilter.enabled && filterEngine.acceptedIdSet(ids)) {
+        compiled = CANFilterCompiler::compileIds(ids);
+    }
+    bool changed = compiled.acceptanceCode != hardwareFilter.acceptanceCode ||
+                   compiled.acceptanceMask != hardwareFilter.acceptanceMask ||
+                   compiled.singleFilter != hardwareFilter.singleFilter;
+    
+    if (compiled.acceptsAll()) {
+        CANLog::printf("[CAN] Hardware filter: ACCEPT_ALL (software filtering only)\n");
+    } else {
+        CANLog::printf("[CAN] Hardware filter: %s code=0x%08X mask=0x%08X, %u/%u IDs%s\n",
+                      compiled.singleFilter ? "SINGLE" : "DUAL",
+                      compiled.acceptanceCode, compiled.acceptanceMask,
+                      compiled.hardwareAcceptedIds, compiled.requestedIds,
+                      compiled.exact ? " (exact)" : "");
+    }
+    
+    // The controller already holds this acceptance code, or gets it at the next install
+    if (!changed || !interfaceEnabled) {
+        lockFilter();
+        hardwareFilter = compiled;
+        unlockFilter();
         return true;
     }
     
-    switch (messageFilter.type) {
-        case CANFilterType::ACCEPT_ALL:
-            return true;
-            
-        case CANFilterType::WHITELIST:
-            for (uint32_t id : messageFilter.whitelist) {
-                if (message.id == id) {
-                    return true;
-                }
+    // Acceptance filter is only loaded at driver install: park the receive task
+    // and rebuild the controller; rings, latest values and statistics are kept
+    bool hadReceiveTask = receiveTaskRunning;
+    stopReceiveTask();
+    
+    // The software filter already changed, so neither filter may be trusted as exact
+    CANAcceptanceFilter previous = hardwareFilter;
+    previous.exact = false;
+    bool exact = compiled.exact;
+    compiled.exact = false;
+    lockFilter();
+    hardwareFilter = compiled;
+    unlockFilter();
+    
+    bool reloaded = reinstallDriver();
+    if (reloaded) {
+        lockFilter();
+        hardwareFilter.exact = exact;
+        unlockFilter();
+    } else {
+        // Keep the interface running on the acceptance code that worked before
+        CANLog::printf("[CAN] ERROR: Failed to reload hardware filter, restoring previous\n");
+        lockFilter();
+        hardwareFilter = previous;
+        unlockFilter();
+        if (!reinstallDriver()) {
+            stop();
+            CANLog::printf("[CAN] ERROR: Controller lost while reloading filter\n");
+            if (errorCallback) {
+                errorCallback(ESP_ERR_INVALID_STATE, "Filter reload failed");
             }
             return false;
-            
-        case CANFilterType::BLACKLIST:
-            for (uint32_t id : messageFilter.blacklist) {
-                if (message.id == id) {
-                    return false;
-                }
-            }
-            return true;
-            
-        case CANFilterType::RANGE:
-            return (message.id >= messageFilter.rangeStart && 
-                   message.id <= messageFilter.rangeEnd);
-            
-        case CANFilterType::CUSTOM:
-            if (messageFilter.customFilter) {
-                return messageFilter.customFilter(message);
-            }
-            return true;
-            
-        default:
-            return true;
+        }
+    }
+    
+    if (hadReceiveTask && !startReceiveTask(receiveTaskCore, receiveTaskPriority)) {
+        return false;
+    }
+    return reloaded;
+}
+
+bool CANInterface::applyMessageFilter(const CANFrame& frame) {
+    if (!messageFilter.enabled) {
+        return true;
+    }
+    
+    // Hardware already guarantees a match for this frame format
+    if (hardwareEnforced && hardwareFilter.exact && frame.isExtended() == hardwareFilter.extended) {
+        statistics.hardwareFiltered++;
+        return true;
     }
+    
+    // Constant-time bitmap/hash decision
+    return filterEngine.accepts(frame);
 }
 
 // ===== STATUS & DIAGNOSTICS =====
 
+void CANInterface::setLogging(bool enabled) {
+    CANLog::setEnabled(enabled);
+}
+
 String CANInterface::getStatus() const {
     if (!interfaceEnabled) {
         return "DISABLED";
     }
     
     if (busOff) {
-        return "BUS_OFF";
+        return recovery.getState() == CANRecoveryState::BACKOFF ? "BUS_OFF" : "RECOVERING";
     }
     
-    twai_status_info_t status_info;
-    esp_err_t result = twai_get_status_info(&status_info);
-    
-    if (result == ESP_OK) {
-        switch (status_info.state) {
-            case TWAI_STATE_STOPPED:
+    CANTransportStatus status;
+    if (transport->getStatus(status)) {
+        switch (status.state) {
+            case CANTransportState::STOPPED:
                 return "STOPPED";
-            case TWAI_STATE_RUNNING:
+            case CANTransportState::RUNNING:
                 return "RUNNING";
-            case TWAI_STATE_BUS_OFF:
+            case CANTransportState::BUS_OFF:
                 return "BUS_OFF";
-            case TWAI_STATE_RECOVERING:
+            case CANTransportState::RECOVERING:
                 return "RECOVERING";
             default:
                 return "UNKNOWN";
@@ -517,16 +1085,18 @@ bool CANInterface::isBusOff() const {
     return busOff;
 }
 
+CANRecoveryState CANInterface::getRecoveryState() const {
+    return recovery.getState();
+}
+
 uint16_t CANInterface::getErrorState() const {
     if (!interfaceEnabled) {
         return 0xFFFF;
     }
     
-    twai_status_info_t status_info;
-    esp_err_t result = twai_get_status_info(&status_info);
-    
-    if (result == ESP_OK) {
-        return (status_info.tx_error_counter << 8) | status_info.rx_error_counter;
+    CANTransportStatus status;
+    if (transport->getStatus(status)) {
+        return (status.txErrorCounter << 8) | status.rxErrorCounter;
     }
     
     return 0;
@@ -534,59 +1104,147 @@ uint16_t CANInterface::getErrorState() const {
 
 CANStatistics CANInterface::getStatistics() const {
     CANStatistics stats = statistics;
+    stats.receiveOverflow = receiveQueue.overflowCount();
+    CANTxSchedulerStatistics tx = getTransmitStatistics();
+    stats.transmitOverflow = tx.rejected + tx.evicted;
+    stats.transmitExpired = tx.expired;
     stats.uptimeSeconds = (millis() - interfaceStartTime) / 1000;
+    
+    uint32_t now = static_cast<uint32_t>(esp_timer_get_time());
+    portENTER_CRITICAL(&statsLock);
+    stats.busUtilization = busLoad.getLoad(CANLoadWindow::WINDOW_1S, now);
+    stats.busUtilization100ms = busLoad.getLoad(CANLoadWindow::WINDOW_100MS, now);
+    stats.busUtilization10s = busLoad.getLoad(CANLoadWindow::WINDOW_10S, now);
+    stats.busUtilizationPeak = busLoad.getPeak(CANLoadWindow::WINDOW_100MS);
+    portEXIT_CRITICAL(&statsLock);
     return stats;
 }
 
 void CANInterface::resetStatistics() {
     statistics = CANStatistics();
+    receiveQueue.resetOverflowCount();
+    receiveAdmission.resetStatistics();
+    portENTER_CRITICAL(&txLock);
+    transmitQueue.resetStatistics();
+    portEXIT_CRITICAL(&txLock);
     interfaceStartTime = millis();
+    portENTER_CRITICAL(&statsLock);
+    busLoad.reset(static_cast<uint32_t>(esp_timer_get_time()));
+    idStatistics.clear();
+    portEXIT_CRITICAL(&statsLock);
+}
+
+float CANInterface::getBusLoad(CANLoadWindow window) const {
+    portENTER_CRITICAL(&statsLock);
+    float load = busLoad.getLoad(window, static_cast<uint32_t>(esp_timer_get_time()));
+    portEXIT_CRITICAL(&statsLock);
+    return load;
+}
+
+float CANInterface::getBusLoadPeak(CANLoadWindow window) const {
+    portENTER_CRITICAL(&statsLock);
+    float peak = busLoad.getPeak(window);
+    portEXIT_CRITICAL(&statsLock);
+    return peak;
+}
+
+void CANInterface::setBusLoadStuffingModel(CANStuffingModel model) {
+    portENTER_CRITICAL(&statsLock);
+    busLoad.setStuffingModel(model);
+    portEXIT_CRITICAL(&statsLock);
+}
+
+bool CANInterface::getIdStatistics(uint32_t id, bool extended, CANIdStatistics& stats) const {
+    portENTER_CRITICAL(&statsLock);
+    const CANIdStatistics* entry = idStatistics.find(id, extended);
+    if (entry != nullptr) {
+        stats = *entry;
+    }
+    portEXIT_CRITICAL(&statsLock);
+    return entry != nullptr;
+}
+
+size_t CANInterface::getIdStatistics(CANIdStatistics* stats, size_t maxEntries) const {
+    portENTER_CRITICAL(&statsLock);
+    size_t copied = idStatistics.snapshot(stats, maxEntries);
+    portEXIT_CRITICAL(&statsLock);
+    return copied;
 }
 
 void CANInterface::printDiagnostics() const {
-    Serial.println(F("=== CAN Interface Diagnostics ==="));
-    Serial.printf("Status: %s\n", getStatus().c_str());
-    Serial.printf("Speed: %d bps\n", getSpeedBPS(currentSpeed));
-    Serial.print("Mode: ");
+    CANLog::printf("=== CAN Interface Diagnostics ===\n");
+    CANLog::printf("Status: %s\n", getStatus().c_str());
+    CANLog::printf("Transport: %s\n", transport->getName());
+    CANLog::printf("Speed: %d bps\n", getSpeedBPS(currentSpeed));
+    CANLog::printf("Mode: ");
     switch (currentMode) {
         case CANMode::NORMAL:
-            Serial.println("NORMAL");
+            CANLog::printf("NORMAL\n");
             break;
         case CANMode::LISTEN_ONLY:
-            Serial.println("LISTEN_ONLY");
+            CANLog::printf("LISTEN_ONLY\n");
             break;
         case CANMode::SELF_TEST:
-            Serial.println("SELF_TEST");
+            CANLog::printf("SELF_TEST\n");
             break;
         case CANMode::NO_ACK:
-            Serial.println("NO_ACK");
+            CANLog::printf("NO_ACK\n");
             break;
     }
     
     CANStatistics stats = getStatistics();
-    Serial.printf("Messages RX: %d\n", stats.messagesReceived);
-    Serial.printf("Messages TX: %d\n", stats.messagesSent);
-    Serial.printf("Error frames: %d\n", stats.errorFrames);
-    Serial.printf("Bus-off events: %d\n", stats.busOffEvents);
-    Serial.printf("RX queue size: %d\n", receiveQueue.size());
-    Serial.printf("TX queue size: %d\n", transmitQueue.size());
-    Serial.printf("Filter rejects: %d\n", stats.filterRejects);
-    Serial.printf("Uptime: %d seconds\n", stats.uptimeSeconds);
+    CANLog::printf("Messages RX: %d\n", stats.messagesReceived);
+    CANLog::printf("Messages TX: %d\n", stats.messagesSent);
+    CANLog::printf("Error frames: %d\n", stats.errorFrames);
+    CANLog::printf("Bus-off events: %d (recovered %u, driver reinstalls %u, last outage %u ms)\n",
+                  stats.busOffEvents, stats.busRecoveries, recovery.getReinstalls(),
+                  recovery.getLastOutageMs());
+    CANLog::printf("Arbitration lost: %u, TX failed: %u, driver RX missed: %u\n",
+                  stats.arbitrationLost, stats.transmitFailed, stats.driverRxMissed);
+    CANLog::printf("Bus load: %.1f%% (100 ms %.1f%%, 10 s %.1f%%, peak %.1f%%)\n",
+                  stats.busUtilization, stats.busUtilization100ms,
+                  stats.busUtilization10s, stats.busUtilizationPeak);
+    CANLog::printf("RX queue size: %u/%u\n", static_cast<unsigned>(receiveQueue.size()),
+                  static_cast<unsigned>(receiveQueue.capacity()));
+    CANLog::printf("TX queue size: %u/%u (%u in driver)\n", static_cast<unsigned>(transmitQueue.size()),
+                  static_cast<unsigned>(transmitQueue.capacity()), transmitQueue.inFlight());
+    CANLog::printf("RX overflow: %d\n", stats.receiveOverflow);
+    CANRxAdmissionStatistics admission = receiveAdmission.getStatistics();
+    CANLog::printf("RX shed (response/subscribed/background): %u/%u/%u\n",
+                  admission.shed[0], admission.shed[1], admission.shed[2]);
+    CANLog::printf("TX overflow: %d, expired: %d\n", stats.transmitOverflow, stats.transmitExpired);
+    CANLog::printf("Filter rejects (software): %d\n", stats.filterRejects);
+    CANLog::printf("Filter passes (hardware only): %d\n", stats.hardwareFiltered);
+    CANLog::printf("IDs tracked: %u (untracked frames: %u)\n",
+                  static_cast<unsigned>(idStatistics.size()), idStatistics.untracked());
+    if (!hardwareFilter.acceptsAll()) {
+        CANLog::printf("Hardware filter: %s, passes %u IDs for %u requested%s\n",
+                      hardwareFilter.singleFilter ? "SINGLE" : "DUAL",
+                      hardwareFilter.hardwareAcceptedIds, hardwareFilter.requestedIds,
+                      hardwareEnforced ? "" : " (not loaded by transport)");
+    }
+    CANLog::printf("Driver queues: RX %u / TX %u\n", driverRxQueueLength, driverTxQueueLength);
+    if (receiveTaskRunning) {
+        CANLog::printf("Receive task: core %d, priority %u\n", receiveTaskCore, receiveTaskPriority);
+    } else {
+        CANLog::printf("Receive task: not running (polled)\n");
+    }
+    CANLog::printf("Uptime: %d seconds\n", stats.uptimeSeconds);
     
     if (interfaceEnabled) {
-        twai_status_info_t status_info;
-        if (twai_get_status_info(&status_info) == ESP_OK) {
-            Serial.printf("TX error count: %d\n", status_info.tx_error_counter);
-            Serial.printf("RX error count: %d\n", status_info.rx_error_counter);
-            Serial.printf("TX failed count: %d\n", status_info.tx_failed_count);
-            Serial.printf("RX missed count: %d\n", status_info.rx_missed_count);
-            Serial.printf("RX overrun count: %d\n", status_info.rx_overrun_count);
-            Serial.printf("Arbitration lost: %d\n", status_info.arb_lost_count);
-            Serial.printf("Bus error count: %d\n", status_info.bus_error_count);
+        CANTransportStatus status;
+        if (transport->getStatus(status)) {
+            CANLog::printf("TX error count: %d\n", status.txErrorCounter);
+            CANLog::printf("RX error count: %d\n", status.rxErrorCounter);
+            CANLog::printf("TX failed count: %d\n", status.txFailed);
+            CANLog::printf("RX missed count: %d\n", status.rxMissed);
+            CANLog::printf("RX overrun count: %d\n", status.rxOverrun);
+            CANLog::printf("Arbitration lost: %d\n", status.arbitrationLost);
+            CANLog::printf("Bus error count: %d\n", status.busErrors);
         }
     }
     
-    Serial.println(F("================================"));
+    CANLog::printf("================================\n");
 }
 
 void CANInterface::setErrorCallback(CANErrorCallback callback) {
@@ -596,7 +1254,7 @@ void CANInterface::setErrorCallback(CANErrorCallback callback) {
 // ===== OBD2 SPECIFIC FUNCTIONS =====
 
 bool CANInterface::initializeOBD2() {
-    Serial.println(F("[CAN] Initializing for OBD2 communication..."));
+    CANLog::printf("[CAN] Initializing for OBD2 communication...\n");
     
     // Set up OBD2-specific filter
     std::vector<uint32_t> obd2_ids = {
@@ -613,7 +1271,7 @@ bool CANInterface::initializeOBD2() {
     
     setWhitelistFilter(obd2_ids);
     
-    Serial.println(F("[CAN] OBD2 initialization complete"));
+    CANLog::printf("[CAN] OBD2 initialization complete\n");
     return true;
 }
 
@@ -669,70 +1327,107 @@ bool CANInterface::parseOBD2Response(const CANMessage& message, uint16_t& pid,
             memcpy(data, &message.data[3], length);
         }
         
+        // A current data answer must carry the whole PID
+        if (mode == 0x41 && length < OBD2Batch::mode01DataLength(pidByte)) {
+            return false;
+        }
+        
         return true;
     }
     
-    // Multi-frame responses not implemented yet
+    // Multi-frame responses are reassembled by ISOTPTransport (isotp.h)
     return false;
 }
 
+bool CANInterface::parseOBD2Response(const CANMessage& message, uint16_t& pid, OBD2Value& value) {
+    uint8_t data[8];
+    uint8_t length = 0;
+    if (!parseOBD2Response(message, pid, data, length)) {
+        return false;
+    }
+    
+    // Freeze frame answers put a frame number before the data; Mode 01 only
+    if ((pid >> 8) != 0x41) {
+        return false;
+    }
+    return OBD2PIDCodec::decode(pid & 0xFF, data, length, value);
+}
+
 // ===== UTILITY FUNCTIONS =====
 
 String CANInterface::messageToString(const CANMessage& message) {
-    String str = "";
-    
-    // Add timestamp
-    str += String(message.timestamp) + ":";
-    
-    // Add ID
-    if (message.extd) {
-        str += String(message.id, HEX) + "#";
-    } else {
-        str += String(message.id, HEX) + "#";
+    // Formatted in a fixed buffer with table hex; one String per call
+    char text[64];
+    int length = snprintf(text, sizeof(text), "%llu:", static_cast<unsigned long long>(message.timestamp));
+    
+    // Add ID (no leading zeros)
+    uint8_t digits = 1;
+    while (digits < 8 && (message.id >> (4 * digits)) != 0) {
+        digits++;
     }
+    SLCAN::putHex(text + length, message.id, digits);
+    length += digits;
+    text[length++] = '#';
     
     // Add data
-    for (int i = 0; i < message.dlc; i++) {
-        if (message.data[i] < 0x10) str += "0";
-        str += String(message.data[i], HEX);
+    uint8_t dlc = message.dlc > 8 ? 8 : message.dlc;
+    for (int i = 0; i < dlc; i++) {
+        SLCAN::putHex(text + length, message.data[i], 2);
+        length += 2;
     }
     
     // Add flags
-    if (message.rtr) str += "#RTR";
-    if (message.extd) str += "#EXT";
+    if (message.rtr) {
+        memcpy(text + length, "#RTR", 4);
+        length += 4;
+    }
+    if (message.extd) {
+        memcpy(text + length, "#EXT", 4);
+        length += 4;
+    }
     
-    str.toUpperCase();
-    return str;
+    text[length] = '\0';
+    return String(text);
 }
 
 bool CANInterface::stringToMessage(const String& str, CANMessage& message) {
     // Simple parser for basic CAN message format: ID#DATA
-    int hashPos = str.indexOf('#');
-    if (hashPos == -1) {
+    const char* text = str.c_str();
+    const char* hash = strchr(text, '#');
+    if (hash == nullptr) {
         return false;
     }
     
     // Parse ID
-    String idStr = str.substring(0, hashPos);
-    message.id = strtoul(idStr.c_str(), NULL, 16);
-    
-    // Parse data
-    String dataStr = str.substring(hashPos + 1);
-    message.dlc = dataStr.length() / 2;
+    size_t idDigits = hash - text;
+    uint32_t id;
+    if (idDigits == 0 || idDigits > 8 || !SLCAN::parseHex(text, static_cast<uint8_t>(idDigits), id)) {
+        return false;
+    }
     
-    if (message.dlc > 8) {
+    // Parse data (up to the next '#' or end)
+    const char* data = hash + 1;
+    const char* dataEnd = strchr(data, '#');
+    size_t dataLength = dataEnd != nullptr ? static_cast<size_t>(dataEnd - data) : strlen(data);
+    if (dataLength / 2 > 8) {
         return false;
     }
     
-    for (int i = 0; i < message.dlc; i++) {
-        String byteStr = dataStr.substring(i * 2, (i * 2) + 2);
-        message.data[i] = strtoul(byteStr.c_str(), NULL, 16);
+    uint8_t dlc = dataLength / 2;
+    for (int i = 0; i < dlc; i++) {
+        uint32_t value;
+        if (!SLCAN::parseHex(data + i * 2, 2, value)) {
+            return false;
+        }
+        message.data[i] = value;
     }
     
+    message.id = id;
+    message.dlc = dlc;
     message.type = CANMessageType::STANDARD;
     message.extd = false;
     message.rtr = false;
-    message.timestamp = millis();
+    message.timestamp = esp_timer_get_time();
     
     return true;
 }
@@ -795,7 +1490,7 @@ void CANInterface::convertFromTWAI(const twai_message_t& twaiMsg, CANMessage& ca
     canMsg.extd = twaiMsg.extd;
     canMsg.rtr = twaiMsg.rtr;
     canMsg.type = twaiMsg.extd ? CANMessageType::EXTENDED : CANMessageType::STANDARD;
-    canMsg.timestamp = millis();
+    canMsg.timestamp = esp_timer_get_time();
     canMsg.errorFlags = 0;
     
     memcpy(canMsg.data, twaiMsg.data, canMsg.dlc);
@@ -812,41 +1507,188 @@ void CANInterface::convertToTWAI(const CANMessage& canMsg, twai_message_t& twaiM
 
 // ===== INTERNAL METHODS =====
 
-void CANInterface::handleCANError(uint16_t errorCode) {
-    statistics.errorFrames++;
+bool CANInterface::installDriver() {
+    CANTransportConfig config;
+    config.speed = currentSpeed;
+    config.mode = currentMode;
+    config.filter = hardwareFilter;         // Compiled from the current software filter
+    config.rxQueueLength = driverRxQueueLength;
+    config.txQueueLength = driverTxQueueLength;
     
-    // Check for bus-off condition
-    if (errorCode == ESP_ERR_INVALID_STATE) {
-        busOff = true;
-        statistics.busOffEvents++;
+    if (!transport->install(config)) {
+        CANLog::printf("[CAN] ERROR: Failed to install %s transport\n", transport->getName());
+        return false;
     }
     
+    // Backends that load a looser filter (or none) leave the software check on
+    CANAcceptanceFilter applied = transport->getAppliedFilter();
+    lockFilter();
+    hardwareEnforced = applied.acceptanceCode == config.filter.acceptanceCode &&
+                       applied.acceptanceMask == config.filter.acceptanceMask &&
+                       applied.singleFilter == config.filter.singleFilter;
+    unlockFilter();
+    
+    driverCounters = DriverCounters();
+    return true;
+}
+
+void CANInterface::handleCANError(uint16_t errorCode) {
+    // Bus state and error counters come from driver alerts (handleAlerts)
     String errorDesc = getErrorDescription(errorCode);
-    Serial.printf("[CAN] ERROR: %s (code: 0x%X)\n", errorDesc.c_str(), errorCode);
+    CANLog::printf("[CAN] ERROR: %s (code: 0x%X)\n", errorDesc.c_str(), errorCode);
     
     if (errorCallback) {
         errorCallback(errorCode, errorDesc);
     }
 }
 
-void CANInterface::updateStatistics() {
-    // Calculate bus utilization (simplified)
-    unsigned long currentTime = millis();
-    unsigned long timeDiff = currentTime - statistics.lastMessageTime;
+bool CANInterface::reinstallDriver() {
+    // Rings, filters and statistics are kept; only the controller is rebuilt
+    transport->uninstall();
+    portENTER_CRITICAL(&txLock);
+    transmitQueue.onDriverReset();
+    portEXIT_CRITICAL(&txLock);
+    if (!installDriver()) {
+        return false;
+    }
+    return transport->start();
+}
+
+void CANInterface::handleAlerts(uint32_t alerts) {
+    // TX_SUCCESS and RX_DATA only wake the loop; counters come from the transport
+    if (alerts & (CANTransportEvent::BUS_ERROR | CANTransportEvent::ARB_LOST |
+                  CANTransportEvent::TX_FAILED | CANTransportEvent::RX_OVERFLOW |
+                  CANTransportEvent::BUS_OFF)) {
+        sampleDriverCounters();
+    }
     
-    if (timeDiff > 0) {
-        uint32_t totalMessages = statistics.messagesReceived + statistics.messagesSent;
-        float messagesPerSecond = (float)totalMessages / ((currentTime - interfaceStartTime) / 1000.0);
-        
-        // Estimate utilization based on message rate and average message size
-        float avgMessageBits = 64 + 47; // 64-bit data + overhead
-        float bitsPerSecond = messagesPerSecond * avgMessageBits;
-        statistics.busUtilization = (bitsPerSecond / getSpeedBPS(currentSpeed)) * 100.0;
+    if (alerts & CANTransportEvent::BUS_OFF) {
+        busOff = true;
+        statistics.busOffEvents++;
+        recovery.onBusOff(millis());
+        CANLog::printf("[CAN] Bus-off, recovery attempt %u in %u ms\n",
+                      recovery.getAttempt() + 1, recovery.getCurrentDelayMs());
+        if (errorCallback) {
+            errorCallback(ESP_ERR_INVALID_STATE, "Bus-off");
+        }
+    }
+    
+    if (alerts & CANTransportEvent::BUS_RECOVERED) {
+        recovery.onBusRecovered();
+    }
+    
+    if (alerts & (CANTransportEvent::TX_SUCCESS | CANTransportEvent::TX_FAILED |
+                  CANTransportEvent::BUS_OFF)) {
+        settleTransmits(alerts);
+    }
+}
+
+void CANInterface::serviceRecovery() {
+    CANRecoveryAction action = recovery.poll(millis());
+    if (action == CANRecoveryAction::NONE) {
+        return;
+    }
+    
+    bool success;
+    switch (action) {
+        case CANRecoveryAction::INITIATE_RECOVERY:
+            success = transport->initiateRecovery();
+            break;
+        case CANRecoveryAction::START_DRIVER:
+            success = transport->start();
+            break;
+        default:
+            CANLog::printf("[CAN] Recovery stalled, reinstalling driver\n");
+            success = reinstallDriver();
+            break;
+    }
+    recovery.onActionResult(action, success, millis());
+    
+    if (busOff && !recovery.isBusOff()) {
+        busOff = false;
+        statistics.busRecoveries++;
+        CANLog::printf("[CAN] Bus recovered after %u ms\n", recovery.getLastOutageMs());
+    }
+}
+
+void CANInterface::sampleDriverCounters() {
+    CANTransportStatus status;
+    if (!transport->getStatus(status)) {
+        return;
+    }
+    
+    // Events coalesce, so count transport deltas rather than events
+    statistics.errorFrames += status.busErrors - driverCounters.busErrors;
+    statistics.arbitrationLost += status.arbitrationLost - driverCounters.arbitrationLost;
+    statistics.transmitFailed += status.txFailed - driverCounters.transmitFailed;
+    statistics.driverRxMissed += status.rxMissed - driverCounters.receiveMissed;
+    driverCounters.busErrors = status.busErrors;
+    driverCounters.arbitrationLost = status.arbitrationLost;
+    driverCounters.transmitFailed = status.txFailed;
+    driverCounters.receiveMissed = status.rxMissed;
+}
+
+void CANInterface::settleTransmits(uint32_t alerts) {
+    CANTransportStatus status;
+    if (!transport->getStatus(status)) {
+        return;
+    }
+    
+    // Events coalesce, so completions come from the transport's queue level.
+    // Frames sent with sendFrame() share that queue and only delay settling.
+    bool failed = (alerts & (CANTransportEvent::TX_FAILED | CANTransportEvent::BUS_OFF)) != 0;
+    portENTER_CRITICAL(&txLock);
+    uint32_t settled = transmitQueue.onDriverLevel(status.txPending, failed);
+    portEXIT_CRITICAL(&txLock);
+    if (!failed) {
+        statistics.messagesSent += settled;
+    }
+    
+    // Refill the window now rather than at the next processTransmitQueue()
+    if (settled > 0 && receiveTaskRunning) {
+        pumpTransmitQueue();
+    }
+}
+
+int CANInterface::pumpTransmitQueue() {
+    if (!interfaceEnabled || busOff) {
+        return 0;
+    }
+    
+    int submitted = 0;
+    for (;;) {
+        CANTxEntry entry;
+        uint32_t now = millis();
+        portENTER_CRITICAL(&txLock);
+        bool taken = transmitQueue.take(now, entry);
+        portEXIT_CRITICAL(&txLock);
+        if (!taken) {
+            break;
+        }
         
-        if (statistics.busUtilization > 100.0) {
-            statistics.busUtilization = 100.0;
+        // Transport calls stay outside the spinlock; a refused frame keeps its place
+        receiveAdmission.noteTransmit(entry.frame, now);
+        esp_err_t result = toEspError(transport->transmit(entry.frame, 0));
+        if (result != ESP_OK) {
+            portENTER_CRITICAL(&txLock);
+            transmitQueue.giveBack(entry);
+            portEXIT_CRITICAL(&txLock);
+            if (result != ESP_ERR_TIMEOUT) {     // Timeout only means the driver queue is full
+                handleCANError(result);
+            }
+            break;
         }
+        recordBusLoad(entry.frame);
+        submitted++;
     }
+    return submitted;
+}
+
+void CANInterface::recordBusLoad(const CANFrame& frame) {
+    // Transmitted frames; received ones are charged in acceptReceived()
+    portENTER_CRITICAL(&statsLock);
+    busLoad.recordFrame(frame, static_cast<uint32_t>(esp_timer_get_time()));
+    portEXIT_CRITICAL(&statsLock);
 }
 
 String CANInterface::getErrorDescription(uint16_t errorCode) {
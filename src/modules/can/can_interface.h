@@ -11,116 +11,33 @@
  */
 
 #include <vector>
-#include <queue>
 #include <functional>
 #include "../../config/project_config.h"
 #include "../../config/hardware_config.h"
+#include "can_types.h"
+#include "can_frame.h"
+#include "can_ring_buffer.h"
+#include "can_hw_filter.h"
+#include "can_filter_engine.h"
+#include "can_bus_load.h"
+#include "can_id_stats.h"
+#include "can_latest.h"
+#include "can_dispatch.h"
+#include "can_fanout.h"
+#include "can_rx_admission.h"
+#include "can_recovery.h"
+#include "can_tx_scheduler.h"
+#include "can_autobaud.h"
+#include "can_transport.h"
+#include "can_transport_twai.h"
+#include "obd2_batch.h"
+#include "../obd2/obd2_pid_codec.h"
 
 // ESP32 CAN includes
 #include "driver/twai.h"
-
-/**
- * @brief CAN bus speed configurations
- */
-enum class CANSpeed {
-    CAN_125KBPS,    // 125 kbit/s
-    CAN_250KBPS,    // 250 kbit/s  
-    CAN_500KBPS,    // 500 kbit/s (Standard OBD2)
-    CAN_1MBPS       // 1 Mbit/s
-};
-
-/**
- * @brief CAN message types
- */
-enum class CANMessageType {
-    STANDARD,       // Standard 11-bit identifier
-    EXTENDED,       // Extended 29-bit identifier
-    ERROR_FRAME,    // Error frame
-    REMOTE_FRAME    // Remote transmission request
-};
-
-/**
- * @brief CAN operation modes
- */
-enum class CANMode {
-    NORMAL,         // Normal operation
-    LISTEN_ONLY,    // Listen-only (no ACK, no error frames)
-    SELF_TEST,      // Self-test mode (loopback)
-    NO_ACK          // No acknowledgment mode
-};
-
-/**
- * @brief CAN filter types
- */
-enum class CANFilterType {
-    ACCEPT_ALL,     // Accept all messages
-    WHITELIST,      // Accept only whitelisted IDs
-    BLACKLIST,      // Reject blacklisted IDs
-    RANGE,          // Accept ID range
-    CUSTOM          // Custom filter function
-};
-
-/**
- * @brief CAN message structure
- */
-struct CANMessage {
-    uint32_t id;                    // CAN identifier
-    CANMessageType type;            // Message type
-    uint8_t dlc;                    // Data length code (0-8)
-    uint8_t data[8];                // Data bytes
-    bool rtr;                       // Remote transmission request
-    bool extd;                      // Extended frame format
-    unsigned long timestamp;        // Reception timestamp
-    uint16_t errorFlags;            // Error flags if any
-    
-    // Constructor
-    CANMessage() : id(0), type(CANMessageType::STANDARD), dlc(0), 
-                   rtr(false), extd(false), timestamp(0), errorFlags(0) {
-        memset(data, 0, sizeof(data));
-    }
-};
-
-/**
- * @brief CAN statistics structure
- */
-struct CANStatistics {
-    uint32_t messagesReceived;      // Total messages received
-    uint32_t messagesSent;          // Total messages sent
-    uint32_t errorFrames;           // Error frames received
-    uint32_t busOffEvents;          // Bus-off events
-    uint32_t arbitrationLost;       // Arbitration lost count
-    uint32_t receiveOverflow;       // Receive buffer overflow
-    uint32_t transmitTimeout;       // Transmit timeout count
-    uint32_t filterRejects;         // Messages rejected by filter
-    float busUtilization;           // Bus utilization percentage
-    unsigned long lastMessageTime;  // Last message timestamp
-    unsigned long uptimeSeconds;    // Interface uptime
-    
-    // Constructor
-    CANStatistics() : messagesReceived(0), messagesSent(0), errorFrames(0),
-                     busOffEvents(0), arbitrationLost(0), receiveOverflow(0),
-                     transmitTimeout(0), filterRejects(0), busUtilization(0.0),
-                     lastMessageTime(0), uptimeSeconds(0) {}
-};
-
-/**
- * @brief CAN message filter
- */
-struct CANFilter {
-    CANFilterType type;             // Filter type
-    uint32_t id;                    // Filter ID
-    uint32_t mask;                  // Filter mask
-    uint32_t rangeStart;            // Range start (for range filter)
-    uint32_t rangeEnd;              // Range end (for range filter)
-    std::vector<uint32_t> whitelist; // Whitelist IDs
-    std::vector<uint32_t> blacklist; // Blacklist IDs
-    std::function<bool(const CANMessage&)> customFilter; // Custom filter function
-    bool enabled;                   // Filter enabled
-    
-    // Constructor
-    CANFilter() : type(CANFilterType::ACCEPT_ALL), id(0), mask(0),
-                  rangeStart(0), rangeEnd(0), enabled(true) {}
-};
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 
 /**
  * @brief CAN message callback function type
@@ -142,30 +59,83 @@ private:
     CANSpeed currentSpeed;
     CANMode currentMode;
     bool interfaceEnabled;
-    bool busOff;
+    volatile bool busOff;                   // Set by alerts, read by transmitters
+    
+    // Controller backend (on-chip TWAI unless setTransport() picked another)
+    CANTwaiTransport twaiTransport;
+    CANTransport* transport;
     
-    // Message handling
-    std::queue<CANMessage> receiveQueue;
-    std::queue<CANMessage> transmitQueue;
-    const size_t maxQueueSize = 100;
+    // Message handling (SPSC rings of compact frames, no heap allocation after construction)
+    CANRingBuffer<CANFrame, CAN_RX_RING_SIZE> receiveQueue;
+    CANRxAdmission receiveAdmission;        // Sheds low classes before the ring fills
+    CANTxScheduler transmitQueue;           // Priority/deadline order, guarded by txLock
     
     // Filtering
     CANFilter messageFilter;
+    CANFilterEngine filterEngine;           // Compiled software decision tables
+    CANAcceptanceFilter hardwareFilter;     // Compiled from messageFilter
+    bool hardwareEnforced;                  // Transport loaded hardwareFilter as compiled
     
     // Statistics
     CANStatistics statistics;
     unsigned long interfaceStartTime;
+    mutable CANBusLoadMeter busLoad;        // Fed by the RX task and transmitters
+    CANIdStatsTable idStatistics;           // Fed by the RX task
+    CANLatestTable latestFrames;            // Written by the RX path, read lock-free
+    CANFrameFanout* fanout;                 // Shares frames with extra consumers (not owned)
+    mutable portMUX_TYPE statsLock;         // Guards busLoad and idStatistics
+    mutable portMUX_TYPE txLock;            // Guards transmitQueue (callers vs alert handler)
     
     // Callbacks
     CANMessageCallback messageCallback;
+    const CANDispatchTable* dispatchTable;  // Per-ID handlers, tried first (not owned)
+    CANFrameHandler frameHandler;           // Tried before messageCallback
+    void* frameHandlerContext;
     CANErrorCallback errorCallback;
     
+    // Receive task (producer side of receiveQueue while running)
+    TaskHandle_t receiveTaskHandle;
+    TaskHandle_t notifyTaskHandle;          // Consumer woken on new frames
+    SemaphoreHandle_t filterLock;           // Guards filter tables against the task
+    SemaphoreHandle_t receiveTaskExit;      // Given by the task as it leaves its loop
+    volatile bool receiveTaskRunning;
+    int receiveTaskCore;
+    UBaseType_t receiveTaskPriority;
+    uint32_t driverRxQueueLength;
+    uint32_t driverTxQueueLength;
+    
+    // Bus-off recovery (driven by whoever reads the alerts)
+    CANRecoveryController recovery;
+    struct DriverCounters {
+        uint32_t busErrors;
+        uint32_t arbitrationLost;
+        uint32_t transmitFailed;
+        uint32_t receiveMissed;
+        DriverCounters() : busErrors(0), arbitrationLost(0), transmitFailed(0), receiveMissed(0) {}
+    };
+    DriverCounters driverCounters;          // Last transport status sample
+    
     // Internal methods
     bool configureCANController();
-    void processReceivedMessage(const twai_message_t& message);
+    bool installDriver();
+    bool reinstallDriver();
+    void handleAlerts(uint32_t alerts);
+    void serviceRecovery();
+    void sampleDriverCounters();
+    void settleTransmits(uint32_t alerts);
+    int pumpTransmitQueue();
     void handleCANError(uint16_t errorCode);
-    bool applyMessageFilter(const CANMessage& message);
-    void updateStatistics();
+    bool applyMessageFilter(const CANFrame& frame);
+    bool readFromDriver(CANFrame& frame, uint32_t timeout);
+    bool acceptReceived(const CANFrame& frame);
+    bool queueReceived(const CANFrame& frame, uint32_t now);
+    void deliverToCallback(const CANFrame& frame);
+    void receiveTaskLoop();
+    static void receiveTaskEntry(void* parameter);
+    void lockFilter();
+    void unlockFilter();
+    bool updateHardwareFilter();
+    void recordBusLoad(const CANFrame& frame);
     String getErrorDescription(uint16_t errorCode);
     
 public:
@@ -213,6 +183,69 @@ public:
      */
     bool isInitialized() const;
     
+    /**
+     * @brief Set transport queue depths (applied at next initialize)
+     * @param rxLength Driver receive queue length
+     * @param txLength Driver transmit queue length
+     * @return false if interface is active or a length is zero
+     */
+    bool setDriverQueueLengths(uint32_t rxLength, uint32_t txLength);
+    
+    /**
+     * @brief Select the controller backend (applied at next initialize)
+     * @param backend Transport to use, e.g. CANMCP2515Transport or
+     *                CANLoopbackTransport (nullptr = on-chip TWAI)
+     * @return false if interface is active
+     * @note The backend is not owned and must outlive the interface.
+     */
+    bool setTransport(CANTransport* backend);
+    
+    /**
+     * @brief Get the controller backend in use
+     * @return Current transport
+     */
+    CANTransport* getTransport() const;
+    
+    // ===== RECEIVE TASK =====
+    
+    /**
+     * @brief Start dedicated receive task pinned to a core
+     * @param core CPU core (0 or 1)
+     * @param priority FreeRTOS task priority
+     * @return true if task is running
+     *
+     * The task blocks on transport events, drains frames in bursts into the
+     * receive queue and notifies the consumer task. While it runs,
+     * receiveMessage() only reads the queue and callbacks fire in the
+     * consumer's context.
+     */
+    bool startReceiveTask(int core = CAN_RX_TASK_CORE,
+                          UBaseType_t priority = CAN_RX_TASK_PRIORITY);
+    
+    /**
+     * @brief Stop receive task (waits for it to exit)
+     */
+    void stopReceiveTask();
+    
+    /**
+     * @brief Check if receive task is running
+     * @return true if running
+     */
+    bool isReceiveTaskRunning() const;
+    
+    /**
+     * @brief Set task notified when frames are queued
+     * @param task Consumer task handle (nullptr = first waitForMessages() caller)
+     */
+    void setReceiveNotifyTask(TaskHandle_t task);
+    
+    /**
+     * @brief Block until receive queue has frames
+     * @param timeout Timeout in milliseconds
+     * @return true if frames are available
+     */
+    bool waitForMessages(uint32_t timeout);
+    
     // ===== CONFIGURATION =====
     
     /**
@@ -228,6 +261,16 @@ public:
      */
     CANSpeed getSpeed() const;
     
+    /**
+     * @brief Detect the bus bitrate and switch to it
+     * @param detected Receives the detected speed
+     * @param timeoutMs Give up after this long
+     * @param allowProbe Transmit a probe request if the bus is silent
+     * @return true if a bitrate was locked; a running interface resumes either way
+     */
+    bool detectSpeed(CANSpeed& detected, uint32_t timeoutMs = CAN_AUTOBAUD_TIMEOUT_MS,
+                     bool allowProbe = true);
+    
     /**
      * @brief Set operation mode
      * @param mode New operation mode
@@ -277,20 +320,69 @@ public:
      * @return true if request sent successfully
      */
     bool sendOBD2Request(uint16_t pid, uint8_t mode = 0x01);
+
+    /**
+     * @brief Send Mode 01 PIDs packed up to six per request
+     * @param pids Parameter IDs
+     * @param count Number of PIDs
+     * @return Number of requests sent (responses split with OBD2Batch::split)
+     */
+    int sendOBD2BatchRequest(const uint8_t* pids, uint8_t count);
+    
+    /**
+     * @brief Send compact frame
+     * @param frame Frame to send
+     * @param timeout Timeout in milliseconds
+     * @return true if frame sent successfully
+     */
+    bool sendFrame(const CANFrame& frame, uint32_t timeout = 1000);
+    
+    /**
+     * @brief Send frames in order
+     * @param frames Frames to send
+     * @param count Number of frames
+     * @param timeout Timeout per frame in milliseconds
+     * @return Number of frames sent before the first failure
+     */
+    size_t sendFrames(const CANFrame* frames, size_t count, uint32_t timeout = 10);
     
     /**
      * @brief Queue message for transmission
      * @param message Message to queue
+     * @param priority Priority class
+     * @param lifetimeMs Drop the message if it is not handed to the driver
+     *                   within this many milliseconds (0 = no deadline)
      * @return true if message queued successfully
      */
-    bool queueMessage(const CANMessage& message);
+    bool queueMessage(const CANMessage& message, CANTxPriority priority = CANTxPriority::NORMAL,
+                      uint32_t lifetimeMs = 0);
     
     /**
-     * @brief Process transmit queue
-     * @return Number of messages sent
+     * @brief Queue compact frame for transmission
+     * @param frame Frame to queue
+     * @param priority Priority class
+     * @param lifetimeMs Drop the frame if it is not handed to the driver
+     *                   within this many milliseconds (0 = no deadline)
+     * @return true if frame queued (a full queue evicts its least urgent frame
+     *         if this one is more urgent)
+     */
+    bool queueFrame(const CANFrame& frame, CANTxPriority priority = CANTxPriority::NORMAL,
+                    uint32_t lifetimeMs = 0);
+    
+    /**
+     * @brief Hand queued frames to the driver, most urgent first
+     * @return Number of frames handed to the driver
+     * @note Never blocks. At most CAN_TX_IN_FLIGHT frames sit in the driver at
+     *       once; TX alerts settle them and, with the receive task running,
+     *       refill the window without waiting for the next call.
      */
     int processTransmitQueue();
     
+    /**
+     * @brief Transmit scheduler counters (queued, expired, evicted, ...)
+     */
+    CANTxSchedulerStatistics getTransmitStatistics() const;
+    
     // ===== MESSAGE RECEPTION =====
     
     /**
@@ -301,6 +393,43 @@ public:
      */
     bool receiveMessage(CANMessage& message, uint32_t timeout = 0);
     
+    /**
+     * @brief Receive compact frame (no CANMessage expansion)
+     * @param frame Reference to store received frame
+     * @param timeout Timeout in milliseconds
+     * @return true if frame received
+     */
+    bool receiveFrame(CANFrame& frame, uint32_t timeout = 0);
+    
+    /**
+     * @brief Take every queued frame up to maxFrames in one pass
+     * @param frames Destination array
+     * @param maxFrames Capacity of frames
+     * @return Number of frames received (does not wait or read the driver)
+     */
+    size_t receiveFrames(CANFrame* frames, size_t maxFrames);
+    
+    /**
+     * @brief Newest accepted frame of an ID, without draining the receive queue
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param value Receives the frame and its counters; age is
+     *              value.ageUs(esp_timer_get_time())
+     * @return true if the ID has been received
+     */
+    bool readLatest(uint32_t id, bool extended, CANLatestValue& value) const;
+    
+    /**
+     * @brief Newest frame of an ID, only if its payload changed since the last call
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param seenChanges Caller's change counter (start at 0), updated on success
+     * @param value Receives the frame and its counters
+     * @return true if the payload changed
+     */
+    bool readLatestIfChanged(uint32_t id, bool extended, uint32_t& seenChanges,
+                             CANLatestValue& value) const;
+    
     /**
      * @brief Check if messages are available
      * @return Number of messages in receive queue
@@ -309,67 +438,165 @@ public:
     
     /**
      * @brief Process received messages
-     * @return Number of messages processed
+     * @return Number of messages queued (frames shed under load are not counted)
      */
     int processReceiveQueue();
     
+    /**
+     * @brief Read driver alerts and advance bus-off recovery (polled mode)
+     * @param timeout Wait for an alert in milliseconds
+     * @return Alerts handled (0 while the receive task owns them)
+     */
+    uint32_t processAlerts(uint32_t timeout = 0);
+    
     /**
      * @brief Flush receive queue
      */
     void flushReceiveQueue();
     
+    /**
+     * @brief Keep a broadcast ID when the receive queue backs up
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @return false if the 29-bit subscription table is full
+     * @note Subscribed frames are shed only after unsubscribed ones; responses
+     *       to our own OBD2 requests are kept until the queue is full.
+     */
+    bool subscribeBroadcast(uint32_t id, bool extended = false);
+    
+    bool unsubscribeBroadcast(uint32_t id, bool extended = false);
+    
+    /**
+     * @brief Set the receive queue depths at which frames are shed
+     * @param backgroundLevel Unsubscribed frames are dropped from this depth
+     * @param subscribedLevel Subscribed frames are dropped from this depth
+     * @return false unless backgroundLevel <= subscribedLevel <= queue capacity
+     */
+    bool setReceiveShedLevels(size_t backgroundLevel, size_t subscribedLevel);
+    
+    /**
+     * @brief Frames queued and shed per receive class (indexed by CANRxClass)
+     */
+    CANRxAdmissionStatistics getReceiveAdmissionStatistics() const;
+    
     /**
      * @brief Set message received callback
      * @param callback Callback function
      */
     void setMessageCallback(CANMessageCallback callback);
     
+    /**
+     * @brief Set a handler that sees each frame before the message callback
+     * @param handler Returns true for frames it consumed (nullptr to clear)
+     * @param context Passed back to the handler
+     * @note Called wherever the message callback would be. Frames of known
+     *       IDs go straight to generated decoders without being expanded
+     *       into a CANMessage; the rest still reach the callback.
+     */
+    void setFrameHandler(CANFrameHandler handler, void* context = nullptr);
+    
+    /**
+     * @brief Route frames by identifier before the frame handler
+     * @param table Per-ID handlers (nullptr to clear)
+     * @note The table is not owned and must outlive the interface. Frames
+     *       whose handler returns false, or with no handler, continue to
+     *       the frame handler and then the message callback.
+     */
+    void setDispatchTable(const CANDispatchTable* table);
+    
+    /**
+     * @brief Publish every accepted frame to a fan-out's subscribers
+     * @param frameFanout Fan-out with its consumers subscribed (nullptr to clear)
+     * @note Set before start(); the fan-out is not owned. Frames are published
+     *       from the RX path, so consumers see them even when the receive
+     *       queue is full, and a slow consumer only drops its own frames.
+     */
+    void setFanout(CANFrameFanout* frameFanout);
+    
     // ===== FILTERING =====
     
     /**
      * @brief Set message filter
      * @param filter Filter configuration
+     * @return false if the controller could not be reloaded with the new
+     *         acceptance filter: the previous one stays loaded, or if that
+     *         also fails the interface is stopped and the error callback fires
      */
-    void setMessageFilter(const CANFilter& filter);
+    bool setMessageFilter(const CANFilter& filter);
     
     /**
      * @brief Set accept all filter
+     * @return false if the controller could not be reloaded (see setMessageFilter)
      */
-    void setAcceptAllFilter();
+    bool setAcceptAllFilter();
     
     /**
      * @brief Set whitelist filter
      * @param ids Vector of accepted IDs
+     * @return false if the controller could not be reloaded (see setMessageFilter)
      */
-    void setWhitelistFilter(const std::vector<uint32_t>& ids);
+    bool setWhitelistFilter(const std::vector<uint32_t>& ids);
     
     /**
      * @brief Set blacklist filter
      * @param ids Vector of rejected IDs
+     * @return false if the controller could not be reloaded (see setMessageFilter)
      */
-    void setBlacklistFilter(const std::vector<uint32_t>& ids);
+    bool setBlacklistFilter(const std::vector<uint32_t>& ids);
     
     /**
      * @brief Set range filter
      * @param startId Start of ID range
      * @param endId End of ID range
+     * @return false if the controller could not be reloaded (see setMessageFilter)
      */
-    void setRangeFilter(uint32_t startId, uint32_t endId);
+    bool setRangeFilter(uint32_t startId, uint32_t endId);
     
     /**
      * @brief Set custom filter function
      * @param filterFunc Custom filter function
+     * @return false if the controller could not be reloaded (see setMessageFilter)
+     */
+    bool setCustomFilter(std::function<bool(const CANMessage&)> filterFunc);
+    
+    /**
+     * @brief Set composed filter rules (whitelist/blacklist/range/predicate)
+     * @param rules Rule set; compiled before use
+     * @return false if the controller could not be reloaded (see setMessageFilter)
      */
-    void setCustomFilter(std::function<bool(const CANMessage&)> filterFunc);
+    bool setFilterRules(const CANFilterEngine& rules);
     
     /**
      * @brief Enable/disable filter
      * @param enabled Filter enabled state
+     * @return false if the controller could not be reloaded (see setMessageFilter)
      */
-    void setFilterEnabled(bool enabled);
+    bool setFilterEnabled(bool enabled);
+    
+    /**
+     * @brief Get hardware acceptance filter compiled from the current filter
+     * @return Compiled TWAI acceptance filter
+     */
+    CANAcceptanceFilter getHardwareFilter() const;
+    
+    /**
+     * @brief Check if accepted frames skip the software filter
+     * @return true if the hardware filter is exact and the transport loaded it as compiled
+     */
+    bool isHardwareFilterExact() const;
     
     // ===== STATUS & DIAGNOSTICS =====
     
+    /**
+     * @brief Turn CAN status lines on Serial on or off
+     *
+     * Covers every CANInterface and transport, receive task included. Turn
+     * it off when Serial carries a protocol (SLCAN gateway).
+     *
+     * @param enabled false to stay quiet
+     */
+    static void setLogging(bool enabled);
+    
     /**
      * @brief Get CAN bus status
      * @return Status string
@@ -382,6 +609,12 @@ public:
      */
     bool isBusOff() const;
     
+    /**
+     * @brief Get bus-off recovery progress
+     * @return RUNNING unless a recovery is pending
+     */
+    CANRecoveryState getRecoveryState() const;
+    
     /**
      * @brief Get error state
      * @return Error state code
@@ -399,6 +632,46 @@ public:
      */
     void resetStatistics();
     
+    /**
+     * @brief Get bus utilization over a sliding window
+     * @param window Window length (100 ms, 1 s, 10 s)
+     * @return Load in percent
+     *
+     * Only frames that reach the driver are counted; with a restrictive
+     * hardware acceptance filter this is a lower bound.
+     */
+    float getBusLoad(CANLoadWindow window = CANLoadWindow::WINDOW_1S) const;
+    
+    /**
+     * @brief Get peak bus utilization since the last statistics reset
+     * @param window Window length
+     * @return Peak load in percent
+     */
+    float getBusLoadPeak(CANLoadWindow window = CANLoadWindow::WINDOW_100MS) const;
+    
+    /**
+     * @brief Select the bit stuffing estimate for bus load
+     * @param model EXPECTED (default) or WORST_CASE for schedulability margins
+     */
+    void setBusLoadStuffingModel(CANStuffingModel model);
+    
+    /**
+     * @brief Get arrival statistics of one identifier
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param stats Output statistics
+     * @return true if the ID has been seen since the last reset
+     */
+    bool getIdStatistics(uint32_t id, bool extended, CANIdStatistics& stats) const;
+    
+    /**
+     * @brief Copy arrival statistics of every tracked identifier
+     * @param stats Output array
+     * @param maxEntries Capacity of stats
+     * @return Number of entries copied
+     */
+    size_t getIdStatistics(CANIdStatistics* stats, size_t maxEntries) const;
+    
     /**
      * @brief Print diagnostics
      */
@@ -456,17 +729,30 @@ public:
      * @param pid Reference to store parsed PID
      * @param data Reference to store parsed data
      * @param length Reference to store data length
-     * @return true if parsing successful
+     * @return true if parsing successful (false if a Mode 01 answer is
+     *         shorter than its PID's J1979 length)
      */
     static bool parseOBD2Response(const CANMessage& message, uint16_t& pid, 
                                  uint8_t* data, uint8_t& length);
     
+    /**
+     * @brief Parse an OBD2 Mode 01 response and decode its value
+     * @param message CAN message containing OBD2 data
+     * @param pid Reference to store parsed PID (response mode, e.g. 0x410C)
+     * @param value Primary value in J1979 engineering units (fixed point)
+     * @return true if the message is a Mode 01 answer with a known PID
+     */
+    static bool parseOBD2Response(const CANMessage& message, uint16_t& pid, OBD2Value& value);
+    
     // ===== UTILITY FUNCTIONS =====
     
     /**
      * @brief Convert CAN message to string
      * @param message CAN message
      * @return String representation
+     *
+     * For streaming use SLCAN::encodeFrame() (slcan.h), which writes into a
+     * caller buffer without allocating.
      */
     static String messageToString(const CANMessage& message);
     
@@ -513,36 +799,59 @@ public:
      * @param twaiMsg Reference to store converted message
      */
     static void convertToTWAI(const CANMessage& canMsg, twai_message_t& twaiMsg);
+    
+    /**
+     * @brief Convert TWAI message to compact frame
+     * @param twaiMsg TWAI message structure
+     * @param frame Reference to store converted frame
+     * @param timestampUs Reception time in microseconds
+     */
+    static void convertFromTWAI(const twai_message_t& twaiMsg, CANFrame& frame, uint64_t timestampUs) {
+        frame.idFlags = (twaiMsg.identifier & CANFrame::ID_MASK) |
+                        (twaiMsg.extd ? CANFrame::FLAG_EXTENDED : 0) |
+                        (twaiMsg.rtr ? CANFrame::FLAG_REMOTE : 0);
+        frame.dlc = twaiMsg.data_length_code > 8 ? 8 : twaiMsg.data_length_code;
+        memcpy(frame.data, twaiMsg.data, 8);    // Fixed size: one 8-byte move
+        frame.timestamp = timestampUs;
+    }
+    
+    /**
+     * @brief Convert a burst of TWAI messages to compact frames
+     * @param twaiMsgs TWAI messages
+     * @param frames Output frames
+     * @param count Number of messages
+     * @param timestampsUs Reception time per message
+     */
+    static void convertFromTWAI(const twai_message_t* twaiMsgs, CANFrame* frames, size_t count,
+                                const uint64_t* timestampsUs) {
+        for (size_t i = 0; i < count; i++) {
+            convertFromTWAI(twaiMsgs[i], frames[i], timestampsUs[i]);
+        }
+    }
+    
+    /**
+     * @brief Convert compact frame to TWAI message
+     * @param frame Frame to convert
+     * @param twaiMsg Reference to store converted message
+     */
+    static void convertToTWAI(const CANFrame& frame, twai_message_t& twaiMsg) {
+        twaiMsg.flags = 0;
+        twaiMsg.identifier = frame.id();
+        twaiMsg.extd = frame.isExtended();
+        twaiMsg.rtr = frame.isRemote();
+        twaiMsg.data_length_code = frame.dlc;
+        memcpy(twaiMsg.data, frame.data, 8);
+    }
+    
+    /**
+     * @brief Convert a batch of compact frames to TWAI messages
+     * @param frames Frames to convert
+     * @param twaiMsgs Output TWAI messages
+     * @param count Number of frames
+     */
+    static void convertToTWAI(const CANFrame* frames, twai_message_t* twaiMsgs, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            convertToTWAI(frames[i], twaiMsgs[i]);
+        }
+    }
 };
-
-// ===== OBD2 CAN DEFINITIONS =====
-namespace OBD2CAN {
-    // Standard OBD2 CAN IDs
-    constexpr uint32_t FUNCTIONAL_REQUEST_ID    = 0x7DF;    // Functional diagnostic request
-    constexpr uint32_t RESPONSE_ID_BASE         = 0x7E8;    // Response ID base (0x7E8-0x7EF)
-    constexpr uint32_t PHYSICAL_REQUEST_BASE    = 0x7E0;    // Physical request base (0x7E0-0x7E7)
-    
-    // Extended OBD2 CAN IDs (29-bit)
-    constexpr uint32_t EXT_FUNCTIONAL_REQUEST   = 0x18DB33F1; // Extended functional request
-    constexpr uint32_t EXT_RESPONSE_BASE        = 0x18DAF100; // Extended response base
-    constexpr uint32_t EXT_PHYSICAL_REQUEST_BASE = 0x18DA00F1; // Extended physical request base
-    
-    // OBD2 frame types
-    constexpr uint8_t FRAME_TYPE_SINGLE         = 0x00;    // Single frame
-    constexpr uint8_t FRAME_TYPE_FIRST          = 0x10;    // First frame (multi-frame)
-    constexpr uint8_t FRAME_TYPE_CONSECUTIVE    = 0x20;    // Consecutive frame
-    constexpr uint8_t FRAME_TYPE_FLOW_CONTROL   = 0x30;    // Flow control frame
-    
-    // Flow control flags
-    constexpr uint8_t FC_FLAG_CONTINUE_TO_SEND  = 0x00;    // Continue to send
-    constexpr uint8_t FC_FLAG_WAIT              = 0x01;    // Wait
-    constexpr uint8_t FC_FLAG_OVERFLOW          = 0x02;    // Buffer overflow
-    
-    // Timing parameters (ISO 14229)
-    constexpr uint32_t P2_CLIENT_MAX            = 50;      // P2*client max (ms)
-    constexpr uint32_t P2_STAR_CLIENT_MAX       = 5000;    // P2*client max (ms)
-    constexpr uint8_t  ST_MIN_DEFAULT           = 0;       // STmin default (ms)
-    constexpr uint8_t  BLOCK_SIZE_DEFAULT       = 0;       // Block size default (unlimited)
-}
-
-#endif // CAN_INTERFACE_H
\ No newline at end of file
@@ -0,0 +1,139 @@
+/**
+ * @file can_latest.cpp
+ * @brief Latest received frame per CAN identifier implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_latest.h"
+#include <string.h>
+
+static_assert((CAN_LATEST_TABLE_SIZE & (CAN_LATEST_TABLE_SIZE - 1)) == 0,
+              "CAN_LATEST_TABLE_SIZE must be a power of two");
+static_assert(sizeof(CANFrame) % sizeof(uint32_t) == 0, "CANFrame must be whole words");
+
+CANLatestTable::CANLatestTable() {
+    clear();
+}
+
+bool CANLatestTable::update(const CANFrame& frame) {
+    uint32_t key = makeKey(frame.id(), frame.isExtended());
+    size_t index = probe(key);
+    if (index == CAPACITY) {
+        untrackedFrames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t image[FRAME_WORDS];
+    memcpy(image, &frame, sizeof(image));
+
+    Slot& slot = slots[index];
+    bool fresh = slot.key.load(std::memory_order_relaxed) == EMPTY;
+
+    // Payload is data[8] + the dlc byte; only the writer touches these words
+    bool changed = fresh;
+    if (!fresh) {
+        uint32_t oldImage[FRAME_WORDS];
+        for (size_t i = 0; i < FRAME_WORDS; i++) {
+            oldImage[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        CANFrame old;
+        memcpy(&old, oldImage, sizeof(old));
+        uint8_t dlc = frame.dlc > 8 ? 8 : frame.dlc;
+        changed = old.dlc != frame.dlc || memcmp(old.data, frame.data, dlc) != 0;
+    }
+
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < FRAME_WORDS; i++) {
+        slot.words[i].store(image[i], std::memory_order_relaxed);
+    }
+    if (changed) {
+        slot.changes.store(slot.changes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+
+    if (fresh) {
+        // Publish the identifier only once its first frame is readable
+        slot.key.store(key, std::memory_order_release);
+        used.fetch_add(1, std::memory_order_relaxed);
+    }
+    return changed;
+}
+
+bool CANLatestTable::read(uint32_t id, bool extended, CANLatestValue& value) const {
+    size_t index = probe(makeKey(id, extended));
+    if (index == CAPACITY || slots[index].key.load(std::memory_order_acquire) == EMPTY) {
+        return false;
+    }
+    return copy(slots[index], value);
+}
+
+bool CANLatestTable::readIfChanged(uint32_t id, bool extended, uint32_t& seenChanges,
+                                   CANLatestValue& value) const {
+    size_t index = probe(makeKey(id, extended));
+    if (index == CAPACITY || slots[index].key.load(std::memory_order_acquire) == EMPTY) {
+        return false;
+    }
+    // Cheap check before copying the frame
+    if (slots[index].changes.load(std::memory_order_relaxed) == seenChanges) {
+        return false;
+    }
+    if (!copy(slots[index], value) || value.changes == seenChanges) {
+        return false;
+    }
+    seenChanges = value.changes;
+    return true;
+}
+
+void CANLatestTable::clear() {
+    for (size_t i = 0; i < CAPACITY; i++) {
+        slots[i].key.store(EMPTY, std::memory_order_relaxed);
+        slots[i].sequence.store(0, std::memory_order_relaxed);
+        slots[i].changes.store(0, std::memory_order_relaxed);
+        for (size_t w = 0; w < FRAME_WORDS; w++) {
+            slots[i].words[w].store(0, std::memory_order_relaxed);
+        }
+    }
+    used.store(0, std::memory_order_relaxed);
+    untrackedFrames.store(0, std::memory_order_relaxed);
+}
+
+// ===== INTERNAL METHODS =====
+
+size_t CANLatestTable::probe(uint32_t key) const {
+    // Linear probing; returns the key's slot, the first free slot, or
+    // CAPACITY when the key is absent and the table is full
+    size_t index = hashKey(key) & (CAPACITY - 1);
+    for (size_t i = 0; i < CAPACITY; i++) {
+        uint32_t current = slots[index].key.load(std::memory_order_acquire);
+        if (current == EMPTY || current == key) {
+            return index;
+        }
+        index = (index + 1) & (CAPACITY - 1);
+    }
+    return CAPACITY;
+}
+
+bool CANLatestTable::copy(const Slot& slot, CANLatestValue& value) const {
+    uint32_t image[FRAME_WORDS];
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;               // Writer mid-update
+        }
+        for (size_t i = 0; i < FRAME_WORDS; i++) {
+            image[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        uint32_t changes = slot.changes.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            memcpy(&value.frame, image, sizeof(image));
+            value.updates = before / 2;
+            value.changes = changes;
+            return true;
+        }
+    }
+    return false;
+}
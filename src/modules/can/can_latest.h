@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * @file can_latest.h
+ * @brief Latest received frame per CAN identifier
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Broadcast consumers usually want the newest value of an ID, not every
+ * frame in order. The RX path overwrites one slot per identifier, and a
+ * reader copies that slot whenever it likes, without draining the receive
+ * queue or ever seeing a backlog. Each slot is a seqlock. The single writer
+ * makes the sequence odd, stores the frame and makes it even again. A
+ * reader retries if the sequence was odd or moved during its copy. Slot
+ * words are relaxed atomics, so a torn copy is detected, never undefined.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+
+/**
+ * @brief Snapshot of one identifier's newest frame
+ */
+struct CANLatestValue {
+    CANFrame frame;                 // Newest frame; timestamp is its reception time
+    uint32_t updates;               // Frames received for this ID
+    uint32_t changes;               // Frames whose payload differed from the one before
+
+    /**
+     * @brief Age of the frame in microseconds
+     * @param nowUs Current time on the RX timestamp clock
+     */
+    uint64_t ageUs(uint64_t nowUs) const {
+        return nowUs > frame.timestamp ? nowUs - frame.timestamp : 0;
+    }
+};
+
+/**
+ * @class CANLatestTable
+ * @brief Fixed-capacity open addressing table of latest frames
+ *
+ * One writer (update, clear), any number of readers. Readers never block
+ * the writer; a reader that keeps losing the race gives up after a few
+ * retries rather than spin against a preempted writer. Once full, frames
+ * of new IDs are only counted in untracked().
+ */
+class CANLatestTable {
+public:
+    static constexpr size_t CAPACITY = CAN_LATEST_TABLE_SIZE;
+
+    CANLatestTable();
+
+    /**
+     * @brief Store a received frame (writer only)
+     * @param frame Received frame
+     * @return true if the payload differs from the previous frame of this ID
+     */
+    bool update(const CANFrame& frame);
+
+    /**
+     * @brief Copy out the newest frame of an identifier
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param value Receives the snapshot
+     * @return false if the ID was never seen (or the writer kept the slot busy)
+     */
+    bool read(uint32_t id, bool extended, CANLatestValue& value) const;
+
+    /**
+     * @brief Copy out the newest frame only if its payload changed
+     * @param id CAN identifier
+     * @param extended 29-bit identifier
+     * @param seenChanges Caller's last seen change count, updated on success
+     * @param value Receives the snapshot
+     * @return true if the payload changed since seenChanges
+     */
+    bool readIfChanged(uint32_t id, bool extended, uint32_t& seenChanges, CANLatestValue& value) const;
+
+    size_t size() const { return used.load(std::memory_order_relaxed); }
+    uint32_t untracked() const { return untrackedFrames.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Forget all identifiers (writer only, readers must be idle)
+     */
+    void clear();
+
+private:
+    static constexpr size_t FRAME_WORDS = sizeof(CANFrame) / sizeof(uint32_t);
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr int READ_ATTEMPTS = 4;
+
+    struct Slot {
+        std::atomic<uint32_t> key;          // Identifier and extended flag + 1, 0 = empty
+        std::atomic<uint32_t> sequence;     // Odd while being written; updates = sequence / 2
+        std::atomic<uint32_t> changes;
+        std::atomic<uint32_t> words[FRAME_WORDS];   // CANFrame image
+    };
+
+    Slot slots[CAPACITY];
+    std::atomic<size_t> used;
+    std::atomic<uint32_t> untrackedFrames;
+
+    size_t probe(uint32_t key) const;
+    bool copy(const Slot& slot, CANLatestValue& value) const;
+
+    static uint32_t makeKey(uint32_t id, bool extended) {
+        return ((id & CANFrame::ID_MASK) | (extended ? CANFrame::FLAG_EXTENDED : 0)) + 1;
+    }
+
+    static uint32_t hashKey(uint32_t key) {
+        return (key * 2654435761U) >> 7;    // Knuth multiplicative hash
+    }
+};
@@ -0,0 +1,38 @@
+/**
+ * @file can_log.cpp
+ * @brief Switchable status output for the CAN module
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_log.h"
+#include <Arduino.h>
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+#include "../../config/project_config.h"
+
+namespace {
+    std::atomic<bool> logEnabled(true);
+}
+
+void CANLog::setEnabled(bool enabled) {
+    logEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool CANLog::isEnabled() {
+    return logEnabled.load(std::memory_order_relaxed);
+}
+
+void CANLog::printf(const char* format, ...) {
+    if (!isEnabled()) {
+        return;
+    }
+
+    char line[CAN_LOG_LINE_SIZE];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    Serial.print(line);
+}
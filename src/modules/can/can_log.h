@@ -0,0 +1,28 @@
+#pragma once
+
+/**
+ * @file can_log.h
+ * @brief Switchable status output for the CAN module
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Every CAN status line (interface, receive task, transports) goes through
+ * here instead of Serial directly, so a sketch that uses Serial for
+ * something else - the SLCAN gateway - can turn CAN logging off.
+ */
+
+namespace CANLog {
+    /**
+     * @brief Turn CAN status output on or off (on by default)
+     */
+    void setEnabled(bool enabled);
+
+    bool isEnabled();
+
+    /**
+     * @brief printf to Serial if logging is enabled
+     *
+     * Lines longer than CAN_LOG_LINE_SIZE are truncated.
+     */
+    void printf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+}
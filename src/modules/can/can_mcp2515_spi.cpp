@@ -0,0 +1,97 @@
+/**
+ * @file can_mcp2515_spi.cpp
+ * @brief ESP32 SPI bus and interrupt line for the MCP2515 transport
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_mcp2515_spi.h"
+#include "esp_timer.h"
+#include "can_log.h"
+
+CANMCP2515SpiPort::CANMCP2515SpiPort(SPIClass& spi, uint8_t csPin, uint8_t intPin, uint32_t frequency)
+    : spi(spi), csPin(csPin), intPin(intPin), settings(frequency, MSBFIRST, SPI_MODE0),
+      busLock(nullptr), interruptSignal(nullptr), started(false) {
+}
+
+bool CANMCP2515SpiPort::begin() {
+    if (started) {
+        return true;
+    }
+    if (busLock == nullptr) {
+        busLock = xSemaphoreCreateMutex();
+    }
+    if (interruptSignal == nullptr) {
+        interruptSignal = xSemaphoreCreateBinary();
+    }
+    if (busLock == nullptr || interruptSignal == nullptr) {
+        CANLog::printf("[CAN] ERROR: Failed to create MCP2515 semaphores\n");
+        return false;
+    }
+
+    pinMode(csPin, OUTPUT);
+    digitalWrite(csPin, HIGH);
+    spi.begin(SPI_SCK_PIN, SPI_MISO_PIN, SPI_MOSI_PIN, csPin);
+    pinMode(intPin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(intPin), onInterrupt, this, FALLING);
+    started = true;
+    return true;
+}
+
+void CANMCP2515SpiPort::end() {
+    if (!started) {
+        return;
+    }
+    detachInterrupt(digitalPinToInterrupt(intPin));
+    spi.end();
+    started = false;
+}
+
+void CANMCP2515SpiPort::lock() {
+    xSemaphoreTake(busLock, portMAX_DELAY);
+}
+
+void CANMCP2515SpiPort::unlock() {
+    xSemaphoreGive(busLock);
+}
+
+void CANMCP2515SpiPort::transfer(const uint8_t* tx, uint8_t* rx, size_t length) {
+    spi.beginTransaction(settings);
+    digitalWrite(csPin, LOW);
+    if (rx != nullptr) {
+        spi.transferBytes(tx, rx, length);
+    } else {
+        spi.writeBytes(tx, length);
+    }
+    digitalWrite(csPin, HIGH);
+    spi.endTransaction();
+}
+
+bool CANMCP2515SpiPort::interruptPending() {
+    return digitalRead(intPin) == LOW;
+}
+
+bool CANMCP2515SpiPort::waitForInterrupt(uint32_t timeoutMs) {
+    return xSemaphoreTake(interruptSignal, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void CANMCP2515SpiPort::wake() {
+    xSemaphoreGive(interruptSignal);
+}
+
+uint64_t CANMCP2515SpiPort::micros() {
+    return esp_timer_get_time();
+}
+
+uint32_t CANMCP2515SpiPort::millis() {
+    return ::millis();
+}
+
+void IRAM_ATTR CANMCP2515SpiPort::onInterrupt(void* arg) {
+    CANMCP2515SpiPort* port = static_cast<CANMCP2515SpiPort*>(arg);
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(port->interruptSignal, &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+/**
+ * @file can_mcp2515_spi.h
+ * @brief ESP32 SPI bus and interrupt line for the MCP2515 transport
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include <Arduino.h>
+#include <SPI.h>
+#include "../../config/hardware_config.h"
+#include "can_transport_mcp2515.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/**
+ * @class CANMCP2515SpiPort
+ * @brief CANMCP2515Port on the VSPI pins from hardware_config.h
+ *
+ * The INT line's falling edge gives a semaphore; waits take it, and
+ * interruptPending() reads the line itself so a flag raised while the
+ * line was already low is not missed.
+ */
+class CANMCP2515SpiPort : public CANMCP2515Port {
+public:
+    CANMCP2515SpiPort(SPIClass& spi = SPI, uint8_t csPin = CAN_CS_PIN,
+                      uint8_t intPin = CAN_INT_PIN, uint32_t frequency = CAN_SPI_FREQUENCY);
+
+    bool begin() override;
+    void end() override;
+    void lock() override;
+    void unlock() override;
+    void transfer(const uint8_t* tx, uint8_t* rx, size_t length) override;
+    bool interruptPending() override;
+    bool waitForInterrupt(uint32_t timeoutMs) override;
+    void wake() override;
+    uint64_t micros() override;
+    uint32_t millis() override;
+
+private:
+    SPIClass& spi;
+    uint8_t csPin;
+    uint8_t intPin;
+    SPISettings settings;
+    SemaphoreHandle_t busLock;
+    SemaphoreHandle_t interruptSignal;
+    bool started;
+
+    static void IRAM_ATTR onInterrupt(void* arg);
+};
@@ -0,0 +1,123 @@
+/**
+ * @file can_recovery.cpp
+ * @brief Bus-off recovery state machine implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_recovery.h"
+
+CANRecoveryController::CANRecoveryController(uint32_t baseDelayMs, uint32_t maxDelayMs,
+                                             uint32_t recoveryTimeoutMs, uint32_t stableMs)
+    : baseDelayMs(baseDelayMs), maxDelayMs(maxDelayMs),
+      recoveryTimeoutMs(recoveryTimeoutMs), stableMs(stableMs) {
+    reset();
+    recoveries = 0;
+    reinstalls = 0;
+    lastOutageMs = 0;
+    totalOutageMs = 0;
+}
+
+// ===== EVENTS =====
+
+void CANRecoveryController::onBusOff(uint32_t nowMs) {
+    if (state == CANRecoveryState::RUNNING) {
+        outageStart = nowMs;
+        // A bus-off soon after the last recovery means the fault is still there
+        bool stable = recoveries == 0 || static_cast<uint32_t>(nowMs - lastRecovered) >= stableMs;
+        attempt = stable ? 0 : nextAttempt();
+    } else {
+        attempt = nextAttempt();    // Fell off again while recovering
+    }
+    enterBackoff(nowMs);
+}
+
+void CANRecoveryController::onBusRecovered() {
+    if (state == CANRecoveryState::RECOVERING) {
+        state = CANRecoveryState::RESTART;
+        reinstall = false;
+    }
+}
+
+CANRecoveryAction CANRecoveryController::poll(uint32_t nowMs) {
+    switch (state) {
+        case CANRecoveryState::BACKOFF:
+            return reached(nowMs, deadline) ? CANRecoveryAction::INITIATE_RECOVERY : CANRecoveryAction::NONE;
+
+        case CANRecoveryState::RECOVERING:
+            // BUS_RECOVERED never came (alert lost or controller wedged)
+            return reached(nowMs, deadline) ? CANRecoveryAction::REINSTALL_DRIVER : CANRecoveryAction::NONE;
+
+        case CANRecoveryState::RESTART:
+            return reinstall ? CANRecoveryAction::REINSTALL_DRIVER : CANRecoveryAction::START_DRIVER;
+
+        default:
+            return CANRecoveryAction::NONE;
+    }
+}
+
+void CANRecoveryController::onActionResult(CANRecoveryAction action, bool success, uint32_t nowMs) {
+    switch (action) {
+        case CANRecoveryAction::INITIATE_RECOVERY:
+            if (success) {
+                state = CANRecoveryState::RECOVERING;
+                deadline = nowMs + recoveryTimeoutMs;
+            } else {
+                state = CANRecoveryState::RESTART;
+                reinstall = true;
+            }
+            break;
+
+        case CANRecoveryAction::START_DRIVER:
+            if (success) {
+                finish(nowMs);
+            } else {
+                state = CANRecoveryState::RESTART;
+                reinstall = true;
+            }
+            break;
+
+        case CANRecoveryAction::REINSTALL_DRIVER:
+            reinstalls++;
+            if (success) {
+                finish(nowMs);
+            } else {
+                attempt = nextAttempt();
+                enterBackoff(nowMs);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void CANRecoveryController::reset() {
+    state = CANRecoveryState::RUNNING;
+    reinstall = false;
+    attempt = 0;
+    delayMs = baseDelayMs;
+    deadline = 0;
+    outageStart = 0;
+    lastRecovered = 0;
+}
+
+// ===== INTERNAL METHODS =====
+
+void CANRecoveryController::enterBackoff(uint32_t nowMs) {
+    uint8_t shift = attempt < 16 ? attempt : 16;
+    uint64_t delay = static_cast<uint64_t>(baseDelayMs) << shift;
+    delayMs = delay > maxDelayMs ? maxDelayMs : static_cast<uint32_t>(delay);
+    deadline = nowMs + delayMs;
+    state = CANRecoveryState::BACKOFF;
+    reinstall = false;
+}
+
+void CANRecoveryController::finish(uint32_t nowMs) {
+    state = CANRecoveryState::RUNNING;
+    reinstall = false;
+    lastRecovered = nowMs;
+    lastOutageMs = nowMs - outageStart;
+    totalOutageMs += lastOutageMs;
+    recoveries++;
+}
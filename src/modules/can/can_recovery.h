@@ -0,0 +1,125 @@
+#pragma once
+
+/**
+ * @file can_recovery.h
+ * @brief Bus-off recovery state machine with exponential backoff
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Decides when to call twai_initiate_recovery(), when to restart the driver
+ * after BUS_RECOVERED, and when to give up on the controller and reinstall
+ * the driver. Repeated bus-offs within the stable period double the wait
+ * before the next attempt, so a shorted harness does not hammer the bus.
+ * The controller only tracks time; CANInterface executes the actions.
+ */
+
+#include <stdint.h>
+#include "../../config/project_config.h"
+
+/**
+ * @brief Recovery progress
+ */
+enum class CANRecoveryState : uint8_t {
+    RUNNING = 0,        // Bus on, frames flow
+    BACKOFF,            // Bus-off, waiting before the next attempt
+    RECOVERING,         // Recovery started, waiting for 128 x 11 recessive bits
+    RESTART             // Controller stopped, driver must be started (or reinstalled)
+};
+
+/**
+ * @brief Driver operation requested by poll()
+ */
+enum class CANRecoveryAction : uint8_t {
+    NONE = 0,
+    INITIATE_RECOVERY,  // twai_initiate_recovery()
+    START_DRIVER,       // twai_start()
+    REINSTALL_DRIVER    // Uninstall, install and start with the current configuration
+};
+
+/**
+ * @class CANRecoveryController
+ * @brief Bus-off recovery timing (millisecond clock, wrap safe)
+ *
+ * Not thread safe; drive it from the context that reads TWAI alerts.
+ */
+class CANRecoveryController {
+public:
+    /**
+     * @brief Constructor
+     * @param baseDelayMs Wait before the first recovery attempt
+     * @param maxDelayMs Backoff ceiling
+     * @param recoveryTimeoutMs Wait for BUS_RECOVERED before reinstalling
+     * @param stableMs Bus-on time after which backoff starts over
+     */
+    explicit CANRecoveryController(uint32_t baseDelayMs = CAN_RECOVERY_BASE_DELAY_MS,
+                                   uint32_t maxDelayMs = CAN_RECOVERY_MAX_DELAY_MS,
+                                   uint32_t recoveryTimeoutMs = CAN_RECOVERY_TIMEOUT_MS,
+                                   uint32_t stableMs = CAN_RECOVERY_STABLE_MS);
+
+    /**
+     * @brief BUS_OFF alert
+     * @param nowMs Current time
+     */
+    void onBusOff(uint32_t nowMs);
+
+    /**
+     * @brief BUS_RECOVERED alert (controller is now stopped)
+     */
+    void onBusRecovered();
+
+    /**
+     * @brief Next driver operation due at nowMs
+     * @param nowMs Current time
+     * @return Action to execute, then report with onActionResult()
+     */
+    CANRecoveryAction poll(uint32_t nowMs);
+
+    /**
+     * @brief Report the outcome of the action returned by poll()
+     * @param action Executed action
+     * @param success Driver call succeeded
+     * @param nowMs Current time
+     */
+    void onActionResult(CANRecoveryAction action, bool success, uint32_t nowMs);
+
+    /**
+     * @brief Forget any outage (interface restarted by hand)
+     */
+    void reset();
+
+    CANRecoveryState getState() const { return state; }
+    bool isBusOff() const { return state != CANRecoveryState::RUNNING; }
+    uint8_t getAttempt() const { return attempt; }
+    uint32_t getCurrentDelayMs() const { return delayMs; }
+    uint32_t getRecoveries() const { return recoveries; }
+    uint32_t getReinstalls() const { return reinstalls; }
+    uint32_t getLastOutageMs() const { return lastOutageMs; }
+    uint32_t getTotalOutageMs() const { return totalOutageMs; }
+
+private:
+    uint32_t baseDelayMs;
+    uint32_t maxDelayMs;
+    uint32_t recoveryTimeoutMs;
+    uint32_t stableMs;
+
+    CANRecoveryState state;
+    bool reinstall;                 // RESTART needs a reinstall rather than twai_start()
+    uint8_t attempt;                // Consecutive bus-offs within stableMs
+    uint32_t delayMs;
+    uint32_t deadline;              // BACKOFF: attempt time, RECOVERING: timeout
+    uint32_t outageStart;
+    uint32_t lastRecovered;
+    uint32_t recoveries;
+    uint32_t reinstalls;
+    uint32_t lastOutageMs;
+    uint32_t totalOutageMs;
+
+    void enterBackoff(uint32_t nowMs);
+    void finish(uint32_t nowMs);
+
+    uint8_t nextAttempt() const { return attempt < UINT8_MAX ? attempt + 1 : attempt; }
+
+    static bool reached(uint32_t nowMs, uint32_t time) {
+        return static_cast<int32_t>(nowMs - time) >= 0;
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+/**
+ * @file can_ring_buffer.h
+ * @brief Fixed-capacity single-producer/single-consumer lock-free ring
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Statically sized replacement for the std::queue based CAN queues. One
+ * context (driver callback, ISR or RX task) pushes, one context (the app
+ * task) pops. No heap allocation happens after construction, so long
+ * running sessions cannot fragment the heap.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @class CANRingBuffer
+ * @brief Lock-free SPSC ring buffer with overflow accounting
+ *
+ * Head and tail are free-running counters; the slot index is taken with a
+ * mask, so Capacity must be a power of two. A push into a full ring is
+ * rejected (the newest item is dropped) and counted as an overflow.
+ */
+template <typename T, size_t Capacity>
+class CANRingBuffer {
+    static_assert(Capacity >= 2, "CANRingBuffer capacity must be at least 2");
+    static_assert((Capacity & (Capacity - 1)) == 0, "CANRingBuffer capacity must be a power of two");
+
+private:
+    static constexpr size_t INDEX_MASK = Capacity - 1;
+
+    T slots[Capacity];
+    std::atomic<size_t> head;       // Next write position (producer owned)
+    std::atomic<size_t> tail;       // Next read position (consumer owned)
+    std::atomic<uint32_t> overflows; // Rejected pushes
+
+public:
+    /**
+     * @brief Constructor
+     */
+    CANRingBuffer() : head(0), tail(0), overflows(0) {}
+
+    CANRingBuffer(const CANRingBuffer&) = delete;
+    CANRingBuffer& operator=(const CANRingBuffer&) = delete;
+
+    // ===== PRODUCER SIDE =====
+
+    /**
+     * @brief Push item (producer context only, ISR safe)
+     * @param item Item to copy into the ring
+     * @return true if stored, false if ring was full
+     */
+    bool push(const T& item) {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead - tail.load(std::memory_order_acquire) >= Capacity) {
+            overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        slots[currentHead & INDEX_MASK] = item;
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Reserve the next free slot for in-place writing
+     * @return Pointer to slot, or nullptr if ring is full
+     * @note Call commit() to publish the slot; overflow is not counted here
+     */
+    T* reserve() {
+        size_t currentHead = head.load(std::memory_order_relaxed);
+        if (currentHead - tail.load(std::memory_order_acquire) >= Capacity) {
+            return nullptr;
+        }
+        return &slots[currentHead & INDEX_MASK];
+    }
+
+    /**
+     * @brief Publish the slot returned by reserve()
+     */
+    void commit() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Record an overflow detected outside push()
+     */
+    void countOverflow() {
+        overflows.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // ===== CONSUMER SIDE =====
+
+    /**
+     * @brief Pop oldest item (consumer context only)
+     * @param item Reference to store the item
+     * @return true if an item was available
+     */
+    bool pop(T& item) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = slots[currentTail & INDEX_MASK];
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Pop up to maxItems oldest items with one index update (consumer context only)
+     * @param items Destination array
+     * @param maxItems Capacity of items
+     * @return Number of items popped
+     */
+    size_t popBatch(T* items, size_t maxItems) {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        size_t available = head.load(std::memory_order_acquire) - currentTail;
+        size_t count = available < maxItems ? available : maxItems;
+
+        for (size_t i = 0; i < count; i++) {
+            items[i] = slots[(currentTail + i) & INDEX_MASK];
+        }
+        tail.store(currentTail + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Access oldest item without removing it (consumer context only)
+     * @return Pointer to oldest item, or nullptr if ring is empty
+     */
+    const T* front() const {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail == head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[currentTail & INDEX_MASK];
+    }
+
+    /**
+     * @brief Drop oldest item (consumer context only)
+     * @return true if an item was removed
+     */
+    bool drop() {
+        size_t currentTail = tail.load(std::memory_order_relaxed);
+        if (currentTail == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        tail.store(currentTail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Discard all queued items (consumer context only)
+     */
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // ===== STATUS =====
+
+    /**
+     * @brief Number of queued items (snapshot)
+     */
+    size_t size() const {
+        size_t currentTail = tail.load(std::memory_order_acquire);
+        return head.load(std::memory_order_acquire) - currentTail;
+    }
+
+    bool empty() const { return size() == 0; }
+    bool full() const { return size() >= Capacity; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    /**
+     * @brief Number of pushes rejected because the ring was full
+     */
+    uint32_t overflowCount() const {
+        return overflows.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Reset overflow counter
+     */
+    void resetOverflowCount() {
+        overflows.store(0, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,126 @@
+/**
+ * @file can_rx_admission.cpp
+ * @brief Receive admission control implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_rx_admission.h"
+#include "can_types.h"
+
+static_assert(CAN_RX_SHED_BACKGROUND_LEVEL <= CAN_RX_SHED_SUBSCRIBED_LEVEL &&
+              CAN_RX_SHED_SUBSCRIBED_LEVEL <= CAN_RX_RING_SIZE,
+              "RX shed levels must be ordered and fit the receive ring");
+
+CANRxAdmission::CANRxAdmission() : responseUntil(0), requestSent(false) {
+    levels[static_cast<size_t>(CANRxClass::RESPONSE)] = RING_CAPACITY;
+    levels[static_cast<size_t>(CANRxClass::SUBSCRIBED)] = CAN_RX_SHED_SUBSCRIBED_LEVEL;
+    levels[static_cast<size_t>(CANRxClass::BACKGROUND)] = CAN_RX_SHED_BACKGROUND_LEVEL;
+    resetStatistics();
+}
+
+// ===== CONFIGURATION =====
+
+bool CANRxAdmission::setLevels(size_t backgroundLevel, size_t subscribedLevel) {
+    if (backgroundLevel > subscribedLevel || subscribedLevel > RING_CAPACITY) {
+        return false;
+    }
+    levels[index(CANRxClass::SUBSCRIBED)] = subscribedLevel;
+    levels[index(CANRxClass::BACKGROUND)] = backgroundLevel;
+    return true;
+}
+
+bool CANRxAdmission::subscribe(uint32_t id, bool extended) {
+    return subscriptions.set(CANIdIndex::makeKey(id, extended), 1);
+}
+
+bool CANRxAdmission::unsubscribe(uint32_t id, bool extended) {
+    return subscriptions.set(CANIdIndex::makeKey(id, extended), 0);
+}
+
+void CANRxAdmission::clearSubscriptions() {
+    subscriptions.clear();
+}
+
+// ===== TRANSMIT SIDE =====
+
+bool CANRxAdmission::isRequest(const CANFrame& frame) {
+    uint32_t id = frame.id();
+    if (frame.isExtended()) {
+        return id == OBD2CAN::EXT_FUNCTIONAL_REQUEST ||
+               (id & 0xFFFF00FF) == OBD2CAN::EXT_PHYSICAL_REQUEST_BASE;
+    }
+    // Physical requests and the flow control frames of multi-frame answers
+    return id == OBD2CAN::FUNCTIONAL_REQUEST_ID ||
+           (id >= OBD2CAN::PHYSICAL_REQUEST_BASE && id <= OBD2CAN::PHYSICAL_REQUEST_BASE + 7);
+}
+
+void CANRxAdmission::noteTransmit(const CANFrame& frame, uint32_t now) {
+    if (!isRequest(frame)) {
+        return;
+    }
+    if (!requestSent.load(std::memory_order_acquire)) {
+        // Nothing to extend yet; the unset deadline may look later than now
+        responseUntil.store(now + CAN_RX_RESPONSE_WINDOW_MS, std::memory_order_relaxed);
+        requestSent.store(true, std::memory_order_release);
+        return;
+    }
+    extendWindow(now + CAN_RX_RESPONSE_WINDOW_MS);
+}
+
+bool CANRxAdmission::isAwaitingResponse(uint32_t now) const {
+    if (!requestSent.load(std::memory_order_acquire)) {
+        return false;
+    }
+    return static_cast<int32_t>(responseUntil.load(std::memory_order_relaxed) - now) > 0;
+}
+
+void CANRxAdmission::extendWindow(uint32_t until) {
+    // Transmitters and the RX path both extend; the window only moves forward
+    uint32_t current = responseUntil.load(std::memory_order_relaxed);
+    while (static_cast<int32_t>(until - current) > 0 &&
+           !responseUntil.compare_exchange_weak(current, until, std::memory_order_relaxed)) {
+    }
+}
+
+// ===== RECEIVE SIDE =====
+
+bool CANRxAdmission::isResponse(const CANFrame& frame) {
+    uint32_t id = frame.id();
+    if (frame.isExtended()) {
+        return (id & 0xFFFFFF00) == OBD2CAN::EXT_RESPONSE_BASE;
+    }
+    return id >= OBD2CAN::RESPONSE_ID_BASE && id <= OBD2CAN::RESPONSE_ID_BASE + 7;
+}
+
+CANRxClass CANRxAdmission::classify(const CANFrame& frame, uint32_t now) {
+    if (isResponse(frame) && !frame.isRemote() && isAwaitingResponse(now)) {
+        // Single frame "7F <service> 78": the ECU needs longer than P2
+        bool pending = frame.dlc >= 4 && (frame.data[0] & 0xF0) == OBD2CAN::FRAME_TYPE_SINGLE &&
+                       frame.data[1] == 0x7F && frame.data[3] == 0x78;
+        extendWindow(now + (pending ? CAN_RX_RESPONSE_PENDING_MS : CAN_RX_RESPONSE_WINDOW_MS));
+        return CANRxClass::RESPONSE;
+    }
+    if (subscriptions.find(frame) != 0) {
+        return CANRxClass::SUBSCRIBED;
+    }
+    return CANRxClass::BACKGROUND;
+}
+
+// ===== STATISTICS =====
+
+CANRxAdmissionStatistics CANRxAdmission::getStatistics() const {
+    CANRxAdmissionStatistics stats;
+    for (size_t i = 0; i < CAN_RX_CLASS_COUNT; i++) {
+        stats.admitted[i] = admitted[i].load(std::memory_order_relaxed);
+        stats.shed[i] = shed[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void CANRxAdmission::resetStatistics() {
+    for (size_t i = 0; i < CAN_RX_CLASS_COUNT; i++) {
+        admitted[i].store(0, std::memory_order_relaxed);
+        shed[i].store(0, std::memory_order_relaxed);
+    }
+}
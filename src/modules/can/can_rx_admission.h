@@ -0,0 +1,152 @@
+#pragma once
+
+/**
+ * @file can_rx_admission.h
+ * @brief Priority-aware admission of received frames into the RX ring
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * When the application falls behind, a full receive ring used to drop
+ * whatever arrived next, so under a bus storm the answer to our own OBD2
+ * request was as likely to be lost as any broadcast frame. Each accepted
+ * frame is now put in one of three classes and admitted only while the
+ * ring is below that class's level:
+ *
+ *   RESPONSE    a frame on the OBD2 response IDs while a request we sent
+ *               is outstanding; admitted until the ring is full
+ *   SUBSCRIBED  a broadcast ID registered with subscribe(); shed above
+ *               CAN_RX_SHED_SUBSCRIBED_LEVEL
+ *   BACKGROUND  everything else; shed first, above
+ *               CAN_RX_SHED_BACKGROUND_LEVEL
+ *
+ * The ring space above the subscribed level is kept for responses only.
+ * A response window opens when a request (functional, physical or flow
+ * control) is transmitted, is extended by each response frame so
+ * multi-frame answers stay in class, and by CAN_RX_RESPONSE_PENDING_MS
+ * when an ECU answers "response pending" (negative response 0x78).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+#include "can_dispatch.h"
+
+/**
+ * @brief Receive priority class (lower value is kept longer)
+ */
+enum class CANRxClass : uint8_t {
+    RESPONSE = 0,                   // Answer to a request we sent
+    SUBSCRIBED = 1,                 // Broadcast ID someone asked for
+    BACKGROUND = 2                  // Everything else
+};
+
+static constexpr size_t CAN_RX_CLASS_COUNT = 3;
+
+/**
+ * @brief Admission counters, indexed by CANRxClass
+ */
+struct CANRxAdmissionStatistics {
+    uint32_t admitted[CAN_RX_CLASS_COUNT];  // Frames queued
+    uint32_t shed[CAN_RX_CLASS_COUNT];      // Frames dropped at the class level
+};
+
+/**
+ * @class CANRxAdmission
+ * @brief Classifies received frames and sheds them by ring depth
+ *
+ * classify() and admit() run in the RX producer context (receive task or
+ * polled reader). noteTransmit() may run in any transmitting context.
+ * Subscriptions change the ID index in place: CANInterface updates them
+ * under its filter lock.
+ */
+class CANRxAdmission {
+public:
+    static constexpr size_t RING_CAPACITY = CAN_RX_RING_SIZE;
+
+    CANRxAdmission();
+
+    // ===== CONFIGURATION =====
+
+    /**
+     * @brief Set the ring depths at which the lower classes are shed
+     * @param backgroundLevel Background frames are shed at this depth
+     * @param subscribedLevel Subscribed frames are shed at this depth
+     * @return false if the levels are not ordered background <= subscribed <= capacity
+     */
+    bool setLevels(size_t backgroundLevel, size_t subscribedLevel);
+
+    size_t getLevel(CANRxClass rxClass) const { return levels[index(rxClass)]; }
+
+    /**
+     * @brief Treat a broadcast ID as SUBSCRIBED
+     * @return false if the 29-bit table is full
+     */
+    bool subscribe(uint32_t id, bool extended);
+
+    bool unsubscribe(uint32_t id, bool extended);
+
+    void clearSubscriptions();
+
+    // ===== TRANSMIT SIDE =====
+
+    /**
+     * @brief Open the response window if the frame is an OBD2 request
+     * @param now Current time in milliseconds
+     */
+    void noteTransmit(const CANFrame& frame, uint32_t now);
+
+    /**
+     * @brief Check if a response window is open
+     */
+    bool isAwaitingResponse(uint32_t now) const;
+
+    // ===== RECEIVE SIDE =====
+
+    /**
+     * @brief Priority class of an accepted frame
+     * @param now Current time in milliseconds
+     */
+    CANRxClass classify(const CANFrame& frame, uint32_t now);
+
+    /**
+     * @brief Decide whether a frame of this class may be queued
+     * @param queued Frames in the receive ring now
+     * @return true if admitted; either outcome is counted
+     */
+    bool admit(CANRxClass rxClass, size_t queued) {
+        size_t slot = index(rxClass);
+        if (queued >= levels[slot]) {
+            bump(shed[slot]);
+            return false;
+        }
+        bump(admitted[slot]);
+        return true;
+    }
+
+    // ===== STATISTICS =====
+
+    CANRxAdmissionStatistics getStatistics() const;
+
+    void resetStatistics();
+
+private:
+    CANIdIndex subscriptions;       // Slot 1 = subscribed
+    size_t levels[CAN_RX_CLASS_COUNT];
+    std::atomic<uint32_t> responseUntil;        // millis() deadline of the window
+    std::atomic<bool> requestSent;              // responseUntil is unset before the first request
+    std::atomic<uint32_t> admitted[CAN_RX_CLASS_COUNT];
+    std::atomic<uint32_t> shed[CAN_RX_CLASS_COUNT];
+
+    static size_t index(CANRxClass rxClass) { return static_cast<size_t>(rxClass); }
+
+    // Single producer: a plain store avoids a locked read-modify-write per frame
+    static void bump(std::atomic<uint32_t>& counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static bool isRequest(const CANFrame& frame);
+    static bool isResponse(const CANFrame& frame);
+    void extendWindow(uint32_t until);
+};
@@ -0,0 +1,186 @@
+#pragma once
+
+/**
+ * @file can_signal.h
+ * @brief Compile-time signal extract/insert for generated DBC headers
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * A signal descriptor is a type whose static constexpr members give the DBC
+ * layout (see tools/dbc_codegen.py, which writes them). Every position,
+ * mask and scale is known to the compiler, so extract<S>() touches only the
+ * bytes the signal occupies and compiles to a few loads, shifts and masks;
+ * a factor of 1 and offset of 0 disappear entirely. Bit numbering matches
+ * BroadcastDecoder: Intel start bits give the LSB, Motorola start bits give
+ * the MSB in sawtooth numbering (byte * 8 + bit, bit 7 is a byte's MSB).
+ *
+ * Descriptor members:
+ *   static constexpr uint8_t startBit, length;     // length 1-32
+ *   static constexpr bool motorola, isSigned;
+ *   static constexpr float factor, offset;         // physical = raw * factor + offset
+ *
+ * decode()/encode() work in float. When factor and offset are integers,
+ * decodeInteger()/encodeInteger() keep the value exact (a 32-bit raw
+ * value does not survive a float).
+ */
+
+#include <stdint.h>
+#include <type_traits>
+
+namespace CANSignal {
+
+/**
+ * @brief Byte window and shifts derived from a descriptor
+ */
+template <typename S>
+struct Layout {
+    // MSB position counted from byte 0 bit 7 (Motorola only)
+    static constexpr uint32_t MSB_POS = (S::startBit / 8) * 8 + (7 - S::startBit % 8);
+    // Last bit of the signal: Intel counts up from the LSB, Motorola down the sawtooth
+    static constexpr uint32_t LAST_BIT = S::motorola ? MSB_POS + S::length - 1
+                                                     : S::startBit + S::length - 1;
+    static constexpr uint32_t FIRST_BYTE = S::startBit / 8;
+    static constexpr uint32_t LAST_BYTE = LAST_BIT / 8;
+    static constexpr uint32_t BYTES_NEEDED = LAST_BYTE + 1;     // Minimum DLC
+    // Right shift of the window word (bytes FIRST_BYTE..LAST_BYTE)
+    static constexpr uint32_t SHIFT = S::motorola ? 8 * (LAST_BYTE + 1) - 1 - LAST_BIT
+                                                  : S::startBit - 8 * FIRST_BYTE;
+    static constexpr uint32_t MASK = S::length == 32 ? 0xFFFFFFFFUL : (1UL << S::length) - 1;
+    static constexpr uint32_t SIGN_BIT = (MASK >> 1) + 1;
+
+    static_assert(S::length >= 1 && S::length <= 32, "signal length must be 1-32 bits");
+    static_assert(S::startBit <= 63, "start bit outside the payload");
+    static_assert(LAST_BIT <= 63, "signal runs past the end of the payload");
+};
+
+/**
+ * @brief Raw value type: int32_t for signed signals, uint32_t otherwise
+ */
+template <typename S>
+struct Raw {
+    typedef typename std::conditional<S::isSigned, int32_t, uint32_t>::type type;
+};
+
+/**
+ * @brief Load the signal's byte window into a word (window byte order)
+ */
+template <typename S>
+inline uint64_t loadWindow(const uint8_t* data) {
+    typedef Layout<S> L;
+    uint64_t word = 0;
+    for (uint32_t i = L::FIRST_BYTE; i <= L::LAST_BYTE; i++) {
+        if (S::motorola) {
+            word = (word << 8) | data[i];
+        } else {
+            word |= static_cast<uint64_t>(data[i]) << (8 * (i - L::FIRST_BYTE));
+        }
+    }
+    return word;
+}
+
+/**
+ * @brief Extract the raw value, sign-extended for signed signals
+ * @param data Payload, at least Layout<S>::BYTES_NEEDED bytes
+ */
+template <typename S>
+inline typename Raw<S>::type extract(const uint8_t* data) {
+    typedef Layout<S> L;
+    uint32_t raw = static_cast<uint32_t>(loadWindow<S>(data) >> L::SHIFT) & L::MASK;
+    if (S::isSigned) {
+        raw = (raw ^ L::SIGN_BIT) - L::SIGN_BIT;
+    }
+    return static_cast<typename Raw<S>::type>(raw);
+}
+
+/**
+ * @brief Extract the physical value
+ */
+template <typename S>
+inline float decode(const uint8_t* data) {
+    return static_cast<float>(extract<S>(data)) * S::factor + S::offset;
+}
+
+/**
+ * @brief Write a raw value, leaving every other bit of the payload untouched
+ * @param data Payload, at least Layout<S>::BYTES_NEEDED bytes
+ * @param raw Raw value (truncated to the signal length)
+ */
+template <typename S>
+inline void insert(uint8_t* data, typename Raw<S>::type raw) {
+    typedef Layout<S> L;
+    uint64_t mask = static_cast<uint64_t>(L::MASK) << L::SHIFT;
+    uint64_t bits = (static_cast<uint64_t>(static_cast<uint32_t>(raw) & L::MASK) << L::SHIFT);
+    for (uint32_t i = L::FIRST_BYTE; i <= L::LAST_BYTE; i++) {
+        uint32_t offset = S::motorola ? 8 * (L::LAST_BYTE - i) : 8 * (i - L::FIRST_BYTE);
+        uint8_t byteMask = static_cast<uint8_t>(mask >> offset);
+        data[i] = static_cast<uint8_t>((data[i] & ~byteMask) | (static_cast<uint8_t>(bits >> offset) & byteMask));
+    }
+}
+
+/**
+ * @brief Write a physical value, rounded and clamped to the raw range
+ */
+template <typename S>
+inline void encode(uint8_t* data, float physical) {
+    typedef Layout<S> L;
+    const int64_t minRaw = S::isSigned ? -static_cast<int64_t>(L::SIGN_BIT) : 0;
+    const int64_t maxRaw = S::isSigned ? static_cast<int64_t>(L::SIGN_BIT) - 1 : static_cast<int64_t>(L::MASK);
+    float scaled = (physical - S::offset) / S::factor;
+    int64_t raw;
+    if (!(scaled > static_cast<float>(minRaw))) {
+        raw = minRaw;                       // Also catches NaN
+    } else if (scaled >= static_cast<float>(maxRaw)) {
+        raw = maxRaw;
+    } else {
+        raw = static_cast<int64_t>(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+    insert<S>(data, static_cast<typename Raw<S>::type>(raw));
+}
+
+/**
+ * @brief True when factor and offset are integers (physical values are too)
+ */
+template <typename S>
+struct IntegerScale {
+    static constexpr bool value = S::factor != 0.0f &&
+        S::factor == static_cast<float>(static_cast<int64_t>(S::factor)) &&
+        S::offset == static_cast<float>(static_cast<int64_t>(S::offset));
+};
+
+/**
+ * @brief Extract the physical value of an integer-scaled signal, exactly
+ * @tparam T Value type wide enough for the physical range
+ */
+template <typename S, typename T>
+inline T decodeInteger(const uint8_t* data) {
+    static_assert(IntegerScale<S>::value, "factor and offset must be integers");
+    return static_cast<T>(static_cast<int64_t>(extract<S>(data)) * static_cast<int64_t>(S::factor) +
+                          static_cast<int64_t>(S::offset));
+}
+
+/**
+ * @brief Write an integer physical value, rounded and clamped to the raw range
+ */
+template <typename S>
+inline void encodeInteger(uint8_t* data, int64_t physical) {
+    static_assert(IntegerScale<S>::value, "factor and offset must be integers");
+    typedef Layout<S> L;
+    const int64_t minRaw = S::isSigned ? -static_cast<int64_t>(L::SIGN_BIT) : 0;
+    const int64_t maxRaw = S::isSigned ? static_cast<int64_t>(L::SIGN_BIT) - 1 : static_cast<int64_t>(L::MASK);
+    int64_t numerator = physical - static_cast<int64_t>(S::offset);
+    int64_t factor = static_cast<int64_t>(S::factor);
+    if (factor < 0) {
+        numerator = -numerator;
+        factor = -factor;
+    }
+    // Nearest raw step, halves away from zero like encode()
+    int64_t raw = numerator >= 0 ? (numerator + factor / 2) / factor : -((-numerator + factor / 2) / factor);
+    if (raw < minRaw) {
+        raw = minRaw;
+    } else if (raw > maxRaw) {
+        raw = maxRaw;
+    }
+    insert<S>(data, static_cast<typename Raw<S>::type>(raw));
+}
+
+} // namespace CANSignal
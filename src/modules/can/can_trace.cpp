@@ -0,0 +1,541 @@
+/**
+ * @file can_trace.cpp
+ * @brief Indexed binary CAN trace implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_trace.h"
+#include <string.h>
+
+namespace {
+    const size_t XOR_CACHE_SIZE = 64;      // Same-ID payload references per block
+
+    void put16(uint8_t* p, uint16_t v) {
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+    }
+
+    void put32(uint8_t* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            p[i] = (v >> (8 * i)) & 0xFF;
+        }
+    }
+
+    void put64(uint8_t* p, uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            p[i] = (v >> (8 * i)) & 0xFF;
+        }
+    }
+
+    uint16_t get16(const uint8_t* p) {
+        return p[0] | (p[1] << 8);
+    }
+
+    uint32_t get32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint64_t get64(const uint8_t* p) {
+        return get32(p) | (static_cast<uint64_t>(get32(p + 4)) << 32);
+    }
+
+    // Payload reference for the XOR stage: last payload seen per ID slot
+    struct XorCache {
+        uint32_t idFlags[XOR_CACHE_SIZE];
+        uint8_t data[XOR_CACHE_SIZE][8];
+
+        XorCache() {
+            memset(idFlags, 0xFF, sizeof(idFlags));   // No valid frame has all flag bits set
+            memset(data, 0, sizeof(data));
+        }
+
+        uint8_t* reference(uint32_t id, const uint8_t*& previous) {
+            size_t slot = static_cast<uint32_t>(id * 2654435761UL) >> 26;   // Top 6 bits: 64 slots
+            static const uint8_t zeros[8] = {0};
+            previous = idFlags[slot] == id ? data[slot] : zeros;
+            idFlags[slot] = id;
+            return data[slot];
+        }
+    };
+}
+
+// ===== ENCODING =====
+
+namespace CANTrace {
+
+size_t encodeBlock(const uint8_t* raw, size_t count, uint8_t* out, size_t capacity) {
+    XorCache cache;
+    uint8_t previousHeader[8] = {0};
+    size_t length = 0;
+    size_t zeros = 0;
+
+    // Zero-run RLE: literal for non-zero bytes, 0x00 + run length for zeros
+    auto flushZeros = [&]() -> bool {
+        while (zeros > 0) {
+            if (length + 2 > capacity) {
+                return false;
+            }
+            size_t run = zeros > 255 ? 255 : zeros;
+            out[length++] = 0;
+            out[length++] = static_cast<uint8_t>(run);
+            zeros -= run;
+        }
+        return true;
+    };
+    auto emitByte = [&](uint8_t b) -> bool {
+        if (b == 0) {
+            zeros++;
+            return true;
+        }
+        if (!flushZeros() || length + 1 > capacity) {
+            return false;
+        }
+        out[length++] = b;
+        return true;
+    };
+
+    for (size_t r = 0; r < count; r++) {
+        const uint8_t* record = raw + r * RECORD_SIZE;
+
+        // Delta/DLC and ID words against the previous record
+        for (int i = 0; i < 8; i++) {
+            if (!emitByte(record[i] ^ previousHeader[i])) {
+                return 0;
+            }
+        }
+        memcpy(previousHeader, record, 8);
+
+        // Payload against the last payload of the same ID
+        const uint8_t* previous;
+        uint8_t* slot = cache.reference(get32(record + 4), previous);
+        for (int i = 0; i < 8; i++) {
+            if (!emitByte(record[8 + i] ^ previous[i])) {
+                return 0;
+            }
+        }
+        memcpy(slot, record + 8, 8);
+    }
+    return flushZeros() ? length : 0;
+}
+
+bool decodeBlock(const uint8_t* in, size_t length, size_t count, uint8_t* raw) {
+    // Undo RLE
+    size_t total = count * RECORD_SIZE;
+    size_t produced = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (in[i] != 0) {
+            if (produced >= total) {
+                return false;
+            }
+            raw[produced++] = in[i];
+            continue;
+        }
+        if (i + 1 >= length) {
+            return false;
+        }
+        size_t run = in[++i];
+        if (run == 0 || produced + run > total) {
+            return false;
+        }
+        memset(raw + produced, 0, run);
+        produced += run;
+    }
+    if (produced != total) {
+        return false;
+    }
+
+    // Undo XOR in record order
+    XorCache cache;
+    const uint8_t* previousHeader = nullptr;
+    for (size_t r = 0; r < count; r++) {
+        uint8_t* record = raw + r * RECORD_SIZE;
+        if (previousHeader != nullptr) {
+            for (int i = 0; i < 8; i++) {
+                record[i] ^= previousHeader[i];
+            }
+        }
+        previousHeader = record;
+
+        const uint8_t* previous;
+        uint8_t* slot = cache.reference(get32(record + 4), previous);
+        for (int i = 0; i < 8; i++) {
+            record[8 + i] ^= previous[i];
+        }
+        memcpy(slot, record + 8, 8);
+    }
+    return true;
+}
+
+uint32_t checksum(const uint8_t* data, size_t length) {
+    uint32_t hash = 2166136261UL;          // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+}
+
+// ===== RECORDER =====
+
+CANTraceRecorder::CANTraceRecorder(WriteFunction write, bool compress)
+    : write(write), compress(compress), recording(false), active(0), fileOffset(0),
+      indexCount(0), indexInterval(CAN_TRACE_INDEX_INTERVAL_MS * 1000ULL), nextIndexTime(0) {
+    for (Buffer& b : buffers) {
+        b.count = 0;
+        b.state.store(FREE);
+    }
+}
+
+bool CANTraceRecorder::begin(uint64_t startTimestampUs, uint32_t bitrate) {
+    statistics = CANTraceStatistics();
+    fileOffset = 0;
+    indexCount = 0;
+    indexInterval = CAN_TRACE_INDEX_INTERVAL_MS * 1000ULL;
+    nextIndexTime = 0;
+    for (Buffer& b : buffers) {
+        b.count = 0;
+        b.state.store(FREE);
+    }
+    active = 0;
+    buffers[0].state.store(FILLING);
+
+    uint8_t header[CANTrace::HEADER_SIZE] = {0};
+    put32(header, CANTrace::FILE_MAGIC);
+    put16(header + 4, CANTrace::VERSION);
+    put16(header + 6, CANTrace::HEADER_SIZE);
+    put32(header + 8, bitrate);
+    put32(header + 12, BLOCK_RECORDS);
+    put64(header + 16, startTimestampUs);
+    if (!emit(header, sizeof(header))) {
+        return false;
+    }
+    recording = true;
+    return true;
+}
+
+bool CANTraceRecorder::record(const CANFrame& frame) {
+    if (!recording) {
+        return false;
+    }
+
+    Buffer* b = &buffers[active];
+    if (b->count > 0) {
+        // Delta must fit 28 bits and run forward; otherwise start a new block
+        bool backwards = frame.timestamp < b->lastTimestamp;
+        bool full = b->count == BLOCK_RECORDS;
+        if (full || backwards || frame.timestamp - b->lastTimestamp > CANTrace::MAX_DELTA_US) {
+            if (!sealActive()) {
+                statistics.framesDropped++;
+                return false;
+            }
+            b = &buffers[active];
+        }
+    }
+
+    if (b->count == 0) {
+        b->baseTimestamp = frame.timestamp;
+        b->lastTimestamp = frame.timestamp;
+    }
+
+    uint8_t* r = &b->records[b->count * CANTrace::RECORD_SIZE];
+    uint32_t delta = static_cast<uint32_t>(frame.timestamp - b->lastTimestamp);
+    put32(r, delta | (static_cast<uint32_t>(frame.dlc & 0x0F) << 28));
+    put32(r + 4, frame.idFlags);
+    memcpy(r + 8, frame.data, 8);
+    b->lastTimestamp = frame.timestamp;
+    b->count++;
+    statistics.framesRecorded++;
+
+    if (b->count == BLOCK_RECORDS) {
+        sealActive();   // If the writer is behind, the next record() drops
+    }
+    return true;
+}
+
+bool CANTraceRecorder::sealActive() {
+    uint8_t other = active ^ 1;
+    if (buffers[other].state.load(std::memory_order_acquire) != FREE) {
+        return false;                   // Writer still busy with the previous block
+    }
+    buffers[active].state.store(READY, std::memory_order_release);
+    buffers[other].count = 0;
+    buffers[other].state.store(FILLING, std::memory_order_relaxed);
+    active = other;
+    return true;
+}
+
+bool CANTraceRecorder::service() {
+    for (Buffer& b : buffers) {
+        if (b.state.load(std::memory_order_acquire) == READY) {
+            bool ok = writeBlock(b);
+            b.count = 0;
+            b.state.store(FREE, std::memory_order_release);
+            return ok;
+        }
+    }
+    return false;
+}
+
+bool CANTraceRecorder::end() {
+    if (!recording) {
+        return false;
+    }
+    recording = false;
+
+    // Producer has stopped: write the READY block first, then the partial one
+    bool ok = true;
+    while (service()) {
+    }
+    Buffer& current = buffers[active];
+    if (current.count > 0) {
+        ok = writeBlock(current) && ok;
+        current.count = 0;
+    }
+    current.state.store(FREE);
+
+    // Index and footer
+    uint64_t indexOffset = fileOffset;
+    uint8_t entry[CANTrace::INDEX_ENTRY_SIZE];
+    for (size_t i = 0; i < indexCount; i++) {
+        put64(entry, index[i].timestamp);
+        put64(entry + 8, index[i].offset);
+        ok = emit(entry, sizeof(entry)) && ok;
+    }
+    uint8_t footer[CANTrace::FOOTER_SIZE];
+    put32(footer, CANTrace::INDEX_MAGIC);
+    put32(footer + 4, static_cast<uint32_t>(indexCount));
+    put64(footer + 8, indexOffset);
+    return emit(footer, sizeof(footer)) && ok && statistics.writeErrors == 0;
+}
+
+// ===== INTERNAL METHODS =====
+
+bool CANTraceRecorder::writeBlock(Buffer& buffer) {
+    size_t rawLength = buffer.count * CANTrace::RECORD_SIZE;
+    uint8_t* payload = encoded + CANTrace::BLOCK_HEADER_SIZE;
+    uint8_t encoding = CANTrace::ENCODING_RAW;
+    size_t length = 0;
+
+    if (compress) {
+        // Only keep the encoding if it is strictly smaller than raw
+        length = CANTrace::encodeBlock(buffer.records, buffer.count, payload, rawLength - 1);
+        if (length > 0) {
+            encoding = CANTrace::ENCODING_XOR_RLE;
+        }
+    }
+    if (encoding == CANTrace::ENCODING_RAW) {
+        memcpy(payload, buffer.records, rawLength);
+        length = rawLength;
+    }
+
+    put32(encoded, CANTrace::BLOCK_MAGIC);
+    put16(encoded + 4, buffer.count);
+    encoded[6] = encoding;
+    encoded[7] = 0;
+    put32(encoded + 8, static_cast<uint32_t>(length));
+    put64(encoded + 12, buffer.baseTimestamp);
+    put32(encoded + 20, CANTrace::checksum(payload, length));
+
+    addIndexEntry(buffer.baseTimestamp, fileOffset);
+    statistics.rawBytes += rawLength;
+    if (!emit(encoded, CANTrace::BLOCK_HEADER_SIZE + length)) {
+        return false;
+    }
+    statistics.blocksWritten++;
+    return true;
+}
+
+void CANTraceRecorder::addIndexEntry(uint64_t timestamp, uint64_t offset) {
+    if (indexCount > 0 && timestamp < nextIndexTime) {
+        return;
+    }
+    if (indexCount == CAN_TRACE_INDEX_ENTRIES) {
+        // Keep every other entry and halve the resolution: bounded RAM for any trace length
+        for (size_t i = 0; i < indexCount / 2; i++) {
+            index[i] = index[i * 2];
+        }
+        indexCount /= 2;
+        indexInterval *= 2;
+        if (timestamp < index[indexCount - 1].timestamp + indexInterval) {
+            nextIndexTime = index[indexCount - 1].timestamp + indexInterval;
+            return;
+        }
+    }
+    index[indexCount].timestamp = timestamp;
+    index[indexCount].offset = offset;
+    indexCount++;
+    nextIndexTime = timestamp + indexInterval;
+}
+
+bool CANTraceRecorder::emit(const uint8_t* data, size_t length) {
+    if (!write(data, length)) {
+        statistics.writeErrors++;
+        return false;
+    }
+    fileOffset += length;
+    statistics.bytesWritten += length;
+    return true;
+}
+
+// ===== READER =====
+
+CANTraceReader::CANTraceReader(ReadFunction read)
+    : read(read), fileSize(0), dataEnd(0), startTimestamp(0), bitrate(0), blockRecords(0),
+      indexed(false), nextBlockOffset(0), recordCount(0), recordPosition(0),
+      currentTimestamp(0), corruptBlocks(0), blocksRead(0) {}
+
+bool CANTraceReader::open(uint64_t size) {
+    fileSize = size;
+    indexEntries.clear();
+    indexed = false;
+    corruptBlocks = 0;
+    blocksRead = 0;
+
+    uint8_t header[CANTrace::HEADER_SIZE];
+    if (size < CANTrace::HEADER_SIZE || read(0, header, sizeof(header)) != sizeof(header) ||
+        get32(header) != CANTrace::FILE_MAGIC || get16(header + 4) != CANTrace::VERSION) {
+        return false;
+    }
+    bitrate = get32(header + 8);
+    blockRecords = get32(header + 12);
+    startTimestamp = get64(header + 16);
+    payload.resize(blockRecords * CANTrace::RECORD_SIZE);
+    records.resize(blockRecords * CANTrace::RECORD_SIZE);
+    dataEnd = size;
+
+    // Footer is optional (trace may have been cut off)
+    uint8_t footer[CANTrace::FOOTER_SIZE];
+    if (size >= CANTrace::HEADER_SIZE + CANTrace::FOOTER_SIZE &&
+        read(size - CANTrace::FOOTER_SIZE, footer, sizeof(footer)) == sizeof(footer) &&
+        get32(footer) == CANTrace::INDEX_MAGIC) {
+        uint32_t entries = get32(footer + 4);
+        uint64_t indexOffset = get64(footer + 8);
+        if (indexOffset + entries * CANTrace::INDEX_ENTRY_SIZE + CANTrace::FOOTER_SIZE == size) {
+            uint8_t entry[CANTrace::INDEX_ENTRY_SIZE];
+            for (uint32_t i = 0; i < entries; i++) {
+                if (read(indexOffset + i * CANTrace::INDEX_ENTRY_SIZE, entry, sizeof(entry)) != sizeof(entry)) {
+                    break;
+                }
+                indexEntries.push_back(std::make_pair(get64(entry), get64(entry + 8)));
+            }
+            indexed = indexEntries.size() == entries;
+            dataEnd = indexOffset;
+        }
+    }
+
+    nextBlockOffset = CANTrace::HEADER_SIZE;
+    recordCount = 0;
+    recordPosition = 0;
+    return true;
+}
+
+bool CANTraceReader::seek(uint64_t timestampUs) {
+    // Last indexed block starting at or before the target
+    uint64_t offset = CANTrace::HEADER_SIZE;
+    for (const auto& entry : indexEntries) {
+        if (entry.first > timestampUs) {
+            break;
+        }
+        offset = entry.second;
+    }
+    nextBlockOffset = offset;
+    recordCount = 0;
+    recordPosition = 0;
+
+    // Skip whole blocks by header, then records inside the block
+    uint8_t header[CANTrace::BLOCK_HEADER_SIZE];
+    while (nextBlockOffset + CANTrace::BLOCK_HEADER_SIZE <= dataEnd) {
+        if (read(nextBlockOffset, header, sizeof(header)) != sizeof(header) ||
+            get32(header) != CANTrace::BLOCK_MAGIC) {
+            return false;
+        }
+        uint64_t following = nextBlockOffset + CANTrace::BLOCK_HEADER_SIZE + get32(header + 8);
+        if (following + CANTrace::BLOCK_HEADER_SIZE <= dataEnd) {
+            uint8_t nextHeader[CANTrace::BLOCK_HEADER_SIZE];
+            if (read(following, nextHeader, sizeof(nextHeader)) == sizeof(nextHeader) &&
+                get32(nextHeader) == CANTrace::BLOCK_MAGIC && get64(nextHeader + 12) <= timestampUs) {
+                nextBlockOffset = following;    // Target is in a later block
+                continue;
+            }
+        }
+        break;
+    }
+
+    // Walk records without consuming them until the target time
+    while (true) {
+        if (recordPosition >= recordCount) {
+            if (nextBlockOffset + CANTrace::BLOCK_HEADER_SIZE > dataEnd || !loadBlock(nextBlockOffset)) {
+                return false;
+            }
+            continue;
+        }
+        const uint8_t* r = &records[recordPosition * CANTrace::RECORD_SIZE];
+        uint64_t timestamp = currentTimestamp + (get32(r) & CANTrace::MAX_DELTA_US);
+        if (timestamp >= timestampUs) {
+            return true;
+        }
+        currentTimestamp = timestamp;
+        recordPosition++;
+    }
+}
+
+bool CANTraceReader::next(CANFrame& frame) {
+    while (recordPosition >= recordCount) {
+        if (nextBlockOffset + CANTrace::BLOCK_HEADER_SIZE > dataEnd || !loadBlock(nextBlockOffset)) {
+            return false;
+        }
+    }
+
+    const uint8_t* r = &records[recordPosition * CANTrace::RECORD_SIZE];
+    uint32_t deltaDlc = get32(r);
+    currentTimestamp += deltaDlc & CANTrace::MAX_DELTA_US;
+    frame.timestamp = currentTimestamp;
+    frame.dlc = deltaDlc >> 28;
+    frame.idFlags = get32(r + 4);
+    memcpy(frame.data, r + 8, 8);
+    recordPosition++;
+    return true;
+}
+
+bool CANTraceReader::loadBlock(uint64_t offset) {
+    uint8_t header[CANTrace::BLOCK_HEADER_SIZE];
+    while (offset + CANTrace::BLOCK_HEADER_SIZE <= dataEnd) {
+        if (read(offset, header, sizeof(header)) != sizeof(header) || get32(header) != CANTrace::BLOCK_MAGIC) {
+            return false;
+        }
+        uint16_t count = get16(header + 4);
+        uint8_t encoding = header[6];
+        uint32_t length = get32(header + 8);
+        uint64_t next = offset + CANTrace::BLOCK_HEADER_SIZE + length;
+        if (count > blockRecords || length > payload.size() || next > dataEnd) {
+            return false;
+        }
+
+        bool ok = read(offset + CANTrace::BLOCK_HEADER_SIZE, payload.data(), length) == length &&
+                  CANTrace::checksum(payload.data(), length) == get32(header + 20);
+        if (ok && encoding == CANTrace::ENCODING_RAW) {
+            ok = length == count * CANTrace::RECORD_SIZE;
+            if (ok) {
+                memcpy(records.data(), payload.data(), length);
+            }
+        } else if (ok) {
+            ok = encoding == CANTrace::ENCODING_XOR_RLE &&
+                 CANTrace::decodeBlock(payload.data(), length, count, records.data());
+        }
+
+        offset = next;
+        nextBlockOffset = next;
+        if (!ok) {
+            corruptBlocks++;    // Skip it; the next block is self-contained
+            continue;
+        }
+        recordCount = count;
+        recordPosition = 0;
+        currentTimestamp = get64(header + 12);
+        blocksRead++;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+/**
+ * @file can_trace.h
+ * @brief Indexed binary CAN trace format, streaming recorder and reader
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * File layout (little endian):
+ *
+ *   Header  32 bytes   "CTRC", version, bitrate, block size, start time
+ *   Block   24 bytes   "CBLK", record count, encoding, payload length,
+ *                      base timestamp, FNV-1a checksum of the payload
+ *           payload    recordCount x 16-byte records, raw or XOR/RLE coded
+ *   ...
+ *   Index   16 bytes   per entry: block timestamp, block file offset
+ *   Footer  16 bytes   "CIDX", entry count, index file offset
+ *
+ * A record is {delta_us:28 | dlc:4, idFlags, data[8]}; delta is relative to
+ * the previous record (the block base for the first), so every block decodes
+ * on its own and a reader can start at any indexed block. The footer is only
+ * written by end(); without it the reader falls back to walking block
+ * headers.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+
+namespace CANTrace {
+    constexpr uint32_t FILE_MAGIC   = 0x43525443;  // "CTRC"
+    constexpr uint32_t BLOCK_MAGIC  = 0x4B4C4243;  // "CBLK"
+    constexpr uint32_t INDEX_MAGIC  = 0x58444943;  // "CIDX"
+    constexpr uint16_t VERSION      = 1;
+
+    constexpr size_t HEADER_SIZE       = 32;
+    constexpr size_t BLOCK_HEADER_SIZE = 24;
+    constexpr size_t RECORD_SIZE       = 16;
+    constexpr size_t INDEX_ENTRY_SIZE  = 16;
+    constexpr size_t FOOTER_SIZE       = 16;
+
+    constexpr uint32_t MAX_DELTA_US = 0x0FFFFFFF;  // 28 bits, ~268 s
+
+    enum Encoding : uint8_t {
+        ENCODING_RAW = 0,
+        ENCODING_XOR_RLE = 1    // XOR against previous record / same-ID payload, zero-run RLE
+    };
+
+    /**
+     * @brief Encode raw records as ENCODING_XOR_RLE
+     * @param raw Records (count x RECORD_SIZE)
+     * @param count Record count
+     * @param out Output buffer
+     * @param capacity Output capacity
+     * @return Encoded length, or 0 if it would not fit in capacity
+     */
+    size_t encodeBlock(const uint8_t* raw, size_t count, uint8_t* out, size_t capacity);
+
+    /**
+     * @brief Decode an ENCODING_XOR_RLE payload
+     * @param in Encoded payload
+     * @param length Payload length
+     * @param count Record count
+     * @param raw Output records (count x RECORD_SIZE)
+     * @return true if the payload decoded to exactly count records
+     */
+    bool decodeBlock(const uint8_t* in, size_t length, size_t count, uint8_t* raw);
+
+    uint32_t checksum(const uint8_t* data, size_t length);
+}
+
+/**
+ * @brief Recorder counters
+ */
+struct CANTraceStatistics {
+    uint32_t framesRecorded;
+    uint32_t framesDropped;         // Both buffers busy (storage too slow)
+    uint32_t blocksWritten;
+    uint32_t writeErrors;
+    uint64_t bytesWritten;
+    uint64_t rawBytes;              // Record bytes before encoding
+
+    CANTraceStatistics() : framesRecorded(0), framesDropped(0), blocksWritten(0),
+                           writeErrors(0), bytesWritten(0), rawBytes(0) {}
+};
+
+/**
+ * @class CANTraceRecorder
+ * @brief Double-buffered trace writer
+ *
+ * record() runs in the receive context and only copies 16 bytes into the
+ * filling buffer. When it is full the buffers swap and service(), called
+ * from a lower priority writer task, encodes and writes the full one. If
+ * the writer falls a whole block behind, frames are dropped and counted
+ * rather than blocking reception.
+ */
+class CANTraceRecorder {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t length)> WriteFunction;
+
+    static constexpr size_t BLOCK_RECORDS = CAN_TRACE_BLOCK_RECORDS;
+
+    /**
+     * @brief Constructor
+     * @param write Storage backend, appends bytes
+     * @param compress Encode blocks with XOR/RLE when it saves space
+     */
+    explicit CANTraceRecorder(WriteFunction write, bool compress = true);
+
+    /**
+     * @brief Start a trace (writer context, before any record())
+     * @param startTimestampUs Timestamp of the trace start
+     * @param bitrate Bus bitrate, stored in the header
+     * @return true if the header was written
+     */
+    bool begin(uint64_t startTimestampUs, uint32_t bitrate);
+
+    /**
+     * @brief Append a frame (receive context)
+     * @param frame Frame with microsecond timestamp
+     * @return false if dropped
+     */
+    bool record(const CANFrame& frame);
+
+    /**
+     * @brief Write a full block if one is waiting (writer context)
+     * @return true if a block was written
+     */
+    bool service();
+
+    /**
+     * @brief Flush the partial block and write the index (after the last record())
+     * @return true if everything reached storage
+     */
+    bool end();
+
+    bool isRecording() const { return recording; }
+    const CANTraceStatistics& getStatistics() const { return statistics; }
+
+private:
+    enum BufferState : uint8_t { FREE, FILLING, READY };
+
+    struct Buffer {
+        uint8_t records[BLOCK_RECORDS * CANTrace::RECORD_SIZE];
+        uint16_t count;
+        uint64_t baseTimestamp;
+        uint64_t lastTimestamp;
+        std::atomic<uint8_t> state;
+    };
+
+    struct IndexEntry {
+        uint64_t timestamp;
+        uint64_t offset;
+    };
+
+    WriteFunction write;
+    bool compress;
+    volatile bool recording;
+    Buffer buffers[2];
+    uint8_t active;                 // Buffer owned by record()
+    uint8_t encoded[CANTrace::BLOCK_HEADER_SIZE + BLOCK_RECORDS * CANTrace::RECORD_SIZE];
+    uint64_t fileOffset;
+    IndexEntry index[CAN_TRACE_INDEX_ENTRIES];
+    size_t indexCount;
+    uint64_t indexInterval;         // Microseconds; doubles when the index fills
+    uint64_t nextIndexTime;
+    CANTraceStatistics statistics;
+
+    bool sealActive();
+    bool writeBlock(Buffer& buffer);
+    void addIndexEntry(uint64_t timestamp, uint64_t offset);
+    bool emit(const uint8_t* data, size_t length);
+};
+
+/**
+ * @class CANTraceReader
+ * @brief Sequential and time-seeking reader for CTRC traces
+ */
+class CANTraceReader {
+public:
+    /**
+     * @brief Random-access read: copy length bytes at offset into data
+     * @return Bytes read
+     */
+    typedef std::function<size_t(uint64_t offset, uint8_t* data, size_t length)> ReadFunction;
+
+    explicit CANTraceReader(ReadFunction read);
+
+    /**
+     * @brief Parse header and index
+     * @param fileSize Trace size in bytes
+     * @return false if the header is invalid
+     */
+    bool open(uint64_t fileSize);
+
+    /**
+     * @brief Position at the first frame with timestamp >= timestampUs
+     * @return false if no such frame exists
+     */
+    bool seek(uint64_t timestampUs);
+
+    /**
+     * @brief Read the next frame
+     * @return false at end of trace
+     */
+    bool next(CANFrame& frame);
+
+    uint64_t getStartTimestamp() const { return startTimestamp; }
+    uint32_t getBitrate() const { return bitrate; }
+    size_t getIndexSize() const { return indexEntries.size(); }
+    bool hasIndex() const { return indexed; }
+    uint32_t getCorruptBlocks() const { return corruptBlocks; }
+    uint32_t getBlocksRead() const { return blocksRead; }
+
+private:
+    ReadFunction read;
+    uint64_t fileSize;
+    uint64_t dataEnd;               // Start of index, or file size
+    uint64_t startTimestamp;
+    uint32_t bitrate;
+    uint32_t blockRecords;
+    bool indexed;
+    std::vector<std::pair<uint64_t, uint64_t>> indexEntries;   // timestamp, offset
+
+    uint64_t nextBlockOffset;
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> records;
+    size_t recordCount;
+    size_t recordPosition;
+    uint64_t currentTimestamp;
+    uint32_t corruptBlocks;
+    uint32_t blocksRead;
+
+    bool loadBlock(uint64_t offset);
+};
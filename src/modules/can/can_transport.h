@@ -0,0 +1,156 @@
+#pragma once
+
+/**
+ * @file can_transport.h
+ * @brief Controller backend interface below CANInterface
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * CANInterface owns queues, filters, statistics, recovery and the receive
+ * task; a transport only moves frames to and from one controller. The
+ * calls mirror the TWAI driver (install/start/stop, transmit/receive with
+ * a timeout, alert-style events, status counters) so the built-in TWAI
+ * backend is a thin wrapper and other controllers can slot in behind the
+ * same receive task and recovery logic.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../config/project_config.h"
+#include "can_types.h"
+#include "can_frame.h"
+#include "can_hw_filter.h"
+
+/**
+ * @brief Event bits returned by CANTransport::readEvents() (TWAI alert equivalents)
+ */
+namespace CANTransportEvent {
+    constexpr uint32_t RX_DATA       = 0x0001;  // Frames waiting in receive()
+    constexpr uint32_t TX_SUCCESS    = 0x0002;  // A frame left the backend's TX queue
+    constexpr uint32_t TX_FAILED     = 0x0004;  // A frame was given up on
+    constexpr uint32_t BUS_ERROR     = 0x0008;
+    constexpr uint32_t ARB_LOST      = 0x0010;
+    constexpr uint32_t BUS_OFF       = 0x0020;
+    constexpr uint32_t BUS_RECOVERED = 0x0040;  // Recovery finished, start() to rejoin
+    constexpr uint32_t RX_OVERFLOW   = 0x0080;  // Frames lost in the controller or backend queue
+}
+
+/**
+ * @brief Result of a transmit or receive call
+ */
+enum class CANTransportResult : uint8_t {
+    OK = 0,
+    TIMEOUT,            // TX queue full or nothing received within the timeout
+    NOT_RUNNING,        // Not installed/started, or bus-off
+    FAILED              // Controller error
+};
+
+/**
+ * @brief Controller state
+ */
+enum class CANTransportState : uint8_t {
+    STOPPED = 0,
+    RUNNING,
+    BUS_OFF,
+    RECOVERING
+};
+
+/**
+ * @brief Install-time configuration
+ */
+struct CANTransportConfig {
+    CANSpeed speed;
+    CANMode mode;
+    CANAcceptanceFilter filter;     // Backends apply what their hardware can express (getAppliedFilter)
+    uint32_t rxQueueLength;         // Backend receive queue (frames)
+    uint32_t txQueueLength;         // Backend transmit queue (frames)
+
+    CANTransportConfig() : speed(CANSpeed::CAN_500KBPS), mode(CANMode::NORMAL),
+                           rxQueueLength(CAN_DRIVER_RX_QUEUE_LEN),
+                           txQueueLength(CAN_DRIVER_TX_QUEUE_LEN) {}
+};
+
+/**
+ * @brief Controller status; counters are cumulative since install()
+ */
+struct CANTransportStatus {
+    CANTransportState state;
+    uint32_t txPending;             // Frames queued but not yet on the bus
+    uint32_t rxPending;             // Frames waiting for receive()
+    uint8_t txErrorCounter;
+    uint8_t rxErrorCounter;
+    uint32_t txFailed;
+    uint32_t rxMissed;              // Lost to a full backend queue
+    uint32_t rxOverrun;             // Lost in the controller itself
+    uint32_t arbitrationLost;
+    uint32_t busErrors;
+
+    CANTransportStatus() : state(CANTransportState::STOPPED), txPending(0), rxPending(0),
+                           txErrorCounter(0), rxErrorCounter(0), txFailed(0), rxMissed(0),
+                           rxOverrun(0), arbitrationLost(0), busErrors(0) {}
+};
+
+/**
+ * @class CANTransport
+ * @brief One CAN controller
+ *
+ * transmit() and receive() may be called from different tasks; readEvents()
+ * has a single caller (the receive task, or the polling loop).
+ */
+class CANTransport {
+public:
+    virtual ~CANTransport() {}
+
+    /**
+     * @brief Configure the controller and allocate queues (not started)
+     */
+    virtual bool install(const CANTransportConfig& config) = 0;
+
+    /**
+     * @brief Release the controller; queued frames are discarded
+     */
+    virtual void uninstall() = 0;
+
+    virtual bool start() = 0;
+    virtual bool stop() = 0;
+
+    /**
+     * @brief Queue a frame for transmission
+     * @param frame Frame to send
+     * @param timeoutMs Wait for queue space (0 = return TIMEOUT at once)
+     * @param singleShot Give up after one attempt instead of retrying
+     */
+    virtual CANTransportResult transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                        bool singleShot = false) = 0;
+
+    /**
+     * @brief Take a received frame (timestamp set by the backend)
+     * @param frame Receives the frame
+     * @param timeoutMs Wait for a frame (0 = poll)
+     */
+    virtual CANTransportResult receive(CANFrame& frame, uint32_t timeoutMs) = 0;
+
+    /**
+     * @brief Wait for events
+     * @param timeoutMs Longest wait; 0 returns pending events only
+     * @return CANTransportEvent bits raised since the last call
+     */
+    virtual uint32_t readEvents(uint32_t timeoutMs) = 0;
+
+    virtual bool getStatus(CANTransportStatus& status) = 0;
+
+    /**
+     * @brief Acceptance filter the controller enforces since install()
+     * @return The installed filter, or accept-all where the backend could not
+     *         load it as given; CANInterface only skips software filtering
+     *         when this is the filter it asked for
+     */
+    virtual CANAcceptanceFilter getAppliedFilter() const = 0;
+
+    /**
+     * @brief Start bus-off recovery (BUS_RECOVERED follows when done)
+     */
+    virtual bool initiateRecovery() = 0;
+
+    virtual const char* getName() const = 0;
+};
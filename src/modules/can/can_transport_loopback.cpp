@@ -0,0 +1,213 @@
+/**
+ * @file can_transport_loopback.cpp
+ * @brief In-memory CAN transport
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_transport_loopback.h"
+#include <chrono>
+#include <thread>
+
+CANLoopbackTransport::CANLoopbackTransport(ClockUs clock)
+    : clock(clock), peer(nullptr), mode(CANMode::NORMAL), installed(false),
+      state(CANTransportState::STOPPED), pendingEvents(0), txFailed(0), rxMissed(0) {
+    lockFlag.clear();
+}
+
+void CANLoopbackTransport::connect(CANLoopbackTransport* other) {
+    if (peer != nullptr && peer != other) {
+        peer->peer = nullptr;
+    }
+    peer = other;
+    if (other != nullptr) {
+        other->peer = this;
+    }
+}
+
+void CANLoopbackTransport::injectBusOff() {
+    if (state != CANTransportState::RUNNING) {
+        return;
+    }
+    state = CANTransportState::BUS_OFF;
+    raise(CANTransportEvent::BUS_OFF);
+}
+
+// ===== LIFECYCLE =====
+
+bool CANLoopbackTransport::install(const CANTransportConfig& config) {
+    mode = config.mode;
+    rxRing.clear();
+    pendingEvents.store(0);
+    txFailed.store(0);
+    rxMissed.store(0);
+    state = CANTransportState::STOPPED;
+    installed = true;
+    return true;
+}
+
+void CANLoopbackTransport::uninstall() {
+    installed = false;
+    state = CANTransportState::STOPPED;
+    rxRing.clear();
+}
+
+bool CANLoopbackTransport::start() {
+    if (!installed) {
+        return false;
+    }
+    state = CANTransportState::RUNNING;
+    return true;
+}
+
+bool CANLoopbackTransport::stop() {
+    if (!installed) {
+        return false;
+    }
+    state = CANTransportState::STOPPED;
+    return true;
+}
+
+// ===== FRAMES =====
+
+CANTransportResult CANLoopbackTransport::transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                                  bool singleShot) {
+    (void)timeoutMs;
+    (void)singleShot;
+    if (!installed || state != CANTransportState::RUNNING) {
+        return CANTransportResult::NOT_RUNNING;
+    }
+    if (mode == CANMode::LISTEN_ONLY) {
+        return CANTransportResult::FAILED;
+    }
+
+    uint64_t timestamp = now();
+    CANLoopbackTransport* target = peer;
+    bool delivered = true;
+    if (target == nullptr) {
+        deliver(frame, timestamp);
+    } else {
+        // A stopped peer cannot acknowledge; NO_ACK mode does not need it to
+        if (target->installed && target->state == CANTransportState::RUNNING) {
+            target->deliver(frame, timestamp);
+        } else {
+            delivered = mode == CANMode::NO_ACK;
+        }
+        if (mode == CANMode::SELF_TEST) {
+            deliver(frame, timestamp);
+        }
+    }
+
+    if (delivered) {
+        raise(CANTransportEvent::TX_SUCCESS);
+    } else {
+        txFailed.fetch_add(1, std::memory_order_relaxed);
+        raise(CANTransportEvent::TX_FAILED);
+    }
+    return CANTransportResult::OK;
+}
+
+CANTransportResult CANLoopbackTransport::receive(CANFrame& frame, uint32_t timeoutMs) {
+    if (!installed) {
+        return CANTransportResult::NOT_RUNNING;
+    }
+    for (uint32_t waited = 0; ; waited++) {
+        if (rxRing.pop(frame)) {
+            return CANTransportResult::OK;
+        }
+        if (waited >= timeoutMs) {
+            return CANTransportResult::TIMEOUT;
+        }
+        sleepMs(1);
+    }
+}
+
+void CANLoopbackTransport::deliver(const CANFrame& frame, uint64_t timestampUs) {
+    // Several transmitters may deliver at once; the ring takes one producer
+    lock();
+    bool stored = false;
+    CANFrame* slot = rxRing.reserve();
+    if (slot != nullptr) {
+        *slot = frame;
+        slot->idFlags &= ~CANFrame::FLAG_ERROR;
+        slot->timestamp = timestampUs;
+        rxRing.commit();
+        stored = true;
+    } else {
+        rxRing.countOverflow();
+    }
+    unlock();
+
+    if (stored) {
+        raise(CANTransportEvent::RX_DATA);
+    } else {
+        rxMissed.fetch_add(1, std::memory_order_relaxed);
+        raise(CANTransportEvent::RX_OVERFLOW);
+    }
+}
+
+// ===== EVENTS & STATUS =====
+
+uint32_t CANLoopbackTransport::readEvents(uint32_t timeoutMs) {
+    if (!installed) {
+        return 0;
+    }
+    for (uint32_t waited = 0; ; waited++) {
+        uint32_t events = pendingEvents.exchange(0, std::memory_order_relaxed);
+        if (!rxRing.empty()) {
+            events |= CANTransportEvent::RX_DATA;
+        }
+        if (events != 0 || waited >= timeoutMs) {
+            return events;
+        }
+        sleepMs(1);
+    }
+}
+
+bool CANLoopbackTransport::getStatus(CANTransportStatus& status) {
+    if (!installed) {
+        return false;
+    }
+    status = CANTransportStatus();
+    status.state = state;
+    status.rxPending = static_cast<uint32_t>(rxRing.size());
+    status.txFailed = txFailed.load(std::memory_order_relaxed);
+    status.rxMissed = rxMissed.load(std::memory_order_relaxed);
+    if (state == CANTransportState::BUS_OFF) {
+        status.txErrorCounter = 255;
+    }
+    return true;
+}
+
+bool CANLoopbackTransport::initiateRecovery() {
+    if (state != CANTransportState::BUS_OFF) {
+        return false;
+    }
+    state = CANTransportState::STOPPED;
+    raise(CANTransportEvent::BUS_RECOVERED);
+    return true;
+}
+
+// ===== INTERNAL METHODS =====
+
+void CANLoopbackTransport::lock() {
+    while (lockFlag.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+void CANLoopbackTransport::unlock() {
+    lockFlag.clear(std::memory_order_release);
+}
+
+uint64_t CANLoopbackTransport::now() const {
+    if (clock != nullptr) {
+        return static_cast<uint64_t>(clock());
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CANLoopbackTransport::sleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
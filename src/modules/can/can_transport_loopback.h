@@ -0,0 +1,82 @@
+#pragma once
+
+/**
+ * @file can_transport_loopback.h
+ * @brief In-memory CAN transport
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Frames never touch a controller: a transmitted frame lands in the
+ * receive queue of the connected peer, or back in the sender's own when
+ * there is no peer (SELF_TEST mode delivers to both, like TWAI self
+ * test). Lets everything above the transport run and be benchmarked on
+ * a bench without a bus, and two CANInterface instances talk to each
+ * other. Bus-off can be injected to exercise recovery.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "../../config/project_config.h"
+#include "can_transport.h"
+#include "can_ring_buffer.h"
+
+/**
+ * @class CANLoopbackTransport
+ * @brief Loopback backend; transmit completes at once, waits are 1 ms sleeps
+ */
+class CANLoopbackTransport : public CANTransport {
+public:
+    typedef int64_t (*ClockUs)();
+
+    static constexpr size_t RX_CAPACITY = CAN_RX_RING_SIZE;
+
+    /**
+     * @brief Constructor
+     * @param clock Timestamp source (esp_timer_get_time on target; nullptr = steady clock)
+     */
+    explicit CANLoopbackTransport(ClockUs clock = nullptr);
+
+    /**
+     * @brief Cross-connect two transports (nullptr disconnects this one)
+     */
+    void connect(CANLoopbackTransport* other);
+
+    /**
+     * @brief Force bus-off (BUS_OFF event; initiateRecovery() ends it)
+     */
+    void injectBusOff();
+
+    bool install(const CANTransportConfig& config) override;
+    void uninstall() override;
+    bool start() override;
+    bool stop() override;
+    CANTransportResult transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                bool singleShot = false) override;
+    CANTransportResult receive(CANFrame& frame, uint32_t timeoutMs) override;
+    uint32_t readEvents(uint32_t timeoutMs) override;
+    bool getStatus(CANTransportStatus& status) override;
+    bool initiateRecovery() override;
+    CANAcceptanceFilter getAppliedFilter() const override { return CANAcceptanceFilter(); }  // Passes every frame
+    const char* getName() const override { return "Loopback"; }
+
+private:
+    ClockUs clock;
+    CANLoopbackTransport* peer;
+    CANMode mode;
+    volatile bool installed;
+    volatile CANTransportState state;
+
+    CANRingBuffer<CANFrame, RX_CAPACITY> rxRing;    // Producers serialized by lockFlag
+    std::atomic<uint32_t> pendingEvents;
+    std::atomic<uint32_t> txFailed;
+    std::atomic<uint32_t> rxMissed;
+    std::atomic_flag lockFlag;
+
+    void lock();
+    void unlock();
+    void deliver(const CANFrame& frame, uint64_t timestampUs);
+    void raise(uint32_t events) { pendingEvents.fetch_or(events, std::memory_order_relaxed); }
+    uint64_t now() const;
+    static void sleepMs(uint32_t ms);
+};
@@ -0,0 +1,579 @@
+/**
+ * @file can_transport_mcp2515.cpp
+ * @brief CAN transport over an external MCP2515 SPI controller
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_transport_mcp2515.h"
+#include <string.h>
+
+using namespace MCP2515;
+
+namespace {
+
+constexpr uint32_t MODE_SWITCH_TIMEOUT_MS = 10;    // Leaving normal mode waits for bus idle
+
+uint32_t bitrateOf(CANSpeed speed) {
+    switch (speed) {
+        case CANSpeed::CAN_125KBPS:
+            return 125000;
+        case CANSpeed::CAN_250KBPS:
+            return 250000;
+        case CANSpeed::CAN_1MBPS:
+            return 1000000;
+        default:
+            return 500000;
+    }
+}
+
+uint8_t opmodeFor(CANMode mode) {
+    switch (mode) {
+        case CANMode::LISTEN_ONLY:
+            return MODE_LISTEN;
+        case CANMode::SELF_TEST:
+        case CANMode::NO_ACK:
+            return MODE_LOOPBACK;
+        default:
+            return MODE_NORMAL;
+    }
+}
+
+// Identifier register layout shared by buffers, masks and filters
+void packId(uint32_t id, bool extended, uint8_t* regs) {
+    if (extended) {
+        regs[0] = static_cast<uint8_t>(id >> 21);
+        regs[1] = static_cast<uint8_t>((((id >> 18) & 0x07) << 5) | SIDL_IDE | ((id >> 16) & 0x03));
+        regs[2] = static_cast<uint8_t>(id >> 8);
+        regs[3] = static_cast<uint8_t>(id);
+    } else {
+        regs[0] = static_cast<uint8_t>(id >> 3);
+        regs[1] = static_cast<uint8_t>((id & 0x07) << 5);
+        regs[2] = 0;
+        regs[3] = 0;
+    }
+}
+
+} // namespace
+
+CANMCP2515Transport::CANMCP2515Transport(CANMCP2515Port& port, uint32_t oscillatorHz)
+    : port(port), oscillatorHz(oscillatorHz), mode(CANMode::NORMAL), installed(false),
+      state(CANTransportState::STOPPED), txHead(0), txCount(0), txLimit(TX_CAPACITY),
+      txBusy(false), oneShotMode(false), pendingEvents(0) {
+}
+
+// ===== CONTROLLER LIFECYCLE =====
+
+bool CANMCP2515Transport::install(const CANTransportConfig& config) {
+    if (installed) {
+        uninstall();
+    }
+    if (!port.begin()) {
+        return false;
+    }
+
+    port.lock();
+    uint8_t reset = INSTR_RESET;
+    port.transfer(&reset, nullptr, 1);
+
+    // Reset leaves the controller in configuration mode; seeing it there
+    // also proves something answers on the bus
+    uint8_t setup[4];
+    bool ok = requestMode(MODE_CONFIG) &&
+              computeBitTiming(oscillatorHz, bitrateOf(config.speed), setup);
+    if (ok) {
+        // CNF3, CNF2, CNF1 and CANINTE are consecutive
+        setup[3] = INT_RX0 | INT_RX1 | INT_TX0 | INT_ERR | INT_MERR;
+        writeRegisters(REG_CNF3, setup, sizeof(setup));
+
+        uint8_t mask[4];
+        uint8_t code[4];
+        uint8_t rxControl[2];
+        appliedFilter = CANAcceptanceFilter();
+        if (computeAcceptance(config.filter, mask, code)) {
+            // Both buffers must pass the same IDs or rollover would split them
+            uint8_t filters[12];
+            for (size_t i = 0; i < 3; i++) {
+                memcpy(&filters[i * 4], code, 4);
+            }
+            writeRegisters(REG_RXF0SIDH, filters, sizeof(filters));
+            writeRegisters(REG_RXF3SIDH, filters, sizeof(filters));
+            uint8_t masks[8];
+            memcpy(masks, mask, 4);
+            memcpy(&masks[4], mask, 4);
+            writeRegisters(REG_RXM0SIDH, masks, sizeof(masks));
+            rxControl[0] = RXB0_BUKT;
+            rxControl[1] = 0;
+            appliedFilter = config.filter;
+        } else {
+            rxControl[0] = RXB_RXM_ANY | RXB0_BUKT;
+            rxControl[1] = RXB_RXM_ANY;
+        }
+        writeRegisters(REG_RXB0CTRL, &rxControl[0], 1);
+        writeRegisters(REG_RXB1CTRL, &rxControl[1], 1);
+    }
+
+    mode = config.mode;
+    state = CANTransportState::STOPPED;
+    rxRing.clear();
+    txHead = 0;
+    txCount = 0;
+    txLimit = config.txQueueLength == 0 ? 1 :
+              config.txQueueLength < TX_CAPACITY ? config.txQueueLength : TX_CAPACITY;
+    txBusy = false;
+    oneShotMode = false;
+    pendingEvents = 0;
+    counters = CANTransportStatus();
+    installed = ok;
+    port.unlock();
+
+    if (!ok) {
+        port.end();
+    }
+    return ok;
+}
+
+void CANMCP2515Transport::uninstall() {
+    if (!installed) {
+        return;
+    }
+    port.lock();
+    uint8_t reset = INSTR_RESET;
+    port.transfer(&reset, nullptr, 1);
+    installed = false;
+    state = CANTransportState::STOPPED;
+    appliedFilter = CANAcceptanceFilter();
+    txBusy = false;
+    txCount = 0;
+    port.unlock();
+    rxRing.clear();
+    port.end();
+}
+
+bool CANMCP2515Transport::start() {
+    if (!installed) {
+        return false;
+    }
+    port.lock();
+    // Also clears CANCTRL.OSM
+    bool ok = requestMode(opmodeFor(mode));
+    if (ok) {
+        oneShotMode = false;
+        state = CANTransportState::RUNNING;
+    }
+    port.unlock();
+    return ok;
+}
+
+bool CANMCP2515Transport::stop() {
+    if (!installed) {
+        return false;
+    }
+    port.lock();
+    dropTransmits();
+    bool ok = requestMode(MODE_CONFIG);
+    state = CANTransportState::STOPPED;
+    port.unlock();
+    return ok;
+}
+
+// ===== FRAMES =====
+
+CANTransportResult CANMCP2515Transport::transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                                 bool singleShot) {
+    if (!installed) {
+        return CANTransportResult::NOT_RUNNING;
+    }
+    if (mode == CANMode::LISTEN_ONLY) {
+        return CANTransportResult::FAILED;
+    }
+
+    TxSlot slot;
+    slot.frame = frame;
+    slot.singleShot = singleShot;
+    uint32_t started = port.millis();
+
+    for (;;) {
+        port.lock();
+        if (state != CANTransportState::RUNNING) {
+            port.unlock();
+            return CANTransportResult::NOT_RUNNING;
+        }
+
+        bool queued = true;
+        if (!txBusy) {
+            load(slot);
+        } else if (txCount < txLimit) {
+            txQueue[(txHead + txCount) % TX_CAPACITY] = slot;
+            txCount++;
+        } else {
+            queued = false;
+        }
+
+        // Full: a completion may already be waiting behind the INT line
+        uint32_t events = 0;
+        if (!queued && port.interruptPending()) {
+            events = service();
+        }
+        port.unlock();
+
+        if (queued) {
+            return CANTransportResult::OK;
+        }
+        if (events != 0) {
+            port.wake();        // Whoever waits in readEvents() gets these
+            continue;
+        }
+
+        uint32_t elapsed = port.millis() - started;
+        if (elapsed >= timeoutMs) {
+            return CANTransportResult::TIMEOUT;
+        }
+        // Short waits: the receive task may take the interrupt first
+        port.waitForInterrupt(1);
+    }
+}
+
+CANTransportResult CANMCP2515Transport::receive(CANFrame& frame, uint32_t timeoutMs) {
+    if (!installed) {
+        return CANTransportResult::NOT_RUNNING;
+    }
+
+    uint32_t started = port.millis();
+    for (;;) {
+        if (rxRing.pop(frame)) {
+            return CANTransportResult::OK;
+        }
+        if (port.interruptPending()) {
+            port.lock();
+            service();
+            port.unlock();
+            if (rxRing.pop(frame)) {
+                return CANTransportResult::OK;
+            }
+        }
+
+        uint32_t elapsed = port.millis() - started;
+        if (elapsed >= timeoutMs) {
+            return CANTransportResult::TIMEOUT;
+        }
+        port.waitForInterrupt(timeoutMs - elapsed);
+    }
+}
+
+// ===== EVENTS & STATUS =====
+
+uint32_t CANMCP2515Transport::readEvents(uint32_t timeoutMs) {
+    if (!installed) {
+        return 0;
+    }
+
+    port.lock();
+    bool ready = pendingEvents != 0;
+    port.unlock();
+    if (!ready && rxRing.empty() && timeoutMs > 0 && !port.interruptPending()) {
+        port.waitForInterrupt(timeoutMs);
+    }
+
+    port.lock();
+    // EFLG is watched while bus-off, the controller recovers on its own
+    if (port.interruptPending() || state == CANTransportState::BUS_OFF ||
+        state == CANTransportState::RECOVERING) {
+        service();
+    }
+    uint32_t events = pendingEvents;
+    pendingEvents = 0;
+    port.unlock();
+
+    if (!rxRing.empty()) {
+        events |= CANTransportEvent::RX_DATA;
+    }
+    return events;
+}
+
+bool CANMCP2515Transport::getStatus(CANTransportStatus& status) {
+    if (!installed) {
+        return false;
+    }
+    port.lock();
+    status = counters;
+    status.state = state;
+    status.txPending = static_cast<uint32_t>(txCount + (txBusy ? 1 : 0));
+    port.unlock();
+    status.rxPending = static_cast<uint32_t>(rxRing.size());
+    return true;
+}
+
+bool CANMCP2515Transport::initiateRecovery() {
+    port.lock();
+    bool busOff = installed && state == CANTransportState::BUS_OFF;
+    if (busOff) {
+        state = CANTransportState::RECOVERING;
+    }
+    port.unlock();
+    return busOff;
+}
+
+// ===== CONTROLLER SERVICE =====
+
+uint32_t CANMCP2515Transport::service() {
+    // CANINTF and EFLG are adjacent: one read says what happened
+    uint8_t flags[2];
+    readRegisters(REG_CANINTF, flags, sizeof(flags));
+    uint8_t interrupts = flags[0];
+    uint8_t errors = flags[1];
+    uint64_t now = port.micros();
+    uint32_t events = 0;
+    uint8_t handled = 0;
+
+    if ((interrupts & (INT_RX0 | INT_RX1)) == (INT_RX0 | INT_RX1)) {
+        // Both full: one burst across RXB0, CANSTAT/CANCTRL, RXB1CTRL and RXB1.
+        // RXB0 filled first (RXB1 only takes rollover), so it goes first.
+        uint8_t tx[2 + RX_BURST_SIZE] = {INSTR_READ, REG_RXB0SIDH};
+        uint8_t rx[2 + RX_BURST_SIZE];
+        port.transfer(tx, rx, sizeof(tx));
+        storeReceived(&rx[2], now, events);
+        storeReceived(&rx[2 + REG_RXB1SIDH - REG_RXB0SIDH], now, events);
+        handled |= INT_RX0 | INT_RX1;
+    } else if (interrupts & (INT_RX0 | INT_RX1)) {
+        // READ RX BUFFER releases the buffer when chip select rises
+        uint8_t tx[1 + BUFFER_SIZE] = {
+            static_cast<uint8_t>((interrupts & INT_RX0) ? INSTR_READ_RXB0 : INSTR_READ_RXB1)};
+        uint8_t rx[1 + BUFFER_SIZE];
+        port.transfer(tx, rx, sizeof(tx));
+        storeReceived(&rx[1], now, events);
+    }
+
+    if (interrupts & INT_TX0) {
+        handled |= INT_TX0;
+        if (txBusy) {
+            txBusy = false;
+            events |= CANTransportEvent::TX_SUCCESS;
+        }
+    }
+
+    if (interrupts & INT_MERR) {
+        handled |= INT_MERR;
+        uint8_t control;
+        readRegisters(REG_TXB0CTRL, &control, 1);
+        counters.busErrors++;
+        events |= CANTransportEvent::BUS_ERROR;
+        if (control & TXB_MLOA) {
+            counters.arbitrationLost++;
+            events |= CANTransportEvent::ARB_LOST;
+        }
+        // TXREQ still set means the controller keeps retrying; clear means
+        // a one-shot frame was given up on
+        if (txBusy && !(control & TXB_TXREQ) && !(interrupts & INT_TX0)) {
+            txBusy = false;
+            counters.txFailed++;
+            events |= CANTransportEvent::TX_FAILED;
+        }
+    }
+
+    if (interrupts & INT_ERR) {
+        handled |= INT_ERR;
+        uint8_t errorCounters[2];
+        readRegisters(REG_TEC, errorCounters, sizeof(errorCounters));
+        counters.txErrorCounter = errorCounters[0];
+        counters.rxErrorCounter = errorCounters[1];
+        events |= CANTransportEvent::BUS_ERROR;
+    }
+
+    if (errors & (EFLG_RX0OVR | EFLG_RX1OVR)) {
+        counters.rxOverrun += ((errors & EFLG_RX0OVR) ? 1 : 0) + ((errors & EFLG_RX1OVR) ? 1 : 0);
+        modifyRegister(REG_EFLG, EFLG_RX0OVR | EFLG_RX1OVR, 0);
+        events |= CANTransportEvent::RX_OVERFLOW;
+    }
+
+    if ((errors & EFLG_TXBO) && state == CANTransportState::RUNNING) {
+        state = CANTransportState::BUS_OFF;
+        counters.txFailed += dropTransmits();
+        events |= CANTransportEvent::BUS_OFF;
+    } else if (!(errors & EFLG_TXBO) && state == CANTransportState::RECOVERING) {
+        // Like TWAI, a recovered controller waits for start()
+        state = CANTransportState::STOPPED;
+        events |= CANTransportEvent::BUS_RECOVERED;
+    }
+
+    // Release flags before reloading TXB0 so its completion cannot be cleared unseen
+    if (handled != 0) {
+        modifyRegister(REG_CANINTF, handled, 0);
+    }
+    if (!txBusy && state == CANTransportState::RUNNING) {
+        loadNext();
+    }
+
+    pendingEvents |= events;
+    return events;
+}
+
+void CANMCP2515Transport::storeReceived(const uint8_t* buffer, uint64_t timestampUs, uint32_t& events) {
+    CANFrame* slot = rxRing.reserve();
+    if (slot == nullptr) {
+        rxRing.countOverflow();
+        counters.rxMissed++;
+        events |= CANTransportEvent::RX_OVERFLOW;
+        return;
+    }
+    decodeBuffer(buffer, *slot, timestampUs);
+    rxRing.commit();
+    events |= CANTransportEvent::RX_DATA;
+}
+
+void CANMCP2515Transport::load(const TxSlot& slot) {
+    if (slot.singleShot != oneShotMode) {
+        modifyRegister(REG_CANCTRL, CANCTRL_OSM, slot.singleShot ? CANCTRL_OSM : 0);
+        oneShotMode = slot.singleShot;
+    }
+
+    // LOAD TX BUFFER writes header and payload without an address byte
+    uint8_t tx[1 + BUFFER_SIZE];
+    tx[0] = INSTR_LOAD_TXB0;
+    encodeHeader(slot.frame, &tx[1]);
+    size_t payload = slot.frame.isRemote() ? 0 : (tx[5] & 0x0F);
+    memcpy(&tx[6], slot.frame.data, payload);
+    port.transfer(tx, nullptr, 6 + payload);
+
+    uint8_t send = INSTR_RTS_TXB0;
+    port.transfer(&send, nullptr, 1);
+    txBusy = true;
+}
+
+void CANMCP2515Transport::loadNext() {
+    if (txCount == 0) {
+        return;
+    }
+    load(txQueue[txHead]);
+    txHead = (txHead + 1) % TX_CAPACITY;
+    txCount--;
+}
+
+uint32_t CANMCP2515Transport::dropTransmits() {
+    uint32_t dropped = static_cast<uint32_t>(txCount + (txBusy ? 1 : 0));
+    if (txBusy) {
+        modifyRegister(REG_TXB0CTRL, TXB_TXREQ, 0);
+    }
+    txBusy = false;
+    txHead = 0;
+    txCount = 0;
+    return dropped;
+}
+
+// ===== REGISTER ACCESS =====
+
+void CANMCP2515Transport::readRegisters(uint8_t address, uint8_t* values, size_t count) {
+    uint8_t tx[2 + 16] = {INSTR_READ, address};
+    uint8_t rx[2 + 16];
+    port.transfer(tx, rx, 2 + count);
+    memcpy(values, &rx[2], count);
+}
+
+void CANMCP2515Transport::writeRegisters(uint8_t address, const uint8_t* values, size_t count) {
+    uint8_t tx[2 + 16] = {INSTR_WRITE, address};
+    memcpy(&tx[2], values, count);
+    port.transfer(tx, nullptr, 2 + count);
+}
+
+void CANMCP2515Transport::modifyRegister(uint8_t address, uint8_t mask, uint8_t value) {
+    uint8_t tx[4] = {INSTR_BIT_MODIFY, address, mask, value};
+    port.transfer(tx, nullptr, sizeof(tx));
+}
+
+bool CANMCP2515Transport::requestMode(uint8_t opmode) {
+    modifyRegister(REG_CANCTRL, MODE_MASK | CANCTRL_OSM, opmode);
+
+    uint32_t started = port.millis();
+    do {
+        uint8_t status;
+        readRegisters(REG_CANSTAT, &status, 1);
+        if ((status & MODE_MASK) == opmode) {
+            return true;
+        }
+    } while (port.millis() - started < MODE_SWITCH_TIMEOUT_MS);
+    return false;
+}
+
+// ===== REGISTER IMAGES =====
+
+bool CANMCP2515Transport::computeBitTiming(uint32_t oscillatorHz, uint32_t bitrate, uint8_t cnf[3]) {
+    if (bitrate == 0) {
+        return false;
+    }
+
+    // Most time quanta first: finer sample point placement and resync
+    for (uint32_t quanta = 25; quanta >= 5; quanta--) {
+        uint64_t divisor = 2ULL * bitrate * quanta;
+        if (oscillatorHz % divisor != 0) {
+            continue;
+        }
+        uint32_t prescaler = static_cast<uint32_t>(oscillatorHz / divisor);
+        if (prescaler < 1 || prescaler > 64) {
+            continue;
+        }
+
+        // Sync segment is one quantum; PS2 takes the 12.5% after the sample point
+        uint32_t phase2 = (quanta + 4) / 8;
+        if (phase2 < 2) {
+            phase2 = 2;
+        }
+        uint32_t beforeSample = quanta - 1 - phase2;
+        uint32_t phase1 = beforeSample / 2;
+        uint32_t propagation = beforeSample - phase1;
+        if (phase1 < 1 || phase1 > 8 || propagation > 8 || phase2 > 8 || beforeSample < phase2) {
+            continue;
+        }
+
+        cnf[0] = static_cast<uint8_t>(phase2 - 1);                                 // CNF3
+        cnf[1] = static_cast<uint8_t>(0x80 | ((phase1 - 1) << 3) | (propagation - 1)); // CNF2, BTLMODE
+        cnf[2] = static_cast<uint8_t>(prescaler - 1);                              // CNF1, SJW = 1
+        return true;
+    }
+    return false;
+}
+
+bool CANMCP2515Transport::computeAcceptance(const CANAcceptanceFilter& filter, uint8_t mask[4],
+                                            uint8_t code[4]) {
+    if (!filter.singleFilter || filter.acceptsAll()) {
+        return false;
+    }
+
+    // TWAI mask bits mean don't care, MCP2515 mask bits mean must match.
+    // Data byte and RTR bits of the TWAI filter have no MCP2515 equivalent
+    // and are left to the software filter.
+    uint32_t care = ~filter.acceptanceMask;
+    if (filter.extended) {
+        packId((filter.acceptanceCode >> 3) & CANFrame::ID_MASK, true, code);
+        packId((care >> 3) & CANFrame::ID_MASK, true, mask);
+        mask[1] &= static_cast<uint8_t>(~SIDL_IDE);     // Mask bit 3 is unimplemented
+    } else {
+        packId((filter.acceptanceCode >> 21) & 0x7FF, false, code);
+        packId((care >> 21) & 0x7FF, false, mask);
+    }
+    return true;
+}
+
+void CANMCP2515Transport::encodeHeader(const CANFrame& frame, uint8_t header[5]) {
+    packId(frame.id(), frame.isExtended(), header);
+    header[4] = static_cast<uint8_t>((frame.dlc > 8 ? 8 : frame.dlc) | (frame.isRemote() ? DLC_RTR : 0));
+}
+
+void CANMCP2515Transport::decodeBuffer(const uint8_t* buffer, CANFrame& frame, uint64_t timestampUs) {
+    uint32_t id;
+    bool extended = (buffer[1] & SIDL_IDE) != 0;
+    bool remote;
+    if (extended) {
+        id = (static_cast<uint32_t>(buffer[0]) << 21) | (static_cast<uint32_t>(buffer[1] >> 5) << 18) |
+             (static_cast<uint32_t>(buffer[1] & 0x03) << 16) | (static_cast<uint32_t>(buffer[2]) << 8) |
+             buffer[3];
+        remote = (buffer[4] & DLC_RTR) != 0;
+    } else {
+        id = (static_cast<uint32_t>(buffer[0]) << 3) | (buffer[1] >> 5);
+        remote = (buffer[1] & SIDL_SRR) != 0;
+    }
+    frame.setId(id, extended, remote);
+    uint8_t dlc = buffer[4] & 0x0F;
+    frame.dlc = dlc > 8 ? 8 : dlc;
+    memcpy(frame.data, &buffer[5], 8);
+    frame.timestamp = timestampUs;
+}
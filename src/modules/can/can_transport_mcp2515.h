@@ -0,0 +1,255 @@
+#pragma once
+
+/**
+ * @file can_transport_mcp2515.h
+ * @brief CAN transport over an external MCP2515 SPI controller
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * The MCP2515 has two receive buffers (RXB0 rolls over into RXB1) and
+ * three transmit buffers. Every register access is an SPI transaction,
+ * so the driver is built around keeping those few and short:
+ *
+ * - One READ of CANINTF+EFLG per interrupt tells what happened.
+ * - When both receive buffers are full, one READ from RXB0SIDH through
+ *   RXB1D7 fetches both frames and a single BIT MODIFY releases them
+ *   together with any TX and error flags seen in the same pass. A single
+ *   full buffer uses READ RX BUFFER, which releases it on chip select.
+ * - Only TXB0 is used, fed from a software queue. The controller orders
+ *   its three buffers by priority bits and then by buffer number, not by
+ *   submission, so using one keeps frames in the order they were queued
+ *   (CANInterface's scheduler depends on that).
+ *
+ * The SPI bus, interrupt line and clocks come through CANMCP2515Port,
+ * so the driver runs unchanged against the register-level emulator in
+ * tests/test_can_transport_mcp2515.cpp.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../config/project_config.h"
+#include "can_transport.h"
+#include "can_ring_buffer.h"
+
+/**
+ * @brief MCP2515 SPI instructions, registers and bits (datasheet DS20001801)
+ */
+namespace MCP2515 {
+    // SPI instructions
+    constexpr uint8_t INSTR_RESET          = 0xC0;
+    constexpr uint8_t INSTR_READ           = 0x03;
+    constexpr uint8_t INSTR_WRITE          = 0x02;
+    constexpr uint8_t INSTR_BIT_MODIFY     = 0x05;
+    constexpr uint8_t INSTR_READ_STATUS    = 0xA0;
+    constexpr uint8_t INSTR_READ_RXB0      = 0x90;  // From RXB0SIDH, clears RX0IF
+    constexpr uint8_t INSTR_READ_RXB1      = 0x94;  // From RXB1SIDH, clears RX1IF
+    constexpr uint8_t INSTR_LOAD_TXB0      = 0x40;  // From TXB0SIDH
+    constexpr uint8_t INSTR_RTS_TXB0       = 0x81;
+
+    // Registers
+    constexpr uint8_t REG_RXF0SIDH  = 0x00;     // RXF0-RXF2, 4 bytes each
+    constexpr uint8_t REG_RXF3SIDH  = 0x10;     // RXF3-RXF5, 4 bytes each
+    constexpr uint8_t REG_CANSTAT   = 0x0E;
+    constexpr uint8_t REG_CANCTRL   = 0x0F;
+    constexpr uint8_t REG_TEC       = 0x1C;
+    constexpr uint8_t REG_REC       = 0x1D;
+    constexpr uint8_t REG_RXM0SIDH  = 0x20;     // RXM0, RXM1, 4 bytes each
+    constexpr uint8_t REG_CNF3      = 0x28;
+    constexpr uint8_t REG_CNF2      = 0x29;
+    constexpr uint8_t REG_CNF1      = 0x2A;
+    constexpr uint8_t REG_CANINTE   = 0x2B;
+    constexpr uint8_t REG_CANINTF   = 0x2C;
+    constexpr uint8_t REG_EFLG      = 0x2D;
+    constexpr uint8_t REG_TXB0CTRL  = 0x30;
+    constexpr uint8_t REG_TXB0SIDH  = 0x31;
+    constexpr uint8_t REG_RXB0CTRL  = 0x60;
+    constexpr uint8_t REG_RXB0SIDH  = 0x61;
+    constexpr uint8_t REG_RXB1CTRL  = 0x70;
+    constexpr uint8_t REG_RXB1SIDH  = 0x71;
+
+    constexpr size_t BUFFER_SIZE    = 13;       // SIDH, SIDL, EID8, EID0, DLC, D0-D7
+    constexpr size_t RX_BURST_SIZE  = REG_RXB1SIDH + BUFFER_SIZE - REG_RXB0SIDH;   // 29
+
+    // CANCTRL / CANSTAT
+    constexpr uint8_t MODE_MASK     = 0xE0;     // REQOP in CANCTRL, OPMOD in CANSTAT
+    constexpr uint8_t MODE_NORMAL   = 0x00;
+    constexpr uint8_t MODE_LOOPBACK = 0x40;
+    constexpr uint8_t MODE_LISTEN   = 0x60;
+    constexpr uint8_t MODE_CONFIG   = 0x80;
+    constexpr uint8_t CANCTRL_OSM   = 0x08;     // One-shot mode
+
+    // CANINTE / CANINTF
+    constexpr uint8_t INT_RX0       = 0x01;
+    constexpr uint8_t INT_RX1       = 0x02;
+    constexpr uint8_t INT_TX0       = 0x04;
+    constexpr uint8_t INT_ERR       = 0x20;
+    constexpr uint8_t INT_MERR      = 0x80;
+
+    // EFLG
+    constexpr uint8_t EFLG_RX1OVR   = 0x80;
+    constexpr uint8_t EFLG_RX0OVR   = 0x40;
+    constexpr uint8_t EFLG_TXBO     = 0x20;
+
+    // TXBnCTRL
+    constexpr uint8_t TXB_MLOA      = 0x20;
+    constexpr uint8_t TXB_TXERR     = 0x10;
+    constexpr uint8_t TXB_TXREQ     = 0x08;
+
+    // RXBnCTRL
+    constexpr uint8_t RXB_RXM_ANY   = 0x60;     // Filters off, receive everything
+    constexpr uint8_t RXB0_BUKT     = 0x04;     // Roll over into RXB1 when RXB0 is full
+
+    // Identifier registers
+    constexpr uint8_t SIDL_IDE      = 0x08;     // Extended identifier (EXIDE in filters)
+    constexpr uint8_t SIDL_SRR      = 0x10;     // Standard remote frame (receive side)
+    constexpr uint8_t DLC_RTR       = 0x40;
+}
+
+/**
+ * @class CANMCP2515Port
+ * @brief SPI bus, interrupt line and clocks the MCP2515 driver runs on
+ */
+class CANMCP2515Port {
+public:
+    virtual ~CANMCP2515Port() {}
+
+    virtual bool begin() = 0;
+    virtual void end() = 0;
+
+    /**
+     * @brief Serialize controller access between tasks (not recursive)
+     */
+    virtual void lock() = 0;
+    virtual void unlock() = 0;
+
+    /**
+     * @brief One transaction: chip select low, clock length bytes, chip select high
+     * @param tx Bytes to send
+     * @param rx Bytes clocked in (nullptr to discard)
+     */
+    virtual void transfer(const uint8_t* tx, uint8_t* rx, size_t length) = 0;
+
+    /**
+     * @brief INT line asserted (low)
+     */
+    virtual bool interruptPending() = 0;
+
+    /**
+     * @brief Sleep until the INT line falls or wake() is called
+     * @return false on timeout
+     */
+    virtual bool waitForInterrupt(uint32_t timeoutMs) = 0;
+    virtual void wake() = 0;
+
+    virtual uint64_t micros() = 0;     // Frame timestamps
+    virtual uint32_t millis() = 0;     // Timeouts
+};
+
+/**
+ * @class CANMCP2515Transport
+ * @brief Interrupt-driven MCP2515 backend
+ *
+ * The controller is serviced by whoever finds its INT line asserted:
+ * readEvents() in the receive task, receive() when polled, transmit()
+ * while waiting for room. Mode mapping: LISTEN_ONLY uses listen-only
+ * mode; SELF_TEST and NO_ACK use loopback mode, which does not drive the
+ * bus. Bus-off recovery is done by the controller itself (128 x 11
+ * recessive bits); initiateRecovery() only waits for it to finish.
+ */
+class CANMCP2515Transport : public CANTransport {
+public:
+    static constexpr size_t RX_CAPACITY = CAN_MCP2515_RX_RING_SIZE;
+    static constexpr size_t TX_CAPACITY = CAN_MCP2515_TX_QUEUE_MAX;
+
+    /**
+     * @brief Constructor
+     * @param port SPI bus and interrupt line
+     * @param oscillatorHz Crystal on the MCP2515 module
+     */
+    explicit CANMCP2515Transport(CANMCP2515Port& port, uint32_t oscillatorHz = CAN_MCP2515_CLOCK_HZ);
+
+    /**
+     * @brief Reset the controller and load timing, filters and interrupts
+     * @note rxQueueLength is fixed at RX_CAPACITY; txQueueLength is capped
+     *       at TX_CAPACITY. Single-filter acceptance filters are loaded into
+     *       both masks and all six filters; dual filters fall back to accept-all
+     *       (getAppliedFilter() says which).
+     */
+    bool install(const CANTransportConfig& config) override;
+    void uninstall() override;
+    bool start() override;
+    bool stop() override;
+    CANTransportResult transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                bool singleShot = false) override;
+    CANTransportResult receive(CANFrame& frame, uint32_t timeoutMs) override;
+    uint32_t readEvents(uint32_t timeoutMs) override;
+    bool getStatus(CANTransportStatus& status) override;
+    bool initiateRecovery() override;
+    CANAcceptanceFilter getAppliedFilter() const override { return appliedFilter; }
+    const char* getName() const override { return "MCP2515"; }
+
+    /**
+     * @brief CNF1-CNF3 for a bitrate, sample point as close to 87.5% as allowed
+     * @param oscillatorHz Crystal frequency
+     * @param bitrate Bits per second
+     * @param cnf Receives CNF3, CNF2, CNF1 (register order)
+     * @return false if no valid 5-25 TQ bit time exists
+     */
+    static bool computeBitTiming(uint32_t oscillatorHz, uint32_t bitrate, uint8_t cnf[3]);
+
+    /**
+     * @brief Mask and filter register images for an acceptance filter
+     * @param filter Compiled TWAI-style filter (mask 1 = don't care)
+     * @param mask Receives RXMnSIDH..RXMnEID0 (mask 1 = must match)
+     * @param code Receives RXFnSIDH..RXFnEID0
+     * @return false if the filter needs accept-all (dual filter, or accepts all)
+     */
+    static bool computeAcceptance(const CANAcceptanceFilter& filter, uint8_t mask[4], uint8_t code[4]);
+
+    /**
+     * @brief Identifier registers (SIDH, SIDL, EID8, EID0) and DLC for a frame
+     */
+    static void encodeHeader(const CANFrame& frame, uint8_t header[5]);
+
+    /**
+     * @brief Frame from a receive buffer image (SIDH..D7)
+     */
+    static void decodeBuffer(const uint8_t* buffer, CANFrame& frame, uint64_t timestampUs);
+
+private:
+    struct TxSlot {
+        CANFrame frame;
+        bool singleShot;
+    };
+
+    CANMCP2515Port& port;
+    uint32_t oscillatorHz;
+    CANMode mode;
+    bool installed;
+    CANTransportState state;
+    CANAcceptanceFilter appliedFilter;  // Accept-all unless computeAcceptance() loaded it
+
+    CANRingBuffer<CANFrame, RX_CAPACITY> rxRing;    // Producer: service (locked), consumer: receive()
+    TxSlot txQueue[TX_CAPACITY];
+    size_t txHead;
+    size_t txCount;
+    size_t txLimit;
+    bool txBusy;                    // TXB0 holds a frame
+    bool oneShotMode;               // CANCTRL.OSM as last written
+
+    uint32_t pendingEvents;
+    CANTransportStatus counters;    // Cumulative counters and cached TEC/REC
+
+    // Register access (port locked)
+    void readRegisters(uint8_t address, uint8_t* values, size_t count);
+    void writeRegisters(uint8_t address, const uint8_t* values, size_t count);
+    void modifyRegister(uint8_t address, uint8_t mask, uint8_t value);
+    bool requestMode(uint8_t opmode);
+
+    // Controller service (port locked)
+    uint32_t service();
+    void storeReceived(const uint8_t* buffer, uint64_t timestampUs, uint32_t& events);
+    void load(const TxSlot& slot);
+    void loadNext();
+    uint32_t dropTransmits();
+};
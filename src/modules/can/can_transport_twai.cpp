@@ -0,0 +1,189 @@
+/**
+ * @file can_transport_twai.cpp
+ * @brief CAN transport over the ESP32 on-chip TWAI controller
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_transport_twai.h"
+#include "can_interface.h"
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "can_log.h"
+
+CANTwaiTransport::CANTwaiTransport() : installed(false), selfReception(false) {
+}
+
+// ===== DRIVER LIFECYCLE =====
+
+bool CANTwaiTransport::install(const CANTransportConfig& config) {
+    // Get timing configuration for the specified speed
+    twai_timing_config_t timing_config;
+    if (!CANInterface::getTimingConfig(config.speed, timing_config)) {
+        CANLog::printf("[CAN] ERROR: Invalid CAN speed configuration\n");
+        return false;
+    }
+
+    // Configure CAN controller
+    twai_general_config_t general_config = TWAI_GENERAL_CONFIG_DEFAULT(
+        static_cast<gpio_num_t>(CAN_TX_PIN),
+        static_cast<gpio_num_t>(CAN_RX_PIN),
+        TWAI_MODE_NORMAL
+    );
+
+    // Set mode based on configuration
+    switch (config.mode) {
+        case CANMode::LISTEN_ONLY:
+            general_config.mode = TWAI_MODE_LISTEN_ONLY;
+            break;
+        case CANMode::SELF_TEST:
+            // The driver has no self test mode: no-ACK plus self reception per frame
+            general_config.mode = TWAI_MODE_NO_ACK;
+            break;
+        case CANMode::NO_ACK:
+            general_config.mode = TWAI_MODE_NO_ACK;
+            break;
+        default:
+            general_config.mode = TWAI_MODE_NORMAL;
+            break;
+    }
+
+    // Driver queues absorb bursts until the frames are drained
+    general_config.rx_queue_len = config.rxQueueLength;
+    general_config.tx_queue_len = config.txQueueLength;
+
+    // Receive, transmit and error state changes all arrive as alerts
+    general_config.alerts_enabled = CAN_DRIVER_ALERTS;
+
+    // Acceptance filter compiled from the current software filter
+    twai_filter_config_t filter_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    filter_config.acceptance_code = config.filter.acceptanceCode;
+    filter_config.acceptance_mask = config.filter.acceptanceMask;
+    filter_config.single_filter = config.filter.singleFilter;
+
+    esp_err_t result = twai_driver_install(&general_config, &timing_config, &filter_config);
+    if (result != ESP_OK) {
+        CANLog::printf("[CAN] ERROR: Failed to install TWAI driver: %s\n", esp_err_to_name(result));
+        return false;
+    }
+
+    selfReception = config.mode == CANMode::SELF_TEST;
+    appliedFilter = config.filter;
+    installed = true;
+    return true;
+}
+
+void CANTwaiTransport::uninstall() {
+    if (!installed) {
+        return;
+    }
+    twai_stop();
+    twai_driver_uninstall();
+    appliedFilter = CANAcceptanceFilter();
+    installed = false;
+}
+
+bool CANTwaiTransport::start() {
+    esp_err_t result = twai_start();
+    if (result != ESP_OK) {
+        CANLog::printf("[CAN] ERROR: Failed to start TWAI driver: %s\n", esp_err_to_name(result));
+        return false;
+    }
+    return true;
+}
+
+bool CANTwaiTransport::stop() {
+    return twai_stop() == ESP_OK;
+}
+
+// ===== FRAMES =====
+
+CANTransportResult CANTwaiTransport::transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                              bool singleShot) {
+    twai_message_t message;
+    CANInterface::convertToTWAI(frame, message);
+    message.ss = singleShot ? 1 : 0;
+    message.self = selfReception ? 1 : 0;
+    return toResult(twai_transmit(&message, pdMS_TO_TICKS(timeoutMs)));
+}
+
+CANTransportResult CANTwaiTransport::receive(CANFrame& frame, uint32_t timeoutMs) {
+    twai_message_t message;
+    esp_err_t result = twai_receive(&message, pdMS_TO_TICKS(timeoutMs));
+    if (result != ESP_OK) {
+        return toResult(result);
+    }
+
+    // The driver does not timestamp frames; use the time they left its queue
+    CANInterface::convertFromTWAI(message, frame, esp_timer_get_time());
+    return CANTransportResult::OK;
+}
+
+// ===== EVENTS & STATUS =====
+
+uint32_t CANTwaiTransport::readEvents(uint32_t timeoutMs) {
+    uint32_t alerts = 0;
+    if (twai_read_alerts(&alerts, pdMS_TO_TICKS(timeoutMs)) != ESP_OK) {
+        return 0;
+    }
+
+    uint32_t events = 0;
+    if (alerts & TWAI_ALERT_RX_DATA) events |= CANTransportEvent::RX_DATA;
+    if (alerts & TWAI_ALERT_TX_SUCCESS) events |= CANTransportEvent::TX_SUCCESS;
+    if (alerts & TWAI_ALERT_TX_FAILED) events |= CANTransportEvent::TX_FAILED;
+    if (alerts & TWAI_ALERT_BUS_ERROR) events |= CANTransportEvent::BUS_ERROR;
+    if (alerts & TWAI_ALERT_ARB_LOST) events |= CANTransportEvent::ARB_LOST;
+    if (alerts & TWAI_ALERT_BUS_OFF) events |= CANTransportEvent::BUS_OFF;
+    if (alerts & TWAI_ALERT_BUS_RECOVERED) events |= CANTransportEvent::BUS_RECOVERED;
+    if (alerts & TWAI_ALERT_RX_QUEUE_FULL) events |= CANTransportEvent::RX_OVERFLOW;
+    return events;
+}
+
+bool CANTwaiTransport::getStatus(CANTransportStatus& status) {
+    twai_status_info_t info;
+    if (twai_get_status_info(&info) != ESP_OK) {
+        return false;
+    }
+
+    switch (info.state) {
+        case TWAI_STATE_RUNNING:
+            status.state = CANTransportState::RUNNING;
+            break;
+        case TWAI_STATE_BUS_OFF:
+            status.state = CANTransportState::BUS_OFF;
+            break;
+        case TWAI_STATE_RECOVERING:
+            status.state = CANTransportState::RECOVERING;
+            break;
+        default:
+            status.state = CANTransportState::STOPPED;
+            break;
+    }
+    status.txPending = info.msgs_to_tx;
+    status.rxPending = info.msgs_to_rx;
+    status.txErrorCounter = info.tx_error_counter > 255 ? 255 : info.tx_error_counter;
+    status.rxErrorCounter = info.rx_error_counter > 255 ? 255 : info.rx_error_counter;
+    status.txFailed = info.tx_failed_count;
+    status.rxMissed = info.rx_missed_count;
+    status.rxOverrun = info.rx_overrun_count;
+    status.arbitrationLost = info.arb_lost_count;
+    status.busErrors = info.bus_error_count;
+    return true;
+}
+
+bool CANTwaiTransport::initiateRecovery() {
+    return twai_initiate_recovery() == ESP_OK;
+}
+
+CANTransportResult CANTwaiTransport::toResult(esp_err_t result) {
+    switch (result) {
+        case ESP_OK:
+            return CANTransportResult::OK;
+        case ESP_ERR_TIMEOUT:
+            return CANTransportResult::TIMEOUT;
+        case ESP_ERR_INVALID_STATE:
+            return CANTransportResult::NOT_RUNNING;
+        default:
+            return CANTransportResult::FAILED;
+    }
+}
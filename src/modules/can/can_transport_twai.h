@@ -0,0 +1,48 @@
+#pragma once
+
+/**
+ * @file can_transport_twai.h
+ * @brief CAN transport over the ESP32 on-chip TWAI controller
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Thin wrapper around the IDF TWAI driver: its queues, alerts and status
+ * counters already match the CANTransport calls one for one.
+ */
+
+#include "can_transport.h"
+#include "driver/twai.h"
+
+// TWAI alerts mapped to CANTransportEvent bits
+#define CAN_DRIVER_ALERTS (TWAI_ALERT_RX_DATA | TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED | \
+                           TWAI_ALERT_BUS_ERROR | TWAI_ALERT_ARB_LOST | TWAI_ALERT_BUS_OFF | \
+                           TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_RX_QUEUE_FULL)
+
+/**
+ * @class CANTwaiTransport
+ * @brief Default CANInterface backend (CAN_TX_PIN/CAN_RX_PIN transceiver)
+ */
+class CANTwaiTransport : public CANTransport {
+public:
+    CANTwaiTransport();
+
+    bool install(const CANTransportConfig& config) override;
+    void uninstall() override;
+    bool start() override;
+    bool stop() override;
+    CANTransportResult transmit(const CANFrame& frame, uint32_t timeoutMs,
+                                bool singleShot = false) override;
+    CANTransportResult receive(CANFrame& frame, uint32_t timeoutMs) override;
+    uint32_t readEvents(uint32_t timeoutMs) override;
+    bool getStatus(CANTransportStatus& status) override;
+    bool initiateRecovery() override;
+    CANAcceptanceFilter getAppliedFilter() const override { return appliedFilter; }
+    const char* getName() const override { return "TWAI"; }
+
+private:
+    bool installed;
+    bool selfReception;     // SELF_TEST: every frame is also received locally
+    CANAcceptanceFilter appliedFilter;  // Loaded as given
+
+    static CANTransportResult toResult(esp_err_t result);
+};
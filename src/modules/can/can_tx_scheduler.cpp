@@ -0,0 +1,199 @@
+/**
+ * @file can_tx_scheduler.cpp
+ * @brief Priority and deadline ordered transmit queue implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "can_tx_scheduler.h"
+
+CANTxScheduler::CANTxScheduler(uint8_t window)
+    : count(0), nextSequence(0), window(window == 0 ? 1 : window), inFlightCount(0) {
+}
+
+// ===== QUEUE =====
+
+bool CANTxScheduler::push(const CANFrame& frame, CANTxPriority priority, uint32_t lifetimeMs,
+                          uint32_t nowMs) {
+    CANTxEntry entry;
+    entry.frame = frame;
+    entry.priority = priority;
+    entry.hasDeadline = lifetimeMs > 0;
+    entry.deadline = nowMs + lifetimeMs;
+    entry.sequence = nextSequence++;
+
+    if (count == CAPACITY) {
+        dropExpired(nowMs);
+    }
+    if (count == CAPACITY) {
+        size_t victim = leastUrgent();
+        if (!before(entry, heap[victim])) {
+            statistics.rejected++;
+            return false;
+        }
+        removeAt(victim);
+        statistics.evicted++;
+    }
+
+    insert(entry);
+    statistics.queued++;
+    return true;
+}
+
+bool CANTxScheduler::take(uint32_t nowMs, CANTxEntry& entry) {
+    if (inFlightCount >= window) {
+        return false;
+    }
+    while (count > 0 && expired(heap[0], nowMs)) {
+        removeAt(0);
+        statistics.expired++;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    entry = heap[0];
+    removeAt(0);
+    inFlightCount++;
+    statistics.submitted++;
+    return true;
+}
+
+void CANTxScheduler::giveBack(const CANTxEntry& entry) {
+    if (inFlightCount > 0) {
+        inFlightCount--;
+    }
+    if (statistics.submitted > 0) {
+        statistics.submitted--;
+    }
+    // Room is guaranteed unless a push evicted into the slot meanwhile;
+    // then the returned frame competes like a new one
+    if (count == CAPACITY) {
+        size_t victim = leastUrgent();
+        if (!before(entry, heap[victim])) {
+            statistics.rejected++;
+            return;
+        }
+        removeAt(victim);
+        statistics.evicted++;
+    }
+    insert(entry);
+}
+
+void CANTxScheduler::clear() {
+    count = 0;
+}
+
+// ===== DRIVER COMPLETION =====
+
+uint32_t CANTxScheduler::onDriverLevel(uint32_t driverQueued, bool failed) {
+    if (driverQueued >= inFlightCount) {
+        return 0;
+    }
+    // The driver sends in order, so whatever left its queue is done
+    uint32_t settled = inFlightCount - driverQueued;
+    inFlightCount = static_cast<uint8_t>(driverQueued);
+    if (failed) {
+        statistics.failed += settled;
+    } else {
+        statistics.completed += settled;
+    }
+    return settled;
+}
+
+void CANTxScheduler::onDriverReset() {
+    statistics.failed += inFlightCount;
+    inFlightCount = 0;
+}
+
+// ===== HEAP =====
+
+bool CANTxScheduler::before(const CANTxEntry& a, const CANTxEntry& b) {
+    if (a.priority != b.priority) {
+        return a.priority < b.priority;
+    }
+    if (a.hasDeadline != b.hasDeadline) {
+        return a.hasDeadline;           // Frames with a deadline before best-effort ones
+    }
+    if (a.hasDeadline && a.deadline != b.deadline) {
+        return static_cast<int32_t>(a.deadline - b.deadline) < 0;
+    }
+    return static_cast<int32_t>(a.sequence - b.sequence) < 0;
+}
+
+void CANTxScheduler::insert(const CANTxEntry& entry) {
+    heap[count] = entry;
+    siftUp(count);
+    count++;
+}
+
+void CANTxScheduler::removeAt(size_t index) {
+    count--;
+    if (index == count) {
+        return;
+    }
+    heap[index] = heap[count];
+    siftDown(index);
+    siftUp(index);
+}
+
+void CANTxScheduler::siftUp(size_t index) {
+    CANTxEntry entry = heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!before(entry, heap[parent])) {
+            break;
+        }
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = entry;
+}
+
+void CANTxScheduler::siftDown(size_t index) {
+    CANTxEntry entry = heap[index];
+    for (;;) {
+        size_t child = 2 * index + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!before(heap[child], entry)) {
+            break;
+        }
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = entry;
+}
+
+size_t CANTxScheduler::leastUrgent() const {
+    // The least urgent entry is a leaf; only the second half needs a look
+    size_t worst = count / 2;
+    for (size_t i = worst + 1; i < count; i++) {
+        if (before(heap[worst], heap[i])) {
+            worst = i;
+        }
+    }
+    return worst;
+}
+
+void CANTxScheduler::dropExpired(uint32_t nowMs) {
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (expired(heap[i], nowMs)) {
+            statistics.expired++;
+        } else {
+            heap[kept++] = heap[i];
+        }
+    }
+    if (kept == count) {
+        return;
+    }
+    count = kept;
+    for (size_t i = count / 2; i > 0; i--) {
+        siftDown(i - 1);
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+/**
+ * @file can_tx_scheduler.h
+ * @brief Priority and deadline ordered transmit queue
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Frames wait in a fixed-capacity binary heap ordered by priority class,
+ * then earliest deadline, then submission order. Only a small window of
+ * frames is handed to the TWAI driver at a time, because once a frame is
+ * in the driver's FIFO nothing can overtake it; the window is refilled as
+ * TX alerts report completions. A frame whose deadline passes while it
+ * waits is dropped instead of going out late, and a full queue makes room
+ * by evicting its least urgent frame. Nothing here blocks.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+
+/**
+ * @brief Transmit priority class (lower value goes first)
+ */
+enum class CANTxPriority : uint8_t {
+    URGENT = 0,         // Diagnostic requests, anything a response is waiting on
+    ELEVATED,           // Time-sensitive periodic traffic
+    NORMAL,
+    BACKGROUND          // Bulk or best-effort traffic
+};
+
+/**
+ * @brief Queued frame with its scheduling key
+ */
+struct CANTxEntry {
+    CANFrame frame;
+    uint32_t deadline;              // Millisecond clock; ignored unless hasDeadline
+    uint32_t sequence;              // Submission order, breaks ties
+    CANTxPriority priority;
+    bool hasDeadline;
+};
+
+/**
+ * @brief Transmit scheduler statistics
+ */
+struct CANTxSchedulerStatistics {
+    uint32_t queued;
+    uint32_t submitted;             // Handed to the driver
+    uint32_t completed;             // Reported done by TX alerts
+    uint32_t failed;                // Reported failed (TX_FAILED, bus-off, driver reset)
+    uint32_t expired;               // Deadline passed while queued
+    uint32_t rejected;              // Queue full and the frame was the least urgent
+    uint32_t evicted;               // Dropped to make room for a more urgent frame
+
+    CANTxSchedulerStatistics() : queued(0), submitted(0), completed(0), failed(0),
+                                 expired(0), rejected(0), evicted(0) {}
+};
+
+/**
+ * @class CANTxScheduler
+ * @brief Ordered transmit queue with driver completion tracking
+ *
+ * Not thread safe; CANInterface serializes access with a spinlock and
+ * calls the driver outside it (take, transmit, giveBack on refusal).
+ */
+class CANTxScheduler {
+public:
+    static constexpr size_t CAPACITY = CAN_TX_RING_SIZE;
+
+    /**
+     * @brief Constructor
+     * @param window Frames allowed in the driver at once
+     */
+    explicit CANTxScheduler(uint8_t window = CAN_TX_IN_FLIGHT);
+
+    /**
+     * @brief Queue a frame
+     * @param frame Frame to send
+     * @param priority Priority class
+     * @param lifetimeMs Drop the frame if it is not handed to the driver
+     *                   within this many milliseconds (0 = no deadline)
+     * @param nowMs Current time
+     * @return false if the queue is full of frames at least as urgent
+     */
+    bool push(const CANFrame& frame, CANTxPriority priority, uint32_t lifetimeMs, uint32_t nowMs);
+
+    /**
+     * @brief Take the most urgent frame if the driver window has room
+     * @param nowMs Current time (expired frames on the way are dropped)
+     * @param entry Receives the frame, now counted as in flight
+     * @return false if nothing is queued or the window is full
+     */
+    bool take(uint32_t nowMs, CANTxEntry& entry);
+
+    /**
+     * @brief Return a frame the driver refused (keeps its place in line)
+     */
+    void giveBack(const CANTxEntry& entry);
+
+    /**
+     * @brief Settle in-flight frames from the driver's queue level
+     * @param driverQueued Frames the driver still holds (msgs_to_tx)
+     * @param failed A TX_FAILED or BUS_OFF alert came with this level
+     * @return Frames settled
+     */
+    uint32_t onDriverLevel(uint32_t driverQueued, bool failed);
+
+    /**
+     * @brief Driver reinstalled or stopped; everything in flight is lost
+     */
+    void onDriverReset();
+
+    /**
+     * @brief Drop all queued frames (in-flight accounting is kept)
+     */
+    void clear();
+
+    size_t size() const { return count; }
+    size_t capacity() const { return CAPACITY; }
+    uint8_t inFlight() const { return inFlightCount; }
+    uint8_t getWindow() const { return window; }
+    void setWindow(uint8_t frames) { window = frames == 0 ? 1 : frames; }
+
+    const CANTxSchedulerStatistics& getStatistics() const { return statistics; }
+    void resetStatistics() { statistics = CANTxSchedulerStatistics(); }
+
+private:
+    CANTxEntry heap[CAPACITY];
+    size_t count;
+    uint32_t nextSequence;
+    uint8_t window;
+    uint8_t inFlightCount;
+    CANTxSchedulerStatistics statistics;
+
+    static bool before(const CANTxEntry& a, const CANTxEntry& b);
+    static bool expired(const CANTxEntry& entry, uint32_t nowMs) {
+        return entry.hasDeadline && static_cast<int32_t>(nowMs - entry.deadline) > 0;
+    }
+
+    void insert(const CANTxEntry& entry);
+    void removeAt(size_t index);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    size_t leastUrgent() const;
+    void dropExpired(uint32_t nowMs);
+};
@@ -0,0 +1,162 @@
+#pragma once
+
+/**
+ * @file can_types.h
+ * @brief Plain CAN data types shared by the CAN module
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ * 
+ * Frame, filter and statistics structures used by CANInterface. Kept free
+ * of Arduino and ESP-IDF dependencies so host-side tests can include it.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <functional>
+
+/**
+ * @brief CAN bus speed configurations
+ */
+enum class CANSpeed {
+    CAN_125KBPS,    // 125 kbit/s
+    CAN_250KBPS,    // 250 kbit/s  
+    CAN_500KBPS,    // 500 kbit/s (Standard OBD2)
+    CAN_1MBPS       // 1 Mbit/s
+};
+
+/**
+ * @brief CAN message types
+ */
+enum class CANMessageType {
+    STANDARD,       // Standard 11-bit identifier
+    EXTENDED,       // Extended 29-bit identifier
+    ERROR_FRAME,    // Error frame
+    REMOTE_FRAME    // Remote transmission request
+};
+
+/**
+ * @brief CAN operation modes
+ */
+enum class CANMode {
+    NORMAL,         // Normal operation
+    LISTEN_ONLY,    // Listen-only (no ACK, no error frames)
+    SELF_TEST,      // Self-test mode (loopback)
+    NO_ACK          // No acknowledgment mode
+};
+
+/**
+ * @brief CAN filter types
+ */
+enum class CANFilterType {
+    ACCEPT_ALL,     // Accept all messages
+    WHITELIST,      // Accept only whitelisted IDs
+    BLACKLIST,      // Reject blacklisted IDs
+    RANGE,          // Accept ID range
+    CUSTOM          // Custom filter function
+};
+
+/**
+ * @brief CAN message structure
+ */
+struct CANMessage {
+    uint32_t id;                    // CAN identifier
+    CANMessageType type;            // Message type
+    uint8_t dlc;                    // Data length code (0-8)
+    uint8_t data[8];                // Data bytes
+    bool rtr;                       // Remote transmission request
+    bool extd;                      // Extended frame format
+    uint64_t timestamp;             // Reception time in microseconds (esp_timer)
+    uint16_t errorFlags;            // Error flags if any
+    
+    // Constructor
+    CANMessage() : id(0), type(CANMessageType::STANDARD), dlc(0), 
+                   rtr(false), extd(false), timestamp(0), errorFlags(0) {
+        memset(data, 0, sizeof(data));
+    }
+};
+
+/**
+ * @brief CAN statistics structure
+ */
+struct CANStatistics {
+    uint32_t messagesReceived;      // Total messages received
+    uint32_t messagesSent;          // Total messages sent
+    uint32_t errorFrames;           // Error frames received
+    uint32_t busOffEvents;          // Bus-off events
+    uint32_t arbitrationLost;       // Arbitration lost count
+    uint32_t receiveOverflow;       // Receive buffer overflow
+    uint32_t transmitOverflow;      // Transmit queue overflow
+    uint32_t transmitTimeout;       // Transmit timeout count
+    uint32_t transmitExpired;       // Queued frames dropped at their deadline
+    uint32_t transmitFailed;        // Driver gave up on a frame (single shot or bus-off)
+    uint32_t driverRxMissed;        // Frames lost to a full driver RX queue
+    uint32_t busRecoveries;         // Bus-off recoveries completed
+    uint32_t filterRejects;         // Messages rejected by software filter
+    uint32_t hardwareFiltered;      // Messages accepted on hardware filter alone
+    float busUtilization;           // Bus utilization percentage (1 s window)
+    float busUtilization100ms;      // Bus utilization over the last 100 ms
+    float busUtilization10s;        // Bus utilization over the last 10 s
+    float busUtilizationPeak;       // Highest 100 ms utilization since reset
+    uint64_t lastMessageTime;       // Last message timestamp (microseconds)
+    unsigned long uptimeSeconds;    // Interface uptime
+    
+    // Constructor
+    CANStatistics() : messagesReceived(0), messagesSent(0), errorFrames(0),
+                     busOffEvents(0), arbitrationLost(0), receiveOverflow(0),
+                     transmitOverflow(0), transmitTimeout(0), transmitExpired(0),
+                     transmitFailed(0), driverRxMissed(0), busRecoveries(0), filterRejects(0),
+                     hardwareFiltered(0), busUtilization(0.0),
+                     busUtilization100ms(0.0), busUtilization10s(0.0),
+                     busUtilizationPeak(0.0),
+                     lastMessageTime(0), uptimeSeconds(0) {}
+};
+
+/**
+ * @brief CAN message filter
+ */
+struct CANFilter {
+    CANFilterType type;             // Filter type
+    uint32_t id;                    // Filter ID
+    uint32_t mask;                  // Filter mask
+    uint32_t rangeStart;            // Range start (for range filter)
+    uint32_t rangeEnd;              // Range end (for range filter)
+    std::vector<uint32_t> whitelist; // Whitelist IDs
+    std::vector<uint32_t> blacklist; // Blacklist IDs
+    std::function<bool(const CANMessage&)> customFilter; // Custom filter function
+    bool enabled;                   // Filter enabled
+    
+    // Constructor
+    CANFilter() : type(CANFilterType::ACCEPT_ALL), id(0), mask(0),
+                  rangeStart(0), rangeEnd(0), enabled(true) {}
+};
+
+// ===== OBD2 CAN DEFINITIONS =====
+namespace OBD2CAN {
+    // Standard OBD2 CAN IDs
+    constexpr uint32_t FUNCTIONAL_REQUEST_ID    = 0x7DF;    // Functional diagnostic request
+    constexpr uint32_t RESPONSE_ID_BASE         = 0x7E8;    // Response ID base (0x7E8-0x7EF)
+    constexpr uint32_t PHYSICAL_REQUEST_BASE    = 0x7E0;    // Physical request base (0x7E0-0x7E7)
+    
+    // Extended OBD2 CAN IDs (29-bit)
+    constexpr uint32_t EXT_FUNCTIONAL_REQUEST   = 0x18DB33F1; // Extended functional request
+    constexpr uint32_t EXT_RESPONSE_BASE        = 0x18DAF100; // Extended response base
+    constexpr uint32_t EXT_PHYSICAL_REQUEST_BASE = 0x18DA00F1; // Extended physical request base
+    
+    // OBD2 frame types
+    constexpr uint8_t FRAME_TYPE_SINGLE         = 0x00;    // Single frame
+    constexpr uint8_t FRAME_TYPE_FIRST          = 0x10;    // First frame (multi-frame)
+    constexpr uint8_t FRAME_TYPE_CONSECUTIVE    = 0x20;    // Consecutive frame
+    constexpr uint8_t FRAME_TYPE_FLOW_CONTROL   = 0x30;    // Flow control frame
+    
+    // Flow control flags
+    constexpr uint8_t FC_FLAG_CONTINUE_TO_SEND  = 0x00;    // Continue to send
+    constexpr uint8_t FC_FLAG_WAIT              = 0x01;    // Wait
+    constexpr uint8_t FC_FLAG_OVERFLOW          = 0x02;    // Buffer overflow
+    
+    // Timing parameters (ISO 14229)
+    constexpr uint32_t P2_CLIENT_MAX            = 50;      // P2*client max (ms)
+    constexpr uint32_t P2_STAR_CLIENT_MAX       = 5000;    // P2*client max (ms)
+    constexpr uint8_t  ST_MIN_DEFAULT           = 0;       // STmin default (ms)
+    constexpr uint8_t  BLOCK_SIZE_DEFAULT       = 0;       // Block size default (unlimited)
+}
@@ -0,0 +1,459 @@
+/**
+ * @file isotp.cpp
+ * @brief ISO-TP (ISO 15765-2) transport implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "isotp.h"
+#include <string.h>
+
+static_assert(ISOTP_MAX_MESSAGE_SIZE >= 8 && ISOTP_MAX_MESSAGE_SIZE <= 4095,
+              "ISO-TP on classic CAN carries 8..4095 byte messages");
+
+namespace {
+    constexpr uint32_t TIMEOUT_US = ISOTP_TIMEOUT_MS * 1000UL;
+    constexpr uint8_t SF_MAX_PAYLOAD = 7;
+    constexpr uint8_t FF_PAYLOAD = 6;
+    constexpr uint8_t CF_PAYLOAD = 7;
+}
+
+// ===== CONSTRUCTOR =====
+
+ISOTPTransport::ISOTPTransport(SendFunction send, ClockFunction clockSource) :
+    sendFrame(send),
+    clock(clockSource),
+    receiveCallback(nullptr),
+    completeCallback(nullptr),
+    rxBlockSize(ISOTP_RX_BLOCK_SIZE),
+    rxStMin(ISOTP_RX_STMIN)
+{
+    for (int i = 0; i < ISOTP_MAX_SESSIONS; i++) {
+        sessions[i].open = false;
+        sessions[i].rxState = RxState::IDLE;
+        sessions[i].txState = TxState::IDLE;
+    }
+}
+
+// ===== SESSIONS =====
+
+int ISOTPTransport::openSession(uint32_t txId, uint32_t rxId, bool extended) {
+    if (findSession(rxId, extended) >= 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < ISOTP_MAX_SESSIONS; i++) {
+        Session& s = sessions[i];
+        if (s.open) {
+            continue;
+        }
+        s.open = true;
+        s.extended = extended;
+        s.txId = txId;
+        s.rxId = rxId;
+        s.rxState = RxState::IDLE;
+        s.txState = TxState::IDLE;
+        return i;
+    }
+    return -1;
+}
+
+void ISOTPTransport::closeSession(int session) {
+    if (!isValid(session)) {
+        return;
+    }
+    if (sessions[session].rxState != RxState::IDLE) {
+        abortReceive(session, ISOTPResult::ABORTED);
+    }
+    if (sessions[session].txState != TxState::IDLE) {
+        finishTransmit(session, ISOTPResult::ABORTED);
+    }
+    sessions[session].open = false;
+}
+
+int ISOTPTransport::findSession(uint32_t rxId, bool extended) const {
+    for (int i = 0; i < ISOTP_MAX_SESSIONS; i++) {
+        const Session& s = sessions[i];
+        if (s.open && s.rxId == rxId && s.extended == extended) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ISOTPTransport::openOBD2Sessions() {
+    int opened = 0;
+    for (uint32_t ecu = 0; ecu < 8; ecu++) {
+        if (openSession(OBD2CAN::PHYSICAL_REQUEST_BASE + ecu, OBD2CAN::RESPONSE_ID_BASE + ecu) >= 0) {
+            opened++;
+        }
+    }
+    return opened;
+}
+
+bool ISOTPTransport::isValid(int session) const {
+    return session >= 0 && session < ISOTP_MAX_SESSIONS && sessions[session].open;
+}
+
+// ===== TRANSFER =====
+
+bool ISOTPTransport::send(int session, const uint8_t* data, uint16_t length) {
+    if (!isValid(session) || length == 0 || length > ISOTP_MAX_MESSAGE_SIZE) {
+        return false;
+    }
+
+    Session& s = sessions[session];
+    if (s.txState != TxState::IDLE) {
+        return false;
+    }
+
+    uint8_t frame[8];
+
+    // Single frame
+    if (length <= SF_MAX_PAYLOAD) {
+        frame[0] = OBD2CAN::FRAME_TYPE_SINGLE | length;
+        memcpy(&frame[1], data, length);
+        if (!transmit(s.txId, s.extended, frame, length + 1)) {
+            return false;
+        }
+        statistics.messagesSent++;
+        if (completeCallback) {
+            completeCallback(session, ISOTPResult::OK);
+        }
+        return true;
+    }
+
+    // First frame, then wait for the receiver's flow control
+    memcpy(s.txBuffer, data, length);
+    frame[0] = OBD2CAN::FRAME_TYPE_FIRST | ((length >> 8) & 0x0F);
+    frame[1] = length & 0xFF;
+    memcpy(&frame[2], data, FF_PAYLOAD);
+    if (!transmit(s.txId, s.extended, frame, 8)) {
+        return false;
+    }
+
+    s.txLength = length;
+    s.txOffset = FF_PAYLOAD;
+    s.txSequence = 1;
+    s.txWaitCount = 0;
+    s.txDeadline = clock() + TIMEOUT_US;
+    s.txState = TxState::WAIT_FLOW_CONTROL;
+    return true;
+}
+
+bool ISOTPTransport::sendFunctional(uint32_t id, const uint8_t* data, uint8_t length, bool extended) {
+    if (length == 0 || length > SF_MAX_PAYLOAD) {
+        return false; // Functional requests are single frame only
+    }
+
+    uint8_t frame[8];
+    frame[0] = OBD2CAN::FRAME_TYPE_SINGLE | length;
+    memcpy(&frame[1], data, length);
+    return transmit(id, extended, frame, length + 1);
+}
+
+bool ISOTPTransport::onFrame(const CANMessage& message) {
+    int index = findSession(message.id, message.extd);
+    if (index < 0) {
+        return false;
+    }
+
+    statistics.framesReceived++;
+    if (message.dlc == 0) {
+        return true;
+    }
+
+    uint32_t now = clock();
+    switch (message.data[0] & 0xF0) {
+        case OBD2CAN::FRAME_TYPE_SINGLE:
+            handleSingleFrame(index, message);
+            break;
+        case OBD2CAN::FRAME_TYPE_FIRST:
+            handleFirstFrame(index, message, now);
+            break;
+        case OBD2CAN::FRAME_TYPE_CONSECUTIVE:
+            handleConsecutiveFrame(index, message, now);
+            break;
+        case OBD2CAN::FRAME_TYPE_FLOW_CONTROL:
+            handleFlowControl(index, message, now);
+            break;
+        default:
+            break; // Reserved PCI types are ignored
+    }
+    return true;
+}
+
+void ISOTPTransport::poll() {
+    uint32_t now = clock();
+
+    for (int i = 0; i < ISOTP_MAX_SESSIONS; i++) {
+        Session& s = sessions[i];
+        if (!s.open) {
+            continue;
+        }
+
+        if (s.txState == TxState::SENDING) {
+            sendConsecutiveFrames(i, now);
+        } else if (s.txState == TxState::WAIT_FLOW_CONTROL && reached(now, s.txDeadline)) {
+            statistics.timeouts++;
+            finishTransmit(i, ISOTPResult::TIMEOUT_BS);
+        }
+
+        if (s.rxState == RxState::RECEIVING && reached(now, s.rxDeadline)) {
+            statistics.timeouts++;
+            abortReceive(i, ISOTPResult::TIMEOUT_CR);
+        }
+    }
+}
+
+bool ISOTPTransport::isBusy(int session) const {
+    if (!isValid(session)) {
+        return false;
+    }
+    return sessions[session].rxState != RxState::IDLE || sessions[session].txState != TxState::IDLE;
+}
+
+// ===== CONFIGURATION =====
+
+void ISOTPTransport::setReceiveFlowControl(uint8_t blockSize, uint8_t stMin) {
+    rxBlockSize = blockSize;
+    rxStMin = stMin;
+}
+
+void ISOTPTransport::setReceiveCallback(ReceiveCallback callback) {
+    receiveCallback = callback;
+}
+
+void ISOTPTransport::setCompleteCallback(CompleteCallback callback) {
+    completeCallback = callback;
+}
+
+uint32_t ISOTPTransport::stMinToMicros(uint8_t stMin) {
+    if (stMin <= 0x7F) {
+        return stMin * 1000UL;
+    }
+    if (stMin >= 0xF1 && stMin <= 0xF9) {
+        return (stMin - 0xF0) * 100UL;
+    }
+    return 0x7F * 1000UL; // Reserved values: use the longest valid STmin
+}
+
+const char* ISOTPTransport::resultName(ISOTPResult result) {
+    switch (result) {
+        case ISOTPResult::OK:             return "OK";
+        case ISOTPResult::TIMEOUT_BS:     return "TIMEOUT_BS";
+        case ISOTPResult::TIMEOUT_CR:     return "TIMEOUT_CR";
+        case ISOTPResult::WRONG_SEQUENCE: return "WRONG_SEQUENCE";
+        case ISOTPResult::UNEXPECTED_PDU: return "UNEXPECTED_PDU";
+        case ISOTPResult::OVERFLOW:       return "OVERFLOW";
+        case ISOTPResult::WAIT_LIMIT:     return "WAIT_LIMIT";
+        case ISOTPResult::SEND_FAILED:    return "SEND_FAILED";
+        case ISOTPResult::ABORTED:        return "ABORTED";
+    }
+    return "UNKNOWN";
+}
+
+// ===== FRAME HANDLING =====
+
+bool ISOTPTransport::transmit(uint32_t id, bool extended, const uint8_t* payload, uint8_t length) {
+    CANMessage message;
+    message.id = id;
+    message.extd = extended;
+    message.type = extended ? CANMessageType::EXTENDED : CANMessageType::STANDARD;
+    message.dlc = 8;
+    memcpy(message.data, payload, length);
+    memset(&message.data[length], ISOTP_PADDING_BYTE, 8 - length);
+
+    if (!sendFrame || !sendFrame(message)) {
+        return false;
+    }
+    statistics.framesSent++;
+    return true;
+}
+
+bool ISOTPTransport::sendFlowControl(const Session& s, uint8_t flag) {
+    uint8_t frame[3] = {
+        static_cast<uint8_t>(OBD2CAN::FRAME_TYPE_FLOW_CONTROL | flag),
+        rxBlockSize,
+        rxStMin
+    };
+    return transmit(s.txId, s.extended, frame, sizeof(frame));
+}
+
+bool ISOTPTransport::sendConsecutiveFrames(int index, uint32_t now) {
+    Session& s = sessions[index];
+
+    while (s.txState == TxState::SENDING && reached(now, s.txNextTime)) {
+        uint8_t frame[8];
+        uint16_t remaining = s.txLength - s.txOffset;
+        uint8_t chunk = remaining < CF_PAYLOAD ? remaining : CF_PAYLOAD;
+        frame[0] = OBD2CAN::FRAME_TYPE_CONSECUTIVE | s.txSequence;
+        memcpy(&frame[1], &s.txBuffer[s.txOffset], chunk);
+        if (!transmit(s.txId, s.extended, frame, chunk + 1)) {
+            // Driver queue full: retry on next poll until the deadline
+            if (reached(now, s.txDeadline)) {
+                finishTransmit(index, ISOTPResult::SEND_FAILED);
+            }
+            return false;
+        }
+
+        s.txOffset += chunk;
+        s.txDeadline = now + TIMEOUT_US;
+        s.txSequence = (s.txSequence + 1) & 0x0F;
+
+        if (s.txOffset >= s.txLength) {
+            finishTransmit(index, ISOTPResult::OK);
+            return true;
+        }
+
+        if (s.txBlockSize != 0 && --s.txBlockRemaining == 0) {
+            s.txWaitCount = 0;
+            s.txDeadline = now + TIMEOUT_US;
+            s.txState = TxState::WAIT_FLOW_CONTROL;
+            return true;
+        }
+
+        if (s.txSeparationUs != 0) {
+            s.txNextTime = now + s.txSeparationUs;
+            return true; // One frame per STmin period
+        }
+    }
+    return true;
+}
+
+void ISOTPTransport::handleSingleFrame(int index, const CANMessage& message) {
+    Session& s = sessions[index];
+    uint8_t length = message.data[0] & 0x0F;
+    if (length == 0 || length > SF_MAX_PAYLOAD || length >= message.dlc) {
+        return;
+    }
+
+    if (s.rxState == RxState::RECEIVING) {
+        abortReceive(index, ISOTPResult::UNEXPECTED_PDU);
+    }
+
+    memcpy(s.rxBuffer, &message.data[1], length);
+    statistics.messagesReceived++;
+    if (receiveCallback) {
+        receiveCallback(index, s.rxBuffer, length);
+    }
+}
+
+void ISOTPTransport::handleFirstFrame(int index, const CANMessage& message, uint32_t now) {
+    Session& s = sessions[index];
+    uint16_t length = ((message.data[0] & 0x0F) << 8) | message.data[1];
+    if (message.dlc < 8 || length <= SF_MAX_PAYLOAD) {
+        return;
+    }
+
+    if (s.rxState == RxState::RECEIVING) {
+        abortReceive(index, ISOTPResult::UNEXPECTED_PDU);
+    }
+
+    if (length > ISOTP_MAX_MESSAGE_SIZE) {
+        statistics.overflows++;
+        sendFlowControl(s, OBD2CAN::FC_FLAG_OVERFLOW);
+        return;
+    }
+
+    memcpy(s.rxBuffer, &message.data[2], FF_PAYLOAD);
+    s.rxLength = length;
+    s.rxReceived = FF_PAYLOAD;
+    s.rxSequence = 1;
+    s.rxBlockCount = 0;
+    s.rxDeadline = now + TIMEOUT_US;
+    s.rxState = RxState::RECEIVING;
+
+    sendFlowControl(s, OBD2CAN::FC_FLAG_CONTINUE_TO_SEND);
+}
+
+void ISOTPTransport::handleConsecutiveFrame(int index, const CANMessage& message, uint32_t now) {
+    Session& s = sessions[index];
+    if (s.rxState != RxState::RECEIVING) {
+        return;
+    }
+
+    if ((message.data[0] & 0x0F) != s.rxSequence) {
+        statistics.sequenceErrors++;
+        abortReceive(index, ISOTPResult::WRONG_SEQUENCE);
+        return;
+    }
+
+    uint16_t remaining = s.rxLength - s.rxReceived;
+    uint8_t chunk = remaining < CF_PAYLOAD ? remaining : CF_PAYLOAD;
+    if (chunk >= message.dlc) {
+        return; // Short frame, ignore
+    }
+
+    memcpy(&s.rxBuffer[s.rxReceived], &message.data[1], chunk);
+    s.rxReceived += chunk;
+    s.rxSequence = (s.rxSequence + 1) & 0x0F;
+    s.rxDeadline = now + TIMEOUT_US;
+
+    if (s.rxReceived >= s.rxLength) {
+        s.rxState = RxState::IDLE;
+        statistics.messagesReceived++;
+        if (receiveCallback) {
+            receiveCallback(index, s.rxBuffer, s.rxLength);
+        }
+        return;
+    }
+
+    if (rxBlockSize != 0 && ++s.rxBlockCount >= rxBlockSize) {
+        s.rxBlockCount = 0;
+        sendFlowControl(s, OBD2CAN::FC_FLAG_CONTINUE_TO_SEND);
+    }
+}
+
+void ISOTPTransport::handleFlowControl(int index, const CANMessage& message, uint32_t now) {
+    Session& s = sessions[index];
+    if (s.txState != TxState::WAIT_FLOW_CONTROL || message.dlc < 3) {
+        return;
+    }
+
+    switch (message.data[0] & 0x0F) {
+        case OBD2CAN::FC_FLAG_CONTINUE_TO_SEND:
+            s.txBlockSize = message.data[1];
+            s.txBlockRemaining = message.data[1];
+            s.txSeparationUs = stMinToMicros(message.data[2]);
+            s.txNextTime = now;
+            s.txDeadline = now + TIMEOUT_US;
+            s.txState = TxState::SENDING;
+            sendConsecutiveFrames(index, now);
+            break;
+
+        case OBD2CAN::FC_FLAG_WAIT:
+            if (++s.txWaitCount > ISOTP_MAX_WAIT_FRAMES) {
+                finishTransmit(index, ISOTPResult::WAIT_LIMIT);
+            } else {
+                s.txDeadline = now + TIMEOUT_US;
+            }
+            break;
+
+        case OBD2CAN::FC_FLAG_OVERFLOW:
+            statistics.overflows++;
+            finishTransmit(index, ISOTPResult::OVERFLOW);
+            break;
+
+        default:
+            finishTransmit(index, ISOTPResult::UNEXPECTED_PDU);
+            break;
+    }
+}
+
+void ISOTPTransport::finishTransmit(int index, ISOTPResult result) {
+    sessions[index].txState = TxState::IDLE;
+    if (result == ISOTPResult::OK) {
+        statistics.messagesSent++;
+    }
+    if (completeCallback) {
+        completeCallback(index, result);
+    }
+}
+
+void ISOTPTransport::abortReceive(int index, ISOTPResult result) {
+    sessions[index].rxState = RxState::IDLE;
+    if (completeCallback) {
+        completeCallback(index, result);
+    }
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+/**
+ * @file isotp.h
+ * @brief ISO-TP (ISO 15765-2) segmentation and reassembly
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Transport layer for diagnostic messages longer than one CAN frame
+ * (VIN, DTC lists, UDS data). Frames are sent through a caller supplied
+ * hook and received frames are fed in with onFrame(), so the engine has
+ * no driver dependency and runs unchanged in host tests.
+ */
+
+#include <stdint.h>
+#include <functional>
+#include "../../config/project_config.h"
+#include "can_types.h"
+
+/**
+ * @brief ISO-TP transfer result
+ */
+enum class ISOTPResult : uint8_t {
+    OK = 0,
+    TIMEOUT_BS,             // No flow control from receiver (N_Bs)
+    TIMEOUT_CR,             // No consecutive frame from sender (N_Cr)
+    WRONG_SEQUENCE,         // Consecutive frame sequence number mismatch
+    UNEXPECTED_PDU,         // New transfer started while one was in progress
+    OVERFLOW,               // Message does not fit the receive buffer
+    WAIT_LIMIT,             // Too many FC.WAIT frames
+    SEND_FAILED,            // Send hook refused the frame
+    ABORTED                 // Session closed during transfer
+};
+
+/**
+ * @brief ISO-TP transport statistics
+ */
+struct ISOTPStatistics {
+    uint32_t framesSent;
+    uint32_t framesReceived;
+    uint32_t messagesSent;
+    uint32_t messagesReceived;
+    uint32_t timeouts;
+    uint32_t sequenceErrors;
+    uint32_t overflows;
+
+    ISOTPStatistics() : framesSent(0), framesReceived(0), messagesSent(0),
+                        messagesReceived(0), timeouts(0), sequenceErrors(0), overflows(0) {}
+};
+
+/**
+ * @class ISOTPTransport
+ * @brief Concurrent ISO-TP sessions, one per ECU address pair
+ *
+ * Each session owns preallocated RX and TX buffers of ISOTP_MAX_MESSAGE_SIZE
+ * bytes; nothing is allocated per transfer. Call onFrame() for every
+ * received frame and poll() regularly (every loop pass or after each
+ * receive wakeup) to pace consecutive frames and expire timeouts.
+ */
+class ISOTPTransport {
+public:
+    typedef std::function<bool(const CANMessage&)> SendFunction;
+    typedef std::function<uint32_t()> ClockFunction;      // Monotonic microseconds
+    typedef std::function<void(int session, const uint8_t* data, uint16_t length)> ReceiveCallback;
+    typedef std::function<void(int session, ISOTPResult result)> CompleteCallback;
+
+    /**
+     * @brief Constructor
+     * @param send Hook that transmits one CAN frame
+     * @param clock Monotonic microsecond clock (micros() on target)
+     */
+    ISOTPTransport(SendFunction send, ClockFunction clock);
+
+    // ===== SESSIONS =====
+
+    /**
+     * @brief Open a session for one address pair
+     * @param txId ID we send on (e.g. 0x7E0)
+     * @param rxId ID the peer answers on (e.g. 0x7E8)
+     * @param extended 29-bit identifiers
+     * @return Session index, or -1 if none free or rxId already in use
+     */
+    int openSession(uint32_t txId, uint32_t rxId, bool extended = false);
+
+    /**
+     * @brief Close a session, aborting any transfer in progress
+     * @param session Session index
+     */
+    void closeSession(int session);
+
+    /**
+     * @brief Find the session receiving on an ID
+     * @param rxId Receive CAN identifier
+     * @param extended 29-bit identifier
+     * @return Session index or -1
+     */
+    int findSession(uint32_t rxId, bool extended = false) const;
+
+    /**
+     * @brief Open sessions for all eight standard OBD2 ECU addresses
+     * @return Number of sessions opened
+     */
+    int openOBD2Sessions();
+
+    // ===== TRANSFER =====
+
+    /**
+     * @brief Start sending a message on a session
+     * @param session Session index
+     * @param data Payload
+     * @param length Payload length (1..ISOTP_MAX_MESSAGE_SIZE)
+     * @return false if session busy, length invalid or first frame not sent
+     */
+    bool send(int session, const uint8_t* data, uint16_t length);
+
+    /**
+     * @brief Send a single-frame message to a functional address
+     * @param id Functional request ID (e.g. 0x7DF)
+     * @param data Payload
+     * @param length Payload length (1..7)
+     * @param extended 29-bit identifier
+     * @return true if frame was sent
+     */
+    bool sendFunctional(uint32_t id, const uint8_t* data, uint8_t length, bool extended = false);
+
+    /**
+     * @brief Feed a received CAN frame
+     * @param message Received frame
+     * @return true if the frame belonged to an open session
+     */
+    bool onFrame(const CANMessage& message);
+
+    /**
+     * @brief Send due consecutive frames and expire timeouts
+     */
+    void poll();
+
+    /**
+     * @brief Check if a session has a transfer in progress
+     * @param session Session index
+     * @return true if sending or receiving
+     */
+    bool isBusy(int session) const;
+
+    // ===== CONFIGURATION =====
+
+    /**
+     * @brief Set the flow control parameters we advertise when receiving
+     * @param blockSize Frames per block (0 = whole message)
+     * @param stMin Raw STmin byte (0x00-0x7F ms, 0xF1-0xF9 100-900 us)
+     */
+    void setReceiveFlowControl(uint8_t blockSize, uint8_t stMin);
+
+    /**
+     * @brief Set callback for reassembled messages
+     * @param callback Receive callback (data valid during the call only)
+     */
+    void setReceiveCallback(ReceiveCallback callback);
+
+    /**
+     * @brief Set callback for finished transmissions and errors
+     * @param callback Completion callback
+     */
+    void setCompleteCallback(CompleteCallback callback);
+
+    /**
+     * @brief Get statistics
+     */
+    const ISOTPStatistics& getStatistics() const { return statistics; }
+
+    /**
+     * @brief Convert raw STmin byte to microseconds
+     * @param stMin Raw STmin byte
+     * @return Separation time in microseconds
+     */
+    static uint32_t stMinToMicros(uint8_t stMin);
+
+    /**
+     * @brief Get result name for logging
+     */
+    static const char* resultName(ISOTPResult result);
+
+private:
+    enum class RxState : uint8_t { IDLE, RECEIVING };
+    enum class TxState : uint8_t { IDLE, WAIT_FLOW_CONTROL, SENDING };
+
+    struct Session {
+        bool open;
+        bool extended;
+        uint32_t txId;
+        uint32_t rxId;
+
+        // Reassembly
+        RxState rxState;
+        uint16_t rxLength;
+        uint16_t rxReceived;
+        uint8_t rxSequence;
+        uint8_t rxBlockCount;
+        uint32_t rxDeadline;
+        uint8_t rxBuffer[ISOTP_MAX_MESSAGE_SIZE];
+
+        // Segmentation
+        TxState txState;
+        uint16_t txLength;
+        uint16_t txOffset;
+        uint8_t txSequence;
+        uint8_t txBlockSize;
+        uint8_t txBlockRemaining;
+        uint8_t txWaitCount;
+        uint32_t txSeparationUs;
+        uint32_t txNextTime;
+        uint32_t txDeadline;
+        uint8_t txBuffer[ISOTP_MAX_MESSAGE_SIZE];
+    };
+
+    Session sessions[ISOTP_MAX_SESSIONS];
+    SendFunction sendFrame;
+    ClockFunction clock;
+    ReceiveCallback receiveCallback;
+    CompleteCallback completeCallback;
+    uint8_t rxBlockSize;
+    uint8_t rxStMin;
+    ISOTPStatistics statistics;
+
+    bool isValid(int session) const;
+    bool transmit(uint32_t id, bool extended, const uint8_t* payload, uint8_t length);
+    bool sendFlowControl(const Session& s, uint8_t flag);
+    bool sendConsecutiveFrames(int index, uint32_t now);
+    void handleSingleFrame(int index, const CANMessage& message);
+    void handleFirstFrame(int index, const CANMessage& message, uint32_t now);
+    void handleConsecutiveFrame(int index, const CANMessage& message, uint32_t now);
+    void handleFlowControl(int index, const CANMessage& message, uint32_t now);
+    void finishTransmit(int index, ISOTPResult result);
+    void abortReceive(int index, ISOTPResult result);
+
+    static bool reached(uint32_t now, uint32_t deadline) {
+        return static_cast<int32_t>(now - deadline) >= 0;
+    }
+};
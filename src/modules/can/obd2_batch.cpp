@@ -0,0 +1,112 @@
+/**
+ * @file obd2_batch.cpp
+ * @brief Multi-PID Mode 01 packing implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "obd2_batch.h"
+
+namespace {
+    // SAE J1979 Mode 01 data bytes per PID (0 = not defined)
+    const uint8_t MODE01_LENGTHS[256] = {
+        // 0x00-0x0F
+        4, 4, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1,
+        // 0x10-0x1F
+        2, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2,
+        // 0x20-0x2F
+        4, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1,
+        // 0x30-0x3F
+        1, 2, 2, 1, 4, 4, 4, 4, 4, 4, 4, 4, 2, 2, 2, 2,
+        // 0x40-0x4F
+        4, 4, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 4,
+        // 0x50-0x5F
+        4, 1, 1, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 1,
+        // 0x60-0x6F
+        4, 1, 1, 2, 5, 2, 5, 3, 7, 7, 5, 5, 5, 11, 9, 3,
+        // 0x70-0x7F
+        10, 6, 5, 5, 5, 7, 7, 5, 9, 9, 7, 7, 9, 1, 1, 13,
+        // 0x80-0x8F
+        4, 41, 41, 9, 1, 10, 5, 5, 13, 41, 41, 7, 17, 1, 1, 7,
+        // 0x90-0x9F
+        3, 5, 2, 3, 12, 0, 0, 0, 9, 9, 6, 4, 17, 4, 2, 9,
+        // 0xA0-0xAF
+        4, 9, 2, 9, 4, 4, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        // 0xB0-0xBF
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        // 0xC0-0xCF
+        4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        // 0xD0-0xDF
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        // 0xE0-0xEF
+        4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        // 0xF0-0xFF
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+}
+
+namespace OBD2Batch {
+
+uint8_t mode01DataLength(uint8_t pid) {
+    return MODE01_LENGTHS[pid];
+}
+
+size_t pack(const uint8_t* pids, size_t count, uint8_t requests[][1 + MAX_PIDS_PER_REQUEST],
+            uint8_t* lengths, size_t maxRequests) {
+    size_t used = 0;
+    int16_t open[2] = {-1, -1};     // Request being filled: [0] data PIDs, [1] support PIDs
+
+    for (size_t i = 0; i < count; i++) {
+        uint8_t pid = pids[i];
+
+        // Drop duplicates
+        bool duplicate = false;
+        for (size_t r = 0; r < used && !duplicate; r++) {
+            for (uint8_t p = 1; p < lengths[r]; p++) {
+                if (requests[r][p] == pid) {
+                    duplicate = true;
+                    break;
+                }
+            }
+        }
+        if (duplicate) {
+            continue;
+        }
+
+        int kind = isSupportPID(pid) ? 1 : 0;
+        if (open[kind] < 0 || lengths[open[kind]] == 1 + MAX_PIDS_PER_REQUEST) {
+            if (used == maxRequests) {
+                break;
+            }
+            open[kind] = used++;
+            requests[open[kind]][0] = MODE_CURRENT_DATA;
+            lengths[open[kind]] = 1;
+        }
+        requests[open[kind]][lengths[open[kind]]++] = pid;
+    }
+    return used;
+}
+
+size_t split(const uint8_t* response, uint16_t length, PIDValue* values, size_t maxValues) {
+    if (length < 1 || response[0] != MODE_CURRENT_DATA + 0x40) {
+        return 0;
+    }
+
+    size_t count = 0;
+    uint16_t offset = 1;
+    while (offset < length && count < maxValues) {
+        uint8_t pid = response[offset];
+        uint8_t dataLength = MODE01_LENGTHS[pid];
+        if (dataLength == 0 || offset + 1 + dataLength > length) {
+            break; // Unknown PID or truncated: the rest cannot be framed
+        }
+        values[count].pid = pid;
+        values[count].length = dataLength;
+        values[count].data = &response[offset + 1];
+        count++;
+        offset += 1 + dataLength;
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+ * @file obd2_batch.h
+ * @brief Multi-PID Mode 01 request packing and response splitting
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * SAE J1979 lets a Mode 01 request carry up to six PIDs; the ECU answers
+ * with one message holding each supported PID followed by its data bytes.
+ * Splitting the answer needs the data length of every PID, kept here as a
+ * flat table.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace OBD2Batch {
+    constexpr uint8_t MAX_PIDS_PER_REQUEST = 6;
+    constexpr uint8_t MODE_CURRENT_DATA    = 0x01;
+
+    /**
+     * @brief One PID value inside a multi-PID response
+     */
+    struct PIDValue {
+        uint8_t pid;
+        uint8_t length;
+        const uint8_t* data;    // Points into the response buffer
+    };
+
+    /**
+     * @brief Mode 01 data byte count for a PID
+     * @param pid Parameter ID
+     * @return Data bytes, or 0 if the PID is not defined
+     */
+    uint8_t mode01DataLength(uint8_t pid);
+
+    /**
+     * @brief Check for a "PIDs supported" bitmap PID (0x00, 0x20, ... 0xE0)
+     * @param pid Parameter ID
+     * @return true if PID reports support for the next 32 PIDs
+     *
+     * J1979 only allows these to be combined with each other.
+     */
+    inline bool isSupportPID(uint8_t pid) {
+        return (pid & 0x1F) == 0;
+    }
+
+    /**
+     * @brief Pack PIDs into as few Mode 01 requests as possible
+     * @param pids PIDs to request (duplicates are dropped)
+     * @param count Number of PIDs
+     * @param requests Output request payloads (SID followed by up to six PIDs)
+     * @param lengths Output payload lengths
+     * @param maxRequests Capacity of requests/lengths
+     * @return Number of requests written
+     */
+    size_t pack(const uint8_t* pids, size_t count, uint8_t requests[][1 + MAX_PIDS_PER_REQUEST],
+                uint8_t* lengths, size_t maxRequests);
+
+    /**
+     * @brief Split a Mode 01 response into per-PID values
+     * @param response Payload starting with 0x41
+     * @param length Payload length
+     * @param values Output values
+     * @param maxValues Capacity of values
+     * @return Number of values; parsing stops at an unknown PID or short data
+     */
+    size_t split(const uint8_t* response, uint16_t length, PIDValue* values, size_t maxValues);
+}
@@ -0,0 +1,554 @@
+/**
+ * @file obd2_request_scheduler.cpp
+ * @brief Pipelined OBD2 request scheduler implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "obd2_request_scheduler.h"
+#include <string.h>
+
+static_assert(OBD2_REQUEST_SLOTS <= 256, "request IDs carry the slot index in 8 bits");
+static_assert((OBD2_WHEEL_SLOTS & (OBD2_WHEEL_SLOTS - 1)) == 0, "wheel size must be a power of two");
+
+namespace {
+    constexpr uint32_t TICK_US = OBD2_WHEEL_TICK_MS * 1000UL;
+    constexpr uint32_t WHEEL_MASK = OBD2_WHEEL_SLOTS - 1;
+    constexpr uint8_t NEGATIVE_RESPONSE = 0x7F;
+    constexpr uint8_t NRC_RESPONSE_PENDING = 0x78;
+    constexpr uint8_t POSITIVE_OFFSET = 0x40;
+
+    bool packedAll(const uint8_t* pids, uint8_t count,
+                   const uint8_t packed[][1 + OBD2Batch::MAX_PIDS_PER_REQUEST],
+                   const uint8_t* lengths, size_t requestCount) {
+        for (uint8_t i = 0; i < count; i++) {
+            bool found = false;
+            for (size_t r = 0; r < requestCount && !found; r++) {
+                found = memchr(&packed[r][1], pids[i], lengths[r] - 1) != nullptr;
+            }
+            if (!found) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+// ===== CONSTRUCTOR =====
+
+OBD2RequestScheduler::OBD2RequestScheduler(ISOTPTransport& isotp, ClockFunction clockSource) :
+    transport(isotp),
+    clock(clockSource),
+    pendingHead(NONE),
+    pendingTail(NONE),
+    pendingCount(0),
+    functionalRequest(NONE),
+    inFlightCount(0),
+    maxInFlight(OBD2_MAX_IN_FLIGHT),
+    knownEcus(0),
+    wheelTick(0),
+    wheelTime(0)
+{
+    for (int i = 0; i < OBD2_REQUEST_SLOTS; i++) {
+        requests[i].state = SlotState::FREE;
+        requests[i].generation = 0;
+        requests[i].next = NONE;
+        requests[i].prev = NONE;
+    }
+    for (int i = 0; i < 8; i++) {
+        ecuRequest[i] = NONE;
+    }
+    for (int i = 0; i < OBD2_WHEEL_SLOTS; i++) {
+        wheel[i] = NONE;
+    }
+
+    // Map transport sessions to ECU indices
+    transport.openOBD2Sessions();
+    for (int i = 0; i < ISOTP_MAX_SESSIONS; i++) {
+        sessionEcu[i] = -1;
+    }
+    for (uint8_t ecu = 0; ecu < 8; ecu++) {
+        int session = transport.findSession(OBD2CAN::RESPONSE_ID_BASE + ecu);
+        if (session >= 0) {
+            sessionEcu[session] = ecu;
+        }
+    }
+    transport.setReceiveCallback([this](int session, const uint8_t* data, uint16_t length) {
+        handleResponse(session, data, length);
+    });
+
+    wheelTime = clock();
+}
+
+// ===== REQUESTS =====
+
+int OBD2RequestScheduler::submit(uint8_t ecu, uint8_t sid, uint8_t pid, ResponseCallback callback,
+                                 uint32_t timeoutMs) {
+    uint8_t request[2] = {sid, pid};
+    return submitRaw(ecu, request, pid == NO_PID ? 1 : 2, callback, timeoutMs);
+}
+
+int OBD2RequestScheduler::submitRaw(uint8_t ecu, const uint8_t* request, uint8_t length,
+                                    ResponseCallback callback, uint32_t timeoutMs) {
+    int index = enqueue(ecu, request, length, timeoutMs);
+    if (index < 0) {
+        return -1;
+    }
+    requests[index].callback = callback;
+    return makeId(index);
+}
+
+int OBD2RequestScheduler::submitBatch(uint8_t ecu, const uint8_t* pids, uint8_t count,
+                                      PIDCallback callback, uint32_t timeoutMs) {
+    const size_t maxRequests = OBD2_REQUEST_SLOTS;
+    uint8_t packed[maxRequests][1 + OBD2Batch::MAX_PIDS_PER_REQUEST];
+    uint8_t lengths[maxRequests];
+    size_t requestCount = OBD2Batch::pack(pids, count, packed, lengths, maxRequests);
+    if (requestCount == 0 || (ecu >= 8 && ecu != FUNCTIONAL)) {
+        return 0;
+    }
+
+    // All or nothing, so no PID is left without a result
+    size_t freeSlots = 0;
+    for (int i = 0; i < OBD2_REQUEST_SLOTS; i++) {
+        freeSlots += requests[i].state == SlotState::FREE ? 1 : 0;
+    }
+    if (freeSlots < requestCount || !packedAll(pids, count, packed, lengths, requestCount)) {
+        statistics.rejected++;
+        return 0;
+    }
+
+    // Each slot keeps the PIDs it asked for in its request bytes and splits
+    // its own response back into them (completeBatch)
+    int queued = 0;
+    for (size_t i = 0; i < requestCount; i++) {
+        int index = enqueue(ecu, packed[i], lengths[i], timeoutMs);
+        requests[index].pidCallback = callback;
+        queued++;
+    }
+    return queued;
+}
+
+int OBD2RequestScheduler::enqueue(uint8_t ecu, const uint8_t* request, uint8_t length, uint32_t timeoutMs) {
+    if ((ecu >= 8 && ecu != FUNCTIONAL) || length == 0 || length > 7) {
+        return -1;
+    }
+
+    for (int i = 0; i < OBD2_REQUEST_SLOTS; i++) {
+        Request& r = requests[i];
+        if (r.state != SlotState::FREE) {
+            continue;
+        }
+
+        r.state = SlotState::PENDING;
+        r.ecu = ecu;
+        r.length = length;
+        memcpy(r.request, request, length);
+        r.pidsReported = 0;
+        r.timeoutUs = timeoutMs * 1000UL;
+        r.next = NONE;
+
+        // Append to pending FIFO
+        if (pendingTail == NONE) {
+            pendingHead = i;
+        } else {
+            requests[pendingTail].next = i;
+        }
+        pendingTail = i;
+        pendingCount++;
+        statistics.submitted++;
+        return i;
+    }
+
+    statistics.rejected++;
+    return -1;
+}
+
+bool OBD2RequestScheduler::cancel(int requestId) {
+    int index = requestId & 0xFF;
+    if (requestId < 0 || index >= OBD2_REQUEST_SLOTS) {
+        return false;
+    }
+
+    Request& r = requests[index];
+    if (r.state == SlotState::FREE || r.generation != ((requestId >> 8) & 0xFF)) {
+        return false;
+    }
+
+    if (r.state == SlotState::PENDING) {
+        int16_t prev = NONE;
+        for (int16_t i = pendingHead; i != NONE; prev = i, i = requests[i].next) {
+            if (i != index) {
+                continue;
+            }
+            if (prev == NONE) {
+                pendingHead = r.next;
+            } else {
+                requests[prev].next = r.next;
+            }
+            if (pendingTail == index) {
+                pendingTail = prev;
+            }
+            pendingCount--;
+            break;
+        }
+    }
+
+    complete(index, OBD2RequestStatus::CANCELLED, r.ecu, 0, nullptr, 0, clock());
+    release(index);
+    return true;
+}
+
+// ===== PROCESSING =====
+
+bool OBD2RequestScheduler::onFrame(const CANMessage& message) {
+    bool consumed = transport.onFrame(message);
+    if (consumed) {
+        dispatch(); // A completed response may have freed its ECU
+    }
+    return consumed;
+}
+
+void OBD2RequestScheduler::poll() {
+    transport.poll();
+    advanceWheel(clock());
+    dispatch();
+}
+
+void OBD2RequestScheduler::setMaxInFlight(uint8_t limit) {
+    if (limit < 1) {
+        limit = 1;
+    }
+    maxInFlight = limit > OBD2_MAX_IN_FLIGHT ? OBD2_MAX_IN_FLIGHT : limit;
+}
+
+void OBD2RequestScheduler::dispatch() {
+    int16_t prev = NONE;
+    int16_t index = pendingHead;
+
+    while (index != NONE && inFlightCount < maxInFlight && functionalRequest == NONE) {
+        Request& r = requests[index];
+        int16_t next = r.next;
+
+        bool ready;
+        if (r.ecu == FUNCTIONAL) {
+            // Functional request needs a quiet bus and holds back later requests
+            if (inFlightCount != 0) {
+                break;
+            }
+            ready = true;
+        } else {
+            ready = ecuRequest[r.ecu] == NONE;
+        }
+
+        if (ready) {
+            if (!sendRequest(index)) {
+                break; // Driver queue full, retry on next poll
+            }
+            if (prev == NONE) {
+                pendingHead = next;
+            } else {
+                requests[prev].next = next;
+            }
+            if (pendingTail == index) {
+                pendingTail = prev;
+            }
+            pendingCount--;
+        } else {
+            prev = index; // ECU busy: keep order, look further down the queue
+        }
+        index = next;
+    }
+}
+
+bool OBD2RequestScheduler::sendRequest(int index) {
+    Request& r = requests[index];
+    uint32_t now = clock();
+
+    bool sent;
+    if (r.ecu == FUNCTIONAL) {
+        sent = transport.sendFunctional(OBD2CAN::FUNCTIONAL_REQUEST_ID, r.request, r.length);
+    } else {
+        int session = transport.findSession(OBD2CAN::RESPONSE_ID_BASE + r.ecu);
+        sent = session >= 0 && transport.send(session, r.request, r.length);
+    }
+    if (!sent) {
+        return false;
+    }
+
+    r.state = SlotState::IN_FLIGHT;
+    r.sentAt = now;
+    r.deadline = now + r.timeoutUs;
+    r.answered = 0;
+    r.expected = knownEcus;
+    if (r.ecu == FUNCTIONAL) {
+        functionalRequest = index;
+    } else {
+        ecuRequest[r.ecu] = index;
+    }
+    inFlightCount++;
+    if (inFlightCount > statistics.maxInFlight) {
+        statistics.maxInFlight = inFlightCount;
+    }
+    statistics.sent++;
+    wheelInsert(index);
+    return true;
+}
+
+// ===== RESPONSE CORRELATION =====
+
+bool OBD2RequestScheduler::matches(const Request& r, const uint8_t* data, uint16_t length) const {
+    if (data[0] == NEGATIVE_RESPONSE) {
+        return length >= 3 && data[1] == r.request[0];
+    }
+    if (data[0] != static_cast<uint8_t>(r.request[0] + POSITIVE_OFFSET)) {
+        return false;
+    }
+    if (r.length < 2) {
+        return true; // Service without PID
+    }
+    if (length < 2) {
+        return false;
+    }
+    for (uint8_t i = 1; i < r.length; i++) {
+        if (data[1] == r.request[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void OBD2RequestScheduler::handleResponse(int session, const uint8_t* data, uint16_t length) {
+    int ecu = (session >= 0 && session < ISOTP_MAX_SESSIONS) ? sessionEcu[session] : -1;
+    if (ecu < 0 || length == 0) {
+        statistics.unmatched++;
+        return;
+    }
+
+    uint32_t now = clock();
+    uint8_t ecuBit = 1 << ecu;
+    knownEcus |= ecuBit;
+
+    int index = ecuRequest[ecu];
+    if (index == NONE || !matches(requests[index], data, length)) {
+        index = functionalRequest;
+        if (index == NONE || !matches(requests[index], data, length)) {
+            statistics.unmatched++;
+            return;
+        }
+    }
+    Request& r = requests[index];
+
+    if (data[0] == NEGATIVE_RESPONSE) {
+        if (data[2] == NRC_RESPONSE_PENDING) {
+            // ECU needs longer: move the deadline out to P2*
+            statistics.pendingExtensions++;
+            wheelRemove(index);
+            r.deadline = now + OBD2CAN::P2_STAR_CLIENT_MAX * 1000UL;
+            wheelInsert(index);
+            return;
+        }
+        statistics.negative++;
+        complete(index, OBD2RequestStatus::NEGATIVE, ecu, data[2], nullptr, 0, now);
+    } else {
+        statistics.responses++;
+        complete(index, OBD2RequestStatus::OK, ecu, 0, data, length, now);
+    }
+
+    if (r.state != SlotState::IN_FLIGHT) {
+        return; // Cancelled from its own callback
+    }
+    if (r.ecu != FUNCTIONAL) {
+        release(index);
+        return;
+    }
+
+    // Functional: done once every ECU known at send time has answered
+    r.answered |= ecuBit;
+    if (r.expected != 0 && (r.answered & r.expected) == r.expected) {
+        finishBatch(index, now);
+        if (r.state == SlotState::IN_FLIGHT) {
+            release(index);
+        }
+    }
+}
+
+void OBD2RequestScheduler::complete(int index, OBD2RequestStatus status, uint8_t ecu, uint8_t nrc,
+                                    const uint8_t* data, uint16_t length, uint32_t now) {
+    Request& r = requests[index];
+    if (r.pidCallback) {
+        completeBatch(index, status, ecu, nrc, data, length, now);
+        return;
+    }
+    if (!r.callback) {
+        return;
+    }
+
+    OBD2Response response;
+    response.status = status;
+    response.requestId = makeId(index);
+    response.ecu = ecu;
+    response.sid = r.request[0];
+    response.pid = r.length >= 2 ? r.request[1] : 0;
+    response.nrc = nrc;
+    response.data = data;
+    response.length = length;
+    response.latencyUs = r.state == SlotState::IN_FLIGHT ? now - r.sentAt : 0;
+    r.callback(response);
+}
+
+void OBD2RequestScheduler::completeBatch(int index, OBD2RequestStatus status, uint8_t ecu, uint8_t nrc,
+                                         const uint8_t* data, uint16_t length, uint32_t now) {
+    Request& r = requests[index];
+
+    OBD2Batch::PIDValue values[OBD2Batch::MAX_PIDS_PER_REQUEST];
+    size_t valueCount = 0;
+    if (status == OBD2RequestStatus::OK) {
+        valueCount = OBD2Batch::split(data, length, values, OBD2Batch::MAX_PIDS_PER_REQUEST);
+    }
+
+    OBD2PIDResult result;
+    result.ecu = ecu;
+    result.nrc = nrc;
+    result.latencyUs = r.state == SlotState::IN_FLIGHT ? now - r.sentAt : 0;
+
+    // Stop if a callback cancels the request (release bumps the generation)
+    uint8_t generation = r.generation;
+    for (uint8_t p = 0; p + 1 < r.length && r.generation == generation; p++) {
+        uint8_t bit = 1 << p;
+        result.pid = r.request[p + 1];
+        result.status = status;
+        result.data = nullptr;
+        result.length = 0;
+
+        if (status == OBD2RequestStatus::OK) {
+            const OBD2Batch::PIDValue* value = nullptr;
+            for (size_t v = 0; v < valueCount; v++) {
+                if (values[v].pid == result.pid) {
+                    value = &values[v];
+                    break;
+                }
+            }
+            if (value != nullptr) {
+                result.data = value->data;
+                result.length = value->length;
+            } else if (r.ecu == FUNCTIONAL) {
+                continue; // Another ECU may own this PID; finishBatch() reports it otherwise
+            } else {
+                result.status = OBD2RequestStatus::NOT_SUPPORTED;
+            }
+        } else if (status != OBD2RequestStatus::NEGATIVE && (r.pidsReported & bit) != 0) {
+            continue; // Already answered; closing statuses only cover the rest
+        }
+
+        r.pidsReported |= bit;
+        r.pidCallback(result);
+    }
+}
+
+void OBD2RequestScheduler::finishBatch(int index, uint32_t now) {
+    // Functional batch closing: PIDs no ECU answered still get a result
+    Request& r = requests[index];
+    if (!r.pidCallback) {
+        return;
+    }
+    complete(index, r.answered != 0 ? OBD2RequestStatus::NOT_SUPPORTED : OBD2RequestStatus::TIMEOUT,
+             FUNCTIONAL, 0, nullptr, 0, now);
+}
+
+void OBD2RequestScheduler::release(int index) {
+    Request& r = requests[index];
+    if (r.state == SlotState::IN_FLIGHT) {
+        wheelRemove(index);
+        if (r.ecu == FUNCTIONAL) {
+            functionalRequest = NONE;
+        } else {
+            ecuRequest[r.ecu] = NONE;
+        }
+        inFlightCount--;
+    }
+    r.state = SlotState::FREE;
+    r.generation++;
+    r.callback = nullptr;
+    r.pidCallback = nullptr;
+}
+
+// ===== DEADLINE TIMER WHEEL =====
+
+void OBD2RequestScheduler::wheelInsert(int index) {
+    Request& r = requests[index];
+
+    // Ticks from the wheel's current position until the deadline is reached
+    int32_t delta = static_cast<int32_t>(r.deadline - wheelTime);
+    uint32_t ticks = delta <= 0 ? 1 : (static_cast<uint32_t>(delta) + TICK_US - 1) / TICK_US;
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    r.wheelSlot = (wheelTick + ticks) & WHEEL_MASK;
+    r.rounds = (ticks - 1) / OBD2_WHEEL_SLOTS;
+    r.prev = NONE;
+    r.next = wheel[r.wheelSlot];
+    if (r.next != NONE) {
+        requests[r.next].prev = index;
+    }
+    wheel[r.wheelSlot] = index;
+}
+
+void OBD2RequestScheduler::wheelRemove(int index) {
+    Request& r = requests[index];
+    if (r.prev == NONE) {
+        if (wheel[r.wheelSlot] == index) {
+            wheel[r.wheelSlot] = r.next;
+        }
+    } else {
+        requests[r.prev].next = r.next;
+    }
+    if (r.next != NONE) {
+        requests[r.next].prev = r.prev;
+    }
+    r.next = NONE;
+    r.prev = NONE;
+}
+
+void OBD2RequestScheduler::advanceWheel(uint32_t now) {
+    while (reached(now, wheelTime + TICK_US)) {
+        wheelTime += TICK_US;
+        wheelTick++;
+
+        // Collect first: expiry callbacks may cancel other requests in this slot
+        int16_t expired[OBD2_REQUEST_SLOTS];
+        int expiredCount = 0;
+        for (int16_t i = wheel[wheelTick & WHEEL_MASK]; i != NONE; i = requests[i].next) {
+            if (requests[i].rounds == 0) {
+                expired[expiredCount++] = i;
+            } else {
+                requests[i].rounds--;
+            }
+        }
+
+        for (int i = 0; i < expiredCount; i++) {
+            if (requests[expired[i]].state == SlotState::IN_FLIGHT) {
+                expire(expired[i], now);
+            }
+        }
+    }
+}
+
+void OBD2RequestScheduler::expire(int index, uint32_t now) {
+    Request& r = requests[index];
+    if (r.ecu == FUNCTIONAL && r.answered != 0) {
+        // Response window closed, answers already delivered
+        finishBatch(index, now);
+        if (r.state == SlotState::IN_FLIGHT) {
+            release(index);
+        }
+        return;
+    }
+
+    statistics.timeouts++;
+    complete(index, OBD2RequestStatus::TIMEOUT, r.ecu, 0, nullptr, 0, now);
+    if (r.state == SlotState::IN_FLIGHT) {
+        release(index);
+    }
+}
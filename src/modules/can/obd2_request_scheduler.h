@@ -0,0 +1,266 @@
+#pragma once
+
+/**
+ * @file obd2_request_scheduler.h
+ * @brief Pipelined OBD2 request scheduler with response correlation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Keeps one request in flight per ECU address (0x7E0-0x7E7) instead of
+ * idling through a P2 timeout per query. Responses are matched to their
+ * request by ECU, service ID and PID; deadlines live in a timer wheel so
+ * expiring them costs O(1) per tick regardless of how many are pending.
+ */
+
+#include <stdint.h>
+#include <functional>
+#include "../../config/project_config.h"
+#include "can_types.h"
+#include "isotp.h"
+#include "obd2_batch.h"
+
+/**
+ * @brief Final state of a scheduled request
+ */
+enum class OBD2RequestStatus : uint8_t {
+    OK = 0,             // Positive response (one callback per responding ECU)
+    NEGATIVE,           // Negative response (0x7F), see nrc
+    TIMEOUT,            // No response before the deadline
+    CANCELLED,          // Cancelled by caller
+    NOT_SUPPORTED       // PID missing from a multi-PID response
+};
+
+/**
+ * @brief Response passed to request callbacks
+ */
+struct OBD2Response {
+    OBD2RequestStatus status;
+    int requestId;
+    uint8_t ecu;                // Responding ECU (0-7), 0xFF for timeouts of functional requests
+    uint8_t sid;                // Request service ID
+    uint8_t pid;                // First requested PID (0 if service has none)
+    uint8_t nrc;                // Negative response code (NEGATIVE only)
+    const uint8_t* data;        // Positive response payload incl. SID+0x40 (valid during callback)
+    uint16_t length;
+    uint32_t latencyUs;         // Request sent to response received
+};
+
+/**
+ * @brief Per-PID result of a batched Mode 01 request
+ */
+struct OBD2PIDResult {
+    OBD2RequestStatus status;
+    uint8_t ecu;                // Responding ECU (0-7), 0xFF if no ECU answered the PID
+    uint8_t pid;
+    uint8_t nrc;                // Negative response code (NEGATIVE only)
+    const uint8_t* data;        // PID data bytes (valid during callback)
+    uint8_t length;
+    uint32_t latencyUs;
+};
+
+/**
+ * @brief Scheduler statistics
+ */
+struct OBD2SchedulerStatistics {
+    uint32_t submitted;
+    uint32_t sent;
+    uint32_t responses;
+    uint32_t negative;
+    uint32_t pendingExtensions;     // NRC 0x78 deadline extensions
+    uint32_t timeouts;
+    uint32_t unmatched;             // Responses without an outstanding request
+    uint32_t rejected;              // submit() or submitBatch() with no free slot
+    uint8_t maxInFlight;
+
+    OBD2SchedulerStatistics() : submitted(0), sent(0), responses(0), negative(0),
+                                pendingExtensions(0), timeouts(0), unmatched(0),
+                                rejected(0), maxInFlight(0) {}
+};
+
+/**
+ * @class OBD2RequestScheduler
+ * @brief Multi-ECU request pipeline over ISOTPTransport
+ *
+ * The scheduler owns the transport's receive callback. Feed received frames
+ * through onFrame() and call poll() every loop pass. Requests are single
+ * frame (up to 7 bytes); responses may be multi-frame.
+ *
+ * Ordering: requests to the same ECU are sent in submission order, one at a
+ * time. A functional request waits until no physical request is in flight
+ * and blocks later requests until it completes. It completes when every
+ * ECU seen so far has answered, or at its deadline.
+ */
+class OBD2RequestScheduler {
+public:
+    static constexpr uint8_t FUNCTIONAL = 0xFF;     // ECU value for 0x7DF requests
+    static constexpr uint8_t NO_PID = 0xFF;         // Services without PID (03, 04, 07, 0A)
+
+    typedef std::function<void(const OBD2Response&)> ResponseCallback;
+    typedef std::function<void(const OBD2PIDResult&)> PIDCallback;
+    typedef std::function<uint32_t()> ClockFunction; // Monotonic microseconds
+
+    /**
+     * @brief Constructor (opens the eight OBD2 sessions on the transport)
+     * @param transport ISO-TP transport used for requests and responses
+     * @param clock Monotonic microsecond clock
+     */
+    OBD2RequestScheduler(ISOTPTransport& transport, ClockFunction clock);
+
+    // ===== REQUESTS =====
+
+    /**
+     * @brief Queue a single-PID request
+     * @param ecu ECU index 0-7 or FUNCTIONAL
+     * @param sid Service ID (mode)
+     * @param pid PID, or NO_PID
+     * @param callback Completion callback
+     * @param timeoutMs Response deadline (P2)
+     * @return Request ID, or -1 if no slot is free
+     */
+    int submit(uint8_t ecu, uint8_t sid, uint8_t pid, ResponseCallback callback,
+               uint32_t timeoutMs = OBD2_RESPONSE_TIMEOUT_MS);
+
+    /**
+     * @brief Queue a raw single-frame request
+     * @param ecu ECU index 0-7 or FUNCTIONAL
+     * @param request Service ID followed by parameters
+     * @param length Request length (1-7)
+     * @param callback Completion callback
+     * @param timeoutMs Response deadline (P2)
+     * @return Request ID, or -1 if invalid or no slot is free
+     */
+    int submitRaw(uint8_t ecu, const uint8_t* request, uint8_t length, ResponseCallback callback,
+                  uint32_t timeoutMs = OBD2_RESPONSE_TIMEOUT_MS);
+
+    /**
+     * @brief Queue Mode 01 PIDs packed six to a request
+     * @param ecu ECU index 0-7 or FUNCTIONAL
+     * @param pids PIDs to read
+     * @param count Number of PIDs
+     * @param callback Called once per PID (per responding ECU for FUNCTIONAL)
+     * @param timeoutMs Response deadline (P2)
+     * @return Number of requests queued; 0 if the batch was refused, in which
+     *         case no PID is queued and the callback is never called
+     *
+     * A batch is queued whole or not at all: it is refused when its PIDs
+     * need more requests than there are free slots. Once queued, every
+     * PID gets at least one result. Physical requests report PIDs
+     * the ECU left out as NOT_SUPPORTED. Functional requests report each
+     * ECU's answers as they arrive; when the request closes, PIDs no ECU
+     * answered are reported as NOT_SUPPORTED, or TIMEOUT if no ECU answered
+     * at all. The PIDs and callback live in the request slots, so batching
+     * allocates nothing beyond what copying the callback needs.
+     */
+    int submitBatch(uint8_t ecu, const uint8_t* pids, uint8_t count, PIDCallback callback,
+                    uint32_t timeoutMs = OBD2_RESPONSE_TIMEOUT_MS);
+
+    /**
+     * @brief Cancel a pending or in-flight request
+     * @param requestId ID returned by submit()
+     * @return true if request was outstanding
+     */
+    bool cancel(int requestId);
+
+    // ===== PROCESSING =====
+
+    /**
+     * @brief Feed a received CAN frame
+     * @param message Received frame
+     * @return true if frame belonged to an OBD2 session
+     */
+    bool onFrame(const CANMessage& message);
+
+    /**
+     * @brief Expire deadlines, drive the transport and send queued requests
+     */
+    void poll();
+
+    // ===== STATUS =====
+
+    uint8_t inFlight() const { return inFlightCount; }
+    uint8_t pending() const { return pendingCount; }
+    bool idle() const { return inFlightCount == 0 && pendingCount == 0; }
+
+    /**
+     * @brief Bitmask of ECUs that have answered at least once
+     */
+    uint8_t getKnownEcus() const { return knownEcus; }
+
+    /**
+     * @brief Limit concurrent requests (1 = strictly sequential)
+     * @param limit Requests in flight (1..OBD2_MAX_IN_FLIGHT)
+     */
+    void setMaxInFlight(uint8_t limit);
+
+    const OBD2SchedulerStatistics& getStatistics() const { return statistics; }
+
+private:
+    enum class SlotState : uint8_t { FREE, PENDING, IN_FLIGHT };
+
+    static constexpr int16_t NONE = -1;
+
+    struct Request {
+        SlotState state;
+        uint8_t ecu;
+        uint8_t length;
+        uint8_t request[7];
+        uint8_t generation;
+        uint8_t answered;           // Functional: ECUs that responded
+        uint8_t expected;           // Functional: ECUs known when sent
+        uint8_t pidsReported;       // Batch: bit n set once request[n + 1] has a result
+        ResponseCallback callback;
+        PIDCallback pidCallback;    // Batch: per-PID results instead of callback
+        uint32_t timeoutUs;
+        uint32_t sentAt;
+        uint32_t deadline;
+        int16_t next;               // Pending FIFO or wheel slot list
+        int16_t prev;               // Wheel slot list
+        uint16_t wheelSlot;
+        uint16_t rounds;            // Full wheel turns left before expiry
+    };
+
+    ISOTPTransport& transport;
+    ClockFunction clock;
+    Request requests[OBD2_REQUEST_SLOTS];
+
+    // Pending FIFO (intrusive, through Request::next)
+    int16_t pendingHead;
+    int16_t pendingTail;
+    uint8_t pendingCount;
+
+    // In-flight bookkeeping
+    int16_t ecuRequest[8];          // In-flight physical request per ECU
+    int16_t functionalRequest;
+    uint8_t inFlightCount;
+    uint8_t maxInFlight;
+    uint8_t knownEcus;
+    int8_t sessionEcu[ISOTP_MAX_SESSIONS];
+
+    // Deadline timer wheel
+    int16_t wheel[OBD2_WHEEL_SLOTS];
+    uint32_t wheelTick;
+    uint32_t wheelTime;
+
+    OBD2SchedulerStatistics statistics;
+
+    int enqueue(uint8_t ecu, const uint8_t* request, uint8_t length, uint32_t timeoutMs);
+    void dispatch();
+    bool sendRequest(int index);
+    void handleResponse(int session, const uint8_t* data, uint16_t length);
+    bool matches(const Request& r, const uint8_t* data, uint16_t length) const;
+    void complete(int index, OBD2RequestStatus status, uint8_t ecu, uint8_t nrc,
+                  const uint8_t* data, uint16_t length, uint32_t now);
+    void completeBatch(int index, OBD2RequestStatus status, uint8_t ecu, uint8_t nrc,
+                       const uint8_t* data, uint16_t length, uint32_t now);
+    void finishBatch(int index, uint32_t now);
+    void release(int index);
+    void wheelInsert(int index);
+    void wheelRemove(int index);
+    void advanceWheel(uint32_t now);
+    void expire(int index, uint32_t now);
+    int makeId(int index) const { return (requests[index].generation << 8) | index; }
+
+    static bool reached(uint32_t now, uint32_t deadline) {
+        return static_cast<int32_t>(now - deadline) >= 0;
+    }
+};
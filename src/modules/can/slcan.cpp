@@ -0,0 +1,318 @@
+/**
+ * @file slcan.cpp
+ * @brief SLCAN (Lawicel) codec and gateway implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "slcan.h"
+#include <string.h>
+
+namespace {
+    const char HEX_DIGITS[16] = {
+        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+    };
+
+    // ASCII -> nibble, 0xFF for non-hex characters
+    const uint8_t HEX_VALUES[256] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+
+    // "Sn" setup codes (Lawicel); S9 and above are reserved
+    const uint32_t SETUP_BITRATES[9] = {
+        10000, 20000, 50000, 100000, 125000, 250000, 500000, 800000, 1000000
+    };
+
+    const char VERSION_REPLY[] = "V0101\r";     // Hardware 01, software 01
+    const char SERIAL_REPLY[] = "NCH01\r";
+}
+
+// ===== CODEC =====
+
+namespace SLCAN {
+
+void putHex(char* out, uint32_t value, uint8_t digits) {
+    for (int i = digits - 1; i >= 0; i--) {
+        out[i] = HEX_DIGITS[value & 0x0F];
+        value >>= 4;
+    }
+}
+
+bool parseHex(const char* in, uint8_t digits, uint32_t& value) {
+    uint32_t result = 0;
+    for (uint8_t i = 0; i < digits; i++) {
+        uint8_t nibble = HEX_VALUES[static_cast<uint8_t>(in[i])];
+        if (nibble == 0xFF) {
+            return false;
+        }
+        result = (result << 4) | nibble;
+    }
+    value = result;
+    return true;
+}
+
+size_t encodeFrame(const CANFrame& frame, char* out, bool timestamp) {
+    char* p = out;
+    const bool extended = frame.isExtended();
+    if (frame.isRemote()) {
+        *p++ = extended ? 'R' : 'r';
+    } else {
+        *p++ = extended ? 'T' : 't';
+    }
+    if (extended) {
+        putHex(p, frame.id(), 8);
+        p += 8;
+    } else {
+        putHex(p, frame.id(), 3);
+        p += 3;
+    }
+
+    const uint8_t dlc = frame.dlc > 8 ? 8 : frame.dlc;
+    *p++ = HEX_DIGITS[dlc];
+    if (!frame.isRemote()) {
+        for (uint8_t i = 0; i < dlc; i++) {
+            *p++ = HEX_DIGITS[frame.data[i] >> 4];
+            *p++ = HEX_DIGITS[frame.data[i] & 0x0F];
+        }
+    }
+
+    if (timestamp) {
+        putHex(p, static_cast<uint32_t>((frame.timestamp / 1000) % 60000), 4);
+        p += 4;
+    }
+    *p++ = REPLY_OK;
+    return p - out;
+}
+
+bool decodeFrame(const char* line, size_t length, CANFrame& frame) {
+    if (length < 1) {
+        return false;
+    }
+    const char type = line[0];
+    const bool extended = type == 'T' || type == 'R';
+    const bool remote = type == 'r' || type == 'R';
+    if (!extended && type != 't' && !remote) {
+        return false;
+    }
+
+    const uint8_t idDigits = extended ? 8 : 3;
+    uint32_t id;
+    uint32_t dlc;
+    if (length < 1u + idDigits + 1u || !parseHex(line + 1, idDigits, id) ||
+        !parseHex(line + 1 + idDigits, 1, dlc) || dlc > 8) {
+        return false;
+    }
+    if (id > (extended ? CANFrame::ID_MASK : 0x7FFUL)) {
+        return false;
+    }
+
+    const size_t dataStart = 2 + idDigits;
+    if (length != dataStart + (remote ? 0 : dlc * 2)) {
+        return false;
+    }
+
+    frame.setId(id, extended, remote);
+    frame.dlc = static_cast<uint8_t>(dlc);
+    memset(frame.data, 0, sizeof(frame.data));
+    if (!remote) {
+        for (uint8_t i = 0; i < dlc; i++) {
+            const uint8_t high = HEX_VALUES[static_cast<uint8_t>(line[dataStart + 2 * i])];
+            const uint8_t low = HEX_VALUES[static_cast<uint8_t>(line[dataStart + 2 * i + 1])];
+            if (high == 0xFF || low == 0xFF) {
+                return false;
+            }
+            frame.data[i] = (high << 4) | low;
+        }
+    }
+    return true;
+}
+
+uint32_t bitrateForCode(char code) {
+    if (code < '0' || code > '8') {
+        return 0;
+    }
+    return SETUP_BITRATES[code - '0'];
+}
+
+}
+
+// ===== GATEWAY =====
+
+SLCANGateway::SLCANGateway(WriteFunction write, TransmitFunction transmit, BusControlFunction control)
+    : write(write), transmit(transmit), control(control), statusFunction(nullptr),
+      open(false), listenOnly(false), timestamps(false), bitrate(500000),
+      lineLength(0), lineOverflow(false), outputLength(0) {}
+
+void SLCANGateway::receive(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        const char c = static_cast<char>(data[i]);
+        if (c == '\r') {
+            if (lineOverflow) {
+                statistics.lineOverflows++;
+                statistics.commandErrors++;
+                replyStatus(false);
+            } else if (lineLength > 0) {
+                executeCommand(line, lineLength);
+            }
+            lineLength = 0;
+            lineOverflow = false;
+        } else if (c == '\n') {
+            continue;                   // Tolerate CRLF terminals
+        } else if (lineLength < sizeof(line)) {
+            line[lineLength++] = c;
+        } else {
+            lineOverflow = true;
+        }
+    }
+}
+
+bool SLCANGateway::forwardFrame(const CANFrame& frame) {
+    if (!open || frame.isError()) {
+        return false;
+    }
+    char* out = reserveOutput(SLCAN::MAX_FRAME_LINE);
+    outputLength += SLCAN::encodeFrame(frame, out, timestamps);
+    statistics.framesToHost++;
+    return true;
+}
+
+size_t SLCANGateway::flush() {
+    if (outputLength == 0) {
+        return 0;
+    }
+    size_t length = outputLength;
+    outputLength = 0;
+    statistics.writesToHost++;
+    if (!write(reinterpret_cast<const uint8_t*>(output), length)) {
+        statistics.bytesDropped += length;
+        return 0;
+    }
+    return length;
+}
+
+// ===== INTERNAL METHODS =====
+
+void SLCANGateway::executeCommand(const char* command, size_t length) {
+    switch (command[0]) {
+        case 't':
+        case 'T':
+        case 'r':
+        case 'R': {
+            CANFrame frame;
+            frame.timestamp = 0;
+            bool ok = open && !listenOnly && SLCAN::decodeFrame(command, length, frame) && transmit(frame);
+            if (!ok) {
+                statistics.commandErrors++;
+                replyStatus(false);
+                return;
+            }
+            statistics.framesFromHost++;
+            // Auto-poll acknowledgement: "z" for 11-bit, "Z" for 29-bit
+            const char ack[2] = {frame.isExtended() ? 'Z' : 'z', SLCAN::REPLY_OK};
+            reply(ack, sizeof(ack));
+            return;
+        }
+
+        case 'S': {
+            uint32_t rate = length == 2 ? SLCAN::bitrateForCode(command[1]) : 0;
+            if (open || rate == 0) {
+                break;
+            }
+            bitrate = rate;
+            replyStatus(true);
+            return;
+        }
+
+        case 'O':
+        case 'L': {
+            bool listen = command[0] == 'L';
+            if (open || length != 1 ||
+                !control(listen ? SLCANBusCommand::OPEN_LISTEN_ONLY : SLCANBusCommand::OPEN, bitrate)) {
+                break;
+            }
+            open = true;
+            listenOnly = listen;
+            replyStatus(true);
+            return;
+        }
+
+        case 'C':
+            // slcand sends "C" before setup, so closing a closed channel is fine
+            if (open) {
+                control(SLCANBusCommand::CLOSE, bitrate);
+                open = false;
+                listenOnly = false;
+            }
+            replyStatus(true);
+            return;
+
+        case 'F': {
+            if (!open) {
+                break;
+            }
+            char status[4] = {'F', 0, 0, SLCAN::REPLY_OK};
+            SLCAN::putHex(status + 1, statusFunction ? statusFunction() : 0, 2);
+            reply(status, sizeof(status));
+            return;
+        }
+
+        case 'Z':
+            if (length != 2 || (command[1] != '0' && command[1] != '1')) {
+                break;
+            }
+            timestamps = command[1] == '1';
+            replyStatus(true);
+            return;
+
+        case 'M':
+        case 'm':
+            // Acceptance code/mask: filtering stays with CANInterface
+            replyStatus(true);
+            return;
+
+        case 'V':
+            reply(VERSION_REPLY, sizeof(VERSION_REPLY) - 1);
+            return;
+
+        case 'N':
+            reply(SERIAL_REPLY, sizeof(SERIAL_REPLY) - 1);
+            return;
+
+        default:
+            break;
+    }
+    statistics.commandErrors++;
+    replyStatus(false);
+}
+
+void SLCANGateway::reply(const char* text, size_t length) {
+    memcpy(reserveOutput(length), text, length);
+    outputLength += length;
+}
+
+void SLCANGateway::replyStatus(bool ok) {
+    const char status = ok ? SLCAN::REPLY_OK : SLCAN::REPLY_ERROR;
+    reply(&status, 1);
+}
+
+char* SLCANGateway::reserveOutput(size_t length) {
+    if (outputLength + length > sizeof(output)) {
+        flush();
+    }
+    return output + outputLength;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+/**
+ * @file slcan.h
+ * @brief SLCAN (Lawicel) text codec and serial gateway
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Lets the module act as a USB-serial CAN adapter for slcand/can-utils.
+ * Frames and commands are encoded and parsed in fixed buffers with
+ * lookup-table hex, so the gateway never touches the heap per frame.
+ * Outgoing lines are batched and handed to the serial port in one write.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include "../../config/project_config.h"
+#include "can_frame.h"
+
+namespace SLCAN {
+    // Longest frame line: "T" + 8 id + dlc + 16 data + 4 timestamp + CR
+    constexpr size_t MAX_FRAME_LINE = 31;
+
+    constexpr char REPLY_OK = '\r';
+    constexpr char REPLY_ERROR = '\a';    // BELL
+
+    /**
+     * @brief Write value as fixed-width uppercase hex (no terminator)
+     * @param out Destination, digits bytes
+     * @param value Value to format
+     * @param digits Number of hex digits
+     */
+    void putHex(char* out, uint32_t value, uint8_t digits);
+
+    /**
+     * @brief Parse fixed-width hex
+     * @param in Source characters
+     * @param digits Number of hex digits (1-8)
+     * @param value Parsed value
+     * @return false on a non-hex character
+     */
+    bool parseHex(const char* in, uint8_t digits, uint32_t& value);
+
+    /**
+     * @brief Encode a frame as an SLCAN line (t/T/r/R ... CR)
+     * @param frame Frame to encode
+     * @param out Destination, at least MAX_FRAME_LINE bytes
+     * @param timestamp Append the 4-digit millisecond timestamp (0-59999)
+     * @return Line length including CR
+     */
+    size_t encodeFrame(const CANFrame& frame, char* out, bool timestamp);
+
+    /**
+     * @brief Decode a t/T/r/R command (without CR)
+     * @param line Command characters
+     * @param length Command length
+     * @param frame Decoded frame (timestamp untouched)
+     * @return false if malformed
+     */
+    bool decodeFrame(const char* line, size_t length, CANFrame& frame);
+
+    /**
+     * @brief Bitrate for an "Sn" setup command
+     * @param code Digit after S ('0'-'8')
+     * @return Bitrate in bit/s, 0 if invalid
+     */
+    uint32_t bitrateForCode(char code);
+}
+
+/**
+ * @brief Bus state changes requested by the host
+ */
+enum class SLCANBusCommand : uint8_t {
+    OPEN,               // "O"
+    OPEN_LISTEN_ONLY,   // "L"
+    CLOSE               // "C"
+};
+
+/**
+ * @brief Gateway counters
+ */
+struct SLCANStatistics {
+    uint32_t framesToHost;
+    uint32_t framesFromHost;
+    uint32_t commandErrors;         // Malformed or rejected commands
+    uint32_t writesToHost;          // Serial write calls
+    uint32_t bytesDropped;          // Serial write failed
+    uint32_t lineOverflows;         // Host line longer than the buffer
+
+    SLCANStatistics() : framesToHost(0), framesFromHost(0), commandErrors(0),
+                        writesToHost(0), bytesDropped(0), lineOverflows(0) {}
+};
+
+/**
+ * @class SLCANGateway
+ * @brief Lawicel command interpreter between a serial stream and a CAN bus
+ *
+ * The owner feeds serial bytes to receive(), passes bus frames to
+ * forwardFrame() and calls flush() once per service pass. Not thread safe;
+ * run all calls from the gateway task.
+ */
+class SLCANGateway {
+public:
+    typedef std::function<bool(const uint8_t* data, size_t length)> WriteFunction;
+    typedef std::function<bool(const CANFrame& frame)> TransmitFunction;
+    typedef std::function<bool(SLCANBusCommand command, uint32_t bitrate)> BusControlFunction;
+    typedef std::function<uint8_t()> StatusFunction;
+
+    /**
+     * @brief Constructor
+     * @param write Serial output
+     * @param transmit Send a host frame on the bus
+     * @param control Open/close the bus at a bitrate
+     */
+    SLCANGateway(WriteFunction write, TransmitFunction transmit, BusControlFunction control);
+
+    /**
+     * @brief Set the source of the "F" status flags (Lawicel bit layout)
+     * @param status Returns flags byte
+     */
+    void setStatusFunction(StatusFunction status) { statusFunction = status; }
+
+    /**
+     * @brief Process bytes from the host
+     * @param data Serial input
+     * @param length Number of bytes
+     */
+    void receive(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Queue a bus frame for the host (ignored while closed)
+     * @param frame Received frame
+     * @return false if the channel is closed
+     */
+    bool forwardFrame(const CANFrame& frame);
+
+    /**
+     * @brief Write all queued output in one call
+     * @return Bytes written
+     */
+    size_t flush();
+
+    bool isOpen() const { return open; }
+    bool isListenOnly() const { return listenOnly; }
+    uint32_t getBitrate() const { return bitrate; }
+    bool getTimestamps() const { return timestamps; }
+    size_t pendingOutput() const { return outputLength; }
+    const SLCANStatistics& getStatistics() const { return statistics; }
+
+private:
+    WriteFunction write;
+    TransmitFunction transmit;
+    BusControlFunction control;
+    StatusFunction statusFunction;
+
+    bool open;
+    bool listenOnly;
+    bool timestamps;
+    uint32_t bitrate;
+
+    char line[SLCAN_LINE_SIZE];
+    size_t lineLength;
+    bool lineOverflow;
+    char output[SLCAN_OUTPUT_BUFFER_SIZE];
+    size_t outputLength;
+    SLCANStatistics statistics;
+
+    void executeCommand(const char* command, size_t length);
+    void reply(const char* text, size_t length);
+    void replyStatus(bool ok);
+    char* reserveOutput(size_t length);
+};
@@ -0,0 +1,144 @@
+/**
+ * @file broadcast_decoder.cpp
+ * @brief Signal-table broadcast decoder implementation
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "broadcast_decoder.h"
+
+BroadcastDecoder::BroadcastDecoder() : signalCount(0), framesDecoded(0), shortFrames(0) {
+}
+
+bool BroadcastDecoder::setSignals(const BroadcastSignal* signals, size_t count) {
+    signalCount = 0;
+    framesDecoded = 0;
+    shortFrames = 0;
+    if (count > MAX_SIGNALS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        CompiledSignal entry;
+        if (!compile(signals[i], entry)) {
+            signalCount = 0;
+            return false;
+        }
+
+        // Insertion sort by key; signals of one frame keep their table order
+        size_t slot = signalCount;
+        while (slot > 0 && compiled[slot - 1].key > entry.key) {
+            compiled[slot] = compiled[slot - 1];
+            slot--;
+        }
+        compiled[slot] = entry;
+        signalCount++;
+    }
+    return true;
+}
+
+size_t BroadcastDecoder::decode(const CANFrame& frame, VehicleState& state) {
+    if (signalCount == 0 || frame.isRemote() || frame.isError()) {
+        return 0;
+    }
+
+    // Lower bound on the frame's key
+    uint32_t key = frame.idFlags & (CANFrame::ID_MASK | CANFrame::FLAG_EXTENDED);
+    size_t low = 0;
+    size_t high = signalCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (compiled[mid].key < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    size_t updated = 0;
+    for (size_t i = low; i < signalCount && compiled[i].key == key; i++) {
+        const CompiledSignal& signal = compiled[i];
+        if (frame.dlc < signal.bytesNeeded) {
+            shortFrames++;
+            continue;
+        }
+        state.*signal.field = read(frame.data, signal) * signal.factor + signal.offset;
+        updated++;
+    }
+
+    if (updated > 0) {
+        framesDecoded++;
+    }
+    return updated;
+}
+
+size_t BroadcastDecoder::getIds(uint32_t* ids, size_t maxIds) const {
+    size_t copied = 0;
+    for (size_t i = 0; i < signalCount && copied < maxIds; i++) {
+        if (i == 0 || compiled[i].key != compiled[i - 1].key) {
+            ids[copied++] = compiled[i].key & CANFrame::ID_MASK;
+        }
+    }
+    return copied;
+}
+
+bool BroadcastDecoder::extract(const uint8_t* data, uint8_t dlc, const BroadcastSignal& signal, int64_t& raw) {
+    CompiledSignal entry;
+    if (!compile(signal, entry) || dlc < entry.bytesNeeded) {
+        return false;
+    }
+    raw = read(data, entry);
+    return true;
+}
+
+// ===== INTERNAL METHODS =====
+
+bool BroadcastDecoder::compile(const BroadcastSignal& signal, CompiledSignal& out) {
+    if (signal.length == 0 || signal.length > 32 || signal.startBit > 63 || signal.field == nullptr) {
+        return false;
+    }
+
+    uint32_t lastBit;               // Position of the last bit in payload word order
+    if (signal.byteOrder == SignalByteOrder::INTEL) {
+        // Little-endian word: bit n of the word is bit n % 8 of byte n / 8
+        lastBit = signal.startBit + signal.length - 1;
+        if (lastBit > 63) {
+            return false;
+        }
+        out.shift = signal.startBit;
+        out.bytesNeeded = lastBit / 8 + 1;
+    } else {
+        // Big-endian word counted from its MSB: byte 0 bit 7 is position 0
+        uint32_t msb = (signal.startBit / 8) * 8 + (7 - signal.startBit % 8);
+        lastBit = msb + signal.length - 1;
+        if (lastBit > 63) {
+            return false;
+        }
+        out.shift = static_cast<uint8_t>(63 - lastBit);
+        out.bytesNeeded = lastBit / 8 + 1;
+    }
+
+    out.key = (signal.id & CANFrame::ID_MASK) | (signal.extended ? CANFrame::FLAG_EXTENDED : 0);
+    out.motorola = signal.byteOrder == SignalByteOrder::MOTOROLA;
+    out.isSigned = signal.isSigned;
+    out.mask = signal.length == 32 ? 0xFFFFFFFFUL : (1UL << signal.length) - 1;
+    out.factor = signal.factor;
+    out.offset = signal.offset;
+    out.field = signal.field;
+    return true;
+}
+
+int64_t BroadcastDecoder::read(const uint8_t* data, const CompiledSignal& signal) {
+    // Only the bytes the signal spans: extract() callers pass dlc-sized buffers
+    uint64_t word = 0;
+    for (int i = 0; i < signal.bytesNeeded; i++) {
+        word |= static_cast<uint64_t>(data[i]) << (signal.motorola ? 56 - 8 * i : 8 * i);
+    }
+
+    uint32_t raw = static_cast<uint32_t>(word >> signal.shift) & signal.mask;
+    uint32_t signBit = (signal.mask >> 1) + 1;
+    if (signal.isSigned && (raw & signBit)) {
+        return static_cast<int64_t>(raw) - (static_cast<int64_t>(signal.mask) + 1);
+    }
+    return raw;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+/**
+ * @file broadcast_decoder.h
+ * @brief Signal-table decoder for the bike's own periodic CAN broadcasts
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * ECUs broadcast RPM, speed and friends many times a second whether anyone
+ * asks or not. With the interface in LISTEN_ONLY mode this decoder turns
+ * those frames into VehicleState fields without putting a single request on
+ * the bus. Signals follow DBC conventions: Intel signals give the LSB
+ * position, Motorola signals give the MSB position in the usual sawtooth bit
+ * numbering (byte * 8 + bit, bit 7 is a byte's MSB). The table is compiled
+ * once into shift/mask form sorted by identifier, so a frame costs one
+ * binary search plus a shift and a multiply per signal.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../../config/project_config.h"
+#include "../can/can_frame.h"
+#include "vehicle_state.h"
+
+/**
+ * @brief Signal byte order
+ */
+enum class SignalByteOrder : uint8_t {
+    INTEL = 0,          // Little endian, startBit = LSB
+    MOTOROLA            // Big endian, startBit = MSB (DBC numbering)
+};
+
+/**
+ * @brief One broadcast signal: where it sits and which VehicleState field it feeds
+ */
+struct BroadcastSignal {
+    uint32_t id;                    // CAN identifier
+    bool extended;                  // 29-bit identifier
+    uint8_t startBit;
+    uint8_t length;                 // 1-32 bits
+    SignalByteOrder byteOrder;
+    bool isSigned;                  // Two's complement raw value
+    float factor;                   // physical = raw * factor + offset
+    float offset;
+    float VehicleState::* field;    // Target, e.g. &VehicleState::engineRPM
+};
+
+/**
+ * @class BroadcastDecoder
+ * @brief Decodes received frames against a compiled signal table
+ *
+ * Not thread safe; call decode() from the context that owns the VehicleState.
+ */
+class BroadcastDecoder {
+public:
+    static constexpr size_t MAX_SIGNALS = CAN_BROADCAST_MAX_SIGNALS;
+
+    BroadcastDecoder();
+
+    /**
+     * @brief Compile a signal table
+     * @param signals Signal definitions (copied, need not outlive the decoder)
+     * @param count Number of signals
+     * @return false if any signal is malformed or the table is too large
+     *         (the decoder is left empty)
+     */
+    bool setSignals(const BroadcastSignal* signals, size_t count);
+
+    /**
+     * @brief Decode every signal carried by a frame
+     * @param frame Received frame
+     * @param state Receives the physical values
+     * @return Number of fields updated (0 for frames not in the table)
+     */
+    size_t decode(const CANFrame& frame, VehicleState& state);
+
+    /**
+     * @brief Identifiers used by the table (for acceptance filters)
+     * @param ids Destination array
+     * @param maxIds Capacity of ids
+     * @return Number of distinct identifiers copied
+     */
+    size_t getIds(uint32_t* ids, size_t maxIds) const;
+
+    /**
+     * @brief Extract a raw signal value from a payload
+     * @param data Payload bytes (only dlc bytes are read)
+     * @param dlc Payload length
+     * @param signal Signal definition
+     * @param raw Receives the raw value, sign-extended if the signal is signed
+     * @return false if the signal does not fit in dlc bytes
+     */
+    static bool extract(const uint8_t* data, uint8_t dlc, const BroadcastSignal& signal, int64_t& raw);
+
+    size_t getSignalCount() const { return signalCount; }
+    uint32_t getFramesDecoded() const { return framesDecoded; }
+    uint32_t getShortFrames() const { return shortFrames; }
+
+private:
+    struct CompiledSignal {
+        uint32_t key;               // Identifier | FLAG_EXTENDED
+        uint8_t shift;              // Right shift of the 64-bit payload word
+        uint8_t bytesNeeded;        // Minimum DLC
+        bool motorola;
+        bool isSigned;
+        uint32_t mask;
+        float factor;
+        float offset;
+        float VehicleState::* field;
+    };
+
+    CompiledSignal compiled[MAX_SIGNALS];
+    size_t signalCount;
+    uint32_t framesDecoded;
+    uint32_t shortFrames;           // Frames too short for one of their signals
+
+    static bool compile(const BroadcastSignal& signal, CompiledSignal& out);
+    static int64_t read(const uint8_t* data, const CompiledSignal& signal);
+};
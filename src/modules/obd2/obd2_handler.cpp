@@ -8,6 +8,13 @@
 #include "obd2_handler.h"
 #include <Arduino.h>
 
+namespace {
+    // Supported-PID bitmaps follow J1979: PID n*0x20 reports PIDs n*0x20+1 to
+    // n*0x20+0x20 in one word, most significant bit first
+    inline size_t supportWord(uint8_t pid) { return (pid - 1) >> 5; }
+    inline uint32_t supportBit(uint8_t pid) { return 1UL << (31 - ((pid - 1) & 0x1F)); }
+}
+
 // ===== CONSTRUCTOR & DESTRUCTOR =====
 
 OBD2Handler::OBD2Handler() :
@@ -25,6 +32,7 @@ OBD2Handler::OBD2Handler() :
     errorCount(0),
     totalProcessingTime(0)
 {
+    memset(&pidState, 0, sizeof(pidState));
     initializePIDDatabase();
     initializeVehicleState();
 }
@@ -38,12 +46,9 @@ OBD2Handler::~OBD2Handler() {
 bool OBD2Handler::initialize() {
     Serial.println(F("[OBD2] Initializing OBD2 handler..."));
     
-    // Reset to initial state
+    // Reset to initial state (the PID set built by the constructor is kept)
     reset();
     
-    // Initialize PID database
-    initializePIDDatabase();
-    
     // Initialize vehicle state
     initializeVehicleState();
     
@@ -88,27 +93,30 @@ void OBD2Handler::setSimulationMode(SimulationMode mode) {
 }
 
 void OBD2Handler::initializePIDDatabase() {
-    // Clear existing PIDs
-    supportedPIDs.clear();
-    
-    // Add standard PIDs with realistic ranges
-    addSupportedPID(StandardPIDs::SUPPORTED_PIDS_01_20, "Supported PIDs 01-20", 4, "", 0, 0);
-    addSupportedPID(StandardPIDs::ENGINE_LOAD, "Engine Load", 1, "%", 0, 100);
-    addSupportedPID(StandardPIDs::COOLANT_TEMPERATURE, "Coolant Temperature", 1, "°C", -40, 215);
-    addSupportedPID(StandardPIDs::ENGINE_RPM, "Engine RPM", 2, "RPM", 0, 16383.75);
-    addSupportedPID(StandardPIDs::VEHICLE_SPEED, "Vehicle Speed", 1, "km/h", 0, 255);
-    addSupportedPID(StandardPIDs::INTAKE_AIR_TEMP, "Intake Air Temperature", 1, "°C", -40, 215);
-    addSupportedPID(StandardPIDs::MAF_FLOW_RATE, "MAF Flow Rate", 2, "g/s", 0, 655.35);
-    addSupportedPID(StandardPIDs::THROTTLE_POSITION, "Throttle Position", 1, "%", 0, 100);
-    addSupportedPID(StandardPIDs::RUNTIME_SINCE_START, "Runtime Since Start", 2, "s", 0, 65535);
-    addSupportedPID(StandardPIDs::FUEL_TANK_LEVEL, "Fuel Tank Level", 1, "%", 0, 100);
-    addSupportedPID(StandardPIDs::CONTROL_MODULE_VOLTAGE, "Control Module Voltage", 2, "V", 0, 65.535);
-    addSupportedPID(StandardPIDs::AMBIENT_AIR_TEMP, "Ambient Air Temperature", 1, "°C", -40, 215);
-    addSupportedPID(StandardPIDs::FUEL_PRESSURE, "Fuel Pressure", 1, "kPa", 0, 765);
-    addSupportedPID(StandardPIDs::MAP_PRESSURE, "MAP Pressure", 1, "kPa", 0, 255);
-    addSupportedPID(StandardPIDs::TIMING_ADVANCE, "Timing Advance", 1, "°", -64, 63.5);
-    
-    Serial.printf("[OBD2] Initialized %d PIDs in database\n", supportedPIDs.size());
+    // Descriptors are constant (OBD2PIDTable); only the advertised set is built
+    static const uint16_t DEFAULT_PIDS[] = {
+        StandardPIDs::ENGINE_LOAD,
+        StandardPIDs::COOLANT_TEMPERATURE,
+        StandardPIDs::ENGINE_RPM,
+        StandardPIDs::VEHICLE_SPEED,
+        StandardPIDs::INTAKE_AIR_TEMP,
+        StandardPIDs::MAF_FLOW_RATE,
+        StandardPIDs::THROTTLE_POSITION,
+        StandardPIDs::RUNTIME_SINCE_START,
+        StandardPIDs::FUEL_TANK_LEVEL,
+        StandardPIDs::CONTROL_MODULE_VOLTAGE,
+        StandardPIDs::AMBIENT_AIR_TEMP,
+        StandardPIDs::FUEL_PRESSURE,
+        StandardPIDs::MAP_PRESSURE,
+        StandardPIDs::TIMING_ADVANCE
+    };
+    
+    memset(supportedMask, 0, sizeof(supportedMask));
+    for (size_t i = 0; i < sizeof(DEFAULT_PIDS) / sizeof(DEFAULT_PIDS[0]); i++) {
+        addSupportedPID(DEFAULT_PIDS[i]);
+    }
+    
+    Serial.printf("[OBD2] Advertising %u PIDs\n", static_cast<unsigned>(getSupportedPIDs().size()));
 }
 
 void OBD2Handler::initializeVehicleState() {
@@ -120,6 +128,9 @@ void OBD2Handler::initializeVehicleState() {
     vehicleState.coolantTemperature = 90.0;   // Normal operating temp
     vehicleState.intakeAirTemp = 25.0;        // Ambient temperature
     vehicleState.fuelPressure = 300.0;        // Normal fuel pressure
+    vehicleState.manifoldPressure = 33.0;     // Idle vacuum
+    vehicleState.airFlowRate = 3.5;           // g/s at idle
+    vehicleState.timingAdvance = 10.0;        // Idle timing
     vehicleState.batteryVoltage = 12.6;       // Good battery
     vehicleState.alternatorVoltage = 14.2;    // Charging
     vehicleState.fuelLevel = 75.0;            // 3/4 tank
@@ -421,27 +432,16 @@ String OBD2Handler::processPIDQuery(uint16_t pid) {
         return "NO DATA";
     }
     
-    uint8_t responseData[8] = {0};
-    uint8_t dataLength = 0;
-    
-    // Handle supported PIDs list
-    if (pid == StandardPIDs::SUPPORTED_PIDS_01_20) {
-        // Build supported PIDs bitmask for 01-20
-        uint32_t supportedMask = 0;
-        for (auto& pidPair : supportedPIDs) {
-            uint16_t pidNum = pidPair.first;
-            if (pidNum >= 0x0101 && pidNum <= 0x0120) {
-                uint8_t bitPos = pidNum - 0x0101;
-                if (bitPos < 32) {
-                    supportedMask |= (1UL << (31 - bitPos));
-                }
-            }
-        }
-        responseData[0] = (supportedMask >> 24) & 0xFF;
-        responseData[1] = (supportedMask >> 16) & 0xFF;
-        responseData[2] = (supportedMask >> 8) & 0xFF;
-        responseData[3] = supportedMask & 0xFF;
-        dataLength = 4;
+    uint8_t pidByte = pid & 0xFF;
+    uint8_t responseData[OBD2PIDTable::MAX_DATA_BYTES] = {0};
+    
+    // Handle supported PIDs lists (the bitmap is kept in wire order)
+    if (OBD2PIDTable::isSupportPID(pidByte)) {
+        uint32_t mask = supportedMask[pidByte >> 5];
+        responseData[0] = (mask >> 24) & 0xFF;
+        responseData[1] = (mask >> 16) & 0xFF;
+        responseData[2] = (mask >> 8) & 0xFF;
+        responseData[3] = mask & 0xFF;
     }
     
     // Handle specific PIDs
@@ -449,11 +449,17 @@ String OBD2Handler::processPIDQuery(uint16_t pid) {
         float value = calculatePIDValue(pid);
         encodePIDData(pid, value, responseData);
         
-        PIDData pidInfo = getPIDInfo(pid);
-        dataLength = pidInfo.dataBytes;
+        // Keep the value as the tester will read it back from the bytes
+        OBD2Value reported;
+        if (OBD2PIDCodec::decode(pidByte, responseData, sizeof(responseData), reported)) {
+            value = OBD2PIDCodec::toFloat(reported);
+        }
+        pidState.value[pidByte] = value;
+        pidState.lastUpdate[pidByte] = millis();
+        memcpy(pidState.rawData[pidByte], responseData, sizeof(responseData));
     }
     
-    return formatPIDResponse(pid, responseData, dataLength);
+    return formatPIDResponse(pid, responseData, OBD2PIDTable::find(pid)->dataBytes);
 }
 
 String OBD2Handler::formatPIDResponse(uint16_t pid, const uint8_t* data, uint8_t length) {
@@ -497,6 +503,10 @@ void OBD2Handler::updateVehicleSimulation() {
         // Engine load varies with RPM
         vehicleState.engineLoad = 15 + (vehicleState.engineRPM - 800) / 50.0 * 5;
         
+        // Manifold pressure and air flow follow load
+        vehicleState.manifoldPressure = 20 + vehicleState.engineLoad * 0.8;
+        vehicleState.airFlowRate = vehicleState.engineRPM * vehicleState.engineLoad / 3500.0;
+        
         // Coolant temperature slowly rises to operating temperature
         if (vehicleState.coolantTemperature < 90) {
             vehicleState.coolantTemperature += 0.1;
@@ -516,10 +526,10 @@ void OBD2Handler::updateVehicleSimulation() {
 }
 
 bool OBD2Handler::validatePIDRequest(uint16_t pid) {
-    return supportedPIDs.find(pid) != supportedPIDs.end();
+    return isPIDSupported(pid);
 }
 
-float OBD2Handler::calculatePIDValue(uint16_t pid) {
+float OBD2Handler::calculatePIDValue(uint16_t pid) const {
     switch (pid) {
         case StandardPIDs::ENGINE_RPM:
             return vehicleState.engineRPM;
@@ -535,6 +545,16 @@ float OBD2Handler::calculatePIDValue(uint16_t pid) {
             return vehicleState.intakeAirTemp;
         case StandardPIDs::FUEL_PRESSURE:
             return vehicleState.fuelPressure;
+        case StandardPIDs::MAP_PRESSURE:
+            return vehicleState.manifoldPressure;
+        case StandardPIDs::MAF_FLOW_RATE:
+            return vehicleState.airFlowRate;
+        case StandardPIDs::TIMING_ADVANCE:
+            return vehicleState.timingAdvance;
+        case StandardPIDs::BAROMETRIC_PRESSURE:
+            return vehicleState.barometricPressure;
+        case StandardPIDs::ENGINE_FUEL_RATE:
+            return vehicleState.fuelConsumption;
         case StandardPIDs::CONTROL_MODULE_VOLTAGE:
             return vehicleState.batteryVoltage;
         case StandardPIDs::FUEL_TANK_LEVEL:
@@ -549,54 +569,11 @@ float OBD2Handler::calculatePIDValue(uint16_t pid) {
 }
 
 void OBD2Handler::encodePIDData(uint16_t pid, float value, uint8_t* data) {
-    switch (pid) {
-        case StandardPIDs::ENGINE_RPM:
-            {
-                uint16_t rpm = (uint16_t)(value * 4); // RPM = ((A*256)+B)/4
-                data[0] = (rpm >> 8) & 0xFF;
-                data[1] = rpm & 0xFF;
-            }
-            break;
-            
-        case StandardPIDs::VEHICLE_SPEED:
-            data[0] = (uint8_t)value; // km/h directly
-            break;
-            
-        case StandardPIDs::ENGINE_LOAD:
-        case StandardPIDs::THROTTLE_POSITION:
-        case StandardPIDs::FUEL_TANK_LEVEL:
-            data[0] = (uint8_t)(value * 2.55); // Percentage: A/2.55
-            break;
-            
-        case StandardPIDs::COOLANT_TEMPERATURE:
-        case StandardPIDs::INTAKE_AIR_TEMP:
-        case StandardPIDs::AMBIENT_AIR_TEMP:
-            data[0] = (uint8_t)(value + 40); // Temperature: A-40
-            break;
-            
-        case StandardPIDs::FUEL_PRESSURE:
-            data[0] = (uint8_t)(value / 3); // Fuel pressure: A*3
-            break;
-            
-        case StandardPIDs::CONTROL_MODULE_VOLTAGE:
-            {
-                uint16_t voltage = (uint16_t)(value * 1000); // Voltage: ((A*256)+B)/1000
-                data[0] = (voltage >> 8) & 0xFF;
-                data[1] = voltage & 0xFF;
-            }
-            break;
-            
-        case StandardPIDs::RUNTIME_SINCE_START:
-            {
-                uint16_t runtime = (uint16_t)value; // Runtime: (A*256)+B seconds
-                data[0] = (runtime >> 8) & 0xFF;
-                data[1] = runtime & 0xFF;
-            }
-            break;
-            
-        default:
-            data[0] = 0x00;
-            break;
+    // J1979 scaling from the formula table; other fields of the PID stay zero
+    uint8_t pidByte = pid & 0xFF;
+    const OBD2Field* field = OBD2PIDCodec::field(pidByte);
+    if (field != nullptr) {
+        OBD2PIDCodec::encode(pidByte, OBD2PIDCodec::fromFloat(value, field->decimals), data);
     }
 }
 
@@ -657,42 +634,63 @@ String OBD2Handler::getProtocolDescription(OBD2Protocol protocol) {
 
 // ===== PID MANAGEMENT =====
 
-void OBD2Handler::addSupportedPID(uint16_t pid, const String& description, 
-                                  uint8_t dataBytes, const String& unit,
-                                  float minVal, float maxVal) {
-    PIDData pidData;
-    pidData.pid = pid;
-    pidData.description = description;
-    pidData.dataBytes = dataBytes;
-    pidData.unit = unit;
-    pidData.minValue = minVal;
-    pidData.maxValue = maxVal;
-    pidData.supported = true;
-    pidData.lastUpdate = 0;
-    pidData.currentValue = 0.0;
-    memset(pidData.rawData, 0, sizeof(pidData.rawData));
+bool OBD2Handler::addSupportedPID(uint16_t pid) {
+    if ((pid >> 8) != OBD2PIDTable::MODE_CURRENT_DATA || OBD2PIDTable::find(pid) == nullptr) {
+        return false;
+    }
     
-    supportedPIDs[pid] = pidData;
+    uint8_t pidByte = pid & 0xFF;
+    if (pidByte == 0) {
+        return true; // PID 00 is always answered
+    }
+    supportedMask[supportWord(pidByte)] |= supportBit(pidByte);
+    
+    // A tester only asks for PID 20/40/60 if the range before advertises it
+    for (uint8_t range = 0x20; range < pidByte; range += 0x20) {
+        supportedMask[supportWord(range)] |= supportBit(range);
+    }
+    return true;
 }
 
 bool OBD2Handler::isPIDSupported(uint16_t pid) const {
-    return supportedPIDs.find(pid) != supportedPIDs.end();
+    if ((pid >> 8) != OBD2PIDTable::MODE_CURRENT_DATA) {
+        return false;
+    }
+    uint8_t pidByte = pid & 0xFF;
+    if (pidByte == 0) {
+        return true;
+    }
+    return pidByte < OBD2PIDTable::PID_COUNT &&
+           (supportedMask[supportWord(pidByte)] & supportBit(pidByte)) != 0;
 }
 
 std::vector<uint16_t> OBD2Handler::getSupportedPIDs() const {
     std::vector<uint16_t> pids;
-    for (const auto& pair : supportedPIDs) {
-        pids.push_back(pair.first);
+    for (uint16_t pid = 0x0100; pid < 0x0100 + OBD2PIDTable::PID_COUNT; pid++) {
+        if (isPIDSupported(pid)) {
+            pids.push_back(pid);
+        }
     }
     return pids;
 }
 
-PIDData OBD2Handler::getPIDInfo(uint16_t pid) const {
-    auto it = supportedPIDs.find(pid);
-    if (it != supportedPIDs.end()) {
-        return it->second;
+const OBD2PIDDescriptor* OBD2Handler::getPIDInfo(uint16_t pid) const {
+    return OBD2PIDTable::find(pid);
+}
+
+bool OBD2Handler::getPIDSample(uint16_t pid, PIDSample& sample) const {
+    if (!isPIDSupported(pid)) {
+        return false;
     }
-    return PIDData{}; // Return empty struct if not found
+    uint8_t pidByte = pid & 0xFF;
+    if (pidState.lastUpdate[pidByte] == 0) {
+        return false;
+    }
+    sample.value = pidState.value[pidByte];
+    memcpy(sample.rawData, pidState.rawData[pidByte], sizeof(sample.rawData));
+    sample.dataBytes = OBD2PIDTable::find(pid)->dataBytes;
+    sample.lastUpdate = pidState.lastUpdate[pidByte];
+    return true;
 }
 
 // ===== VEHICLE DATA =====
@@ -724,6 +722,15 @@ void OBD2Handler::setVehicleParameter(uint16_t pid, float value) {
         case StandardPIDs::COOLANT_TEMPERATURE:
             vehicleState.coolantTemperature = value;
             break;
+        case StandardPIDs::MAP_PRESSURE:
+            vehicleState.manifoldPressure = value;
+            break;
+        case StandardPIDs::MAF_FLOW_RATE:
+            vehicleState.airFlowRate = value;
+            break;
+        case StandardPIDs::TIMING_ADVANCE:
+            vehicleState.timingAdvance = value;
+            break;
         // Add more cases as needed
     }
     vehicleState.lastUpdate = millis();
@@ -733,6 +740,35 @@ float OBD2Handler::getVehicleParameter(uint16_t pid) const {
     return calculatePIDValue(pid);
 }
 
+// ===== BROADCAST DECODING =====
+
+bool OBD2Handler::setBroadcastSignals(const BroadcastSignal* signals, size_t count) {
+    if (!broadcastDecoder.setSignals(signals, count)) {
+        Serial.println(F("[OBD2] ERROR: Invalid broadcast signal table"));
+        return false;
+    }
+    
+    // Simulation would overwrite the sniffed values
+    if (count > 0) {
+        setSimulationMode(SimulationMode::LIVE_CAN);
+    }
+    Serial.printf("[OBD2] Decoding %u broadcast signals\n", static_cast<unsigned>(count));
+    return true;
+}
+
+size_t OBD2Handler::processBroadcastFrame(const CANFrame& frame) {
+    size_t updated = broadcastDecoder.decode(frame, vehicleState);
+    if (updated > 0) {
+        vehicleState.lastUpdate = millis();
+        vehicleState.updateCount++;
+    }
+    return updated;
+}
+
+const BroadcastDecoder& OBD2Handler::getBroadcastDecoder() const {
+    return broadcastDecoder;
+}
+
 // ===== CONFIGURATION =====
 
 void OBD2Handler::setEchoEnabled(bool enable) {
@@ -768,7 +804,7 @@ String OBD2Handler::getStatistics() const {
     stats += "Error count: " + String(errorCount) + "\n";
     stats += "Average response time: " + String(getAverageResponseTime(), 2) + " ms\n";
     stats += "Current protocol: " + protocolDescription + "\n";
-    stats += "Supported PIDs: " + String(supportedPIDs.size()) + "\n";
+    stats += "Supported PIDs: " + String(getSupportedPIDs().size()) + "\n";
     stats += "Vehicle updates: " + String(vehicleState.updateCount) + "\n";
     return stats;
 }
@@ -869,32 +905,8 @@ uint16_t OBD2Handler::parsePIDFromCommand(const String& command) {
 }
 
 String OBD2Handler::getPIDName(uint16_t pid) {
-    switch (pid) {
-        case StandardPIDs::ENGINE_RPM:
-            return "Engine RPM";
-        case StandardPIDs::VEHICLE_SPEED:
-            return "Vehicle Speed";
-        case StandardPIDs::ENGINE_LOAD:
-            return "Engine Load";
-        case StandardPIDs::THROTTLE_POSITION:
-            return "Throttle Position";
-        case StandardPIDs::COOLANT_TEMPERATURE:
-            return "Coolant Temperature";
-        case StandardPIDs::INTAKE_AIR_TEMP:
-            return "Intake Air Temperature";
-        case StandardPIDs::FUEL_PRESSURE:
-            return "Fuel Pressure";
-        case StandardPIDs::CONTROL_MODULE_VOLTAGE:
-            return "Control Module Voltage";
-        case StandardPIDs::FUEL_TANK_LEVEL:
-            return "Fuel Tank Level";
-        case StandardPIDs::AMBIENT_AIR_TEMP:
-            return "Ambient Air Temperature";
-        case StandardPIDs::RUNTIME_SINCE_START:
-            return "Runtime Since Start";
-        default:
-            return "Unknown PID";
-    }
+    const OBD2PIDDescriptor* info = OBD2PIDTable::find(pid);
+    return info != nullptr ? info->name : "Unknown PID";
 }
 
 ATResponse OBD2Handler::processATCommandDetailed(const String& command) {
@@ -10,10 +10,14 @@
  * and vehicle data management for Chigee XR2 compatibility.
  */
 
-#include <map>
 #include <vector>
 #include "../../config/project_config.h"
 #include "../../config/hardware_config.h"
+#include "../can/can_frame.h"
+#include "vehicle_state.h"
+#include "broadcast_decoder.h"
+#include "obd2_pid_table.h"
+#include "obd2_pid_codec.h"
 
 /**
  * @brief OBD2 protocol types
@@ -52,54 +56,13 @@ enum class SimulationMode {
 };
 
 /**
- * @brief PID data structure
+ * @brief Last value served for a PID (metadata is in OBD2PIDDescriptor)
  */
-struct PIDData {
-    uint16_t pid;           // Parameter ID
-    String description;     // Human-readable description
-    uint8_t dataBytes;      // Number of data bytes
-    String unit;            // Units (RPM, km/h, °C, etc.)
-    float minValue;         // Minimum possible value
-    float maxValue;         // Maximum possible value
-    bool supported;         // Whether this PID is supported
-    unsigned long lastUpdate;  // Last update timestamp
-    float currentValue;     // Current calculated value
-    uint8_t rawData[8];     // Raw CAN data bytes
-};
-
-/**
- * @brief Vehicle state information
- */
-struct VehicleState {
-    // Engine parameters
-    float engineRPM;            // Engine speed (RPM)
-    float vehicleSpeed;         // Vehicle speed (km/h)
-    float engineLoad;           // Calculated engine load (%)
-    float throttlePosition;     // Throttle position (%)
-    float coolantTemperature;   // Engine coolant temperature (°C)
-    float intakeAirTemp;        // Intake air temperature (°C)
-    float fuelPressure;         // Fuel rail pressure (kPa)
-    
-    // Electrical system
-    float batteryVoltage;       // Control module voltage (V)
-    float alternatorVoltage;    // Charging system voltage (V)
-    
-    // Fuel system
-    float fuelLevel;            // Fuel tank level (%)
-    float fuelConsumption;      // Instantaneous fuel consumption (L/h)
-    
-    // Environmental
-    float ambientTemperature;   // Ambient air temperature (°C)
-    float barometricPressure;   // Barometric pressure (kPa)
-    
-    // Status flags
-    bool engineRunning;         // Engine is running
-    bool diagnosticTrouble;     // DTC present
-    uint16_t troubleCodes;      // Number of stored DTCs
-    
-    // Timing
-    unsigned long lastUpdate;   // Last update timestamp
-    uint32_t updateCount;       // Number of updates
+struct PIDSample {
+    float value;                                    // Engineering value
+    uint8_t rawData[OBD2PIDTable::MAX_DATA_BYTES];  // Encoded data bytes
+    uint8_t dataBytes;
+    unsigned long lastUpdate;                       // millis() when served, 0 = never
 };
 
 /**
@@ -125,7 +88,19 @@ private:
     
     // Vehicle data
     VehicleState vehicleState;
-    std::map<uint16_t, PIDData> supportedPIDs;
+    
+    // Supported PIDs as the J1979 bitmaps: word n answers PID n*0x20
+    static constexpr size_t SUPPORT_WORDS = (OBD2PIDTable::PID_COUNT + 31) / 32;
+    uint32_t supportedMask[SUPPORT_WORDS];
+    
+    // Hot per-PID state, structure of arrays indexed by PID byte
+    struct PIDStateBlock {
+        float value[OBD2PIDTable::PID_COUNT];
+        unsigned long lastUpdate[OBD2PIDTable::PID_COUNT];
+        uint8_t rawData[OBD2PIDTable::PID_COUNT][OBD2PIDTable::MAX_DATA_BYTES];
+    };
+    PIDStateBlock pidState;
+    BroadcastDecoder broadcastDecoder;      // Sniffed ECU broadcasts -> vehicleState
     
     // Configuration
     bool echoEnabled;
@@ -150,7 +125,7 @@ private:
     String formatPIDResponse(uint16_t pid, const uint8_t* data, uint8_t length);
     void updateVehicleSimulation();
     bool validatePIDRequest(uint16_t pid);
-    float calculatePIDValue(uint16_t pid);
+    float calculatePIDValue(uint16_t pid) const;
     void encodePIDData(uint16_t pid, float value, uint8_t* data);
     String getProtocolDescription(OBD2Protocol protocol);
     
@@ -237,16 +212,11 @@ public:
     
     /**
      * @brief Add supported PID
-     * @param pid Parameter ID
-     * @param description PID description
-     * @param dataBytes Number of data bytes
-     * @param unit Units string
-     * @param minVal Minimum value
-     * @param maxVal Maximum value
+     * @param pid Mode 01 parameter ID (e.g. StandardPIDs::ENGINE_RPM)
+     * @return false if the PID has no descriptor in OBD2PIDTable
+     * @note The "PIDs supported" PIDs leading up to it are advertised too
      */
-    void addSupportedPID(uint16_t pid, const String& description, 
-                        uint8_t dataBytes, const String& unit,
-                        float minVal, float maxVal);
+    bool addSupportedPID(uint16_t pid);
     
     /**
      * @brief Check if PID is supported
@@ -264,9 +234,17 @@ public:
     /**
      * @brief Get PID information
      * @param pid Parameter ID
-     * @return PID data structure
+     * @return Descriptor in flash, or nullptr if the PID is unknown
+     */
+    const OBD2PIDDescriptor* getPIDInfo(uint16_t pid) const;
+    
+    /**
+     * @brief Get the value and bytes last served for a PID
+     * @param pid Parameter ID
+     * @param sample Output sample
+     * @return false if the PID is not supported or not served yet
      */
-    PIDData getPIDInfo(uint16_t pid) const;
+    bool getPIDSample(uint16_t pid, PIDSample& sample) const;
     
     // ===== VEHICLE DATA =====
     
@@ -296,6 +274,31 @@ public:
      */
     float getVehicleParameter(uint16_t pid) const;
     
+    // ===== BROADCAST DECODING =====
+    
+    /**
+     * @brief Set the signal table for the bike's periodic broadcasts
+     * @param signals Signal definitions (copied)
+     * @param count Number of signals
+     * @return true if the table compiled; switches to SimulationMode::LIVE_CAN
+     */
+    bool setBroadcastSignals(const BroadcastSignal* signals, size_t count);
+    
+    /**
+     * @brief Update vehicle data from a sniffed frame (no request is sent)
+     * 
+     * Not called by the firmware yet: the caller's CAN receive loop must
+     * pass each frame here (src/main.cpp does not bring up CAN).
+     * @param frame Frame received in LISTEN_ONLY (or any) mode
+     * @return Number of VehicleState fields updated
+     */
+    size_t processBroadcastFrame(const CANFrame& frame);
+    
+    /**
+     * @brief Broadcast decoder and its counters
+     */
+    const BroadcastDecoder& getBroadcastDecoder() const;
+    
     // ===== CONFIGURATION =====
     
     /**
@@ -431,6 +434,7 @@ namespace StandardPIDs {
     constexpr uint16_t EGR_ERROR                = 0x012D;  // EGR Error
     constexpr uint16_t COMMANDED_EVAP_PURGE     = 0x012E;  // Commanded evaporative purge
     constexpr uint16_t FUEL_TANK_LEVEL          = 0x012F;  // Fuel tank level input
+    constexpr uint16_t BAROMETRIC_PRESSURE      = 0x0133;  // Absolute barometric pressure
     constexpr uint16_t RUNTIME_SINCE_START      = 0x011F;  // Runtime since engine start
     constexpr uint16_t SUPPORTED_PIDS_41_60     = 0x0140;  // Supported PIDs 41-60
     constexpr uint16_t CONTROL_MODULE_VOLTAGE   = 0x0142;  // Control module power supply voltage
@@ -444,6 +448,5 @@ namespace StandardPIDs {
     constexpr uint16_t ACCELERATOR_PEDAL_POS_E  = 0x014A;  // Accelerator pedal position E
     constexpr uint16_t ACCELERATOR_PEDAL_POS_F  = 0x014B;  // Accelerator pedal position F
     constexpr uint16_t COMMANDED_THROTTLE_ACT   = 0x014C;  // Commanded throttle actuator
+    constexpr uint16_t ENGINE_FUEL_RATE         = 0x015E;  // Engine fuel rate
 }
-
-#endif // OBD2_HANDLER_H
\ No newline at end of file
@@ -0,0 +1,320 @@
+/**
+ * @file obd2_pid_codec.cpp
+ * @brief SAE J1979 Mode 01 formula table and fixed-point encode/decode
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "obd2_pid_codec.h"
+#include "obd2_pid_table.h"
+
+namespace {
+    constexpr uint64_t pow10(uint8_t n) {
+        return n == 0 ? 1 : 10 * pow10(n - 1);
+    }
+
+    // Fewest decimals, up to milli-units, that show every raw step exactly
+    constexpr uint8_t exactDecimals(uint32_t mul, uint32_t div, uint8_t n) {
+        return n > 3 ? 0xFF : (mul * pow10(n)) % div == 0 ? n : exactDecimals(mul, div, n + 1);
+    }
+
+    // Otherwise the fewest that keep one raw step at least one unit, which
+    // is what makes the round trip exact
+    constexpr uint8_t coarseDecimals(uint32_t mul, uint32_t div, uint8_t n) {
+        return mul * pow10(n) >= div ? n : coarseDecimals(mul, div, n + 1);
+    }
+
+    constexpr uint8_t decimalsFor(uint32_t mul, uint32_t div) {
+        return exactDecimals(mul, div, 0) != 0xFF ? exactDecimals(mul, div, 0) : coarseDecimals(mul, div, 0);
+    }
+
+    constexpr OBD2Field scaled(uint8_t start, uint8_t bytes, uint16_t mul, uint32_t div, int16_t offset) {
+        return OBD2Field{start, bytes, false, false, decimalsFor(mul, div), mul, offset, div};
+    }
+
+    constexpr OBD2Field scaledSigned(uint8_t start, uint8_t bytes, uint16_t mul, uint32_t div, int16_t offset) {
+        return OBD2Field{start, bytes, true, false, decimalsFor(mul, div), mul, offset, div};
+    }
+
+    constexpr OBD2Field bits(uint8_t bytes) {
+        return OBD2Field{0, bytes, false, true, 0, 1, 0, 1};
+    }
+
+    // Field layouts shared by the PIDs (start, bytes, mul, div, offset)
+    constexpr OBD2Field BITS_1[]                 = {bits(1)};
+    constexpr OBD2Field BITS_2[]                 = {bits(2)};
+    constexpr OBD2Field BITS_4[]                 = {bits(4)};
+    constexpr OBD2Field COUNT_1[]                = {scaled(0, 1, 1, 1, 0)};          // A
+    constexpr OBD2Field COUNT_2[]                = {scaled(0, 2, 1, 1, 0)};          // 256A+B
+    constexpr OBD2Field PERCENT[]                = {scaled(0, 1, 100, 255, 0)};      // 100A/255
+    constexpr OBD2Field TEMPERATURE[]            = {scaled(0, 1, 1, 1, -40)};        // A-40
+    constexpr OBD2Field TRIM[]                   = {scaled(0, 1, 25, 32, -100)};     // 100A/128-100
+    constexpr OBD2Field FUEL_PRESSURE[]          = {scaled(0, 1, 3, 1, 0)};          // 3A
+    constexpr OBD2Field ENGINE_SPEED[]           = {scaled(0, 2, 1, 4, 0)};          // (256A+B)/4
+    constexpr OBD2Field TIMING_ADVANCE[]         = {scaled(0, 1, 1, 2, -64)};        // A/2-64
+    constexpr OBD2Field AIR_FLOW[]               = {scaled(0, 2, 1, 100, 0)};        // (256A+B)/100
+    constexpr OBD2Field O2_VOLTAGE_TRIM[]        = {scaled(0, 1, 1, 200, 0),         // A/200 V
+                                                    scaled(1, 1, 25, 32, -100)};     // 100B/128-100 %
+    constexpr OBD2Field RAIL_PRESSURE[]          = {scaled(0, 2, 79, 1000, 0)};      // 0.079(256A+B)
+    constexpr OBD2Field RAIL_GAUGE_PRESSURE[]    = {scaled(0, 2, 10, 1, 0)};         // 10(256A+B)
+    constexpr OBD2Field O2_RATIO_VOLTAGE[]       = {scaled(0, 2, 1, 32768, 0),       // 2(256A+B)/65536
+                                                    scaled(2, 2, 1, 8192, 0)};       // 8(256C+D)/65536 V
+    constexpr OBD2Field EVAP_PRESSURE[]          = {scaledSigned(0, 2, 1, 4, 0)};    // signed AB/4
+    constexpr OBD2Field O2_RATIO_CURRENT[]       = {scaled(0, 2, 1, 32768, 0),       // 2(256A+B)/65536
+                                                    scaled(2, 2, 1, 256, -128)};     // (256C+D)/256-128 mA
+    constexpr OBD2Field CATALYST_TEMPERATURE[]   = {scaled(0, 2, 1, 10, -40)};       // (256A+B)/10-40
+    constexpr OBD2Field MODULE_VOLTAGE[]         = {scaled(0, 2, 1, 1000, 0)};       // (256A+B)/1000
+    constexpr OBD2Field ABSOLUTE_LOAD[]          = {scaled(0, 2, 100, 255, 0)};      // 100(256A+B)/255
+    constexpr OBD2Field EQUIVALENCE_RATIO[]      = {scaled(0, 2, 1, 32768, 0)};      // 2(256A+B)/65536
+    constexpr OBD2Field MAXIMUM_VALUES[]         = {scaled(0, 1, 1, 1, 0),           // A ratio
+                                                    scaled(1, 1, 1, 1, 0),           // B V
+                                                    scaled(2, 1, 1, 1, 0),           // C mA
+                                                    scaled(3, 1, 10, 1, 0)};         // 10D kPa
+    constexpr OBD2Field MAXIMUM_AIR_FLOW[]       = {scaled(0, 1, 10, 1, 0)};         // 10A
+    constexpr OBD2Field ABSOLUTE_EVAP_PRESSURE[] = {scaled(0, 2, 1, 200, 0)};        // (256A+B)/200
+    constexpr OBD2Field WIDE_EVAP_PRESSURE[]     = {scaledSigned(0, 2, 1, 1, 0)};    // signed AB
+    constexpr OBD2Field SECONDARY_TRIM[]         = {scaled(0, 1, 25, 32, -100),      // bank 1/2
+                                                    scaled(1, 1, 25, 32, -100)};     // bank 3/4
+    constexpr OBD2Field INJECTION_TIMING[]       = {scaled(0, 2, 1, 128, -210)};     // (256A+B)/128-210
+    constexpr OBD2Field FUEL_RATE[]              = {scaled(0, 2, 1, 20, 0)};         // (256A+B)/20
+    constexpr OBD2Field TORQUE[]                 = {scaled(0, 1, 1, 1, -125)};       // A-125
+
+    template <size_t N>
+    constexpr OBD2PIDFormula formula(const OBD2Field (&fields)[N]) {
+        return OBD2PIDFormula{fields, static_cast<uint8_t>(N)};
+    }
+
+    // Mode 01/02 formulas, one entry per PID byte
+    constexpr OBD2PIDFormula MODE01_FORMULAS[] = {
+        // 0x00-0x0F
+        formula(BITS_4), formula(BITS_4), formula(BITS_2), formula(BITS_2),
+        formula(PERCENT), formula(TEMPERATURE), formula(TRIM), formula(TRIM),
+        formula(TRIM), formula(TRIM), formula(FUEL_PRESSURE), formula(COUNT_1),
+        formula(ENGINE_SPEED), formula(COUNT_1), formula(TIMING_ADVANCE), formula(TEMPERATURE),
+        // 0x10-0x1F
+        formula(AIR_FLOW), formula(PERCENT), formula(BITS_1), formula(BITS_1),
+        formula(O2_VOLTAGE_TRIM), formula(O2_VOLTAGE_TRIM), formula(O2_VOLTAGE_TRIM), formula(O2_VOLTAGE_TRIM),
+        formula(O2_VOLTAGE_TRIM), formula(O2_VOLTAGE_TRIM), formula(O2_VOLTAGE_TRIM), formula(O2_VOLTAGE_TRIM),
+        formula(BITS_1), formula(BITS_1), formula(BITS_1), formula(COUNT_2),
+        // 0x20-0x2F
+        formula(BITS_4), formula(COUNT_2), formula(RAIL_PRESSURE), formula(RAIL_GAUGE_PRESSURE),
+        formula(O2_RATIO_VOLTAGE), formula(O2_RATIO_VOLTAGE), formula(O2_RATIO_VOLTAGE), formula(O2_RATIO_VOLTAGE),
+        formula(O2_RATIO_VOLTAGE), formula(O2_RATIO_VOLTAGE), formula(O2_RATIO_VOLTAGE), formula(O2_RATIO_VOLTAGE),
+        formula(PERCENT), formula(TRIM), formula(PERCENT), formula(PERCENT),
+        // 0x30-0x3F
+        formula(COUNT_1), formula(COUNT_2), formula(EVAP_PRESSURE), formula(COUNT_1),
+        formula(O2_RATIO_CURRENT), formula(O2_RATIO_CURRENT), formula(O2_RATIO_CURRENT), formula(O2_RATIO_CURRENT),
+        formula(O2_RATIO_CURRENT), formula(O2_RATIO_CURRENT), formula(O2_RATIO_CURRENT), formula(O2_RATIO_CURRENT),
+        formula(CATALYST_TEMPERATURE), formula(CATALYST_TEMPERATURE),
+        formula(CATALYST_TEMPERATURE), formula(CATALYST_TEMPERATURE),
+        // 0x40-0x4F
+        formula(BITS_4), formula(BITS_4), formula(MODULE_VOLTAGE), formula(ABSOLUTE_LOAD),
+        formula(EQUIVALENCE_RATIO), formula(PERCENT), formula(TEMPERATURE), formula(PERCENT),
+        formula(PERCENT), formula(PERCENT), formula(PERCENT), formula(PERCENT),
+        formula(PERCENT), formula(COUNT_2), formula(COUNT_2), formula(MAXIMUM_VALUES),
+        // 0x50-0x5F
+        formula(MAXIMUM_AIR_FLOW), formula(BITS_1), formula(PERCENT), formula(ABSOLUTE_EVAP_PRESSURE),
+        formula(WIDE_EVAP_PRESSURE), formula(SECONDARY_TRIM), formula(SECONDARY_TRIM), formula(SECONDARY_TRIM),
+        formula(SECONDARY_TRIM), formula(RAIL_GAUGE_PRESSURE), formula(PERCENT), formula(PERCENT),
+        formula(TEMPERATURE), formula(INJECTION_TIMING), formula(FUEL_RATE), formula(BITS_1),
+        // 0x60-0x63
+        formula(BITS_4), formula(TORQUE), formula(TORQUE), formula(COUNT_2),
+    };
+
+    constexpr size_t ENTRY_COUNT = sizeof(MODE01_FORMULAS) / sizeof(MODE01_FORMULAS[0]);
+    static_assert(ENTRY_COUNT == OBD2PIDTable::PID_COUNT, "one formula per PID byte");
+
+    // Largest magnitude a field decodes to, in fixed-point units
+    constexpr uint64_t maxMagnitude(const OBD2Field& field) {
+        return ((uint64_t(1) << (8 * field.bytes)) - 1) * field.mul * pow10(field.decimals) / field.div +
+               uint64_t(field.offset < 0 ? -field.offset : field.offset) * pow10(field.decimals);
+    }
+
+    constexpr bool fieldOk(const OBD2Field& field) {
+        return (field.bytes == 1 || field.bytes == 2 || field.bytes == 4) &&
+               field.start + field.bytes <= OBD2PIDTable::MAX_DATA_BYTES && field.mul > 0 && field.div > 0 &&
+               (field.isBitField ||
+                (field.bytes <= 2 && field.decimals <= OBD2PIDCodec::MAX_DECIMALS &&
+                 field.mul * pow10(field.decimals) >= field.div && maxMagnitude(field) <= 0x7FFFFFFF));
+    }
+
+    constexpr bool fieldsOk(const OBD2PIDFormula& formula, uint8_t index) {
+        return index == formula.fieldCount || (fieldOk(formula.fields[index]) && fieldsOk(formula, index + 1));
+    }
+
+    // Checked while compiling: field counts, widths, and that every scaled
+    // field fits an int32 with one raw step worth at least one unit
+    constexpr bool wellFormed(size_t index) {
+        return index == ENTRY_COUNT ||
+               (MODE01_FORMULAS[index].fieldCount >= 1 &&
+                MODE01_FORMULAS[index].fieldCount <= OBD2PIDCodec::MAX_FIELDS &&
+                fieldsOk(MODE01_FORMULAS[index], 0) && wellFormed(index + 1));
+    }
+    static_assert(wellFormed(0), "PID formula with a bad field, lossy decimals or int32 overflow");
+
+    constexpr int64_t POWERS_OF_TEN[OBD2PIDCodec::MAX_DECIMALS + 1] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+
+    // Division rounded to nearest, halves away from zero
+    constexpr int64_t roundDiv(int64_t numerator, int64_t denominator) {
+        return numerator >= 0 ? (numerator + denominator / 2) / denominator
+                              : -((-numerator + denominator / 2) / denominator);
+    }
+
+    // Same arithmetic as decode() and encode() at the field's own decimals
+    constexpr int64_t decodeRaw(const OBD2Field& field, int64_t raw) {
+        return roundDiv(raw * field.mul * POWERS_OF_TEN[field.decimals], field.div) +
+               field.offset * POWERS_OF_TEN[field.decimals];
+    }
+
+    constexpr int64_t encodeScaled(const OBD2Field& field, int64_t scaled) {
+        return roundDiv((scaled - field.offset * POWERS_OF_TEN[field.decimals]) * field.div,
+                        field.mul * POWERS_OF_TEN[field.decimals]);
+    }
+
+    constexpr int64_t gcd(int64_t a, int64_t b) {
+        return b == 0 ? a : gcd(b, a % b);
+    }
+
+    // Raw steps after which decode() and encode() repeat shifted by whole
+    // units: adding it to raw adds a multiple of div to the numerator
+    constexpr int64_t period(const OBD2Field& field) {
+        return field.div / gcd(field.mul * POWERS_OF_TEN[field.decimals], field.div);
+    }
+
+    // Halves the range so the recursion stays shallow
+    constexpr bool roundTrips(const OBD2Field& field, int64_t first, int64_t last) {
+        return first == last ? encodeScaled(field, decodeRaw(field, first)) == first
+                             : roundTrips(field, first, first + (last - first) / 2) &&
+                               roundTrips(field, first + (last - first) / 2 + 1, last);
+    }
+
+    constexpr int64_t minRaw(const OBD2Field& field) {
+        return field.isSigned ? -(int64_t(1) << (8 * field.bytes - 1)) : 0;
+    }
+
+    constexpr int64_t maxRaw(const OBD2Field& field) {
+        return (int64_t(1) << (8 * field.bytes - (field.isSigned ? 1 : 0))) - 1;
+    }
+
+    // One period either side of zero covers the whole range; rounding is
+    // symmetric, so negative raw values of signed fields mirror positive ones
+    constexpr bool fieldRoundTrips(const OBD2Field& field) {
+        return field.isBitField ||
+               roundTrips(field, minRaw(field) > -period(field) ? minRaw(field) : -period(field),
+                          maxRaw(field) < period(field) ? maxRaw(field) : period(field));
+    }
+
+    constexpr bool fieldsRoundTrip(const OBD2PIDFormula& formula, uint8_t index) {
+        return index == formula.fieldCount ||
+               (fieldRoundTrips(formula.fields[index]) && fieldsRoundTrip(formula, index + 1));
+    }
+
+    // Checked while compiling: encode(decode(raw)) == raw for every raw
+    // value of every scaled (8/16-bit) field
+    constexpr bool roundTripExact(size_t index) {
+        return index == ENTRY_COUNT || (fieldsRoundTrip(MODE01_FORMULAS[index], 0) && roundTripExact(index + 1));
+    }
+    static_assert(roundTripExact(0), "PID formula whose decimals lose raw steps");
+}
+
+namespace OBD2PIDCodec {
+
+const OBD2PIDFormula* find(uint8_t pid) {
+    return pid < ENTRY_COUNT ? &MODE01_FORMULAS[pid] : nullptr;
+}
+
+const OBD2Field* field(uint8_t pid, uint8_t index) {
+    if (pid >= ENTRY_COUNT || index >= MODE01_FORMULAS[pid].fieldCount) {
+        return nullptr;
+    }
+    return &MODE01_FORMULAS[pid].fields[index];
+}
+
+bool decode(uint8_t pid, const uint8_t* data, uint8_t length, OBD2Value& value, uint8_t index) {
+    const OBD2Field* f = field(pid, index);
+    if (f == nullptr || length < f->start + f->bytes) {
+        return false;
+    }
+
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < f->bytes; i++) {
+        bits = (bits << 8) | data[f->start + i];
+    }
+    if (f->isBitField) {
+        value.scaled = static_cast<int32_t>(bits);
+        value.decimals = 0;
+        return true;
+    }
+
+    int64_t raw = bits;
+    if (f->isSigned && (bits >> (8 * f->bytes - 1)) != 0) {
+        raw -= int64_t(1) << (8 * f->bytes);
+    }
+    int64_t unit = POWERS_OF_TEN[f->decimals];
+    value.scaled = static_cast<int32_t>(roundDiv(raw * f->mul * unit, f->div) + f->offset * unit);
+    value.decimals = f->decimals;
+    return true;
+}
+
+bool encode(uint8_t pid, const OBD2Value& value, uint8_t* data, uint8_t index) {
+    const OBD2Field* f = field(pid, index);
+    if (f == nullptr || value.decimals > MAX_DECIMALS) {
+        return false;
+    }
+
+    int64_t minRaw = 0;
+    int64_t maxRaw = (int64_t(1) << (8 * f->bytes)) - 1;
+    int64_t raw;
+    if (f->isBitField) {
+        if (value.decimals != 0) {
+            return false;
+        }
+        // All 32 bits of a 4-byte field are carried in the int32
+        raw = f->bytes == 4 ? static_cast<uint32_t>(value.scaled) : value.scaled;
+    } else {
+        if (f->isSigned) {
+            minRaw = -(maxRaw + 1) / 2;
+            maxRaw = maxRaw / 2;
+        }
+        int64_t unit = POWERS_OF_TEN[value.decimals];
+        raw = roundDiv((value.scaled - f->offset * unit) * f->div, f->mul * unit);
+    }
+
+    bool inRange = raw >= minRaw && raw <= maxRaw;
+    if (!inRange) {
+        raw = raw < minRaw ? minRaw : maxRaw;
+    }
+    uint32_t bits = static_cast<uint32_t>(raw);
+    for (uint8_t i = f->bytes; i > 0; i--) {
+        data[f->start + i - 1] = bits & 0xFF;
+        bits >>= 8;
+    }
+    return inRange;
+}
+
+float toFloat(const OBD2Value& value) {
+    if (value.decimals > MAX_DECIMALS) {
+        return 0.0f;
+    }
+    return static_cast<float>(value.scaled) / static_cast<float>(POWERS_OF_TEN[value.decimals]);
+}
+
+OBD2Value fromFloat(float value, uint8_t decimals) {
+    OBD2Value result;
+    result.decimals = decimals > MAX_DECIMALS ? MAX_DECIMALS : decimals;
+    float scaledValue = value * static_cast<float>(POWERS_OF_TEN[result.decimals]);
+    if (scaledValue != scaledValue) {
+        result.scaled = 0;  // NaN
+    } else if (scaledValue >= 2147483647.0f) {
+        result.scaled = 0x7FFFFFFF;
+    } else if (scaledValue <= -2147483648.0f) {
+        result.scaled = -0x7FFFFFFF - 1;
+    } else {
+        result.scaled = static_cast<int32_t>(scaledValue < 0 ? scaledValue - 0.5f : scaledValue + 0.5f);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+/**
+ * @file obd2_pid_codec.h
+ * @brief SAE J1979 Mode 01 scaling: raw data bytes to engineering units and back
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Every Mode 01/02 PID 0x00-0x63 has a formula in one constant table,
+ * indexed by PID byte like OBD2PIDTable. A formula is one or more fields
+ * (O2 sensors report ratio and voltage, PID 0x4F four maximums); each field
+ * is a big-endian integer at a byte offset with the J1979 scaling
+ *
+ *     value = raw * mul / div + offset
+ *
+ * where mul, div and offset are integers. Values are fixed point: an int32
+ * holding value * 10^decimals. The number of decimals per field is worked
+ * out while compiling - the fewest that show every raw step exactly, or
+ * failing that, the fewest that keep one raw step at least one unit - so
+ * encode(decode(raw)) == raw for every raw value. Neither direction uses
+ * float; toFloat()/fromFloat() convert at the edges for display and for
+ * float vehicle state.
+ *
+ * Bit-encoded PIDs (support bitmaps, monitor status, ...) decode to their
+ * raw bits with no scaling.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Fixed-point engineering value: scaled / 10^decimals
+ */
+struct OBD2Value {
+    int32_t scaled;
+    uint8_t decimals;
+};
+
+/**
+ * @brief One value inside a PID's data bytes
+ */
+struct OBD2Field {
+    uint8_t start;              // First data byte (A = 0)
+    uint8_t bytes;              // Big-endian width: 1, 2 or 4
+    bool isSigned;              // Raw value is two's complement
+    bool isBitField;            // Raw bits, no scaling
+    uint8_t decimals;           // Fixed-point decimals of the value
+    uint16_t mul;               // value = raw * mul / div + offset
+    int16_t offset;
+    uint32_t div;
+};
+
+/**
+ * @brief All fields of a PID; field 0 is the primary value
+ */
+struct OBD2PIDFormula {
+    const OBD2Field* fields;
+    uint8_t fieldCount;
+};
+
+namespace OBD2PIDCodec {
+    constexpr uint8_t MAX_FIELDS   = 4;     // PID 0x4F
+    constexpr uint8_t MAX_DECIMALS = 9;     // Largest 10^n that fits an int32
+
+    /**
+     * @brief Formula of a Mode 01/02 PID
+     * @param pid PID byte
+     * @return Formula in flash, or nullptr if the PID is not defined
+     */
+    const OBD2PIDFormula* find(uint8_t pid);
+
+    /**
+     * @brief Field of a PID
+     * @return Field, or nullptr if the PID or field index is not defined
+     */
+    const OBD2Field* field(uint8_t pid, uint8_t index = 0);
+
+    /**
+     * @brief Decode one field from response data bytes
+     * @param pid PID byte
+     * @param data Data bytes after mode and PID
+     * @param length Number of data bytes
+     * @param value Decoded value in the field's own decimals
+     * @param index Field index (0 = primary value)
+     * @return false if the PID or field is unknown or the data is too short
+     */
+    bool decode(uint8_t pid, const uint8_t* data, uint8_t length, OBD2Value& value, uint8_t index = 0);
+
+    /**
+     * @brief Encode one field into data bytes
+     *
+     * Only the field's own bytes are written, so fields can be encoded one
+     * after another into the same buffer. Any number of decimals up to
+     * MAX_DECIMALS is accepted; the result is rounded to the nearest raw
+     * step and clamped to the field's range.
+     *
+     * @param pid PID byte
+     * @param value Engineering value
+     * @param data Data bytes after mode and PID (at least start + bytes long)
+     * @param index Field index (0 = primary value)
+     * @return false if the PID or field is unknown or the value was clamped
+     */
+    bool encode(uint8_t pid, const OBD2Value& value, uint8_t* data, uint8_t index = 0);
+
+    /**
+     * @brief Convert a fixed-point value for display or float state
+     */
+    float toFloat(const OBD2Value& value);
+
+    /**
+     * @brief Round a float to a fixed-point value with the given decimals
+     */
+    OBD2Value fromFloat(float value, uint8_t decimals);
+}
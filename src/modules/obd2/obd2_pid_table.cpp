@@ -0,0 +1,144 @@
+/**
+ * @file obd2_pid_table.cpp
+ * @brief SAE J1979 PID descriptor table
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "obd2_pid_table.h"
+
+namespace {
+    // Mode 01/02 descriptors, one entry per PID byte (name, unit, bytes, min, max)
+    constexpr OBD2PIDDescriptor MODE01_PIDS[] = {
+        // 0x00-0x0F
+        {"Supported PIDs 01-20", "", 4, 0, 0},
+        {"Monitor Status", "", 4, 0, 0},
+        {"Freeze DTC", "", 2, 0, 0},
+        {"Fuel System Status", "", 2, 0, 0},
+        {"Engine Load", "%", 1, 0, 100},
+        {"Coolant Temperature", "°C", 1, -40, 215},
+        {"Short Fuel Trim Bank 1", "%", 1, -100, 99.21875f},
+        {"Long Fuel Trim Bank 1", "%", 1, -100, 99.21875f},
+        {"Short Fuel Trim Bank 2", "%", 1, -100, 99.21875f},
+        {"Long Fuel Trim Bank 2", "%", 1, -100, 99.21875f},
+        {"Fuel Pressure", "kPa", 1, 0, 765},
+        {"MAP Pressure", "kPa", 1, 0, 255},
+        {"Engine RPM", "RPM", 2, 0, 16383.75f},
+        {"Vehicle Speed", "km/h", 1, 0, 255},
+        {"Timing Advance", "°", 1, -64, 63.5f},
+        {"Intake Air Temperature", "°C", 1, -40, 215},
+        // 0x10-0x1F
+        {"MAF Flow Rate", "g/s", 2, 0, 655.35f},
+        {"Throttle Position", "%", 1, 0, 100},
+        {"Secondary Air Status", "", 1, 0, 0},
+        {"Oxygen Sensors Present", "", 1, 0, 0},
+        {"O2 Sensor 1 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 2 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 3 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 4 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 5 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 6 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 7 Voltage", "V", 2, 0, 1.275f},
+        {"O2 Sensor 8 Voltage", "V", 2, 0, 1.275f},
+        {"OBD Standards", "", 1, 0, 0},
+        {"Oxygen Sensors Present (4 Banks)", "", 1, 0, 0},
+        {"Auxiliary Input Status", "", 1, 0, 0},
+        {"Runtime Since Start", "s", 2, 0, 65535},
+        // 0x20-0x2F
+        {"Supported PIDs 21-40", "", 4, 0, 0},
+        {"Distance With MIL On", "km", 2, 0, 65535},
+        {"Fuel Rail Pressure", "kPa", 2, 0, 5177.265f},
+        {"Fuel Rail Gauge Pressure", "kPa", 2, 0, 655350},
+        {"O2 Sensor 1 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 2 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 3 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 4 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 5 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 6 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 7 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"O2 Sensor 8 Equivalence Ratio", "ratio", 4, 0, 2},
+        {"Commanded EGR", "%", 1, 0, 100},
+        {"EGR Error", "%", 1, -100, 99.21875f},
+        {"Commanded Evaporative Purge", "%", 1, 0, 100},
+        {"Fuel Tank Level", "%", 1, 0, 100},
+        // 0x30-0x3F
+        {"Warm-ups Since Codes Cleared", "count", 1, 0, 255},
+        {"Distance Since Codes Cleared", "km", 2, 0, 65535},
+        {"Evap System Vapor Pressure", "Pa", 2, -8192, 8191.75f},
+        {"Barometric Pressure", "kPa", 1, 0, 255},
+        {"O2 Sensor 1 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 2 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 3 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 4 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 5 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 6 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 7 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"O2 Sensor 8 Equivalence Ratio (Current)", "ratio", 4, 0, 2},
+        {"Catalyst Temperature B1S1", "°C", 2, -40, 6513.5f},
+        {"Catalyst Temperature B2S1", "°C", 2, -40, 6513.5f},
+        {"Catalyst Temperature B1S2", "°C", 2, -40, 6513.5f},
+        {"Catalyst Temperature B2S2", "°C", 2, -40, 6513.5f},
+        // 0x40-0x4F
+        {"Supported PIDs 41-60", "", 4, 0, 0},
+        {"Monitor Status This Drive Cycle", "", 4, 0, 0},
+        {"Control Module Voltage", "V", 2, 0, 65.535f},
+        {"Absolute Load Value", "%", 2, 0, 25700},
+        {"Commanded Equivalence Ratio", "ratio", 2, 0, 2},
+        {"Relative Throttle Position", "%", 1, 0, 100},
+        {"Ambient Air Temperature", "°C", 1, -40, 215},
+        {"Absolute Throttle Position B", "%", 1, 0, 100},
+        {"Absolute Throttle Position C", "%", 1, 0, 100},
+        {"Accelerator Pedal Position D", "%", 1, 0, 100},
+        {"Accelerator Pedal Position E", "%", 1, 0, 100},
+        {"Accelerator Pedal Position F", "%", 1, 0, 100},
+        {"Commanded Throttle Actuator", "%", 1, 0, 100},
+        {"Time Run With MIL On", "min", 2, 0, 65535},
+        {"Time Since Codes Cleared", "min", 2, 0, 65535},
+        {"Maximum Equivalence Ratio", "ratio", 4, 0, 255},
+        // 0x50-0x5F
+        {"Maximum MAF Flow Rate", "g/s", 4, 0, 2550},
+        {"Fuel Type", "", 1, 0, 0},
+        {"Ethanol Fuel", "%", 1, 0, 100},
+        {"Absolute Evap System Vapor Pressure", "kPa", 2, 0, 327.675f},
+        {"Evap System Vapor Pressure (Wide)", "Pa", 2, -32768, 32767},
+        {"Short Secondary O2 Trim Bank 1", "%", 2, -100, 99.21875f},
+        {"Long Secondary O2 Trim Bank 1", "%", 2, -100, 99.21875f},
+        {"Short Secondary O2 Trim Bank 2", "%", 2, -100, 99.21875f},
+        {"Long Secondary O2 Trim Bank 2", "%", 2, -100, 99.21875f},
+        {"Fuel Rail Absolute Pressure", "kPa", 2, 0, 655350},
+        {"Relative Accelerator Pedal Position", "%", 1, 0, 100},
+        {"Hybrid Battery Remaining Life", "%", 1, 0, 100},
+        {"Engine Oil Temperature", "°C", 1, -40, 215},
+        {"Fuel Injection Timing", "°", 2, -210, 301.9921875f},
+        {"Engine Fuel Rate", "L/h", 2, 0, 3276.75f},
+        {"Emission Requirements", "", 1, 0, 0},
+        // 0x60-0x63
+        {"Supported PIDs 61-80", "", 4, 0, 0},
+        {"Driver Demand Torque", "%", 1, -125, 130},
+        {"Actual Engine Torque", "%", 1, -125, 130},
+        {"Engine Reference Torque", "Nm", 2, 0, 65535},
+    };
+
+    constexpr size_t ENTRY_COUNT = sizeof(MODE01_PIDS) / sizeof(MODE01_PIDS[0]);
+    static_assert(ENTRY_COUNT == OBD2PIDTable::PID_COUNT, "one descriptor per PID byte");
+
+    // Checked while compiling: every entry is defined and fits the sample buffers
+    constexpr bool wellFormed(size_t index) {
+        return index == ENTRY_COUNT ||
+               (MODE01_PIDS[index].name != nullptr && MODE01_PIDS[index].dataBytes >= 1 &&
+                MODE01_PIDS[index].dataBytes <= OBD2PIDTable::MAX_DATA_BYTES &&
+                MODE01_PIDS[index].minValue <= MODE01_PIDS[index].maxValue && wellFormed(index + 1));
+    }
+    static_assert(wellFormed(0), "PID descriptor with no name, bad length or inverted range");
+}
+
+namespace OBD2PIDTable {
+
+const OBD2PIDDescriptor* find(uint8_t mode, uint8_t pid) {
+    if (mode != MODE_CURRENT_DATA || pid >= PID_COUNT) {
+        return nullptr;
+    }
+    return &MODE01_PIDS[pid];
+}
+
+}
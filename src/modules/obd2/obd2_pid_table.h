@@ -0,0 +1,61 @@
+#pragma once
+
+/**
+ * @file obd2_pid_table.h
+ * @brief Flash-resident SAE J1979 PID descriptors
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Static PID metadata (name, unit, data bytes, range) lives in one constant
+ * array indexed by PID byte, so a lookup is a bounds check and an index
+ * instead of a tree walk, and nothing is allocated or copied. The array is
+ * constexpr data with string literals: on the ESP32 it stays in flash.
+ *
+ * Only Mode 01 (current data) is described: Mode 02 (freeze frame) answers
+ * carry a frame number before the data bytes, so dataBytes and the byte
+ * layout would not match. PIDs 0x00-0x63 are covered; bit-encoded PIDs (monitor status, fuel system
+ * status, ...) have no unit or range. Per-PID run-time state belongs to the
+ * user of the table (see OBD2Handler).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Static description of one PID
+ */
+struct OBD2PIDDescriptor {
+    const char* name;           // Human-readable name
+    const char* unit;           // "" for bit-encoded PIDs
+    uint8_t dataBytes;          // Data bytes after mode and PID
+    float minValue;             // Physical range
+    float maxValue;
+};
+
+namespace OBD2PIDTable {
+    constexpr uint8_t MODE_CURRENT_DATA = 0x01;
+    constexpr size_t PID_COUNT          = 0x64;     // PIDs 0x00-0x63
+    constexpr uint8_t MAX_DATA_BYTES    = 4;        // Longest PID in the table
+
+    /**
+     * @brief Descriptor of a PID
+     * @param mode Service (only 0x01 is described)
+     * @param pid PID byte
+     * @return Descriptor in flash, or nullptr for other modes or undefined PIDs
+     */
+    const OBD2PIDDescriptor* find(uint8_t mode, uint8_t pid);
+
+    /**
+     * @brief Descriptor of a mode/PID pair as used by StandardPIDs (0x010C)
+     */
+    inline const OBD2PIDDescriptor* find(uint16_t modePid) {
+        return find(static_cast<uint8_t>(modePid >> 8), static_cast<uint8_t>(modePid & 0xFF));
+    }
+
+    /**
+     * @brief Check for a "PIDs supported" bitmap PID (0x00, 0x20, 0x40, 0x60)
+     */
+    inline bool isSupportPID(uint8_t pid) {
+        return (pid & 0x1F) == 0;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * @file vehicle_state.h
+ * @brief Decoded vehicle data shared by the OBD2 handler and broadcast decoder
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Plain struct with no Arduino dependencies so host-side tests can include it.
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Vehicle state information
+ */
+struct VehicleState {
+    // Engine parameters
+    float engineRPM;            // Engine speed (RPM)
+    float vehicleSpeed;         // Vehicle speed (km/h)
+    float engineLoad;           // Calculated engine load (%)
+    float throttlePosition;     // Throttle position (%)
+    float coolantTemperature;   // Engine coolant temperature (°C)
+    float intakeAirTemp;        // Intake air temperature (°C)
+    float fuelPressure;         // Fuel rail pressure (kPa)
+    float manifoldPressure;     // Intake manifold absolute pressure (kPa)
+    float airFlowRate;          // MAF air flow rate (g/s)
+    float timingAdvance;        // Ignition timing advance (° before TDC)
+    
+    // Electrical system
+    float batteryVoltage;       // Control module voltage (V)
+    float alternatorVoltage;    // Charging system voltage (V)
+    
+    // Fuel system
+    float fuelLevel;            // Fuel tank level (%)
+    float fuelConsumption;      // Instantaneous fuel consumption (L/h)
+    
+    // Environmental
+    float ambientTemperature;   // Ambient air temperature (°C)
+    float barometricPressure;   // Barometric pressure (kPa)
+    
+    // Status flags
+    bool engineRunning;         // Engine is running
+    bool diagnosticTrouble;     // DTC present
+    uint16_t troubleCodes;      // Number of stored DTCs
+    
+    // Timing
+    unsigned long lastUpdate;   // Last update timestamp
+    uint32_t updateCount;       // Number of updates
+};
@@ -0,0 +1,108 @@
+/**
+ * @file slcan_gateway.cpp
+ * @brief SLCAN gateway firmware: the module as a USB-serial CAN adapter
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Bridges CANInterface to the USB serial port with the Lawicel protocol so
+ * the bike bus shows up as a SocketCAN device on a laptop:
+ *
+ *   sudo slcand -o -s6 -t hw -S 921600 /dev/ttyUSB0 can0
+ *   sudo ip link set can0 up
+ *   candump -td can0
+ *
+ * The port carries nothing but SLCAN, so CAN status logging is turned off.
+ */
+
+#include <Arduino.h>
+#include "config/project_config.h"
+#include "modules/can/can_interface.h"
+#include "modules/can/slcan.h"
+
+// Lawicel "F" status bits
+#define SLCAN_STATUS_RX_FULL        0x01
+#define SLCAN_STATUS_TX_FULL        0x02
+#define SLCAN_STATUS_DATA_OVERRUN   0x08
+#define SLCAN_STATUS_BUS_ERROR      0x80
+
+static CANInterface canInterface;
+static CANFrame receivedFrames[CAN_RX_BURST_SIZE];
+static CANStatistics lastStatistics;
+
+static bool serialWrite(const uint8_t* data, size_t length) {
+    return Serial.write(data, length) == length;
+}
+
+static bool transmitFrame(const CANFrame& frame) {
+    return canInterface.sendFrame(frame, 0);
+}
+
+static bool busControl(SLCANBusCommand command, uint32_t bitrate) {
+    if (command == SLCANBusCommand::CLOSE) {
+        canInterface.stop();
+        return true;
+    }
+
+    CANSpeed speed;
+    switch (bitrate) {
+        case 125000:  speed = CANSpeed::CAN_125KBPS; break;
+        case 250000:  speed = CANSpeed::CAN_250KBPS; break;
+        case 500000:  speed = CANSpeed::CAN_500KBPS; break;
+        case 1000000: speed = CANSpeed::CAN_1MBPS;   break;
+        default:      return false;    // TWAI timing table has no entry
+    }
+
+    CANMode mode = command == SLCANBusCommand::OPEN_LISTEN_ONLY ? CANMode::LISTEN_ONLY : CANMode::NORMAL;
+    lastStatistics = CANStatistics();
+    return canInterface.initialize(speed, mode) && canInterface.start() &&
+           canInterface.startReceiveTask();
+}
+
+// Flags are latched between "F" polls, so report counter changes since the last one
+static uint8_t busStatus() {
+    CANStatistics current = canInterface.getStatistics();
+    uint8_t flags = 0;
+    if (current.receiveOverflow != lastStatistics.receiveOverflow) flags |= SLCAN_STATUS_DATA_OVERRUN | SLCAN_STATUS_RX_FULL;
+    if (current.transmitOverflow != lastStatistics.transmitOverflow) flags |= SLCAN_STATUS_TX_FULL;
+    if (current.errorFrames != lastStatistics.errorFrames || canInterface.isBusOff()) flags |= SLCAN_STATUS_BUS_ERROR;
+    lastStatistics = current;
+    return flags;
+}
+
+static SLCANGateway gateway(serialWrite, transmitFrame, busControl);
+
+void setup() {
+    CANInterface::setLogging(false);
+    Serial.setTxBufferSize(SLCAN_OUTPUT_BUFFER_SIZE * 2);
+    Serial.setRxBufferSize(SLCAN_OUTPUT_BUFFER_SIZE);
+    Serial.begin(SLCAN_SERIAL_BAUD);
+    gateway.setStatusFunction(busStatus);
+}
+
+void loop() {
+    // Host commands
+    uint8_t input[64];
+    int available = Serial.available();
+    while (available > 0) {
+        size_t length = Serial.readBytes(input, available < (int)sizeof(input) ? available : sizeof(input));
+        gateway.receive(input, length);
+        available -= length;
+    }
+
+    // Bus frames, one serial write per pass
+    if (gateway.isOpen()) {
+        size_t count;
+        while ((count = canInterface.receiveFrames(receivedFrames, CAN_RX_BURST_SIZE)) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                gateway.forwardFrame(receivedFrames[i]);
+            }
+        }
+    }
+    gateway.flush();
+
+    if (gateway.isOpen()) {
+        canInterface.waitForMessages(1);
+    } else {
+        delay(1);
+    }
+}
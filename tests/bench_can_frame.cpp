@@ -0,0 +1,246 @@
+/*
+ * Benchmark: compact CANFrame vs. CANMessage in rings and on the RX path
+ *
+ * Checks CANFrame <-> CANMessage round trips and that the filter engine
+ * decides identically on both, then reports ring RAM and the per-frame
+ * cost of the RX hot path (driver message -> ring slot -> consumer).
+ * TWAIMessage mirrors the ESP-IDF twai_message_t layout so the conversion
+ * runs the same byte moves as on target.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/bench_can_frame.cpp src/modules/can/can_filter_engine.cpp -o bench_can_frame
+ *   ./bench_can_frame
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#include "../src/config/project_config.h"
+#include "../src/modules/can/can_frame.h"
+#include "../src/modules/can/can_ring_buffer.h"
+#include "../src/modules/can/can_filter_engine.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static inline uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Same layout as ESP-IDF twai_message_t
+struct TWAIMessage {
+  union {
+    struct {
+      uint32_t extd : 1;
+      uint32_t rtr : 1;
+      uint32_t ss : 1;
+      uint32_t self : 1;
+      uint32_t dlc_non_comp : 1;
+      uint32_t reserved : 27;
+    };
+    uint32_t flags;
+  };
+  uint32_t identifier;
+  uint8_t data_length_code;
+  uint8_t data[8];
+};
+
+// Previous RX path: CANInterface::convertFromTWAI() into a CANMessage
+static void legacyConvert(const TWAIMessage& twaiMsg, CANMessage& canMsg, uint64_t timestamp) {
+  canMsg.id = twaiMsg.identifier;
+  canMsg.dlc = twaiMsg.data_length_code;
+  canMsg.extd = twaiMsg.extd;
+  canMsg.rtr = twaiMsg.rtr;
+  canMsg.type = twaiMsg.extd ? CANMessageType::EXTENDED : CANMessageType::STANDARD;
+  canMsg.timestamp = timestamp;
+  canMsg.errorFlags = 0;
+  memcpy(canMsg.data, twaiMsg.data, canMsg.dlc);
+}
+
+// New RX path: CANInterface::convertFromTWAI() into a CANFrame
+static void frameConvert(const TWAIMessage& twaiMsg, CANFrame& frame, uint64_t timestamp) {
+  frame.idFlags = (twaiMsg.identifier & CANFrame::ID_MASK) |
+                  (twaiMsg.extd ? CANFrame::FLAG_EXTENDED : 0) |
+                  (twaiMsg.rtr ? CANFrame::FLAG_REMOTE : 0);
+  frame.dlc = twaiMsg.data_length_code > 8 ? 8 : twaiMsg.data_length_code;
+  memcpy(frame.data, twaiMsg.data, 8);
+  frame.timestamp = timestamp;
+}
+
+static std::vector<TWAIMessage> makeTraffic(size_t count) {
+  std::vector<TWAIMessage> traffic(count);
+  for (size_t i = 0; i < count; i++) {
+    TWAIMessage& m = traffic[i];
+    m.flags = 0;
+    m.extd = (i % 7) == 0;
+    m.identifier = m.extd ? (0x18DAF100 | (i & 0xFF)) : (0x100 + (i % 64));
+    m.data_length_code = 8;
+    for (int b = 0; b < 8; b++) m.data[b] = static_cast<uint8_t>(i + b);
+  }
+  return traffic;
+}
+
+// ===== CORRECTNESS =====
+
+static void testRoundTrip() {
+  CANMessage original;
+  original.id = 0x18DAF110;
+  original.extd = true;
+  original.type = CANMessageType::EXTENDED;
+  original.dlc = 5;
+  for (int i = 0; i < 5; i++) original.data[i] = 0xA0 + i;
+  original.timestamp = 0x123456789ULL;
+
+  CANFrame frame = CANFrame::fromMessage(original);
+  CANMessage back;
+  back.data[7] = 0xEE;
+  frame.toMessage(back);
+  CHECK(frame.id() == 0x18DAF110 && frame.isExtended() && !frame.isRemote() && !frame.isError(),
+        "flags packed into the identifier word");
+  CHECK(back.id == original.id && back.extd && back.dlc == 5 && back.timestamp == original.timestamp &&
+        back.type == CANMessageType::EXTENDED && memcmp(back.data, original.data, 8) == 0,
+        "round trip keeps every field and zeroes bytes past dlc");
+
+  CANMessage remote;
+  remote.id = 0x7DF;
+  remote.rtr = true;
+  remote.dlc = 8;
+  frame = CANFrame::fromMessage(remote);
+  frame.toMessage(back);
+  CHECK(frame.isRemote() && !frame.isExtended() && back.rtr && back.id == 0x7DF, "remote frame");
+
+  CANMessage error;
+  error.type = CANMessageType::ERROR_FRAME;
+  frame = CANFrame::fromMessage(error);
+  frame.toMessage(back);
+  CHECK(frame.isError() && back.type == CANMessageType::ERROR_FRAME, "error frame");
+  printf("  %-32s OK\n", "CANFrame <-> CANMessage");
+}
+
+static void testFilterParity() {
+  CANFilterEngine engine;
+  engine.acceptRange(0x7E8, 0x7EF);
+  engine.accept(0x18DAF110);
+  engine.reject(0x7EA);
+  engine.requirePredicate(0x100, 0x1FF, [](const CANMessage& m) { return m.data[0] & 1; });
+  engine.compile();
+
+  srand(3);
+  bool same = true;
+  for (int i = 0; i < 200000; i++) {
+    CANMessage m;
+    m.extd = rand() & 1;
+    m.id = m.extd ? (rand() & 1 ? 0x18DAF110 : rand() & 0x1FFFFFFF) : (rand() & 0x7FF);
+    m.type = m.extd ? CANMessageType::EXTENDED : CANMessageType::STANDARD;
+    m.dlc = 8;
+    m.data[0] = rand() & 0xFF;
+    if (engine.accepts(m) != engine.accepts(CANFrame::fromMessage(m))) same = false;
+  }
+  CHECK(same, "filter engine decides the same on CANFrame and CANMessage");
+  printf("  %-32s OK\n", "filter parity");
+}
+
+// ===== MEMORY AND RX PATH COST =====
+
+// Previous path: convertFromTWAI into a temporary CANMessage, then push
+static double rxPathMessage(const std::vector<TWAIMessage>& traffic, int rounds) {
+  static CANRingBuffer<CANMessage, 256> ring;
+  CANMessage out;
+  uint64_t sink = 0;
+  uint64_t start = nowNs();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < traffic.size(); i++) {
+      CANMessage message;
+      legacyConvert(traffic[i], message, i);
+      ring.push(message);
+      if (ring.size() >= 128) {
+        while (ring.pop(out)) sink += out.data[0];
+      }
+    }
+  }
+  while (ring.pop(out)) sink += out.data[0];
+  if (sink == 42) printf(" ");  // Keep the consumer loop alive
+  return static_cast<double>(nowNs() - start) / (rounds * traffic.size());
+}
+
+// New path: reserve a slot, convert straight into it, batch pop
+static double rxPathFrame(const std::vector<TWAIMessage>& traffic, int rounds) {
+  static CANRingBuffer<CANFrame, 256> ring;
+  CANFrame out[32];
+  uint64_t sink = 0;
+  uint64_t start = nowNs();
+  for (int r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < traffic.size(); i++) {
+      frameConvert(traffic[i], *ring.reserve(), i);
+      ring.commit();
+      if (ring.size() >= 128) {
+        size_t n;
+        while ((n = ring.popBatch(out, 32)) > 0) {
+          for (size_t k = 0; k < n; k++) sink += out[k].data[0];
+        }
+      }
+    }
+  }
+  size_t n;
+  while ((n = ring.popBatch(out, 32)) > 0) {
+    for (size_t k = 0; k < n; k++) sink += out[k].data[0];
+  }
+  if (sink == 42) printf(" ");
+  return static_cast<double>(nowNs() - start) / (rounds * traffic.size());
+}
+
+static void benchmark() {
+  printf("\nRing RAM:\n");
+  printf("  %-28s %10s %12s %12s\n", "slot type", "slot bytes", "256 frames", "RX+TX rings");
+  size_t messageRing = sizeof(CANRingBuffer<CANMessage, 256>);
+  size_t frameRing = sizeof(CANRingBuffer<CANFrame, 256>);
+  size_t messageRings = sizeof(CANRingBuffer<CANMessage, CAN_RX_RING_SIZE>) +
+                        sizeof(CANRingBuffer<CANMessage, CAN_TX_RING_SIZE>);
+  size_t frameRings = sizeof(CANRingBuffer<CANFrame, CAN_RX_RING_SIZE>) +
+                      sizeof(CANRingBuffer<CANFrame, CAN_TX_RING_SIZE>);
+  printf("  %-28s %10zu %12zu %12zu\n", "CANMessage (before)", sizeof(CANMessage), messageRing, messageRings);
+  printf("  %-28s %10zu %12zu %12zu\n", "CANFrame", sizeof(CANFrame), frameRing, frameRings);
+  printf("  saved: %zu bytes per 256-frame ring, %zu bytes in CANInterface (%d+%d slots)\n",
+         messageRing - frameRing, messageRings - frameRings, CAN_RX_RING_SIZE, CAN_TX_RING_SIZE);
+  printf("  frames per 64-byte cache line: %.2f -> %.2f\n", 64.0 / sizeof(CANMessage), 64.0 / sizeof(CANFrame));
+  CHECK(sizeof(CANFrame) == 24 && sizeof(CANMessage) >= 40, "frame 24 bytes vs message 40");
+  CHECK(messageRing - frameRing >= 256 * 16, "at least 4 KiB saved per 256-frame ring");
+
+  std::vector<TWAIMessage> traffic = makeTraffic(4096);
+  const int ROUNDS = 500;
+  rxPathMessage(traffic, 10);   // Warm up
+  rxPathFrame(traffic, 10);
+  double legacy = rxPathMessage(traffic, ROUNDS);
+  double compact = rxPathFrame(traffic, ROUNDS);
+
+  printf("\nRX path (driver message -> ring -> consumer), %d frames:\n", ROUNDS * 4096);
+  printf("  %-28s %10.2f ns/frame\n", "CANMessage temp + push", legacy);
+  printf("  %-28s %10.2f ns/frame\n", "CANFrame reserve + popBatch", compact);
+  printf("  speedup: %.2fx\n", legacy / compact);
+}
+
+int main() {
+  printf("CANFrame benchmark\n");
+  printf("==================\n");
+
+  testRoundTrip();
+  testFilterParity();
+  benchmark();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nCANFrame benchmark completed\n");
+  return 0;
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+/**
+ * @file example_bike_dbc.h
+ * @brief Signal decoders generated from example_bike.dbc
+ *
+ * Generated by tools/dbc_codegen.py. Do not edit; regenerate instead.
+ */
+
+#include <stdint.h>
+#include "../src/modules/can/can_frame.h"
+#include "../src/modules/can/can_signal.h"
+
+namespace ExampleBike {
+
+// ===== EngineStatus (0x0A0, 8 bytes, from ECU) =====
+
+struct EngineStatus {
+    static constexpr uint32_t ID = 0x0A0;
+    static constexpr bool EXTENDED = false;
+    static constexpr uint8_t DLC = 8;
+    static constexpr uint32_t KEY = ID | (EXTENDED ? CANFrame::FLAG_EXTENDED : 0);
+
+    // 0|16 Intel unsigned, range 0 to 16383.75 [rpm]
+    struct EngineSpeed {
+        static constexpr uint8_t startBit = 0;
+        static constexpr uint8_t length = 16;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.25f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 16|8 Intel unsigned, range 0 to 100 [%]
+    struct ThrottlePosition {
+        static constexpr uint8_t startBit = 16;
+        static constexpr uint8_t length = 8;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.392157f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 24|8 Intel unsigned, range -40 to 215 [degC]
+    struct CoolantTemp {
+        static constexpr uint8_t startBit = 24;
+        static constexpr uint8_t length = 8;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 1.0f;
+        static constexpr float offset = -40.0f;
+    };
+
+    // 32|4 Intel unsigned, range 0 to 6
+    struct GearPosition {
+        static constexpr uint8_t startBit = 32;
+        static constexpr uint8_t length = 4;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 1.0f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 36|10 Intel unsigned, range 0 to 102.3 [%]
+    struct EngineLoad {
+        static constexpr uint8_t startBit = 36;
+        static constexpr uint8_t length = 10;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.1f;
+        static constexpr float offset = 0.0f;
+    };
+
+    struct Values {
+        float EngineSpeed;
+        float ThrottlePosition;
+        int16_t CoolantTemp;
+        uint8_t GearPosition;
+        float EngineLoad;
+    };
+
+    static void decode(const uint8_t* data, Values& values) {
+        values.EngineSpeed = CANSignal::decode<EngineSpeed>(data);
+        values.ThrottlePosition = CANSignal::decode<ThrottlePosition>(data);
+        values.CoolantTemp = CANSignal::decodeInteger<CoolantTemp, int16_t>(data);
+        values.GearPosition = CANSignal::decodeInteger<GearPosition, uint8_t>(data);
+        values.EngineLoad = CANSignal::decode<EngineLoad>(data);
+    }
+
+    static void encode(uint8_t* data, const Values& values) {
+        CANSignal::encode<EngineSpeed>(data, values.EngineSpeed);
+        CANSignal::encode<ThrottlePosition>(data, values.ThrottlePosition);
+        CANSignal::encodeInteger<CoolantTemp>(data, values.CoolantTemp);
+        CANSignal::encodeInteger<GearPosition>(data, values.GearPosition);
+        CANSignal::encode<EngineLoad>(data, values.EngineLoad);
+    }
+};
+
+// ===== WheelSpeeds (0x120, 8 bytes, from ABS) =====
+
+struct WheelSpeeds {
+    static constexpr uint32_t ID = 0x120;
+    static constexpr bool EXTENDED = false;
+    static constexpr uint8_t DLC = 8;
+    static constexpr uint32_t KEY = ID | (EXTENDED ? CANFrame::FLAG_EXTENDED : 0);
+
+    // 7|16 Motorola unsigned, range 0 to 655.35 [km/h]
+    struct FrontWheelSpeed {
+        static constexpr uint8_t startBit = 7;
+        static constexpr uint8_t length = 16;
+        static constexpr bool motorola = true;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.01f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 23|16 Motorola unsigned, range 0 to 655.35 [km/h]
+    struct RearWheelSpeed {
+        static constexpr uint8_t startBit = 23;
+        static constexpr uint8_t length = 16;
+        static constexpr bool motorola = true;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.01f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 39|12 Motorola signed, range -204.8 to 204.7 [deg]
+    struct LeanAngle {
+        static constexpr uint8_t startBit = 39;
+        static constexpr uint8_t length = 12;
+        static constexpr bool motorola = true;
+        static constexpr bool isSigned = true;
+        static constexpr float factor = 0.1f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 51|12 Motorola signed, range -20.48 to 20.47 [m/s2]
+    struct LongAccel {
+        static constexpr uint8_t startBit = 51;
+        static constexpr uint8_t length = 12;
+        static constexpr bool motorola = true;
+        static constexpr bool isSigned = true;
+        static constexpr float factor = 0.01f;
+        static constexpr float offset = 0.0f;
+    };
+
+    struct Values {
+        float FrontWheelSpeed;
+        float RearWheelSpeed;
+        float LeanAngle;
+        float LongAccel;
+    };
+
+    static void decode(const uint8_t* data, Values& values) {
+        values.FrontWheelSpeed = CANSignal::decode<FrontWheelSpeed>(data);
+        values.RearWheelSpeed = CANSignal::decode<RearWheelSpeed>(data);
+        values.LeanAngle = CANSignal::decode<LeanAngle>(data);
+        values.LongAccel = CANSignal::decode<LongAccel>(data);
+    }
+
+    static void encode(uint8_t* data, const Values& values) {
+        CANSignal::encode<FrontWheelSpeed>(data, values.FrontWheelSpeed);
+        CANSignal::encode<RearWheelSpeed>(data, values.RearWheelSpeed);
+        CANSignal::encode<LeanAngle>(data, values.LeanAngle);
+        CANSignal::encode<LongAccel>(data, values.LongAccel);
+    }
+};
+
+// ===== TripComputer (0x18FEF1FE, 8 bytes, from ECU) =====
+
+struct TripComputer {
+    static constexpr uint32_t ID = 0x18FEF1FE;
+    static constexpr bool EXTENDED = true;
+    static constexpr uint8_t DLC = 8;
+    static constexpr uint32_t KEY = ID | (EXTENDED ? CANFrame::FLAG_EXTENDED : 0);
+
+    // 0|32 Intel unsigned, range 0 to 429496729.5 [km]
+    struct Odometer {
+        static constexpr uint8_t startBit = 0;
+        static constexpr uint8_t length = 32;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.1f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 32|8 Intel unsigned, range 0 to 127.5 [%]
+    struct FuelLevel {
+        static constexpr uint8_t startBit = 32;
+        static constexpr uint8_t length = 8;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.5f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 40|8 Intel unsigned, range 0 to 25.5 [V]
+    struct BatteryVoltage {
+        static constexpr uint8_t startBit = 40;
+        static constexpr uint8_t length = 8;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = false;
+        static constexpr float factor = 0.1f;
+        static constexpr float offset = 0.0f;
+    };
+
+    // 48|8 Intel signed, range -128 to 127 [degC]
+    struct AmbientTemp {
+        static constexpr uint8_t startBit = 48;
+        static constexpr uint8_t length = 8;
+        static constexpr bool motorola = false;
+        static constexpr bool isSigned = true;
+        static constexpr float factor = 1.0f;
+        static constexpr float offset = 0.0f;
+    };
+
+    struct Values {
+        float Odometer;
+        float FuelLevel;
+        float BatteryVoltage;
+        int8_t AmbientTemp;
+    };
+
+    static void decode(const uint8_t* data, Values& values) {
+        values.Odometer = CANSignal::decode<Odometer>(data);
+        values.FuelLevel = CANSignal::decode<FuelLevel>(data);
+        values.BatteryVoltage = CANSignal::decode<BatteryVoltage>(data);
+        values.AmbientTemp = CANSignal::decodeInteger<AmbientTemp, int8_t>(data);
+    }
+
+    static void encode(uint8_t* data, const Values& values) {
+        CANSignal::encode<Odometer>(data, values.Odometer);
+        CANSignal::encode<FuelLevel>(data, values.FuelLevel);
+        CANSignal::encode<BatteryVoltage>(data, values.BatteryVoltage);
+        CANSignal::encodeInteger<AmbientTemp>(data, values.AmbientTemp);
+    }
+};
+
+// ===== DISPATCH =====
+
+/**
+ * @brief Decode a known frame and pass its Values to handler(values)
+ * @return false for unknown IDs, remote/error frames and short frames
+ */
+template <typename Handler>
+inline bool dispatch(const CANFrame& frame, Handler& handler) {
+    if (frame.isRemote() || frame.isError()) {
+        return false;
+    }
+    switch (frame.idFlags & (CANFrame::ID_MASK | CANFrame::FLAG_EXTENDED)) {
+    case EngineStatus::KEY: {
+        if (frame.dlc < EngineStatus::DLC) {
+            return false;
+        }
+        EngineStatus::Values values;
+        EngineStatus::decode(frame.data, values);
+        handler(values);
+        return true;
+    }
+    case WheelSpeeds::KEY: {
+        if (frame.dlc < WheelSpeeds::DLC) {
+            return false;
+        }
+        WheelSpeeds::Values values;
+        WheelSpeeds::decode(frame.data, values);
+        handler(values);
+        return true;
+    }
+    case TripComputer::KEY: {
+        if (frame.dlc < TripComputer::DLC) {
+            return false;
+        }
+        TripComputer::Values values;
+        TripComputer::decode(frame.data, values);
+        handler(values);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Adapter for CANInterface::setFrameHandler(&dispatchTo<H>, &handler)
+ */
+template <typename Handler>
+bool dispatchTo(const CANFrame& frame, void* context) {
+    return dispatch(frame, *static_cast<Handler*>(context));
+}
+
+} // namespace ExampleBike
@@ -0,0 +1,110 @@
+#pragma once
+
+/**
+ * @file Arduino.h
+ * @brief Host stand-in for the Arduino core pieces the CAN stack uses
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Only what src/modules/can needs: Serial, String, F(), timing and the
+ * GPIO calls referenced by hardware_config.h macros. Times come from the
+ * same monotonic clock as esp_timer_get_time().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#define IRAM_ATTR
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define INPUT_PULLDOWN  0x09
+
+class __FlashStringHelper;
+#define F(text) (reinterpret_cast<const __FlashStringHelper*>(text))
+
+/**
+ * @class String
+ * @brief std::string with the Arduino String calls used in this project
+ */
+class String {
+public:
+    String(const char* text = "") : value(text != nullptr ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    explicit String(int number) : value(std::to_string(number)) {}
+    explicit String(unsigned int number) : value(std::to_string(number)) {}
+    explicit String(long number) : value(std::to_string(number)) {}
+    explicit String(unsigned long number) : value(std::to_string(number)) {}
+
+    const char* c_str() const { return value.c_str(); }
+    size_t length() const { return value.length(); }
+    bool isEmpty() const { return value.empty(); }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* other) { value += other; return *this; }
+    String& operator+=(char other) { value += other; return *this; }
+    bool concat(const String& other) { value += other.value; return true; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == other; }
+    bool operator!=(const String& other) const { return value != other.value; }
+
+private:
+    std::string value;
+};
+
+/**
+ * @class HostSerial
+ * @brief Serial on stdout; setEnabled(false) silences driver logging in benches
+ */
+class HostSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void setEnabled(bool on) { enabled = on; }
+
+    size_t print(const char* text) { return write(text); }
+    size_t print(const __FlashStringHelper* text) { return write(reinterpret_cast<const char*>(text)); }
+    size_t print(const String& text) { return write(text.c_str()); }
+    size_t print(long number) { return printf("%ld", number); }
+    size_t println() { return write("\n"); }
+    size_t println(const char* text) { return write(text) + write("\n"); }
+    size_t println(const __FlashStringHelper* text) { return println(reinterpret_cast<const char*>(text)); }
+    size_t println(const String& text) { return println(text.c_str()); }
+    size_t println(long number) { return printf("%ld\n", number); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(const uint8_t* data, size_t length);
+    size_t write(const char* text) { return write(reinterpret_cast<const uint8_t*>(text), strlen(text)); }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush() { fflush(stdout); }
+    explicit operator bool() const { return true; }
+    size_t bytesWritten() const { return written; }     // Via print/write, shown or not
+
+private:
+    bool enabled = true;
+    size_t written = 0;
+};
+
+extern HostSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
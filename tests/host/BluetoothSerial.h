@@ -0,0 +1,10 @@
+#pragma once
+
+/**
+ * @file BluetoothSerial.h
+ * @brief Host stand-in so hardware_config.h can be included; no radio on the host
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "Arduino.h"
@@ -0,0 +1,223 @@
+#pragma once
+
+/**
+ * @file twai.h
+ * @brief Host emulation of the IDF TWAI driver
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Same types, macros and calls as the IDF driver (v4.4/v5 API), backed by
+ * an event-driven bus model instead of the controller:
+ *
+ * - RX and TX queues of the depths given to twai_driver_install(); a full
+ *   TX queue blocks twai_transmit() for its timeout, a full RX queue drops
+ *   frames (rx_missed_count, TWAI_ALERT_RX_QUEUE_FULL).
+ * - Every frame occupies the bus for its on-wire time at the installed
+ *   bitrate. The virtual bus clock is the sum of that time; how it maps
+ *   onto host time is set by twai_host_set_time_scale() (1 = real time,
+ *   0 = infinitely fast bus, only the software is measured).
+ * - Frames from other nodes are injected with twai_host_inject(); frames
+ *   that complete are passed to a transmit hook, which is how a test plays
+ *   the ECU.
+ * - Acceptance filter, alerts, status counters, single-shot, self
+ *   reception (message.self, which is how the IDF does self test) and
+ *   NO_ACK / LISTEN_ONLY modes behave as documented for the driver.
+ * - Error injection: bus-off, RX FIFO overruns, arbitration loss and bus
+ *   errors on the next transmissions, a missing acknowledge.
+ *
+ * Error counting follows ISO 11898-1 closely enough for recovery tests:
+ * +8 per transmit error, -1 per success, bus-off at 256, and an error
+ * passive node does not count acknowledge errors (a lone node never goes
+ * bus-off, it retries forever).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+// ===== IDF TYPES =====
+
+typedef enum {
+    TWAI_MODE_NORMAL,
+    TWAI_MODE_NO_ACK,
+    TWAI_MODE_LISTEN_ONLY,
+} twai_mode_t;
+
+typedef enum {
+    TWAI_STATE_STOPPED,
+    TWAI_STATE_RUNNING,
+    TWAI_STATE_BUS_OFF,
+    TWAI_STATE_RECOVERING,
+} twai_state_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t extd: 1;
+            uint32_t rtr: 1;
+            uint32_t ss: 1;
+            uint32_t self: 1;
+            uint32_t dlc_non_comp: 1;
+            uint32_t reserved: 27;
+        };
+        uint32_t flags;
+    };
+    uint32_t identifier;
+    uint8_t data_length_code;
+    uint8_t data[8];
+} twai_message_t;
+
+typedef struct {
+    twai_mode_t mode;
+    int tx_io;
+    int rx_io;
+    int clkout_io;
+    int bus_off_io;
+    uint32_t tx_queue_len;
+    uint32_t rx_queue_len;
+    uint32_t alerts_enabled;
+    uint32_t clkout_divider;
+    int intr_flags;
+} twai_general_config_t;
+
+typedef struct {
+    uint32_t brp;
+    uint8_t tseg_1;
+    uint8_t tseg_2;
+    uint8_t sjw;
+    bool triple_sampling;
+} twai_timing_config_t;
+
+typedef struct {
+    uint32_t acceptance_code;
+    uint32_t acceptance_mask;
+    bool single_filter;
+} twai_filter_config_t;
+
+typedef struct {
+    twai_state_t state;
+    uint32_t msgs_to_tx;
+    uint32_t msgs_to_rx;
+    uint32_t tx_error_counter;
+    uint32_t rx_error_counter;
+    uint32_t tx_failed_count;
+    uint32_t rx_missed_count;
+    uint32_t rx_overrun_count;
+    uint32_t arb_lost_count;
+    uint32_t bus_error_count;
+} twai_status_info_t;
+
+typedef int gpio_num_t;
+
+#define TWAI_IO_UNUSED                  (-1)
+
+#define TWAI_ALERT_TX_IDLE              0x00000001
+#define TWAI_ALERT_TX_SUCCESS           0x00000002
+#define TWAI_ALERT_RX_DATA              0x00000004
+#define TWAI_ALERT_BELOW_ERR_WARN       0x00000008
+#define TWAI_ALERT_ERR_ACTIVE           0x00000010
+#define TWAI_ALERT_RECOVERY_IN_PROGRESS 0x00000020
+#define TWAI_ALERT_BUS_RECOVERED        0x00000040
+#define TWAI_ALERT_ARB_LOST             0x00000080
+#define TWAI_ALERT_ABOVE_ERR_WARN       0x00000100
+#define TWAI_ALERT_BUS_ERROR            0x00000200
+#define TWAI_ALERT_TX_FAILED            0x00000400
+#define TWAI_ALERT_RX_QUEUE_FULL        0x00000800
+#define TWAI_ALERT_ERR_PASS             0x00001000
+#define TWAI_ALERT_BUS_OFF              0x00002000
+#define TWAI_ALERT_RX_FIFO_OVERRUN      0x00004000
+#define TWAI_ALERT_TX_RETRIED           0x00008000
+#define TWAI_ALERT_PERIPH_RESET         0x00010000
+#define TWAI_ALERT_ALL                  0x0001FFFF
+#define TWAI_ALERT_NONE                 0x00000000
+#define TWAI_ALERT_AND_LOG              0x00020000
+
+#define TWAI_GENERAL_CONFIG_DEFAULT(tx_io_num, rx_io_num, op_mode) { \
+    (op_mode), (tx_io_num), (rx_io_num), TWAI_IO_UNUSED, TWAI_IO_UNUSED, \
+    5, 5, TWAI_ALERT_NONE, 14, 0}
+
+// 80 MHz APB clock, 20 quanta per bit
+#define TWAI_TIMING_CONFIG_125KBITS()   {32, 15, 4, 3, false}
+#define TWAI_TIMING_CONFIG_250KBITS()   {16, 15, 4, 3, false}
+#define TWAI_TIMING_CONFIG_500KBITS()   {8, 15, 4, 3, false}
+#define TWAI_TIMING_CONFIG_1MBITS()     {4, 15, 4, 3, false}
+
+#define TWAI_FILTER_CONFIG_ACCEPT_ALL() {0, 0xFFFFFFFF, true}
+
+// ===== IDF DRIVER CALLS =====
+
+esp_err_t twai_driver_install(const twai_general_config_t* g_config, const twai_timing_config_t* t_config,
+                              const twai_filter_config_t* f_config);
+esp_err_t twai_driver_uninstall();
+esp_err_t twai_start();
+esp_err_t twai_stop();
+esp_err_t twai_transmit(const twai_message_t* message, TickType_t ticks_to_wait);
+esp_err_t twai_receive(twai_message_t* message, TickType_t ticks_to_wait);
+esp_err_t twai_read_alerts(uint32_t* alerts, TickType_t ticks_to_wait);
+esp_err_t twai_reconfigure_alerts(uint32_t alerts_enabled, uint32_t* current_alerts);
+esp_err_t twai_initiate_recovery();
+esp_err_t twai_get_status_info(twai_status_info_t* status_info);
+esp_err_t twai_clear_transmit_queue();
+esp_err_t twai_clear_receive_queue();
+
+// ===== HOST EMULATOR CONTROL =====
+
+/**
+ * @brief Called with each frame this node completes on the bus (lock released)
+ */
+typedef void (*twai_host_tx_hook_t)(const twai_message_t& message, void* context);
+
+/**
+ * @brief Restore defaults: real-time bus, acknowledged, no hook, no pending faults
+ * @note Only while the driver is not installed
+ */
+void twai_host_reset();
+
+/**
+ * @brief Host microseconds per microsecond of bus time (1 = real time, 0 = instant)
+ */
+void twai_host_set_time_scale(float scale);
+
+/**
+ * @brief Whether another node acknowledges this node's frames
+ */
+void twai_host_set_acknowledge(bool acknowledge);
+
+void twai_host_set_tx_hook(twai_host_tx_hook_t hook, void* context);
+
+/**
+ * @brief A frame sent by another node, queued on the bus behind current traffic
+ * @return false if the driver is not installed
+ */
+bool twai_host_inject(const twai_message_t& message);
+
+/**
+ * @brief Force bus-off now (TX queue is flushed as failed)
+ */
+void twai_host_inject_bus_off();
+
+/**
+ * @brief Frames lost in the controller's RX FIFO before the driver saw them
+ */
+void twai_host_inject_rx_overrun(uint32_t frames);
+
+/**
+ * @brief The next transmissions lose arbitration once each (then retry)
+ */
+void twai_host_inject_arbitration_loss(uint32_t count);
+
+/**
+ * @brief The next transmissions each hit a bus error (+8 TEC, then retry)
+ */
+void twai_host_inject_bus_errors(uint32_t count);
+
+/**
+ * @brief Virtual bus clock: total on-wire time of all frames so far
+ */
+uint64_t twai_host_bus_time_us();
+
+/**
+ * @brief Frames completed on the bus (both directions) since install
+ */
+uint32_t twai_host_frames_on_bus();
@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in for esp_timer_get_time()
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include <stdint.h>
+
+/**
+ * @brief Microseconds on the host's monotonic clock since the process started
+ */
+int64_t esp_timer_get_time();
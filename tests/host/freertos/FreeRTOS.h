@@ -0,0 +1,46 @@
+#pragma once
+
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types and critical sections
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Ticks are milliseconds (configTICK_RATE_HZ 1000, as on the target).
+ * A portMUX is a recursive mutex: same nesting rules as the ESP32
+ * spinlock, and a host thread holding it may be preempted, which only
+ * makes races easier to hit.
+ */
+
+#include <stdint.h>
+#include <mutex>
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define configTICK_RATE_HZ      1000
+#define portMAX_DELAY           0xFFFFFFFFUL
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       (static_cast<TickType_t>(ms))
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+struct HostMux {
+    std::recursive_mutex mutex;
+
+    HostMux() {}
+    HostMux(const HostMux&) {}
+    HostMux& operator=(const HostMux&) { return *this; }
+};
+
+typedef HostMux portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    HostMux()
+#define portENTER_CRITICAL(mux)         ((mux)->mutex.lock())
+#define portEXIT_CRITICAL(mux)          ((mux)->mutex.unlock())
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define portYIELD_FROM_ISR()            ((void)0)
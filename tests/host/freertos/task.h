@@ -0,0 +1,32 @@
+#pragma once
+
+/**
+ * @file task.h
+ * @brief Host stand-in for FreeRTOS tasks and direct-to-task notifications
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Tasks are detached std::threads; core and priority are recorded only.
+ * A task ends when its function returns (vTaskDelete(nullptr) is a no-op
+ * on the host, so code after it must not run - as on the target). Other
+ * tasks cannot be killed; vTaskDelete(handle) only forgets the handle.
+ */
+
+#include "FreeRTOS.h"
+
+struct HostTask;
+typedef HostTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core);
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                       void* parameter, UBaseType_t priority, TaskHandle_t* created);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+TickType_t xTaskGetTickCount();
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
@@ -0,0 +1,247 @@
+/**
+ * @file host_runtime.cpp
+ * @brief Host implementations of the Arduino, FreeRTOS and esp_timer stand-ins
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ */
+
+#include "Arduino.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdarg.h>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+
+namespace {
+
+const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+std::chrono::steady_clock::time_point deadlineAfter(TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        return std::chrono::steady_clock::time_point::max();
+    }
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+}
+
+} // namespace
+
+// ===== TIME =====
+
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - processStart).count();
+}
+
+unsigned long millis() {
+    return static_cast<unsigned long>(esp_timer_get_time() / 1000);
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(esp_timer_get_time());
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+// ===== GPIO (no pins on the host) =====
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    (void)pin;
+    (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    (void)pin;
+    (void)value;
+}
+
+int digitalRead(uint8_t pin) {
+    (void)pin;
+    return HIGH;
+}
+
+// ===== SERIAL =====
+
+HostSerial Serial;
+
+size_t HostSerial::printf(const char* format, ...) {
+    if (!enabled) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vprintf(format, args);
+    va_end(args);
+    return written > 0 ? static_cast<size_t>(written) : 0;
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t length) {
+    written += length;
+    if (!enabled) {
+        return length;
+    }
+    return fwrite(data, 1, length, stdout);
+}
+
+const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:
+            return "ESP_OK";
+        case ESP_FAIL:
+            return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:
+            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:
+            return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:
+            return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:
+            return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:
+            return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:
+            return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:
+            return "ESP_ERR_TIMEOUT";
+        default:
+            return "UNKNOWN ERROR";
+    }
+}
+
+// ===== TASKS =====
+
+struct HostTask {
+    std::mutex lock;
+    std::condition_variable notified;
+    uint32_t notifications = 0;
+};
+
+namespace {
+
+thread_local HostTask* currentTask = nullptr;
+
+void runTask(TaskFunction_t function, void* parameter, HostTask* task) {
+    currentTask = task;
+    function(parameter);
+    // Handles are never freed: a stale notifyTaskHandle must stay harmless
+}
+
+} // namespace
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                                   void* parameter, UBaseType_t priority, TaskHandle_t* created,
+                                   BaseType_t core) {
+    (void)name;
+    (void)stackDepth;
+    (void)priority;
+    (void)core;
+    HostTask* task = new HostTask();
+    if (created != nullptr) {
+        *created = task;
+    }
+    std::thread(runTask, function, parameter, task).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth,
+                       void* parameter, UBaseType_t priority, TaskHandle_t* created) {
+    return xTaskCreatePinnedToCore(function, name, stackDepth, parameter, priority, created, 0);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    (void)task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (currentTask == nullptr) {
+        currentTask = new HostTask();     // Threads not created through xTaskCreate
+    }
+    return currentTask;
+}
+
+TickType_t xTaskGetTickCount() {
+    return static_cast<TickType_t>(millis());
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->notifications++;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    HostTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> guard(task->lock);
+    task->notified.wait_until(guard, deadlineAfter(ticks), [task] { return task->notifications > 0; });
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clearOnExit ? 0 : value - 1;
+    }
+    return value;
+}
+
+// ===== SEMAPHORES =====
+
+struct HostSemaphore {
+    std::mutex lock;
+    std::condition_variable available;
+    uint32_t count;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    HostSemaphore* semaphore = new HostSemaphore();
+    semaphore->count = 1;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    HostSemaphore* semaphore = new HostSemaphore();
+    semaphore->count = 0;
+    return semaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    std::unique_lock<std::mutex> guard(semaphore->lock);
+    if (!semaphore->available.wait_until(guard, deadlineAfter(ticks),
+                                         [semaphore] { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    {
+        std::lock_guard<std::mutex> guard(semaphore->lock);
+        if (semaphore->count > 0) {
+            return pdFALSE;     // Binary and mutex semaphores hold at most one
+        }
+        semaphore->count = 1;
+    }
+    semaphore->available.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higherPriorityWoken) {
+    if (higherPriorityWoken != nullptr) {
+        *higherPriorityWoken = pdFALSE;
+    }
+    return xSemaphoreGive(semaphore);
+}
@@ -0,0 +1,683 @@
+/**
+ * @file host_twai.cpp
+ * @brief Event-driven TWAI controller and bus model behind the host driver/twai.h
+ * @author Chigee OBD2 Project Team
+ * @date 2025-01-15
+ *
+ * Nothing runs in the background. Every driver call first advances the
+ * model to the current time: the frame at the head of the TX queue gets
+ * the bus as soon as it is free, completes (or fails and retries) at the
+ * end of its on-wire time, and injected frames arrive when their turn on
+ * the bus ends. Blocking calls sleep until the next scheduled event or a
+ * state change from another thread, so a real receive task waiting in
+ * twai_read_alerts() sees alerts at the time the bus would raise them.
+ */
+
+#include "driver/twai.h"
+#include "esp_timer.h"
+#include "../../src/modules/can/can_bus_load.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t APB_CLOCK_HZ = 80000000;
+constexpr uint32_t ERROR_PASSIVE_LIMIT = 128;
+constexpr uint32_t BUS_OFF_LIMIT = 256;
+constexpr uint32_t RECOVERY_BITS = 128 * 11;
+
+struct BusFrame {
+    twai_message_t message;
+    uint64_t doneAt;
+};
+
+struct Emulator {
+    std::mutex lock;
+    std::condition_variable changed;
+
+    // Host controls
+    float timeScale = 1.0f;
+    bool acknowledge = true;
+    twai_host_tx_hook_t hook = nullptr;
+    void* hookContext = nullptr;
+    uint32_t arbitrationLossPending = 0;
+    uint32_t busErrorsPending = 0;
+
+    // Driver
+    bool installed = false;
+    twai_state_t state = TWAI_STATE_STOPPED;
+    twai_mode_t mode = TWAI_MODE_NORMAL;
+    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    uint32_t bitrate = 500000;
+    size_t rxDepth = 0;
+    size_t txDepth = 0;
+    uint32_t alertsEnabled = 0;
+    uint32_t alerts = 0;
+    std::deque<twai_message_t> rxQueue;
+    std::deque<twai_message_t> txQueue;
+    twai_status_info_t counters = {};
+
+    // Bus
+    uint64_t busFreeAt = 0;         // Host time the current frame leaves the bus
+    uint64_t headReadyAt = 0;       // Host time the TX head may start
+    bool txOnBus = false;
+    uint64_t txDoneAt = 0;
+    std::deque<BusFrame> incoming;
+    uint64_t recoveryDoneAt = 0;
+    uint64_t busTimeUs = 0;
+    uint32_t framesOnBus = 0;
+    std::vector<twai_message_t> completed;     // For the hook, called unlocked
+};
+
+Emulator emulator;
+
+uint64_t now() {
+    return static_cast<uint64_t>(esp_timer_get_time());
+}
+
+uint32_t wireTimeUs(const twai_message_t& message, uint32_t bitrate) {
+    uint16_t bits = CANBusLoadMeter::frameBits(message.extd, message.data_length_code > 8 ? 8 : message.data_length_code,
+                                          message.rtr, CANStuffingModel::EXPECTED);
+    return static_cast<uint32_t>((static_cast<uint64_t>(bits) * 1000000 + bitrate - 1) / bitrate);
+}
+
+uint64_t scaled(Emulator& e, uint32_t busUs) {
+    return static_cast<uint64_t>(busUs * e.timeScale);
+}
+
+void raise(Emulator& e, uint32_t alert) {
+    e.alerts |= alert;
+}
+
+bool filterAccepts(const twai_filter_config_t& filter, const twai_message_t& message) {
+    const uint32_t code = filter.acceptance_code;
+    const uint32_t care = ~filter.acceptance_mask;
+    const uint32_t rtr = message.rtr ? 1 : 0;
+    const uint8_t dlc = message.rtr ? 0 : message.data_length_code;
+
+    if (filter.single_filter) {
+        uint32_t bits;
+        uint32_t relevant;
+        if (message.extd) {
+            bits = (message.identifier << 3) | (rtr << 2);
+            relevant = 0xFFFFFFFC;
+        } else {
+            bits = (message.identifier << 21) | (rtr << 20) |
+                   (static_cast<uint32_t>(message.data[0]) << 8) | message.data[1];
+            // Data bytes the frame does not carry are not compared
+            relevant = 0xFFF00000 | (dlc > 0 ? 0xFF00 : 0) | (dlc > 1 ? 0x00FF : 0);
+        }
+        return ((bits ^ code) & care & relevant) == 0;
+    }
+
+    if (message.extd) {
+        uint32_t upper = (message.identifier >> 13) & 0xFFFF;
+        bool first = (((upper << 16) ^ code) & care & 0xFFFF0000) == 0;
+        bool second = ((upper ^ code) & care & 0x0000FFFF) == 0;
+        return first || second;
+    }
+    uint32_t firstBits = (message.identifier << 21) | (rtr << 20) |
+                         (static_cast<uint32_t>(message.data[0] >> 4) << 16) | (message.data[0] & 0x0F);
+    uint32_t firstRelevant = 0xFFF00000 | (dlc > 0 ? 0x000F000F : 0);
+    uint32_t secondBits = (message.identifier << 5) | (rtr << 4);
+    bool first = ((firstBits ^ code) & care & firstRelevant) == 0;
+    bool second = ((secondBits ^ code) & care & 0x0000FFF0) == 0;
+    return first || second;
+}
+
+void receive(Emulator& e, const twai_message_t& message) {
+    if (e.state != TWAI_STATE_RUNNING || !filterAccepts(e.filter, message)) {
+        return;
+    }
+    if (e.counters.rx_error_counter > 0) {
+        e.counters.rx_error_counter--;
+    }
+    if (e.rxQueue.size() >= e.rxDepth) {
+        e.counters.rx_missed_count++;
+        raise(e, TWAI_ALERT_RX_QUEUE_FULL);
+        return;
+    }
+    twai_message_t stored = message;
+    stored.ss = 0;
+    stored.self = 0;
+    e.rxQueue.push_back(stored);
+    raise(e, TWAI_ALERT_RX_DATA);
+}
+
+void enterBusOff(Emulator& e) {
+    e.state = TWAI_STATE_BUS_OFF;
+    e.counters.tx_error_counter = BUS_OFF_LIMIT;
+    e.counters.tx_failed_count += static_cast<uint32_t>(e.txQueue.size());
+    e.txQueue.clear();
+    e.txOnBus = false;
+    raise(e, TWAI_ALERT_BUS_OFF);
+}
+
+void finishHead(Emulator& e, uint64_t at, bool success) {
+    twai_message_t message = e.txQueue.front();
+    e.txQueue.pop_front();
+    e.headReadyAt = at;
+    if (!success) {
+        e.counters.tx_failed_count++;
+        raise(e, TWAI_ALERT_TX_FAILED);
+        return;
+    }
+    if (e.counters.tx_error_counter > 0) {
+        e.counters.tx_error_counter--;
+    }
+    e.framesOnBus++;
+    raise(e, TWAI_ALERT_TX_SUCCESS);
+    if (e.txQueue.empty()) {
+        raise(e, TWAI_ALERT_TX_IDLE);
+    }
+    if (message.self) {
+        receive(e, message);
+    }
+    e.completed.push_back(message);
+}
+
+// Transmit error: +8 TEC, bus-off at 256, retry unless single shot
+void transmitError(Emulator& e, uint64_t at, uint32_t busUs, bool acknowledgeError) {
+    e.counters.bus_error_count++;
+    raise(e, TWAI_ALERT_BUS_ERROR);
+    // An error passive node does not count acknowledge errors (ISO 11898-1)
+    if (!acknowledgeError || e.counters.tx_error_counter < ERROR_PASSIVE_LIMIT) {
+        e.counters.tx_error_counter += 8;
+        if (e.counters.tx_error_counter >= ERROR_PASSIVE_LIMIT &&
+            e.counters.tx_error_counter - 8 < ERROR_PASSIVE_LIMIT) {
+            raise(e, TWAI_ALERT_ERR_PASS);
+        }
+    }
+    if (e.counters.tx_error_counter >= BUS_OFF_LIMIT) {
+        enterBusOff(e);
+        return;
+    }
+    if (e.txQueue.front().ss) {
+        finishHead(e, at, false);
+        return;
+    }
+    // Retries pace at bus speed even on an instant bus, so they cannot spin
+    raise(e, TWAI_ALERT_TX_RETRIED);
+    e.headReadyAt = at + (busUs > 0 ? busUs : 1);
+}
+
+void completeTransmit(Emulator& e, uint64_t at) {
+    e.txOnBus = false;
+    const twai_message_t& message = e.txQueue.front();
+    uint32_t busUs = wireTimeUs(message, e.bitrate);
+    e.busTimeUs += busUs;
+
+    if (e.arbitrationLossPending > 0) {
+        e.arbitrationLossPending--;
+        e.counters.arb_lost_count++;
+        raise(e, TWAI_ALERT_ARB_LOST);
+        if (message.ss) {
+            finishHead(e, at, false);
+        } else {
+            e.headReadyAt = at;
+        }
+        return;
+    }
+    if (e.busErrorsPending > 0) {
+        e.busErrorsPending--;
+        transmitError(e, at, busUs, false);
+        return;
+    }
+    if (e.mode == TWAI_MODE_NORMAL && !e.acknowledge) {
+        transmitError(e, at, busUs, true);
+        return;
+    }
+    finishHead(e, at, true);
+}
+
+// Run every bus event due by time; caller holds the lock
+bool advance(Emulator& e, uint64_t time) {
+    bool processed = false;
+    for (;;) {
+        if (e.state == TWAI_STATE_RUNNING && !e.txOnBus && !e.txQueue.empty()) {
+            uint64_t start = e.headReadyAt > e.busFreeAt ? e.headReadyAt : e.busFreeAt;
+            e.txDoneAt = start + scaled(e, wireTimeUs(e.txQueue.front(), e.bitrate));
+            e.busFreeAt = e.txDoneAt;
+            e.txOnBus = true;
+        }
+
+        uint64_t next = UINT64_MAX;
+        int kind = 0;
+        if (e.txOnBus) {
+            next = e.txDoneAt;
+            kind = 1;
+        }
+        if (!e.incoming.empty() && e.incoming.front().doneAt < next) {
+            next = e.incoming.front().doneAt;
+            kind = 2;
+        }
+        if (e.state == TWAI_STATE_RECOVERING && e.recoveryDoneAt < next) {
+            next = e.recoveryDoneAt;
+            kind = 3;
+        }
+        if (kind == 0 || next > time) {
+            return processed;
+        }
+        processed = true;
+
+        if (kind == 1) {
+            completeTransmit(e, next);
+        } else if (kind == 2) {
+            BusFrame frame = e.incoming.front();
+            e.incoming.pop_front();
+            e.busTimeUs += wireTimeUs(frame.message, e.bitrate);
+            e.framesOnBus++;
+            receive(e, frame.message);
+        } else {
+            // Like the IDF driver, a recovered controller waits for twai_start()
+            e.state = TWAI_STATE_STOPPED;
+            e.counters.tx_error_counter = 0;
+            e.counters.rx_error_counter = 0;
+            raise(e, TWAI_ALERT_BUS_RECOVERED);
+        }
+    }
+}
+
+uint64_t nextEventAt(Emulator& e) {
+    uint64_t next = UINT64_MAX;
+    if (e.txOnBus) {
+        next = e.txDoneAt;
+    } else if (e.state == TWAI_STATE_RUNNING && !e.txQueue.empty()) {
+        next = e.headReadyAt;
+    }
+    if (!e.incoming.empty() && e.incoming.front().doneAt < next) {
+        next = e.incoming.front().doneAt;
+    }
+    if (e.state == TWAI_STATE_RECOVERING && e.recoveryDoneAt < next) {
+        next = e.recoveryDoneAt;
+    }
+    return next;
+}
+
+// Hand completed frames to the hook with the lock released; the hook may inject
+void runHook(Emulator& e, std::unique_lock<std::mutex>& guard) {
+    if (e.hook == nullptr || e.completed.empty()) {
+        e.completed.clear();
+        return;
+    }
+    std::vector<twai_message_t> frames;
+    frames.swap(e.completed);
+    twai_host_tx_hook_t hook = e.hook;
+    void* context = e.hookContext;
+    guard.unlock();
+    for (const twai_message_t& message : frames) {
+        hook(message, context);
+    }
+    guard.lock();
+}
+
+// Advance and sleep until ready() holds or the timeout passes
+template <typename Ready>
+bool waitFor(Emulator& e, std::unique_lock<std::mutex>& guard, TickType_t ticks, Ready ready) {
+    uint64_t deadline = ticks == portMAX_DELAY ? UINT64_MAX : now() + static_cast<uint64_t>(ticks) * 1000;
+    for (;;) {
+        // Other waiters may be asleep on an event this thread just ran
+        bool processed = advance(e, now());
+        if (!e.completed.empty()) {
+            runHook(e, guard);
+            advance(e, now());
+            processed = true;
+        }
+        if (processed) {
+            e.changed.notify_all();
+        }
+        if (ready()) {
+            return true;
+        }
+        uint64_t current = now();
+        if (current >= deadline || !e.installed) {
+            return false;
+        }
+        uint64_t wakeAt = nextEventAt(e);
+        if (wakeAt > deadline) {
+            wakeAt = deadline;
+        }
+        uint64_t sleepUs = wakeAt > current ? wakeAt - current : 0;
+        if (sleepUs > 0) {
+            // Bounded so an infinite timeout still notices uninstall
+            if (sleepUs > 100000) {
+                sleepUs = 100000;
+            }
+            e.changed.wait_for(guard, std::chrono::microseconds(sleepUs));
+        }
+    }
+}
+
+} // namespace
+
+// ===== IDF DRIVER CALLS =====
+
+esp_err_t twai_driver_install(const twai_general_config_t* g_config, const twai_timing_config_t* t_config,
+                              const twai_filter_config_t* f_config) {
+    if (g_config == nullptr || t_config == nullptr || f_config == nullptr ||
+        t_config->brp == 0 || g_config->rx_queue_len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    if (e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    e.installed = true;
+    e.state = TWAI_STATE_STOPPED;
+    e.mode = g_config->mode;
+    e.filter = *f_config;
+    e.bitrate = APB_CLOCK_HZ / (t_config->brp * (1 + t_config->tseg_1 + t_config->tseg_2));
+    e.rxDepth = g_config->rx_queue_len;
+    e.txDepth = g_config->tx_queue_len;
+    e.alertsEnabled = g_config->alerts_enabled;
+    e.alerts = 0;
+    e.rxQueue.clear();
+    e.txQueue.clear();
+    e.incoming.clear();
+    e.counters = twai_status_info_t();
+    e.txOnBus = false;
+    e.busFreeAt = now();
+    e.headReadyAt = e.busFreeAt;
+    e.busTimeUs = 0;
+    e.framesOnBus = 0;
+    e.completed.clear();
+    return ESP_OK;
+}
+
+esp_err_t twai_driver_uninstall() {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed || (e.state != TWAI_STATE_STOPPED && e.state != TWAI_STATE_BUS_OFF)) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        e.installed = false;
+        e.state = TWAI_STATE_STOPPED;
+    }
+    e.changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t twai_start() {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed || e.state != TWAI_STATE_STOPPED) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        // Start clears queues and counters, as the IDF driver does
+        e.rxQueue.clear();
+        e.txQueue.clear();
+        e.incoming.clear();
+        e.txOnBus = false;
+        e.counters.tx_error_counter = 0;
+        e.counters.rx_error_counter = 0;
+        e.busFreeAt = now();
+        e.headReadyAt = e.busFreeAt;
+        e.state = TWAI_STATE_RUNNING;
+    }
+    e.changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t twai_stop() {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed || e.state != TWAI_STATE_RUNNING) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        advance(e, now());
+        e.txQueue.clear();
+        e.txOnBus = false;
+        e.state = TWAI_STATE_STOPPED;
+    }
+    e.changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t twai_transmit(const twai_message_t* message, TickType_t ticks_to_wait) {
+    if (message == nullptr || message->data_length_code > 8 ||
+        (message->extd ? message->identifier > 0x1FFFFFFF : message->identifier > 0x7FF)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Emulator& e = emulator;
+    std::unique_lock<std::mutex> guard(e.lock);
+    if (!e.installed || e.state != TWAI_STATE_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (e.mode == TWAI_MODE_LISTEN_ONLY || e.txDepth == 0) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    bool room = waitFor(e, guard, ticks_to_wait, [&e] {
+        return e.state != TWAI_STATE_RUNNING || e.txQueue.size() < e.txDepth;
+    });
+    if (!room) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (e.state != TWAI_STATE_RUNNING) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (e.txQueue.empty() && !e.txOnBus) {
+        e.headReadyAt = now();
+    }
+    e.txQueue.push_back(*message);
+    guard.unlock();
+    e.changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t twai_receive(twai_message_t* message, TickType_t ticks_to_wait) {
+    if (message == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Emulator& e = emulator;
+    std::unique_lock<std::mutex> guard(e.lock);
+    if (!e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!waitFor(e, guard, ticks_to_wait, [&e] { return !e.rxQueue.empty(); })) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *message = e.rxQueue.front();
+    e.rxQueue.pop_front();
+    return ESP_OK;
+}
+
+esp_err_t twai_read_alerts(uint32_t* alerts, TickType_t ticks_to_wait) {
+    if (alerts == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Emulator& e = emulator;
+    std::unique_lock<std::mutex> guard(e.lock);
+    if (!e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool raised = waitFor(e, guard, ticks_to_wait, [&e] { return (e.alerts & e.alertsEnabled) != 0; });
+    *alerts = e.alerts & e.alertsEnabled;
+    e.alerts = 0;
+    return raised ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t twai_reconfigure_alerts(uint32_t alerts_enabled, uint32_t* current_alerts) {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    if (!e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (current_alerts != nullptr) {
+        *current_alerts = e.alerts & e.alertsEnabled;
+    }
+    e.alertsEnabled = alerts_enabled;
+    e.alerts = 0;
+    return ESP_OK;
+}
+
+esp_err_t twai_initiate_recovery() {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed || e.state != TWAI_STATE_BUS_OFF) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        // 128 occurrences of 11 recessive bits
+        e.state = TWAI_STATE_RECOVERING;
+        e.recoveryDoneAt = now() + scaled(e, static_cast<uint32_t>(
+            static_cast<uint64_t>(RECOVERY_BITS) * 1000000 / e.bitrate));
+        raise(e, TWAI_ALERT_RECOVERY_IN_PROGRESS);
+    }
+    e.changed.notify_all();
+    return ESP_OK;
+}
+
+esp_err_t twai_get_status_info(twai_status_info_t* status_info) {
+    if (status_info == nullptr) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    if (!e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    advance(e, now());
+    *status_info = e.counters;
+    status_info->state = e.state;
+    status_info->msgs_to_tx = static_cast<uint32_t>(e.txQueue.size());
+    status_info->msgs_to_rx = static_cast<uint32_t>(e.rxQueue.size());
+    return ESP_OK;
+}
+
+esp_err_t twai_clear_transmit_queue() {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    if (!e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // The frame on the bus finishes; the rest are dropped
+    while (e.txQueue.size() > (e.txOnBus ? 1u : 0u)) {
+        e.txQueue.pop_back();
+    }
+    return ESP_OK;
+}
+
+esp_err_t twai_clear_receive_queue() {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    if (!e.installed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    e.rxQueue.clear();
+    return ESP_OK;
+}
+
+// ===== HOST EMULATOR CONTROL =====
+
+void twai_host_reset() {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    e.timeScale = 1.0f;
+    e.acknowledge = true;
+    e.hook = nullptr;
+    e.hookContext = nullptr;
+    e.arbitrationLossPending = 0;
+    e.busErrorsPending = 0;
+}
+
+void twai_host_set_time_scale(float scale) {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    e.timeScale = scale < 0.0f ? 0.0f : scale;
+}
+
+void twai_host_set_acknowledge(bool acknowledge) {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        e.acknowledge = acknowledge;
+    }
+    e.changed.notify_all();
+}
+
+void twai_host_set_tx_hook(twai_host_tx_hook_t hook, void* context) {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    e.hook = hook;
+    e.hookContext = context;
+}
+
+bool twai_host_inject(const twai_message_t& message) {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed) {
+            return false;
+        }
+        uint64_t current = now();
+        advance(e, current);
+        uint64_t start = e.busFreeAt > current ? e.busFreeAt : current;
+        BusFrame frame;
+        frame.message = message;
+        frame.doneAt = start + scaled(e, wireTimeUs(message, e.bitrate));
+        e.busFreeAt = frame.doneAt;
+        e.incoming.push_back(frame);
+    }
+    e.changed.notify_all();
+    return true;
+}
+
+void twai_host_inject_bus_off() {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed || e.state != TWAI_STATE_RUNNING) {
+            return;
+        }
+        advance(e, now());
+        enterBusOff(e);
+    }
+    e.changed.notify_all();
+}
+
+void twai_host_inject_rx_overrun(uint32_t frames) {
+    Emulator& e = emulator;
+    {
+        std::lock_guard<std::mutex> guard(e.lock);
+        if (!e.installed || frames == 0) {
+            return;
+        }
+        e.counters.rx_overrun_count += frames;
+        raise(e, TWAI_ALERT_RX_FIFO_OVERRUN);
+    }
+    e.changed.notify_all();
+}
+
+void twai_host_inject_arbitration_loss(uint32_t count) {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    e.arbitrationLossPending += count;
+}
+
+void twai_host_inject_bus_errors(uint32_t count) {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    e.busErrorsPending += count;
+}
+
+uint64_t twai_host_bus_time_us() {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    advance(e, now());
+    return e.busTimeUs;
+}
+
+uint32_t twai_host_frames_on_bus() {
+    Emulator& e = emulator;
+    std::lock_guard<std::mutex> guard(e.lock);
+    advance(e, now());
+    return e.framesOnBus;
+}
@@ -0,0 +1,289 @@
+/*
+ * Test automatic CAN bitrate detection
+ * Runs CANAutoBaud the way CANInterface::detectSpeed() does against a
+ * simulated bus: broadcast traffic at each bitrate and frame period, with
+ * the detector starting at a random phase and from a wrong preferred speed.
+ * A controller at the wrong bitrate reports a bus error early in the first
+ * frame it sees. At the right bitrate it receives the frame. Either way it
+ * first needs 11 recessive bits to integrate. Also covers a silent bus that
+ * an ECU acknowledges (active probe), a dead bus (timeout) and a bus that
+ * errors at every bitrate. The bench compares time-to-lock with the manual
+ * way: setSpeed() + reset(), listen 250 ms, try the next speed.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/test_can_autobaud.cpp src/modules/can/can_autobaud.cpp -o test_can_autobaud
+ *   ./test_can_autobaud
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "../src/modules/can/can_autobaud.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static uint32_t bitrateOf(CANSpeed speed) {
+  switch (speed) {
+    case CANSpeed::CAN_125KBPS: return 125000;
+    case CANSpeed::CAN_250KBPS: return 250000;
+    case CANSpeed::CAN_1MBPS:   return 1000000;
+    default:                    return 500000;
+  }
+}
+
+// ===== SIMULATED BUS =====
+
+enum class SimEvent { NONE, FRAME, ERROR, ACK };
+
+const uint64_t NEVER = UINT64_MAX;
+const uint64_t RECONFIGURE_US = 500;    // Driver uninstall + install + start
+const uint32_t FRAME_BITS = 111;        // 8-byte standard frame with stuffing
+
+struct SimBus {
+  uint32_t bitrate = 500000;
+  uint64_t periodUs = 10000;            // 0: silent
+  uint64_t phaseUs = 0;
+  bool ecuAcks = false;                 // Silent bus with an ECU that answers
+  bool noisy = false;                   // Errors at every bitrate
+
+  // Current controller configuration
+  uint32_t rate = 0;
+  bool listenOnly = true;
+  uint64_t nextFrameStart = NEVER;
+  uint64_t probeDone = NEVER;
+
+  uint64_t frameUs() const { return FRAME_BITS * 1000000ULL / bitrate; }
+  static uint64_t bitsUs(uint32_t bits, uint32_t r) { return bits * 1000000ULL / r; }
+
+  uint64_t frameStartAtOrAfter(uint64_t t) const {
+    if (periodUs == 0) return NEVER;
+    if (t <= phaseUs) return phaseUs;
+    uint64_t k = (t - phaseUs + periodUs - 1) / periodUs;
+    return phaseUs + k * periodUs;
+  }
+
+  void configure(CANSpeed speed, CANMode mode, uint64_t now) {
+    rate = bitrateOf(speed);
+    listenOnly = mode == CANMode::LISTEN_ONLY;
+    probeDone = NEVER;
+    // Integrate: 11 recessive bits at our rate, restarting after any frame
+    uint64_t t = now;
+    while (true) {
+      uint64_t start = frameStartAtOrAfter(t > frameUs() ? t - frameUs() : 0);
+      if (start != NEVER && start < t && start + frameUs() > t) t = start + frameUs();
+      uint64_t integrated = t + bitsUs(11, rate);
+      uint64_t next = frameStartAtOrAfter(t);
+      if (next == NEVER || next >= integrated) {
+        nextFrameStart = frameStartAtOrAfter(integrated);
+        break;
+      }
+      t = next + frameUs();
+    }
+  }
+
+  void sendProbe(uint64_t now) {
+    probeDone = now + bitsUs(FRAME_BITS, rate);
+  }
+
+  // Next alert and when it fires
+  SimEvent next(uint64_t& when) const {
+    when = NEVER;
+    SimEvent event = SimEvent::NONE;
+    if (nextFrameStart != NEVER) {
+      bool clean = rate == bitrate && !noisy;
+      when = nextFrameStart + (clean ? frameUs() : bitsUs(12, std::min(rate, bitrate)));
+      event = clean ? SimEvent::FRAME : SimEvent::ERROR;
+    }
+    if (probeDone < when) {
+      when = probeDone;
+      event = ecuAcks && rate == bitrate ? SimEvent::ACK : SimEvent::ERROR;
+    }
+    return event;
+  }
+
+  void consume(SimEvent event) {
+    if (event == SimEvent::ACK || (event == SimEvent::ERROR && probeDone != NEVER && probeDone <= nextFrameStart)) {
+      probeDone = NEVER;
+    } else {
+      nextFrameStart = frameStartAtOrAfter(nextFrameStart + 1);
+    }
+  }
+};
+
+struct Result {
+  bool locked;
+  CANSpeed speed;
+  uint32_t lockMs;
+  uint16_t switches;
+};
+
+// Mirrors CANInterface::detectSpeed(): poll, reconfigure, wait for alerts
+static Result detect(SimBus& bus, CANSpeed preferred, uint32_t timeoutMs = CAN_AUTOBAUD_TIMEOUT_MS,
+                     bool allowProbe = true) {
+  CANAutoBaud detector;
+  uint64_t t = 0;
+  detector.begin(0, preferred, timeoutMs, allowProbe);
+  while (true) {
+    CANAutoBaudAction action = detector.poll(t / 1000);
+    if (action == CANAutoBaudAction::DONE) break;
+    if (action == CANAutoBaudAction::CONFIGURE) {
+      t += RECONFIGURE_US;
+      bus.configure(detector.getCandidate(), detector.getCandidateMode(), t);
+      detector.onConfigured(t / 1000);
+      continue;
+    }
+    if (action == CANAutoBaudAction::PROBE) bus.sendProbe(t);
+
+    uint64_t when;
+    SimEvent event = bus.next(when);
+    if (event != SimEvent::NONE && when <= t + CAN_AUTOBAUD_POLL_MS * 1000) {
+      t = std::max(t, when);
+      bus.consume(event);
+      if (event == SimEvent::FRAME) detector.onFrame();
+      if (event == SimEvent::ERROR) detector.onBusError();
+      if (event == SimEvent::ACK) detector.onProbeAcknowledged();
+    } else {
+      t += CAN_AUTOBAUD_POLL_MS * 1000;
+    }
+  }
+  return {detector.getState() == CANAutoBaudState::LOCKED, detector.getLockedSpeed(),
+          detector.getLockTimeMs(), detector.getSwitches()};
+}
+
+// Old way: setSpeed() + reset() per speed in enum order, 250 ms listen each
+static Result detectManually(SimBus& bus) {
+  const CANSpeed order[] = {CANSpeed::CAN_125KBPS, CANSpeed::CAN_250KBPS, CANSpeed::CAN_500KBPS, CANSpeed::CAN_1MBPS};
+  uint64_t t = 0;
+  for (uint16_t i = 0; i < 4; i++) {
+    t += RECONFIGURE_US;
+    bus.configure(order[i], CANMode::LISTEN_ONLY, t);
+    uint64_t end = t + 250000;
+    int frames = 0, errors = 0;
+    uint64_t when;
+    SimEvent event;
+    while ((event = bus.next(when)) != SimEvent::NONE && when <= end) {
+      bus.consume(event);
+      if (event == SimEvent::FRAME) frames++;
+      else errors++;
+    }
+    t = end;
+    if (frames > 0 && errors == 0) return {true, order[i], static_cast<uint32_t>(t / 1000), i};
+  }
+  return {false, CANSpeed::CAN_500KBPS, static_cast<uint32_t>(t / 1000), 4};
+}
+
+// ===== TESTS =====
+
+static const CANSpeed SPEEDS[] = {CANSpeed::CAN_125KBPS, CANSpeed::CAN_250KBPS, CANSpeed::CAN_500KBPS, CANSpeed::CAN_1MBPS};
+
+static void testLocksOnEveryBitrate() {
+  for (CANSpeed actual : SPEEDS) {
+    for (CANSpeed preferred : SPEEDS) {
+      SimBus bus;
+      bus.bitrate = bitrateOf(actual);
+      bus.periodUs = 10000;
+      bus.phaseUs = 3700;
+      Result r = detect(bus, preferred);
+      CHECK(r.locked && r.speed == actual, "locks on the bus bitrate from any preferred speed");
+    }
+  }
+
+  SimBus bus;
+  bus.bitrate = 250000;
+  bus.periodUs = 5000;
+  Result r = detect(bus, CANSpeed::CAN_250KBPS);
+  CHECK(r.locked && r.switches == 0, "preferred speed right: no switching");
+  CHECK(r.lockMs <= 12, "preferred speed right: two frames and done");
+}
+
+static void testSilentBusProbe() {
+  SimBus bus;
+  bus.bitrate = 250000;
+  bus.periodUs = 0;
+  bus.ecuAcks = true;
+  Result r = detect(bus, CANSpeed::CAN_500KBPS);
+  CHECK(r.locked && r.speed == CANSpeed::CAN_250KBPS, "probe finds the ECU's bitrate");
+  CHECK(r.lockMs < 4 * CAN_AUTOBAUD_DWELL_MS + 4 * CAN_AUTOBAUD_PROBE_DWELL_MS,
+        "probe sweep follows a single listen sweep");
+
+  SimBus quiet = bus;
+  Result passive = detect(quiet, CANSpeed::CAN_500KBPS, CAN_AUTOBAUD_TIMEOUT_MS, false);
+  CHECK(!passive.locked, "no probe allowed: silent bus never locks");
+
+  SimBus dead;
+  dead.periodUs = 0;
+  Result none = detect(dead, CANSpeed::CAN_500KBPS, 600);
+  CHECK(!none.locked, "nobody acknowledges: fails");
+  CHECK(none.lockMs == 0, "failed detection reports no lock time");
+}
+
+static void testNoisyBus() {
+  SimBus bus;
+  bus.noisy = true;
+  Result r = detect(bus, CANSpeed::CAN_500KBPS, 300);
+  CHECK(!r.locked, "errors at every bitrate: no lock");
+  CHECK(r.switches > 8, "keeps sweeping (listen only, no probes) until the timeout");
+}
+
+// ===== TIME-TO-LOCK BENCH =====
+
+static void benchTimeToLock() {
+  const uint64_t periods[] = {1000, 10000, 50000};
+  printf("\nTime to lock, 200 random phases per cell, preferred speed wrong (ms)\n");
+  printf("%-10s %-8s %18s %18s\n", "bus", "period", "auto mean/max", "manual mean/max");
+
+  uint32_t worst = 0;
+  srand(1);
+  for (CANSpeed actual : SPEEDS) {
+    for (uint64_t period : periods) {
+      uint64_t autoSum = 0, manualSum = 0;
+      uint32_t autoMax = 0, manualMax = 0;
+      bool ok = true;
+      for (int run = 0; run < 200; run++) {
+        SimBus bus;
+        bus.bitrate = bitrateOf(actual);
+        bus.periodUs = period;
+        bus.phaseUs = rand() % period;
+        CANSpeed preferred = actual == CANSpeed::CAN_125KBPS ? CANSpeed::CAN_1MBPS : CANSpeed::CAN_125KBPS;
+        Result a = detect(bus, preferred);
+        SimBus again = bus;
+        Result m = detectManually(again);
+        ok = ok && a.locked && a.speed == actual && m.locked;
+        autoSum += a.lockMs;
+        manualSum += m.lockMs;
+        autoMax = std::max(autoMax, a.lockMs);
+        manualMax = std::max(manualMax, m.lockMs);
+      }
+      CHECK(ok, "every run locks on the right bitrate");
+      worst = std::max(worst, autoMax);
+      printf("%-10u %-8.0f %9.1f / %-6u %9.1f / %-6u\n", bitrateOf(actual), period / 1000.0,
+             autoSum / 200.0, autoMax, manualSum / 200.0, manualMax);
+    }
+  }
+  printf("Worst auto-baud lock: %u ms\n", worst);
+  CHECK(worst < 400, "lock well under a second even with 50 ms frame gaps");
+}
+
+int main() {
+  testLocksOnEveryBitrate();
+  testSilentBusProbe();
+  testNoisyBus();
+  benchTimeToLock();
+
+  if (failures > 0) {
+    printf("\n%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("\nAll CAN auto-baud tests passed\n");
+  return 0;
+}
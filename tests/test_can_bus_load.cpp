@@ -0,0 +1,238 @@
+/*
+ * Test sliding-window CAN bus load meter
+ * Checks the per-frame bit cost against frames serialized bit by bit (with
+ * CRC-15 and real stuffing), window and peak behaviour, and shows what the
+ * old lifetime-average estimate (111 bits x average rate) reported for the
+ * same traffic.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/test_can_bus_load.cpp src/modules/can/can_bus_load.cpp -o test_can_bus_load
+ *   ./test_can_bus_load
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include "../src/modules/can/can_bus_load.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static bool near(float a, float b, float tolerance) {
+  return fabsf(a - b) <= tolerance;
+}
+
+// ===== REFERENCE FRAME SERIALIZER =====
+
+static void pushBits(std::vector<uint8_t>& bits, uint32_t value, int count) {
+  for (int i = count - 1; i >= 0; i--) bits.push_back((value >> i) & 1);
+}
+
+// Stuffed bit count of a data frame, SOF through CRC, plus the fixed trailer
+static int serializedBits(const CANMessage& m) {
+  std::vector<uint8_t> bits;
+  bits.push_back(0);                                    // SOF
+  if (m.extd) {
+    pushBits(bits, m.id >> 18, 11);
+    bits.push_back(1);                                  // SRR
+    bits.push_back(1);                                  // IDE
+    pushBits(bits, m.id & 0x3FFFF, 18);
+    bits.push_back(m.rtr);
+    pushBits(bits, 0, 2);                               // r1, r0
+  } else {
+    pushBits(bits, m.id, 11);
+    bits.push_back(m.rtr);
+    bits.push_back(0);                                  // IDE
+    bits.push_back(0);                                  // r0
+  }
+  pushBits(bits, m.dlc, 4);
+  if (!m.rtr) {
+    for (int i = 0; i < m.dlc; i++) pushBits(bits, m.data[i], 8);
+  }
+
+  uint16_t crc = 0;
+  for (uint8_t b : bits) {
+    bool feedback = b ^ ((crc >> 14) & 1);
+    crc = (crc << 1) & 0x7FFF;
+    if (feedback) crc ^= 0x4599;
+  }
+  pushBits(bits, crc, 15);
+
+  int stuffed = 0, run = 0;
+  int last = -1;
+  for (uint8_t b : bits) {
+    if (b == last) {
+      run++;
+    } else {
+      last = b;
+      run = 1;
+    }
+    if (run == 5) {
+      stuffed++;
+      last = !last;                                     // Stuff bit starts the next run
+      run = 1;
+    }
+  }
+  return bits.size() + stuffed + 13;                    // CRC delim, ACK, EOF, IFS
+}
+
+static CANMessage randomFrame(bool extended, uint8_t dlc) {
+  CANMessage m;
+  m.extd = extended;
+  m.id = extended ? (rand() & 0x1FFFFFFF) : (rand() & 0x7FF);
+  m.dlc = dlc;
+  m.rtr = false;
+  for (int i = 0; i < 8; i++) m.data[i] = rand() & 0xFF;
+  return m;
+}
+
+// ===== TESTS =====
+
+static void testFrameBits() {
+  CHECK(CANBusLoadMeter::frameBits(false, 8, false, CANStuffingModel::NONE) == 111, "std 8 bytes unstuffed");
+  CHECK(CANBusLoadMeter::frameBits(false, 8, false, CANStuffingModel::WORST_CASE) == 135, "std 8 bytes worst case");
+  CHECK(CANBusLoadMeter::frameBits(true, 8, false, CANStuffingModel::NONE) == 131, "ext 8 bytes unstuffed");
+  CHECK(CANBusLoadMeter::frameBits(true, 8, false, CANStuffingModel::WORST_CASE) == 160, "ext 8 bytes worst case");
+  CHECK(CANBusLoadMeter::frameBits(false, 0, false, CANStuffingModel::NONE) == 47, "std empty frame");
+  CHECK(CANBusLoadMeter::frameBits(true, 8, true, CANStuffingModel::NONE) == 67, "remote frame has no data field");
+
+  // Against serialized frames: EXPECTED tracks the mean, WORST_CASE bounds every frame
+  printf("  %-10s %5s %10s %10s %10s %10s\n", "frame", "dlc", "measured", "expected", "worst", "max seen");
+  bool bounded = true, accurate = true;
+  for (int extended = 0; extended < 2; extended++) {
+    for (uint8_t dlc : {0, 2, 4, 8}) {
+      const int N = 20000;
+      double sum = 0;
+      int maxSeen = 0;
+      for (int i = 0; i < N; i++) {
+        int bits = serializedBits(randomFrame(extended, dlc));
+        sum += bits;
+        if (bits > maxSeen) maxSeen = bits;
+      }
+      double mean = sum / N;
+      int expected = CANBusLoadMeter::frameBits(extended, dlc, false, CANStuffingModel::EXPECTED);
+      int worst = CANBusLoadMeter::frameBits(extended, dlc, false, CANStuffingModel::WORST_CASE);
+      printf("  %-10s %5u %10.2f %10d %10d %10d\n", extended ? "extended" : "standard", dlc, mean,
+             expected, worst, maxSeen);
+      if (maxSeen > worst) bounded = false;
+      if (fabs(mean - expected) > 1.5) accurate = false;
+    }
+  }
+  CHECK(bounded, "no serialized frame exceeds the worst-case cost");
+  CHECK(accurate, "expected cost within 1.5 bits of the measured mean");
+  printf("  %-32s OK\n", "frame bit cost");
+}
+
+static void testSteadyLoad() {
+  CANBusLoadMeter meter(500000);
+  CANMessage m = randomFrame(false, 8);
+  uint32_t t = 1000;
+  for (int i = 0; i < 11000; i++, t += 1000) meter.recordFrame(m, t);  // 1 frame/ms for 11 s
+
+  float expected = CANBusLoadMeter::frameBits(false, 8, false, CANStuffingModel::EXPECTED) * 1000 * 100.0f / 500000;
+  CHECK(near(meter.getLoad(CANLoadWindow::WINDOW_100MS, t), expected, 0.5f), "100 ms window");
+  CHECK(near(meter.getLoad(CANLoadWindow::WINDOW_1S, t), expected, 0.3f), "1 s window");
+  CHECK(near(meter.getLoad(CANLoadWindow::WINDOW_10S, t), expected, 0.3f), "10 s window");
+  CHECK(near(meter.getPeak(CANLoadWindow::WINDOW_100MS), expected, 0.5f), "steady traffic peak");
+
+  // Partially filled window divides by the time covered, not the window
+  CANBusLoadMeter fresh(500000);
+  for (uint32_t u = 0; u < 300000; u += 1000) fresh.recordFrame(m, 5000 + u);
+  CHECK(near(fresh.getLoad(CANLoadWindow::WINDOW_10S, 305000), expected, 0.5f),
+        "young 10 s window reports the rate so far");
+
+  // Idle decay: windows empty, peak kept until reset
+  t += 11000000;
+  CHECK(meter.getLoad(CANLoadWindow::WINDOW_10S, t) == 0.0f, "idle bus decays to zero");
+  CHECK(meter.getPeak(CANLoadWindow::WINDOW_100MS) > 0.0f, "peak survives idle");
+  meter.resetPeaks();
+  CHECK(meter.getPeak(CANLoadWindow::WINDOW_100MS) == 0.0f, "peak reset");
+
+  // micros() wrap
+  CANBusLoadMeter wrapped(500000);
+  uint32_t w = 0xFFFFFFFFu - 500000;
+  for (int i = 0; i < 2000; i++, w += 1000) wrapped.recordFrame(m, w);
+  CHECK(near(wrapped.getLoad(CANLoadWindow::WINDOW_1S, w), expected, 0.3f), "load across micros() wrap");
+  // Idle for an hour (past the int32 half of the microsecond clock), then busy again
+  CANBusLoadMeter idle(500000);
+  uint32_t u = 1000;
+  for (int i = 0; i < 2000; i++, u += 1000) idle.recordFrame(m, u);
+  u += 3600u * 1000000u;
+  CHECK(idle.getLoad(CANLoadWindow::WINDOW_1S, u) == 0.0f, "idle hour reads 0 %");
+  for (int i = 0; i < 2000; i++, u += 1000) idle.recordFrame(m, u);
+  CHECK(near(idle.getLoad(CANLoadWindow::WINDOW_1S, u), expected, 0.3f), "windows move after an idle hour");
+  idle.recordFrame(m, u - 5000);
+  CHECK(near(idle.getLoad(CANLoadWindow::WINDOW_1S, u), expected, 0.5f), "late timestamp charged, not a jump");
+  printf("  %-32s OK (%.1f%% at 1 frame/ms)\n", "steady load / windows", expected);
+}
+
+static void testBurst() {
+  // 5 s of 20 Hz background, then a 60 ms back-to-back burst, then 2 s quiet
+  CANBusLoadMeter meter(500000);
+  CANMessage m = randomFrame(false, 8);
+  uint16_t bits = CANBusLoadMeter::frameBits(false, 8, false, CANStuffingModel::EXPECTED);
+  uint32_t frameUs = bits * 2;                              // 2 us per bit at 500 kbps
+  uint32_t t = 1000, count = 0;
+  for (; t < 5000000; t += 50000, count++) meter.recordFrame(m, t);
+  uint32_t burstEnd = t + 60000;
+  for (; t < burstEnd; t += frameUs, count++) meter.recordFrame(m, t);
+
+  float during100 = meter.getLoad(CANLoadWindow::WINDOW_100MS, t);
+  float during10s = meter.getLoad(CANLoadWindow::WINDOW_10S, t);
+  // Old estimate: lifetime average message rate x 111 bits
+  float old = count / (t / 1e6f) * 111 / 500000 * 100;
+
+  t += 2000000;
+  meter.getLoad(CANLoadWindow::WINDOW_100MS, t);            // Visit the boundaries after the burst
+  float peak = meter.getPeak(CANLoadWindow::WINDOW_100MS);
+
+  printf("  %-32s 100 ms %.1f%%, 10 s %.1f%%, peak %.1f%%, old estimate %.1f%%\n", "60 ms burst",
+         during100, during10s, peak, old);
+  CHECK(during100 > 55.0f, "100 ms window sees the burst");
+  CHECK(peak > 55.0f && peak <= 100.0f, "peak tracker keeps the burst");
+  CHECK(during10s < 15.0f, "10 s window smooths the burst");
+  CHECK(old < 5.0f, "lifetime average hides the burst");
+}
+
+static void testWorstCaseModel() {
+  CANBusLoadMeter expected(250000), worst(250000, CANStuffingModel::WORST_CASE);
+  CANMessage m = randomFrame(true, 8);
+  for (uint32_t t = 1000; t < 1001000; t += 2000) {
+    expected.recordFrame(m, t);
+    worst.recordFrame(m, t);
+  }
+  float e = expected.getLoad(CANLoadWindow::WINDOW_1S, 1001000);
+  float w = worst.getLoad(CANLoadWindow::WINDOW_1S, 1001000);
+  CHECK(w > e && near(w / e, 160.0f / 135.0f, 0.02f), "worst-case model charges worst-case stuffing");
+  CHECK(worst.availableBitsPerSecond(50.0f, 1001000) <
+        expected.availableBitsPerSecond(50.0f, 1001000), "worst-case model leaves less headroom");
+  CHECK(worst.availableBitsPerSecond(w - 1.0f, 1001000) == 0, "no headroom above target");
+  printf("  %-32s OK (expected %.1f%%, worst case %.1f%%)\n", "stuffing models", e, w);
+}
+
+int main() {
+  printf("Testing CAN bus load meter\n");
+  printf("==========================\n");
+
+  srand(1);
+  testFrameBits();
+  testSteadyLoad();
+  testBurst();
+  testWorstCaseModel();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nCAN bus load meter tests passed\n");
+  return 0;
+}
@@ -0,0 +1,234 @@
+/*
+ * Test CANFrameFanout: pooled frames shared by several consumers
+ *
+ * Checks reference counting, per-consumer drops and lag counters, runs a
+ * threaded stress with one stalled consumer (the others and the publisher
+ * must not notice), then compares publishing cost with one CANMessage
+ * copy per consumer.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 -Isrc tests/test_can_fanout.cpp src/modules/can/can_fanout.cpp -lpthread -o test_can_fanout
+ *   ./test_can_fanout
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "../src/modules/can/can_fanout.h"
+#include "../src/modules/can/can_ring_buffer.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static CANFrame makeFrame(uint32_t sequence) {
+  CANFrame frame;
+  frame.setId(0x100 + (sequence & 0xFF), false);
+  frame.dlc = 8;
+  for (int i = 0; i < 4; i++) frame.data[i] = static_cast<uint8_t>(sequence >> (8 * i));
+  for (int i = 4; i < 8; i++) frame.data[i] = 0;
+  frame.timestamp = sequence;
+  return frame;
+}
+
+static uint32_t sequenceOf(const CANFrame& frame) {
+  return frame.data[0] | (frame.data[1] << 8) | (frame.data[2] << 16) |
+         (static_cast<uint32_t>(frame.data[3]) << 24);
+}
+
+// ===== FUNCTIONAL =====
+
+static void testSharing() {
+  static CANFrameFanout fanout;
+  int poller = fanout.subscribe("poller");
+  int trace = fanout.subscribe("trace");
+  CHECK(poller >= 0 && trace >= 0 && fanout.getConsumerCount() == 2, "two subscribers");
+
+  CHECK(fanout.publish(makeFrame(1)) == 2, "published to both");
+  CHECK(fanout.getPoolInUse() == 1, "one pool slot for both consumers");
+
+  const CANFrame* a = fanout.acquire(poller);
+  CHECK(a != nullptr && sequenceOf(*a) == 1, "poller reads frame");
+  const CANFrame* b = fanout.acquire(trace);
+  CHECK(b == a, "trace reads the same slot, no copy");
+  fanout.release(poller);
+  CHECK(fanout.getPoolInUse() == 1, "slot kept while trace holds it");
+  fanout.release(trace);
+  CHECK(fanout.getPoolInUse() == 0, "last release frees the slot");
+  CHECK(fanout.acquire(poller) == nullptr, "queue empty");
+
+  // Fill the trace queue: it drops, the poller does not
+  for (uint32_t i = 0; i < CANFrameFanout::QUEUE_DEPTH + 5; i++) {
+    fanout.publish(makeFrame(100 + i));
+    fanout.acquire(poller);
+  }
+  fanout.release(poller);
+  CANFanoutStats stats;
+  CHECK(fanout.getStats(trace, stats), "trace stats");
+  CHECK(stats.dropped == 5 && stats.lag == CANFrameFanout::QUEUE_DEPTH, "trace drops its own overflow");
+  CHECK(stats.peakLag == CANFrameFanout::QUEUE_DEPTH, "trace peak lag");
+  CHECK(fanout.getStats(poller, stats), "poller stats");
+  CHECK(stats.dropped == 0 && stats.lag == 0 && stats.delivered == 1 + CANFrameFanout::QUEUE_DEPTH + 5,
+        "poller unaffected");
+  CHECK(fanout.getPoolInUse() == CANFrameFanout::QUEUE_DEPTH, "only trace's backlog is held");
+
+  // Oldest kept frames come out first
+  const CANFrame* frame = fanout.acquire(trace);
+  CHECK(frame != nullptr && sequenceOf(*frame) == 100, "trace resumes at its oldest frame");
+
+  fanout.resetStats(trace);
+  CHECK(fanout.getStats(trace, stats) && stats.dropped == 0 && stats.delivered == 0, "reset stats");
+
+  fanout.unsubscribe(trace);
+  CHECK(fanout.getPoolInUse() == 0, "unsubscribe releases the backlog");
+  CHECK(fanout.publish(makeFrame(2)) == 1, "remaining subscriber only");
+  fanout.unsubscribe(poller);
+  CHECK(fanout.getPoolInUse() == 0 && fanout.publish(makeFrame(3)) == 0, "no subscribers, no slot");
+
+  for (size_t i = 0; i < CANFrameFanout::MAX_CONSUMERS; i++) fanout.subscribe("c");
+  CHECK(fanout.subscribe("extra") == -1, "subscriber limit");
+  printf("  sharing                     refcount/drops/lag/unsubscribe OK\n");
+}
+
+// ===== STRESS =====
+
+static void testStalledConsumer() {
+  static CANFrameFanout fanout;
+  const uint32_t frames = 2000000;
+  int fast[2] = {fanout.subscribe("poller"), fanout.subscribe("trace")};
+  int stalled = fanout.subscribe("gateway");
+  std::atomic<bool> done(false);
+  std::atomic<bool> ordered(true);
+  std::atomic<uint32_t> received[2];
+  received[0] = 0;
+  received[1] = 0;
+
+  std::thread readers[2];
+  for (int r = 0; r < 2; r++) {
+    readers[r] = std::thread([&, r] {
+      uint32_t expected = 0;
+      for (;;) {
+        const CANFrame* frame = fanout.acquire(fast[r]);
+        if (frame == nullptr) {
+          if (done.load() && fanout.pending(fast[r]) == 0) break;
+          std::this_thread::yield();
+          continue;
+        }
+        uint32_t sequence = sequenceOf(*frame);
+        if (sequence < expected || frame->timestamp != sequence) ordered = false;
+        expected = sequence + 1;
+        received[r]++;
+      }
+      fanout.release(fast[r]);
+    });
+  }
+  // Gateway reads a frame now and then, far slower than the bus
+  std::thread slow([&] {
+    while (!done.load()) {
+      fanout.acquire(stalled);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    fanout.release(stalled);
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t published = 0;
+  for (uint32_t i = 0; i < frames; i++) {
+    // Pace like an RX burst so fast readers keep up on a loaded host
+    while (fanout.pending(fast[0]) > CANFrameFanout::QUEUE_DEPTH / 2 ||
+           fanout.pending(fast[1]) > CANFrameFanout::QUEUE_DEPTH / 2) {
+      std::this_thread::yield();
+    }
+    published += fanout.publish(makeFrame(i));
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  done = true;
+  readers[0].join();
+  readers[1].join();
+  slow.join();
+
+  CANFanoutStats stats[3];
+  fanout.getStats(fast[0], stats[0]);
+  fanout.getStats(fast[1], stats[1]);
+  fanout.getStats(stalled, stats[2]);
+  CHECK(received[0] == frames && received[1] == frames, "fast consumers get every frame");
+  CHECK(stats[0].dropped == 0 && stats[1].dropped == 0, "fast consumers drop nothing");
+  CHECK(ordered, "frames arrive intact and in order");
+  CHECK(stats[2].dropped > frames / 2, "stalled consumer drops its own frames");
+  CHECK(stats[2].delivered + stats[2].dropped + stats[2].lag == frames, "stalled consumer accounted");
+  CHECK(fanout.getPoolExhausted() == 0, "pool never ran dry");
+  CHECK(fanout.getPoolInUse() == stats[2].lag, "only the backlog stays referenced");
+  CHECK(published == 2ull * frames + stats[2].delivered + stats[2].lag, "publish count");
+
+  printf("  stalled consumer            %u frames in %.2f s; %s dropped %u, lag %u (peak %u); others 0\n",
+         frames, seconds, stats[2].name, stats[2].dropped, stats[2].lag, stats[2].peakLag);
+}
+
+// ===== BENCHMARK =====
+
+static void benchmark() {
+  const uint32_t frames = 1 << 20;
+  const int consumers = 3;
+
+  // Copy per consumer: each gets its own CANMessage ring
+  static CANRingBuffer<CANMessage, 64> copies[consumers];
+  auto start = std::chrono::steady_clock::now();
+  volatile uint32_t sink = 0;
+  for (uint32_t i = 0; i < frames; i++) {
+    CANFrame frame = makeFrame(i);
+    for (int c = 0; c < consumers; c++) {
+      CANMessage message;
+      frame.toMessage(message);
+      copies[c].push(message);
+      CANMessage out;
+      copies[c].pop(out);
+      sink = sink + out.data[0];
+    }
+  }
+  double copyNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+
+  static CANFrameFanout fanout;
+  int ids[consumers];
+  for (int c = 0; c < consumers; c++) ids[c] = fanout.subscribe("bench");
+  start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < frames; i++) {
+    fanout.publish(makeFrame(i));
+    for (int c = 0; c < consumers; c++) {
+      const CANFrame* frame = fanout.acquire(ids[c]);
+      sink = sink + frame->data[0];
+    }
+  }
+  double fanoutNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+  CHECK(fanout.getPoolExhausted() == 0, "bench pool never ran dry");
+
+  printf("\n  %d consumers, %u frames (publish + each consumer reads one)\n", consumers, frames);
+  printf("  %-34s %10s %12s\n", "path", "ns/frame", "bytes/frame");
+  printf("  %-34s %10.2f %12zu\n", "CANMessage copy per consumer", copyNs, consumers * sizeof(CANMessage));
+  printf("  %-34s %10.2f %12zu\n", "pooled CANFrame + handles", fanoutNs,
+         sizeof(CANFrame) + consumers * sizeof(uint16_t));
+}
+
+int main() {
+  printf("Testing CAN frame fan-out\n");
+  printf("=========================\n");
+
+  testSharing();
+  testStalledConsumer();
+  benchmark();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nCAN frame fan-out tests passed\n");
+  return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * Test CAN hardware acceptance filter compiler
+ * Checks that compiled TWAI code/mask pairs never drop wanted IDs, that the
+ * reported acceptance counts match the register model, and reports how many
+ * frames the hardware filter saves on a simulated bike bus.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/test_can_hw_filter.cpp src/modules/can/can_hw_filter.cpp -o test_can_hw_filter
+ *   ./test_can_hw_filter
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+#include "../src/modules/can/can_hw_filter.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static bool contains(const std::vector<uint32_t>& ids, uint32_t id) {
+  return std::find(ids.begin(), ids.end(), id) != ids.end();
+}
+
+// Brute-force every 11-bit ID through the register model
+static void verifyStandard(const char* name, const std::vector<uint32_t>& ids,
+                           const CANAcceptanceFilter& f) {
+  uint32_t accepted = 0;
+  bool superset = true;
+  for (uint32_t id = 0; id <= 0x7FF; id++) {
+    bool hw = CANFilterCompiler::hardwareAccepts(f, id, false);
+    if (hw) accepted++;
+    if (contains(ids, id) && !hw) superset = false;
+    if (contains(ids, id) && !CANFilterCompiler::hardwareAccepts(f, id, false, true)) superset = false;
+  }
+  printf("  %-28s %s code=0x%08X mask=0x%08X  hw passes %4u / wanted %3u%s\n",
+         name, f.singleFilter ? "SINGLE" : "DUAL  ", f.acceptanceCode, f.acceptanceMask,
+         accepted, f.requestedIds, f.exact ? " (exact)" : "");
+  CHECK(superset, "hardware filter dropped a wanted standard ID");
+  CHECK(accepted == f.hardwareAcceptedIds, "accepted count disagrees with register model");
+}
+
+static void testOBD2Whitelist() {
+  std::vector<uint32_t> ids = {0x7DF};
+  for (uint32_t i = 0; i < 8; i++) ids.push_back(0x7E8 + i);
+
+  CANFilter filter;
+  filter.type = CANFilterType::WHITELIST;
+  filter.whitelist = ids;
+  CANAcceptanceFilter f = CANFilterCompiler::compile(filter);
+  verifyStandard("OBD2 whitelist", ids, f);
+  CHECK(!f.singleFilter, "OBD2 whitelist should use dual filter mode");
+  CHECK(f.exact, "OBD2 whitelist should compile exactly");
+}
+
+static void testRandomStandard() {
+  srand(1234);
+  for (int round = 0; round < 200; round++) {
+    std::vector<uint32_t> ids;
+    int count = 1 + rand() % 20;
+    for (int i = 0; i < count; i++) ids.push_back(rand() & 0x7FF);
+    CANAcceptanceFilter f = CANFilterCompiler::compileIds(ids);
+
+    bool superset = true;
+    uint32_t accepted = 0;
+    for (uint32_t id = 0; id <= 0x7FF; id++) {
+      bool hw = CANFilterCompiler::hardwareAccepts(f, id, false);
+      accepted += hw;
+      if (contains(ids, id) && !hw) superset = false;
+    }
+    CHECK(superset, "random standard whitelist dropped a wanted ID");
+    CHECK(accepted == f.hardwareAcceptedIds, "random standard accepted count mismatch");
+  }
+  printf("  %-28s 200 random sets OK\n", "random 11-bit whitelists");
+}
+
+static void testRangeAndExtended() {
+  CANFilter range;
+  range.type = CANFilterType::RANGE;
+  range.rangeStart = 0x100;
+  range.rangeEnd = 0x1FF;
+  std::vector<uint32_t> rangeIds;
+  for (uint32_t id = 0x100; id <= 0x1FF; id++) rangeIds.push_back(id);
+  CANAcceptanceFilter f = CANFilterCompiler::compile(range);
+  verifyStandard("range 0x100-0x1FF", rangeIds, f);
+  CHECK(f.exact, "aligned range should compile exactly");
+
+  // 29-bit OBD2 responses 0x18DAF1xx for ECUs 0x00-0x07 plus functional request
+  std::vector<uint32_t> ext;
+  for (uint32_t ecu = 0; ecu < 8; ecu++) ext.push_back(0x18DAF100 | ecu);
+  CANAcceptanceFilter e = CANFilterCompiler::compileIds(ext);
+  CHECK(e.extended, "29-bit set should use extended layout");
+  CHECK(e.exact, "29-bit aligned set should compile exactly");
+  for (uint32_t id : ext) {
+    CHECK(CANFilterCompiler::hardwareAccepts(e, id, true), "extended ID dropped");
+  }
+  CHECK(!CANFilterCompiler::hardwareAccepts(e, 0x18DAF110, true), "extended filter too wide");
+  printf("  %-28s %s code=0x%08X mask=0x%08X  hw passes %4u / wanted %3u\n", "29-bit OBD2 responses",
+         e.singleFilter ? "SINGLE" : "DUAL  ", e.acceptanceCode, e.acceptanceMask,
+         e.hardwareAcceptedIds, e.requestedIds);
+
+  // Mixed 11/29-bit set must still pass everything wanted
+  std::vector<uint32_t> mixed = {0x7E8, 0x7E9, 0x18DAF100, 0x18DAF101};
+  CANAcceptanceFilter m = CANFilterCompiler::compileIds(mixed);
+  CHECK(!m.exact, "mixed filter can never be exact");
+  CHECK(CANFilterCompiler::hardwareAccepts(m, 0x7E8, false), "mixed dropped 0x7E8");
+  CHECK(CANFilterCompiler::hardwareAccepts(m, 0x7E9, false), "mixed dropped 0x7E9");
+  CHECK(CANFilterCompiler::hardwareAccepts(m, 0x18DAF100, true), "mixed dropped 0x18DAF100");
+  CHECK(CANFilterCompiler::hardwareAccepts(m, 0x18DAF101, true), "mixed dropped 0x18DAF101");
+
+  // Software-only filter types fall back to accept-all
+  CANFilter blacklist;
+  blacklist.type = CANFilterType::BLACKLIST;
+  blacklist.blacklist = {0x123};
+  CHECK(CANFilterCompiler::compile(blacklist).acceptsAll(), "blacklist must not reach hardware");
+  CANFilter disabled = range;
+  disabled.enabled = false;
+  CHECK(CANFilterCompiler::compile(disabled).acceptsAll(), "disabled filter must accept all");
+}
+
+// Simulated bike bus: broadcast traffic plus OBD2 responses, 10 s
+struct BusSource { uint32_t id; uint32_t hz; };
+
+static void reportBusSavings() {
+  const BusSource sources[] = {
+    {0x120, 100}, {0x129, 100}, {0x12A, 50}, {0x12B, 50}, {0x130, 50},
+    {0x290, 20}, {0x450, 10}, {0x540, 10}, {0x550, 5}, {0x650, 1},
+    {0x7E8, 40}, {0x7E9, 5}, {0x7DF, 0}
+  };
+  std::vector<uint32_t> obd2 = {0x7DF};
+  for (uint32_t i = 0; i < 8; i++) obd2.push_back(0x7E8 + i);
+  CANAcceptanceFilter f = CANFilterCompiler::compileIds(obd2);
+
+  uint32_t total = 0, hardwarePassed = 0, softwareRejects = 0;
+  for (const BusSource& src : sources) {
+    uint32_t frames = src.hz * 10;
+    total += frames;
+    if (CANFilterCompiler::hardwareAccepts(f, src.id, false)) {
+      hardwarePassed += frames;
+      if (!contains(obd2, src.id)) softwareRejects += frames;
+    }
+  }
+
+  uint32_t softwareOnlyRejects = 0;
+  for (const BusSource& src : sources) {
+    if (!contains(obd2, src.id)) softwareOnlyRejects += src.hz * 10;
+  }
+
+  printf("\nSimulated bike bus (10 s, %u frames):\n", total);
+  printf("  ACCEPT_ALL hardware: %u frames copied to CPU, %u software rejects\n",
+         total, softwareOnlyRejects);
+  printf("  Compiled hardware  : %u frames copied to CPU, %u software rejects\n",
+         hardwarePassed, softwareRejects);
+  printf("  Hardware filter saved %u frame copies (%.1f%%)\n",
+         total - hardwarePassed, 100.0 * (total - hardwarePassed) / total);
+  CHECK(softwareRejects == 0, "exact OBD2 filter should leave nothing for software");
+}
+
+int main() {
+  printf("Testing CAN hardware filter compiler\n");
+  printf("====================================\n");
+
+  testOBD2Whitelist();
+  testRandomStandard();
+  testRangeAndExtended();
+  reportBusSavings();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nCAN hardware filter tests passed\n");
+  return 0;
+}
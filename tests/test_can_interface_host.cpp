@@ -0,0 +1,872 @@
+/*
+ * Test CANInterface on the host against the emulated TWAI driver
+ *
+ * The first half checks the emulator itself (queue depths, filter, modes,
+ * error counting, recovery, injected faults, virtual bus clock), the
+ * second runs the unmodified CANInterface with its receive task: self
+ * test loopback, per-ID dispatch, frame fan-out, OBD2 request/response
+ * against an emulated ECU, bus-off recovery, throughput/latency benches
+ * on an instant and a real-time 500 kbit/s bus, and a broadcast storm
+ * against a slow consumer with and without receive load shedding.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 -DESP32 -Itests/host -Isrc tests/test_can_interface_host.cpp src/modules/can/can_interface.cpp src/modules/can/can_log.cpp src/modules/can/can_transport_twai.cpp src/modules/can/can_transport_loopback.cpp src/modules/can/can_autobaud.cpp src/modules/can/can_bus_load.cpp src/modules/can/can_dispatch.cpp src/modules/can/can_fanout.cpp src/modules/can/can_filter_engine.cpp src/modules/can/can_hw_filter.cpp src/modules/can/can_id_stats.cpp src/modules/can/can_latest.cpp src/modules/can/can_recovery.cpp src/modules/can/can_rx_admission.cpp src/modules/can/can_tx_scheduler.cpp src/modules/can/obd2_batch.cpp src/modules/can/slcan.cpp src/modules/obd2/obd2_pid_codec.cpp tests/host/host_runtime.cpp tests/host/host_twai.cpp -lpthread -o test_can_interface_host
+ *   ./test_can_interface_host
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "Arduino.h"
+#include "driver/twai.h"
+#include "../src/modules/can/can_interface.h"
+#include "../src/modules/can/can_bus_load.h"
+#include "../src/modules/can/can_transport_loopback.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+// ===== HELPERS =====
+
+static twai_message_t makeMessage(uint32_t id, uint8_t dlc, bool extended = false) {
+  twai_message_t message = {};
+  message.identifier = id;
+  message.extd = extended ? 1 : 0;
+  message.data_length_code = dlc;
+  for (uint8_t i = 0; i < dlc; i++) {
+    message.data[i] = static_cast<uint8_t>(id + i);
+  }
+  return message;
+}
+
+static bool install(twai_mode_t mode, uint32_t rxDepth, uint32_t txDepth,
+                    twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL()) {
+  twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(25, 26, mode);
+  general.rx_queue_len = rxDepth;
+  general.tx_queue_len = txDepth;
+  general.alerts_enabled = TWAI_ALERT_ALL;
+  twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+  return twai_driver_install(&general, &timing, &filter) == ESP_OK && twai_start() == ESP_OK;
+}
+
+static void uninstall() {
+  twai_status_info_t status;
+  if (twai_get_status_info(&status) == ESP_OK && status.state == TWAI_STATE_RUNNING) {
+    twai_stop();
+  }
+  twai_driver_uninstall();
+  twai_host_reset();
+}
+
+// Collect alerts for a while
+static uint32_t alertsWithin(uint32_t ms) {
+  uint32_t collected = 0;
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    uint32_t alerts = 0;
+    twai_read_alerts(&alerts, 1);
+    collected |= alerts;
+  }
+  return collected;
+}
+
+static uint32_t frameUs(const twai_message_t& message) {
+  // 500 kbit/s: 2 us per bit
+  return CANBusLoadMeter::frameBits(message.extd, message.data_length_code, message.rtr,
+                                    CANStuffingModel::EXPECTED) * 2;
+}
+
+// ===== EMULATOR TESTS =====
+
+static void testDriverStates() {
+  twai_message_t message = makeMessage(0x123, 8);
+  CHECK(twai_transmit(&message, 0) == ESP_ERR_INVALID_STATE, "transmit needs an installed driver");
+
+  twai_general_config_t general = TWAI_GENERAL_CONFIG_DEFAULT(25, 26, TWAI_MODE_NORMAL);
+  twai_timing_config_t timing = TWAI_TIMING_CONFIG_500KBITS();
+  twai_filter_config_t filter = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+  CHECK(twai_driver_install(&general, &timing, &filter) == ESP_OK, "install");
+  CHECK(twai_driver_install(&general, &timing, &filter) == ESP_ERR_INVALID_STATE, "no double install");
+  CHECK(twai_transmit(&message, 0) == ESP_ERR_INVALID_STATE, "transmit needs a started driver");
+  CHECK(twai_start() == ESP_OK, "start");
+  CHECK(twai_driver_uninstall() == ESP_ERR_INVALID_STATE, "uninstall refused while running");
+  CHECK(twai_stop() == ESP_OK, "stop");
+  CHECK(twai_driver_uninstall() == ESP_OK, "uninstall");
+  twai_host_reset();
+}
+
+static void testTransmitQueueDepth() {
+  CHECK(install(TWAI_MODE_NORMAL, 8, 2), "install");
+  twai_message_t message = makeMessage(0x321, 8);
+  CHECK(twai_transmit(&message, 0) == ESP_OK, "first frame queued");
+  CHECK(twai_transmit(&message, 0) == ESP_OK, "second frame queued");
+  CHECK(twai_transmit(&message, 0) == ESP_ERR_TIMEOUT, "full TX queue times out");
+  CHECK(twai_transmit(&message, 10) == ESP_OK, "room after the head completes");
+
+  uint32_t alerts = alertsWithin(10);
+  CHECK(alerts & TWAI_ALERT_TX_IDLE, "queue drained");
+  CHECK(twai_host_frames_on_bus() == 3, "three frames sent");
+  CHECK(twai_host_bus_time_us() == 3 * frameUs(message), "bus clock counts on-wire time");
+  uninstall();
+}
+
+static void testReceiveQueueDepth() {
+  CHECK(install(TWAI_MODE_NORMAL, 4, 4), "install");
+  twai_host_set_time_scale(0.0f);
+  for (int i = 0; i < 6; i++) {
+    twai_host_inject(makeMessage(0x100 + i, 8));
+  }
+  uint32_t alerts = 0;
+  twai_read_alerts(&alerts, 10);
+  twai_status_info_t status;
+  twai_get_status_info(&status);
+  CHECK(status.msgs_to_rx == 4, "RX queue holds its depth");
+  CHECK(status.rx_missed_count == 2, "excess frames missed");
+  CHECK(alerts & TWAI_ALERT_RX_QUEUE_FULL, "queue full alert");
+
+  twai_message_t received;
+  CHECK(twai_receive(&received, 0) == ESP_OK && received.identifier == 0x100, "oldest frame first");
+  uninstall();
+}
+
+static void testAcceptanceFilter() {
+  // Single filter on 0x7E8-0x7EF, RTR and data bytes don't care
+  twai_filter_config_t filter = {0x7E8u << 21, (0x007u << 21) | 0x001FFFFF, true};
+  CHECK(install(TWAI_MODE_NORMAL, 8, 4, filter), "install");
+  twai_host_set_time_scale(0.0f);
+  twai_host_inject(makeMessage(0x7E8, 8));
+  twai_host_inject(makeMessage(0x7DF, 8));
+  twai_host_inject(makeMessage(0x7EF, 3));
+  twai_host_inject(makeMessage(0x100, 0));
+
+  twai_message_t received;
+  CHECK(twai_receive(&received, 10) == ESP_OK && received.identifier == 0x7E8, "0x7E8 accepted");
+  CHECK(twai_receive(&received, 10) == ESP_OK && received.identifier == 0x7EF, "0x7EF accepted");
+  CHECK(twai_receive(&received, 0) == ESP_ERR_TIMEOUT, "others filtered");
+  CHECK(twai_host_frames_on_bus() == 4, "filtered frames still use the bus");
+  uninstall();
+}
+
+static void testModes() {
+  // Self reception with no other node on the bus
+  CHECK(install(TWAI_MODE_NO_ACK, 8, 4), "install no-ack");
+  twai_host_set_acknowledge(false);
+  twai_message_t message = makeMessage(0x7DF, 8);
+  message.self = 1;
+  CHECK(twai_transmit(&message, 0) == ESP_OK, "self test transmit");
+  twai_message_t received;
+  CHECK(twai_receive(&received, 10) == ESP_OK && received.identifier == 0x7DF &&
+        received.self == 0, "frame received by its sender");
+  uninstall();
+
+  // Normal mode without acknowledge: single shot fails after one attempt
+  CHECK(install(TWAI_MODE_NORMAL, 8, 4), "install normal");
+  twai_host_set_acknowledge(false);
+  message.self = 0;
+  message.ss = 1;
+  twai_transmit(&message, 0);
+  uint32_t alerts = alertsWithin(5);
+  twai_status_info_t status;
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_TX_FAILED, "single shot fails");
+  CHECK(status.tx_error_counter == 8 && status.tx_failed_count == 1, "one transmit error");
+  uninstall();
+
+  // Listen only never transmits but receives
+  CHECK(install(TWAI_MODE_LISTEN_ONLY, 8, 4), "install listen-only");
+  CHECK(twai_transmit(&message, 0) == ESP_ERR_NOT_SUPPORTED, "listen-only refuses transmit");
+  twai_host_inject(makeMessage(0x200, 2));
+  CHECK(twai_receive(&received, 10) == ESP_OK, "listen-only receives");
+  uninstall();
+}
+
+static void testErrorCounting() {
+  // A lone node retries forever at error passive, it never goes bus-off
+  CHECK(install(TWAI_MODE_NORMAL, 8, 4), "install");
+  twai_host_set_time_scale(0.0f);
+  twai_host_set_acknowledge(false);
+  twai_message_t message = makeMessage(0x7E0, 8);
+  twai_transmit(&message, 0);
+  uint32_t alerts = alertsWithin(30);
+  twai_status_info_t status;
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_ERR_PASS, "error passive reached");
+  CHECK(alerts & TWAI_ALERT_TX_RETRIED, "frame retried");
+  CHECK(status.state == TWAI_STATE_RUNNING, "no bus-off from ACK errors");
+  CHECK(status.tx_error_counter == 128, "TEC stops at error passive");
+  CHECK(status.bus_error_count > 16, "retries keep failing");
+
+  twai_host_set_acknowledge(true);
+  alerts = alertsWithin(5);
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_TX_SUCCESS, "frame acknowledged at last");
+  CHECK(status.tx_error_counter == 127, "success decrements TEC");
+  uninstall();
+
+  // Other bus errors do count: 32 of them put the node bus-off
+  CHECK(install(TWAI_MODE_NORMAL, 8, 4), "install");
+  twai_host_set_time_scale(0.0f);
+  twai_host_inject_bus_errors(32);
+  twai_transmit(&message, 0);
+  twai_transmit(&message, 0);
+  alerts = alertsWithin(30);
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_BUS_OFF, "bus-off alert");
+  CHECK(status.state == TWAI_STATE_BUS_OFF, "bus-off state");
+  CHECK(status.tx_failed_count == 2, "queued frames fail at bus-off");
+  CHECK(twai_transmit(&message, 0) == ESP_ERR_INVALID_STATE, "no transmit while bus-off");
+
+  // Recovery: 128 x 11 recessive bits, then stopped until started
+  twai_host_set_time_scale(1.0f);
+  unsigned long start = micros();
+  CHECK(twai_initiate_recovery() == ESP_OK, "recovery initiated");
+  alerts = 0;
+  while (!(alerts & TWAI_ALERT_BUS_RECOVERED) && micros() - start < 100000) {
+    uint32_t raised = 0;
+    twai_read_alerts(&raised, 10);
+    alerts |= raised;
+  }
+  unsigned long elapsed = micros() - start;
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_BUS_RECOVERED, "bus recovered");
+  CHECK(elapsed >= 128 * 11 * 2, "recovery takes 1408 bit times");
+  CHECK(status.state == TWAI_STATE_STOPPED && status.tx_error_counter == 0, "stopped with counters reset");
+  CHECK(twai_start() == ESP_OK, "restart after recovery");
+  uninstall();
+}
+
+static void testInjectedFaults() {
+  CHECK(install(TWAI_MODE_NORMAL, 8, 4), "install");
+  twai_host_set_time_scale(0.0f);
+
+  twai_host_inject_arbitration_loss(2);
+  twai_message_t message = makeMessage(0x7E0, 8);
+  twai_transmit(&message, 0);
+  uint32_t alerts = alertsWithin(5);
+  twai_status_info_t status;
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_ARB_LOST, "arbitration lost alert");
+  CHECK(alerts & TWAI_ALERT_TX_SUCCESS, "frame sent after losing twice");
+  CHECK(status.arb_lost_count == 2 && status.tx_error_counter == 0, "arbitration loss is no error");
+
+  twai_host_inject_arbitration_loss(1);
+  message.ss = 1;
+  twai_transmit(&message, 0);
+  alerts = alertsWithin(5);
+  CHECK(alerts & TWAI_ALERT_TX_FAILED, "single shot gives up on arbitration loss");
+
+  twai_host_inject_rx_overrun(3);
+  twai_read_alerts(&alerts, 0);
+  twai_get_status_info(&status);
+  CHECK(alerts & TWAI_ALERT_RX_FIFO_OVERRUN, "overrun alert");
+  CHECK(status.rx_overrun_count == 3, "overrun counted");
+
+  twai_host_inject_bus_off();
+  twai_get_status_info(&status);
+  CHECK(status.state == TWAI_STATE_BUS_OFF, "forced bus-off");
+  uninstall();
+}
+
+static void testRealTimeBus() {
+  // Injected frames arrive back to back at their on-wire time
+  CHECK(install(TWAI_MODE_NORMAL, 64, 4), "install");
+  twai_message_t message = makeMessage(0x7E8, 8);
+  unsigned long start = micros();
+  for (int i = 0; i < 40; i++) {
+    twai_host_inject(message);
+  }
+  twai_message_t received;
+  int count = 0;
+  while (count < 40 && twai_receive(&received, 50) == ESP_OK) {
+    count++;
+  }
+  unsigned long elapsed = micros() - start;
+  CHECK(count == 40, "all frames received");
+  CHECK(elapsed >= 40 * frameUs(message), "a full bus takes its wire time");
+  CHECK(twai_host_bus_time_us() == 40 * frameUs(message), "bus clock matches");
+  uninstall();
+}
+
+// ===== CANINTERFACE END TO END =====
+
+struct EmulatedEcu {
+  std::atomic<uint32_t> requests{0};
+};
+
+// Answers mode 01 requests on 0x7DF from 0x7E8
+static void ecuRespond(const twai_message_t& request, void* context) {
+  EmulatedEcu* ecu = static_cast<EmulatedEcu*>(context);
+  if (request.identifier != OBD2CAN::FUNCTIONAL_REQUEST_ID || request.data[1] != 0x01) {
+    return;
+  }
+  ecu->requests++;
+  twai_message_t response = makeMessage(OBD2CAN::RESPONSE_ID_BASE, 8);
+  response.data[0] = 0x04;
+  response.data[1] = 0x41;
+  response.data[2] = request.data[2];
+  response.data[3] = 0x1A;
+  response.data[4] = 0xF8;
+  twai_host_inject(response);
+}
+
+static void testInterfaceSelfTest() {
+  CANInterface can;
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::SELF_TEST), "initialize self test");
+  CHECK(can.start(), "start");
+  twai_host_set_acknowledge(false);
+
+  CANMessage message;
+  message.id = 0x123;
+  message.dlc = 4;
+  message.data[0] = 0xDE;
+  message.data[3] = 0xEF;
+  CHECK(can.sendMessage(message, 10), "send");
+  CANMessage received;
+  CHECK(can.receiveMessage(received, 50), "looped back");
+  CHECK(received.id == 0x123 && received.dlc == 4 && received.data[0] == 0xDE &&
+        received.data[3] == 0xEF, "loopback frame intact");
+  can.stop();
+  twai_host_reset();
+}
+
+static void testInterfaceLogging() {
+  // Gateway mode: Serial carries SLCAN, so nothing else may reach it
+  CANInterface::setLogging(false);
+  size_t before = Serial.bytesWritten();
+  CANInterface can;
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::SELF_TEST), "initialize quiet");
+  CHECK(can.start(), "start quiet");
+  can.setMode(CANMode::NORMAL);
+  can.printDiagnostics();
+  can.stop();
+  CHECK(Serial.bytesWritten() == before, "no CAN status lines while logging is off");
+
+  CANInterface::setLogging(true);
+  can.printDiagnostics();
+  CHECK(Serial.bytesWritten() > before, "status lines back once logging is on");
+  twai_host_reset();
+}
+
+static bool countFrame(const CANFrame& frame, void* context) {
+  (void)frame;
+  (*static_cast<uint32_t*>(context))++;
+  return true;
+}
+
+static void testInterfaceDispatch() {
+  CANInterface can;
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL), "initialize");
+  CHECK(can.start(), "start");
+  twai_host_set_time_scale(0.0f);
+
+  // Per-ID handlers first, then the frame handler for everything else
+  uint32_t routed = 0;
+  uint32_t others = 0;
+  CANDispatchTable table;
+  table.add(0x7E8, false, countFrame, &routed);
+  can.setDispatchTable(&table);
+  can.setFrameHandler(countFrame, &others);
+
+  twai_host_inject(makeMessage(0x7E8, 8));
+  twai_host_inject(makeMessage(0x123, 8));
+  twai_host_inject(makeMessage(0x7E8, 8, true));
+  twai_host_inject(makeMessage(0x7E8, 3));
+  CANFrame frame;
+  int received = 0;
+  while (received < 4 && can.receiveFrame(frame, 10)) {
+    received++;
+  }
+  CHECK(received == 4, "frames received");
+  CHECK(routed == 2, "0x7E8 routed by the table");
+  CHECK(others == 2, "other IDs reach the frame handler");
+  can.stop();
+  twai_host_reset();
+}
+
+static void testInterfaceFanout() {
+  static CANFrameFanout fanout;
+  int trace = fanout.subscribe("trace");
+  int gateway = fanout.subscribe("gateway");
+
+  CANInterface can;
+  can.setFanout(&fanout);
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL), "initialize");
+  CHECK(can.start(), "start");
+  CHECK(can.startReceiveTask(), "receive task");
+  twai_host_set_time_scale(0.0f);
+
+  for (int i = 0; i < 20; i++) {
+    twai_host_inject(makeMessage(0x300 + i, 8));
+  }
+  CANFrame frame;
+  int received = 0;
+  while (received < 20 && can.receiveFrame(frame, 50)) {
+    received++;
+  }
+  CHECK(received == 20, "receive queue gets every frame");
+
+  // Each subscriber reads the same frames in place, in order
+  bool ordered = true;
+  int traced = 0;
+  const CANFrame* shared;
+  while ((shared = fanout.acquire(trace)) != nullptr) {
+    ordered = ordered && shared->id() == static_cast<uint32_t>(0x300 + traced);
+    traced++;
+  }
+  CHECK(traced == 20 && ordered, "trace subscriber gets every frame");
+  CHECK(fanout.pending(gateway) == 20, "gateway backlog is its own");
+  CHECK(fanout.getPoolInUse() == 20, "one pool slot per frame");
+
+  can.stopReceiveTask();
+  can.stop();
+  fanout.unsubscribe(trace);
+  fanout.unsubscribe(gateway);
+  CHECK(fanout.getPoolInUse() == 0, "pool released");
+  twai_host_reset();
+}
+
+static void testInterfaceObd2() {
+  EmulatedEcu ecu;
+  twai_host_set_tx_hook(ecuRespond, &ecu);
+
+  CANInterface can;
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL), "initialize");
+  CHECK(can.start(), "start");
+  CHECK(can.startReceiveTask(), "receive task");
+
+  CANMessage response;
+  CHECK(can.sendOBD2Request(0x0C), "request engine speed");
+  CHECK(can.waitOBD2Response(response, 100), "response");
+  CHECK(response.id == 0x7E8 && response.data[1] == 0x41 && response.data[2] == 0x0C, "mode 01 PID 0C answered");
+  uint16_t pid = 0;
+  OBD2Value rpm;
+  CHECK(CANInterface::parseOBD2Response(response, pid, rpm) && pid == 0x410C && rpm.scaled == 172600 &&
+        rpm.decimals == 2, "decoded 1A F8 as 1726.00 RPM");
+  CANMessage truncated = response;
+  truncated.data[0] = 0x03;
+  CHECK(!CANInterface::parseOBD2Response(truncated, pid, rpm), "RPM answer with one data byte rejected");
+  CHECK(ecu.requests == 1, "ECU saw one request");
+
+  can.stopReceiveTask();
+  can.stop();
+  twai_host_reset();
+}
+
+static void testInterfaceRecovery() {
+  CANInterface can;
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL), "initialize");
+  CHECK(can.start(), "start");
+  CHECK(can.startReceiveTask(), "receive task");
+
+  twai_host_inject_bus_off();
+  unsigned long start = millis();
+  while (can.getStatistics().busRecoveries == 0 && millis() - start < 2000) {
+    delay(5);
+  }
+  CANStatistics stats = can.getStatistics();
+  CHECK(stats.busOffEvents == 1, "bus-off seen");
+  CHECK(stats.busRecoveries == 1, "recovered by the interface");
+  CHECK(!can.isBusOff(), "bus on again");
+
+  CANFrame frame;
+  frame.setId(0x7DF, false);
+  frame.dlc = 8;
+  memset(frame.data, 0, 8);
+  CHECK(can.sendFrame(frame, 10), "transmit after recovery");
+
+  can.stopReceiveTask();
+  can.stop();
+  twai_host_reset();
+}
+
+static void testInterfaceFilterReload() {
+  CANInterface can;
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL), "initialize");
+  CHECK(can.start(), "start");
+  CHECK(can.startReceiveTask(), "receive task");
+
+  twai_host_inject(makeMessage(0x123, 8));
+  twai_host_inject(makeMessage(0x7E8, 8));
+  unsigned long start = millis();
+  while (can.availableMessages() < 2 && millis() - start < 500) {
+    delay(1);
+  }
+  CHECK(can.availableMessages() == 2, "two frames queued before the filter change");
+
+  // Reloading the acceptance filter keeps the rings, statistics and task
+  CANFilter filter;
+  filter.type = CANFilterType::WHITELIST;
+  filter.whitelist.push_back(0x7E8);
+  can.setMessageFilter(filter);
+  CHECK(can.getHardwareFilter().exact, "single ID loaded exactly");
+  CHECK(can.isReceiveTaskRunning(), "receive task running again");
+  CHECK(can.availableMessages() == 2, "queued frames survive the reload");
+  CHECK(can.getStatistics().messagesReceived == 2, "statistics survive the reload");
+
+  twai_host_inject(makeMessage(0x123, 8));
+  twai_host_inject(makeMessage(0x7E8, 8));
+  start = millis();
+  while (can.availableMessages() < 3 && millis() - start < 500) {
+    delay(1);
+  }
+  CANFrame frame;
+  uint32_t ids[3] = {0, 0, 0};
+  for (int i = 0; i < 3 && can.receiveFrame(frame, 50); i++) {
+    ids[i] = frame.id();
+  }
+  CHECK(ids[0] == 0x123 && ids[1] == 0x7E8 && ids[2] == 0x7E8, "new filter drops 0x123 in hardware");
+  CHECK(!can.receiveFrame(frame, 20), "nothing else received");
+  CHECK(can.getStatistics().hardwareFiltered == 1, "accepted frame trusted to the hardware");
+
+  can.stopReceiveTask();
+  can.stop();
+  twai_host_reset();
+}
+
+// Loopback whose next installs fail
+class FailingInstallTransport : public CANLoopbackTransport {
+public:
+  int failInstalls = 0;
+
+  bool install(const CANTransportConfig& config) override {
+    if (failInstalls > 0) {
+      failInstalls--;
+      return false;
+    }
+    return CANLoopbackTransport::install(config);
+  }
+};
+
+static void testInterfaceFilterReloadFailure() {
+  FailingInstallTransport transport;
+  CANLoopbackTransport ecu;
+  transport.connect(&ecu);
+  ecu.install(CANTransportConfig());
+  ecu.start();
+
+  CANInterface can;
+  int errors = 0;
+  can.setErrorCallback([&errors](uint16_t, const String&) { errors++; });
+  can.setTransport(&transport);
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL) && can.start(), "start on loopback");
+  CHECK(can.startReceiveTask(), "receive task");
+
+  // New filter refused: the previous acceptance code goes back in
+  transport.failInstalls = 1;
+  std::vector<uint32_t> ids = {0x7E8};
+  CHECK(!can.setWhitelistFilter(ids), "failed reload reported");
+  CHECK(can.isInitialized() && can.isReceiveTaskRunning(), "interface still running");
+  CHECK(can.getHardwareFilter().acceptsAll() && !can.isHardwareFilterExact(), "previous filter restored");
+  CANFrame frame;
+  frame.setId(0x7E8, false);
+  frame.dlc = 8;
+  memset(frame.data, 0, 8);
+  ecu.transmit(frame, 0);
+  CHECK(can.receiveFrame(frame, 100) && frame.id() == 0x7E8, "frames still received");
+  CHECK(errors == 0, "no error while the interface runs");
+
+  // Restoring fails too: the interface stops and says so
+  transport.failInstalls = 2;
+  ids.push_back(0x7E9);
+  CHECK(!can.setWhitelistFilter(ids), "second failed reload reported");
+  CHECK(!can.isInitialized() && !can.isReceiveTaskRunning(), "interface stopped");
+  CHECK(errors == 1, "error callback fired");
+}
+
+static void testInterfaceSlowTaskExit() {
+  CANLoopbackTransport transport;
+  CANLoopbackTransport ecu;
+  transport.connect(&ecu);
+  ecu.install(CANTransportConfig());
+  ecu.start();
+
+  // A filter predicate that outlasts the stop timeout holds filterLock meanwhile
+  static std::atomic<bool> inside(false);
+  static std::atomic<bool> entered(false);
+  CANInterface can;
+  can.setTransport(&transport);
+  can.setCustomFilter([](const CANMessage&) {
+    inside = true;
+    entered = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(CAN_RX_TASK_POLL_MS * 5));
+    inside = false;
+    return true;
+  });
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL) && can.start(), "start on loopback");
+  CHECK(can.startReceiveTask(), "receive task");
+
+  CANFrame frame;
+  frame.setId(0x7E8, false);
+  frame.dlc = 8;
+  memset(frame.data, 0, 8);
+  ecu.transmit(frame, 0);
+  unsigned long start = millis();
+  while (!entered && millis() - start < 500) {
+    delay(1);
+  }
+  can.stopReceiveTask();
+  CHECK(entered && !inside, "stop waits for the task to leave the locked section");
+  CHECK(can.setAcceptAllFilter(), "filter lock free after the stop");
+  can.stop();
+}
+
+static void testInterfaceAppliedFilter() {
+  CANFilter obd2;
+  obd2.type = CANFilterType::WHITELIST;
+  obd2.whitelist = {0x7DF, 0x7E8, 0x7E9, 0x7EA, 0x7EB, 0x7EC, 0x7ED, 0x7EE, 0x7EF};
+
+  // TWAI loads the dual filter: accepted frames skip the software check
+  CANInterface can;
+  can.setMessageFilter(obd2);
+  CHECK(can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL) && can.start(), "start on TWAI");
+  CHECK(can.isHardwareFilterExact(), "TWAI enforces the OBD2 whitelist");
+  twai_host_inject(makeMessage(0x123, 8));
+  twai_host_inject(makeMessage(0x7E8, 8));
+  CANFrame frame;
+  CHECK(can.receiveFrame(frame, 50) && frame.id() == 0x7E8, "TWAI passes the response");
+  CHECK(!can.receiveFrame(frame, 20), "TWAI drops 0x123");
+  CHECK(can.getStatistics().hardwareFiltered == 1, "TWAI frame trusted to the hardware");
+  can.stop();
+  twai_host_reset();
+
+  // Loopback passes everything: the software filter has to decide
+  CANLoopbackTransport loopback;
+  CANLoopbackTransport ecu;
+  loopback.connect(&ecu);
+  CANInterface other;
+  other.setTransport(&loopback);
+  other.setMessageFilter(obd2);
+  CHECK(other.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL) && other.start(), "start on loopback");
+  ecu.install(CANTransportConfig());
+  ecu.start();
+  CHECK(other.getHardwareFilter().exact && !other.isHardwareFilterExact(),
+        "exact filter not trusted on loopback");
+  CANFrame sent;
+  sent.setId(0x123, false);
+  sent.dlc = 8;
+  memset(sent.data, 0, 8);
+  ecu.transmit(sent, 0);
+  sent.setId(0x7E8, false);
+  ecu.transmit(sent, 0);
+  int received = 0;
+  for (int i = 0; i < 4; i++) {
+    if (other.receiveFrame(frame, 10)) {
+      CHECK(frame.id() == 0x7E8, "loopback passes only the response");
+      received++;
+    }
+  }
+  CHECK(received == 1, "one frame received on loopback");
+  CHECK(other.getStatistics().filterRejects == 1, "software filter drops 0x123 on loopback");
+  CHECK(other.getStatistics().hardwareFiltered == 0, "nothing trusted to the loopback");
+  other.stop();
+}
+
+// ===== BENCHES =====
+
+static void benchRequestLatency() {
+  const int rounds = 200;
+  EmulatedEcu ecu;
+  twai_host_set_tx_hook(ecuRespond, &ecu);
+
+  CANInterface can;
+  can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL);
+  can.start();
+  can.startReceiveTask();
+
+  unsigned long worst = 0;
+  unsigned long total = 0;
+  int answered = 0;
+  for (int i = 0; i < rounds; i++) {
+    unsigned long start = micros();
+    CANMessage response;
+    if (can.sendOBD2Request(0x0D) && can.waitOBD2Response(response, 50)) {
+      unsigned long elapsed = micros() - start;
+      total += elapsed;
+      worst = elapsed > worst ? elapsed : worst;
+      answered++;
+    }
+  }
+  CHECK(answered == rounds, "every request answered");
+
+  can.stopReceiveTask();
+  can.stop();
+  twai_host_reset();
+
+  // Request and response are ~111 + ~125 bits: 472 us on the wire at 500 kbit/s
+  printf("  request/response at 500 kbit/s: mean %lu us, worst %lu us over %d rounds\n",
+         answered > 0 ? total / answered : 0, worst, answered);
+}
+
+static void benchReceiveThroughput(float timeScale, int frames) {
+  CANInterface can;
+  can.setDriverQueueLengths(64, 8);
+  can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL);
+  can.start();
+  can.startReceiveTask();
+  twai_host_set_time_scale(timeScale);
+
+  twai_message_t message = makeMessage(0x7E8, 8);
+  int received = 0;
+  int injected = 0;
+  unsigned long start = micros();
+  while (received < frames) {
+    // Keep the bus busy without outrunning the driver queue on an instant bus
+    while (injected < frames && injected - received < 32) {
+      twai_host_inject(message);
+      injected++;
+    }
+    CANFrame frame;
+    if (!can.receiveFrame(frame, 100)) {
+      break;
+    }
+    received++;
+    while (received < frames && can.receiveFrame(frame, 0)) {
+      received++;
+    }
+  }
+  unsigned long elapsed = micros() - start;
+  CANStatistics stats = can.getStatistics();
+  float busLoad = can.getBusLoad();
+
+  can.stopReceiveTask();
+  can.stop();
+  twai_host_reset();
+
+  CHECK(received == frames, "all frames through the interface");
+  CHECK(stats.driverRxMissed == 0 && stats.receiveOverflow == 0, "no frames lost");
+  if (timeScale > 0.0f) {
+    printf("  real-time 500 kbit/s: %d frames in %lu us (wire %u us), bus load %.1f%%\n",
+           received, elapsed, frames * frameUs(message), busLoad);
+  } else {
+    printf("  instant bus: %d frames in %lu us, %.0f frames/s, %.2f us/frame\n",
+           received, elapsed, received * 1e6 / elapsed, static_cast<double>(elapsed) / received);
+  }
+}
+
+// Broadcast storm near 100% load, one in four frames subscribed, a consumer
+// that needs 2 ms per frame, and a PID request every 20 ms. With shedding
+// off the full ring drops whatever comes next, responses included.
+static void benchReceiveStorm(bool shedding) {
+  const unsigned long durationMs = 1500;
+  const uint32_t subscribedId = 0x110;
+  EmulatedEcu ecu;
+  twai_host_set_tx_hook(ecuRespond, &ecu);
+
+  CANInterface can;
+  can.initialize(CANSpeed::CAN_500KBPS, CANMode::NORMAL);
+  if (!shedding) {
+    can.setReceiveShedLevels(CAN_RX_RING_SIZE, CAN_RX_RING_SIZE);
+  }
+  can.subscribeBroadcast(subscribedId);
+  can.start();
+  can.startReceiveTask();
+
+  // Paced at 95% of the wire rate so the storm never queues far ahead of the ECU
+  std::atomic<bool> storming(true);
+  std::thread storm([&] {
+    twai_message_t message = makeMessage(0x200, 8);
+    uint32_t sent = 0;
+    std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+    while (storming.load()) {
+      message.identifier = (sent & 3) == 0 ? subscribedId : 0x200 + (sent & 0xFF);
+      twai_host_inject(message);
+      sent++;
+      next += std::chrono::microseconds(frameUs(message) * 105 / 100);
+      std::this_thread::sleep_until(next);
+    }
+  });
+
+  int requests = 0;
+  int responses = 0;
+  int consumed = 0;
+  unsigned long start = millis();
+  unsigned long lastRequest = start;
+  CANFrame frame;
+  while (millis() - start < durationMs) {
+    if (millis() - lastRequest >= 20) {
+      lastRequest = millis();
+      requests += can.sendOBD2Request(0x0C) ? 1 : 0;
+    }
+    if (!can.receiveFrame(frame, 5)) {
+      continue;
+    }
+    consumed++;
+    responses += (frame.id() == OBD2CAN::RESPONSE_ID_BASE && frame.data[1] == 0x41) ? 1 : 0;
+    delayMicroseconds(2000);    // Decode, log, draw: slower than the bus
+  }
+  storming = false;
+  storm.join();
+  while (can.receiveFrame(frame, 20)) {
+    responses += (frame.id() == OBD2CAN::RESPONSE_ID_BASE && frame.data[1] == 0x41) ? 1 : 0;
+  }
+  CANStatistics stats = can.getStatistics();
+  CANRxAdmissionStatistics admission = can.getReceiveAdmissionStatistics();
+  float busLoad = can.getBusLoad();
+
+  can.stopReceiveTask();
+  can.stop();
+  twai_host_reset();
+
+  const size_t response = static_cast<size_t>(CANRxClass::RESPONSE);
+  const size_t subscribed = static_cast<size_t>(CANRxClass::SUBSCRIBED);
+  const size_t background = static_cast<size_t>(CANRxClass::BACKGROUND);
+  CHECK(stats.driverRxMissed == 0, "storm: RX task kept the driver queue drained");
+  CHECK(admission.shed[background] > 0, "storm: consumer overloaded");
+  if (shedding) {
+    CHECK(requests > 0 && static_cast<uint32_t>(responses) == ecu.requests.load(), "storm: every response kept");
+    CHECK(admission.shed[response] == 0, "storm: no response shed");
+    CHECK(admission.shed[subscribed] * 3 < admission.shed[background], "storm: subscribed shed last");
+  }
+  printf("  storm %-9s %4d requests, %4d answered; consumed %5d; shed response/subscribed/background %u/%u/%u; bus %.0f%%\n",
+         shedding ? "shedding:" : "FIFO:", requests, responses, consumed,
+         admission.shed[response], admission.shed[subscribed], admission.shed[background], busLoad);
+}
+
+int main() {
+  printf("CANInterface on emulated TWAI tests\n");
+  Serial.setEnabled(false);
+
+  testDriverStates();
+  testTransmitQueueDepth();
+  testReceiveQueueDepth();
+  testAcceptanceFilter();
+  testModes();
+  testErrorCounting();
+  testInjectedFaults();
+  testRealTimeBus();
+  testInterfaceSelfTest();
+  testInterfaceLogging();
+  testInterfaceDispatch();
+  testInterfaceFanout();
+  testInterfaceObd2();
+  testInterfaceRecovery();
+  testInterfaceFilterReload();
+  testInterfaceFilterReloadFailure();
+  testInterfaceSlowTaskExit();
+  testInterfaceAppliedFilter();
+
+  printf("Benches:\n");
+  benchRequestLatency();
+  benchReceiveThroughput(0.0f, 50000);
+  benchReceiveThroughput(1.0f, 4000);
+  benchReceiveStorm(false);
+  benchReceiveStorm(true);
+
+  if (failures > 0) {
+    printf("%d test(s) failed\n", failures);
+    return 1;
+  }
+  printf("All CANInterface host tests passed\n");
+  return 0;
+}
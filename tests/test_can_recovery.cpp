@@ -0,0 +1,349 @@
+/*
+ * Test bus-off recovery state machine
+ * Drives CANRecoveryController the way CANInterface does (alerts in, driver
+ * calls out) against a simulated TWAI controller: plain recovery, backoff
+ * doubling and cap, backoff reset after a stable period, a lost
+ * BUS_RECOVERED alert, failing driver calls, and queued TX frames surviving
+ * the outage. Then compares a long bus fault with the old behaviour
+ * (bus-off latched until start()) and with recovering immediately on every
+ * bus-off.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/test_can_recovery.cpp src/modules/can/can_recovery.cpp -o test_can_recovery
+ *   ./test_can_recovery
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../src/modules/can/can_recovery.h"
+#include "../src/modules/can/can_ring_buffer.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+// ===== SIMULATED TWAI CONTROLLER =====
+
+enum SimAlert : uint32_t {
+  SIM_BUS_OFF = 0x1,
+  SIM_BUS_RECOVERED = 0x2
+};
+
+enum class SimState { RUNNING, BUS_OFF, RECOVERING, STOPPED };
+
+// Bus-off after a few ms of failed transmissions while the fault is present
+// (a node at the wrong bitrate, say); recovery needs 128 x 11 recessive bits,
+// ~3 ms at 500 kbps, which an idle bus provides even while the fault lasts.
+struct SimDriver {
+  SimState state = SimState::RUNNING;
+  uint32_t faultStart = 0;
+  uint32_t faultEnd = 0;
+  uint32_t errorSince = 0;
+  bool erroring = false;
+  uint32_t recoveredAt = 0;
+  uint32_t alerts = 0;
+  bool dropRecoveredAlert = false;
+  int failInitiate = 0;
+  int failReinstall = 0;
+  uint32_t initiateCalls = 0;
+  uint32_t transmitted = 0;
+  uint32_t busOffs = 0;
+
+  bool faulty(uint32_t now) const { return now >= faultStart && now < faultEnd; }
+
+  void tick(uint32_t now, bool transmitting) {
+    if (state == SimState::RUNNING && transmitting && faulty(now)) {
+      if (!erroring) {
+        erroring = true;
+        errorSince = now;
+      } else if (now - errorSince >= 2) {
+        state = SimState::BUS_OFF;
+        erroring = false;
+        busOffs++;
+        alerts |= SIM_BUS_OFF;
+      }
+    } else {
+      erroring = false;
+    }
+    if (state == SimState::RECOVERING) {
+      if (now >= recoveredAt) {
+        state = SimState::STOPPED;
+        if (!dropRecoveredAlert) alerts |= SIM_BUS_RECOVERED;
+      }
+    }
+  }
+
+  uint32_t readAlerts() {
+    uint32_t a = alerts;
+    alerts = 0;
+    return a;
+  }
+
+  bool initiateRecovery(uint32_t now) {
+    initiateCalls++;
+    if (failInitiate > 0) {
+      failInitiate--;
+      return false;
+    }
+    if (state != SimState::BUS_OFF) return false;
+    state = SimState::RECOVERING;
+    recoveredAt = now + 3;
+    return true;
+  }
+
+  bool start() {
+    if (state != SimState::STOPPED) return false;
+    state = SimState::RUNNING;
+    return true;
+  }
+
+  bool reinstall() {
+    if (failReinstall > 0) {
+      failReinstall--;
+      return false;
+    }
+    state = SimState::RUNNING;
+    return true;
+  }
+
+  bool transmit(uint32_t now) {
+    if (state != SimState::RUNNING || faulty(now)) return false;
+    transmitted++;
+    return true;
+  }
+};
+
+// ===== INTERFACE MODEL =====
+
+// Mirrors CANInterface: handleAlerts(), serviceRecovery() and
+// processTransmitQueue() once per millisecond
+struct Harness {
+  SimDriver driver;
+  CANRecoveryController recovery;
+  CANRingBuffer<uint32_t, 512> transmitQueue;
+  bool busOff = false;
+  bool autoRecover = true;      // false: old behaviour, bus-off latched
+  uint32_t busOffEvents = 0;
+  uint32_t busRecoveries = 0;
+
+  explicit Harness(uint32_t base = 50, uint32_t max = 2000, uint32_t timeout = 500, uint32_t stable = 10000)
+      : recovery(base, max, timeout, stable) {}
+
+  void step(uint32_t now) {
+    driver.tick(now, !transmitQueue.empty());
+
+    uint32_t alerts = driver.readAlerts();
+    if (alerts & SIM_BUS_OFF) {
+      busOff = true;
+      busOffEvents++;
+      if (autoRecover) recovery.onBusOff(now);
+    }
+    if (alerts & SIM_BUS_RECOVERED) recovery.onBusRecovered();
+
+    CANRecoveryAction action = recovery.poll(now);
+    if (action != CANRecoveryAction::NONE) {
+      bool ok;
+      switch (action) {
+        case CANRecoveryAction::INITIATE_RECOVERY: ok = driver.initiateRecovery(now); break;
+        case CANRecoveryAction::START_DRIVER:      ok = driver.start(); break;
+        default:                                   ok = driver.reinstall(); break;
+      }
+      recovery.onActionResult(action, ok, now);
+      if (busOff && !recovery.isBusOff()) {
+        busOff = false;
+        busRecoveries++;
+      }
+    }
+
+    // Frames stay queued while the bus is off
+    for (int i = 0; i < 4 && !busOff; i++) {
+      const uint32_t* frame = transmitQueue.front();
+      if (frame == nullptr || !driver.transmit(now)) break;
+      transmitQueue.drop();
+    }
+  }
+
+  void run(uint32_t from, uint32_t to) {
+    for (uint32_t t = from; t < to; t++) step(t);
+  }
+
+  void queue(uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) transmitQueue.push(i);
+  }
+};
+
+// ===== TESTS =====
+
+static void testSingleBusOff() {
+  Harness h;
+  h.queue(40);
+  h.driver.faultEnd = 20;
+  h.run(0, 200);
+
+  CHECK(h.busOffEvents == 1, "one bus-off");
+  CHECK(h.busRecoveries == 1, "recovered");
+  CHECK(!h.busOff && h.recovery.getState() == CANRecoveryState::RUNNING, "running again");
+  CHECK(h.recovery.getReinstalls() == 0, "no reinstall needed");
+  // Bus-off at 2, recovery initiated at 52, recessive bits done at 55, started
+  CHECK(h.recovery.getLastOutageMs() == 53, "outage = base delay + recovery sequence");
+  CHECK(h.transmitQueue.empty(), "queued frames delivered after recovery");
+  CHECK(h.driver.transmitted == 40, "every queued frame sent exactly once");
+}
+
+static void testBackoffDoublesAndCaps() {
+  CANRecoveryController r(50, 400, 500, 10000);
+  uint32_t now = 0;
+  const uint32_t expected[] = {50, 100, 200, 400, 400, 400};
+  for (uint32_t i = 0; i < 6; i++) {
+    r.onBusOff(now);
+    CHECK(r.getCurrentDelayMs() == expected[i], "delay sequence 50, 100, 200, 400 (cap)");
+    CHECK(r.poll(now + expected[i] - 1) == CANRecoveryAction::NONE, "no attempt before the deadline");
+    now += expected[i];
+    CHECK(r.poll(now) == CANRecoveryAction::INITIATE_RECOVERY, "attempt at the deadline");
+    r.onActionResult(CANRecoveryAction::INITIATE_RECOVERY, true, now);
+    r.onBusRecovered();
+    CHECK(r.poll(now + 3) == CANRecoveryAction::START_DRIVER, "start after BUS_RECOVERED");
+    r.onActionResult(CANRecoveryAction::START_DRIVER, true, now + 3);
+    now += 100;                         // Falls off again well inside the stable period
+  }
+  CHECK(r.getRecoveries() == 6, "six recoveries");
+
+  // Huge attempt counts must not overflow the shift
+  CANRecoveryController big(50, 2000, 500, 10000);
+  for (int i = 0; i < 1000; i++) big.onBusOff(i);
+  CHECK(big.getCurrentDelayMs() == 2000, "long storms stay at the cap");
+}
+
+static void testStablePeriodResetsBackoff() {
+  CANRecoveryController r(50, 2000, 500, 1000);
+  auto recoverAt = [&r](uint32_t t) {
+    r.onBusOff(t);
+    uint32_t at = t + r.getCurrentDelayMs();
+    r.poll(at);
+    r.onActionResult(CANRecoveryAction::INITIATE_RECOVERY, true, at);
+    r.onBusRecovered();
+    r.onActionResult(CANRecoveryAction::START_DRIVER, true, at + 3);
+    return at + 3;
+  };
+  uint32_t t = recoverAt(0);
+  t = recoverAt(t + 10);
+  CHECK(r.getCurrentDelayMs() == 100, "second bus-off inside stable period doubles");
+  t = recoverAt(t + 1000);
+  CHECK(r.getCurrentDelayMs() == 50, "bus-off after a stable period starts over");
+
+  // Wrap-safe deadlines
+  CANRecoveryController w(50, 2000, 500, 10000);
+  w.onBusOff(0xFFFFFFF0u);
+  CHECK(w.poll(0xFFFFFFFFu) == CANRecoveryAction::NONE, "deadline across wrap not reached");
+  CHECK(w.poll(0x22u) == CANRecoveryAction::INITIATE_RECOVERY, "deadline across wrap reached");
+}
+
+static void testLostRecoveredAlert() {
+  Harness h;
+  h.queue(20);
+  h.driver.faultEnd = 10;
+  h.driver.dropRecoveredAlert = true;
+  h.run(0, 1000);
+
+  CHECK(h.busRecoveries == 1, "recovered without BUS_RECOVERED");
+  CHECK(h.recovery.getReinstalls() == 1, "driver reinstalled after the timeout");
+  // Bus-off at 2, initiate at 52, reinstall at 552
+  CHECK(h.recovery.getLastOutageMs() == 550, "outage = base delay + recovery timeout");
+  CHECK(h.transmitQueue.empty() && h.driver.transmitted == 20, "queue survives the reinstall");
+}
+
+static void testFailingDriverCalls() {
+  Harness h;
+  h.queue(10);
+  h.driver.faultEnd = 10;
+  h.driver.failInitiate = 1;
+  h.run(0, 300);
+  CHECK(h.busRecoveries == 1, "initiate failure falls back to reinstall");
+  CHECK(h.recovery.getReinstalls() == 1, "one reinstall");
+  CHECK(h.recovery.getLastOutageMs() == 51, "reinstall runs on the pass after the failed initiate");
+
+  Harness g;
+  g.queue(10);
+  g.driver.faultEnd = 10;
+  g.driver.failInitiate = 2;
+  g.driver.failReinstall = 2;
+  g.run(0, 2000);
+  CHECK(g.busRecoveries == 1, "recovered once the reinstall succeeds");
+  CHECK(g.recovery.getReinstalls() == 2, "two failed reinstalls");
+  // Bus-off at 2; initiate at 52 and reinstall at 53 fail (back off 100);
+  // initiate at 153 and reinstall at 154 fail (back off 200); initiate at
+  // 354 succeeds and the controller restarts at 357
+  CHECK(g.recovery.getLastOutageMs() == 355, "failed reinstalls back off further");
+  CHECK(g.transmitQueue.empty() && g.driver.transmitted == 10, "queue delivered");
+}
+
+// ===== SHORTED BUS EPISODE =====
+
+struct Episode {
+  uint32_t busOffs;
+  uint32_t attempts;
+  uint32_t delivered;
+  int resumeMs;                 // -1: never resumed
+};
+
+// Bus faulty for 1 s while the app keeps a frame queued every 10 ms
+static Episode runEpisode(bool autoRecover, uint32_t base, uint32_t max) {
+  Harness h(base, max, 500, 10000);
+  h.autoRecover = autoRecover;
+  h.driver.faultStart = 100;
+  h.driver.faultEnd = 1100;
+  int resume = -1;
+  for (uint32_t t = 0; t < 5000; t++) {
+    if (t % 10 == 0) h.transmitQueue.push(t);
+    uint32_t before = h.driver.transmitted;
+    h.step(t);
+    if (resume < 0 && t >= h.driver.faultEnd && h.driver.transmitted > before) {
+      resume = static_cast<int>(t - h.driver.faultEnd);
+    }
+  }
+  return {h.driver.busOffs, h.driver.initiateCalls, h.driver.transmitted, resume};
+}
+
+static void benchEpisode() {
+  Episode latched = runEpisode(false, 50, 2000);
+  Episode immediate = runEpisode(true, 0, 0);
+  Episode backoff = runEpisode(true, CAN_RECOVERY_BASE_DELAY_MS, CAN_RECOVERY_MAX_DELAY_MS);
+
+  printf("\n1 s bus fault, frame queued every 10 ms, 5 s run (500 frames)\n");
+  printf("%-26s %9s %9s %10s %12s\n", "", "bus-offs", "attempts", "delivered", "resume (ms)");
+  const Episode* rows[] = {&latched, &immediate, &backoff};
+  const char* names[] = {"old (latched until start)", "recover immediately", "exponential backoff"};
+  for (int i = 0; i < 3; i++) {
+    printf("%-26s %9u %9u %10u %12d\n", names[i], rows[i]->busOffs, rows[i]->attempts,
+           rows[i]->delivered, rows[i]->resumeMs);
+  }
+
+  CHECK(latched.resumeMs < 0, "old behaviour never resumes on its own");
+  CHECK(backoff.resumeMs >= 0 && backoff.resumeMs <= (int)CAN_RECOVERY_MAX_DELAY_MS + 10,
+        "backoff resumes within one capped delay of the fault clearing");
+  CHECK(backoff.attempts * 10 < immediate.attempts, "backoff makes far fewer attempts on a dead bus");
+  CHECK(backoff.delivered == 500, "no queued frame lost across the outage");
+}
+
+int main() {
+  testSingleBusOff();
+  testBackoffDoublesAndCaps();
+  testStablePeriodResetsBackoff();
+  testLostRecoveredAlert();
+  testFailingDriverCalls();
+  benchEpisode();
+
+  if (failures > 0) {
+    printf("\n%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("\nAll CAN recovery tests passed\n");
+  return 0;
+}
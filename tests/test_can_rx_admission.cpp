@@ -0,0 +1,184 @@
+/*
+ * Test receive admission control
+ * Checks classification (response windows opened by functional, physical,
+ * flow control and 29-bit requests, extension by response frames and by
+ * "response pending", subscriptions), the shed order at the watermarks,
+ * level validation and counters. The storm bench against the emulated bus
+ * lives in test_can_interface_host.cpp.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 -Isrc tests/test_can_rx_admission.cpp src/modules/can/can_rx_admission.cpp src/modules/can/can_dispatch.cpp -o test_can_rx_admission
+ *   ./test_can_rx_admission
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "../src/modules/can/can_rx_admission.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static CANFrame makeFrame(uint32_t id, bool extended = false) {
+  CANFrame frame;
+  frame.setId(id, extended);
+  frame.dlc = 8;
+  memset(frame.data, 0x55, sizeof(frame.data));
+  frame.timestamp = 0;
+  return frame;
+}
+
+static const size_t RESPONSE = static_cast<size_t>(CANRxClass::RESPONSE);
+static const size_t SUBSCRIBED = static_cast<size_t>(CANRxClass::SUBSCRIBED);
+static const size_t BACKGROUND = static_cast<size_t>(CANRxClass::BACKGROUND);
+
+static void testResponseWindow() {
+  CANRxAdmission admission;
+  CANFrame response = makeFrame(0x7E8);
+  CHECK(!admission.isAwaitingResponse(0), "no window before a request");
+  CHECK(admission.classify(response, 0) == CANRxClass::BACKGROUND, "unsolicited response is background");
+
+  admission.noteTransmit(makeFrame(0x123), 1000);
+  CHECK(!admission.isAwaitingResponse(1000), "non-request opens nothing");
+
+  admission.noteTransmit(makeFrame(OBD2CAN::FUNCTIONAL_REQUEST_ID), 1000);
+  CHECK(admission.classify(response, 1010) == CANRxClass::RESPONSE, "answer to functional request");
+  CHECK(admission.classify(makeFrame(0x7EF), 1010) == CANRxClass::RESPONSE, "any ECU may answer");
+  CHECK(admission.classify(makeFrame(0x7F0), 1010) == CANRxClass::BACKGROUND, "0x7F0 is not a response ID");
+  CHECK(admission.classify(makeFrame(0x7E8, true), 1010) == CANRxClass::BACKGROUND, "29-bit 0x7E8 is not");
+
+  // Each response frame extends the window (consecutive frames of long answers)
+  uint32_t now = 1010;
+  for (int i = 0; i < 10; i++) {
+    now += CAN_RX_RESPONSE_WINDOW_MS - 10;
+    CHECK(admission.classify(response, now) == CANRxClass::RESPONSE, "extended by response frames");
+  }
+  now += CAN_RX_RESPONSE_WINDOW_MS;
+  CHECK(admission.classify(response, now) == CANRxClass::BACKGROUND, "window closes");
+
+  // Physical request and flow control open it too
+  admission.noteTransmit(makeFrame(OBD2CAN::PHYSICAL_REQUEST_BASE + 3), now);
+  CHECK(admission.classify(response, now + 1) == CANRxClass::RESPONSE, "physical request");
+  now += 2 * CAN_RX_RESPONSE_WINDOW_MS;
+
+  // "7F 01 78": the ECU needs more time than P2
+  admission.noteTransmit(makeFrame(OBD2CAN::FUNCTIONAL_REQUEST_ID), now);
+  CANFrame pending = makeFrame(0x7E8);
+  pending.data[0] = 0x03;
+  pending.data[1] = 0x7F;
+  pending.data[2] = 0x01;
+  pending.data[3] = 0x78;
+  CHECK(admission.classify(pending, now + 5) == CANRxClass::RESPONSE, "response pending");
+  CHECK(admission.isAwaitingResponse(now + CAN_RX_RESPONSE_PENDING_MS - 10), "window stretched to P2*");
+  CHECK(admission.classify(response, now + CAN_RX_RESPONSE_PENDING_MS - 10) == CANRxClass::RESPONSE,
+        "late final answer kept");
+
+  // The window survives millis() wrap-around
+  CANRxAdmission wrapped;
+  wrapped.noteTransmit(makeFrame(OBD2CAN::FUNCTIONAL_REQUEST_ID), 0xFFFFFFF0u);
+  CHECK(wrapped.classify(response, 0x20) == CANRxClass::RESPONSE, "window across wrap");
+  CANRxAdmission late;
+  late.noteTransmit(makeFrame(OBD2CAN::FUNCTIONAL_REQUEST_ID), 0x90000000u);
+  CHECK(late.classify(response, 0x90000001u) == CANRxClass::RESPONSE, "first request after 25 days");
+  printf("  response window             functional/physical/pending/wrap OK\n");
+}
+
+static void testExtendedAddressing() {
+  CANRxAdmission admission;
+  CANFrame response = makeFrame(0x18DAF110, true);
+  admission.noteTransmit(makeFrame(OBD2CAN::EXT_FUNCTIONAL_REQUEST, true), 0);
+  CHECK(admission.classify(response, 1) == CANRxClass::RESPONSE, "29-bit functional");
+  CHECK(admission.classify(makeFrame(0x18DAF210, true), 1) == CANRxClass::BACKGROUND,
+        "answer to another tester is background");
+
+  CANRxAdmission physical;
+  physical.noteTransmit(makeFrame(0x18DA10F1, true), 0);
+  CHECK(physical.classify(response, 1) == CANRxClass::RESPONSE, "29-bit physical");
+  CHECK(!CANRxAdmission().isAwaitingResponse(0), "fresh instance has no window");
+  printf("  29-bit addressing           OK\n");
+}
+
+static void testSubscriptions() {
+  CANRxAdmission admission;
+  CHECK(admission.subscribe(0x120, false), "subscribe standard");
+  CHECK(admission.subscribe(0x0CF00400, true), "subscribe extended");
+  CHECK(admission.classify(makeFrame(0x120), 0) == CANRxClass::SUBSCRIBED, "standard subscribed");
+  CHECK(admission.classify(makeFrame(0x120, true), 0) == CANRxClass::BACKGROUND, "other width is not");
+  CHECK(admission.classify(makeFrame(0x0CF00400, true), 0) == CANRxClass::SUBSCRIBED, "extended subscribed");
+
+  CANFrame remote = makeFrame(0x0CF00400, true);
+  remote.idFlags |= CANFrame::FLAG_REMOTE;
+  CHECK(admission.classify(remote, 0) == CANRxClass::BACKGROUND, "remote frame is background");
+
+  CHECK(admission.unsubscribe(0x120, false), "unsubscribe");
+  CHECK(admission.classify(makeFrame(0x120), 0) == CANRxClass::BACKGROUND, "unsubscribed");
+
+  // Responses outrank subscriptions
+  admission.subscribe(0x7E8, false);
+  admission.noteTransmit(makeFrame(OBD2CAN::FUNCTIONAL_REQUEST_ID), 0);
+  CHECK(admission.classify(makeFrame(0x7E8), 1) == CANRxClass::RESPONSE, "response first");
+
+  for (uint32_t i = 0; i < CANIdIndex::EXTENDED_CAPACITY; i++) {
+    admission.subscribe(0x1000 + i, true);
+  }
+  CHECK(!admission.subscribe(0x1FFFFFFF, true), "29-bit table full");
+  admission.clearSubscriptions();
+  CHECK(admission.classify(makeFrame(0x0CF00400, true), 0) == CANRxClass::BACKGROUND, "cleared");
+  printf("  subscriptions               OK\n");
+}
+
+static void testShedOrder() {
+  CANRxAdmission admission;
+  size_t background = admission.getLevel(CANRxClass::BACKGROUND);
+  size_t subscribed = admission.getLevel(CANRxClass::SUBSCRIBED);
+  CHECK(background == CAN_RX_SHED_BACKGROUND_LEVEL && subscribed == CAN_RX_SHED_SUBSCRIBED_LEVEL,
+        "configured levels");
+  CHECK(admission.getLevel(CANRxClass::RESPONSE) == CAN_RX_RING_SIZE, "responses use the whole ring");
+
+  CHECK(admission.admit(CANRxClass::BACKGROUND, background - 1), "background below its level");
+  CHECK(!admission.admit(CANRxClass::BACKGROUND, background), "background shed at its level");
+  CHECK(admission.admit(CANRxClass::SUBSCRIBED, background), "subscribed kept there");
+  CHECK(!admission.admit(CANRxClass::SUBSCRIBED, subscribed), "subscribed shed at its level");
+  CHECK(admission.admit(CANRxClass::RESPONSE, CAN_RX_RING_SIZE - 1), "response while space is left");
+  CHECK(!admission.admit(CANRxClass::RESPONSE, CAN_RX_RING_SIZE), "response shed only when full");
+
+  CANRxAdmissionStatistics stats = admission.getStatistics();
+  CHECK(stats.admitted[RESPONSE] == 1 && stats.admitted[SUBSCRIBED] == 1 && stats.admitted[BACKGROUND] == 1,
+        "admitted counters");
+  CHECK(stats.shed[RESPONSE] == 1 && stats.shed[SUBSCRIBED] == 1 && stats.shed[BACKGROUND] == 1,
+        "shed counters");
+  admission.resetStatistics();
+  stats = admission.getStatistics();
+  CHECK(stats.admitted[BACKGROUND] == 0 && stats.shed[RESPONSE] == 0, "reset");
+
+  CHECK(!admission.setLevels(64, 32), "levels out of order rejected");
+  CHECK(!admission.setLevels(32, CAN_RX_RING_SIZE + 1), "level beyond ring rejected");
+  CHECK(admission.setLevels(CAN_RX_RING_SIZE, CAN_RX_RING_SIZE), "shedding off: one level for all");
+  CHECK(admission.admit(CANRxClass::BACKGROUND, CAN_RX_RING_SIZE - 1), "background up to full");
+  printf("  shed order                  background < subscribed < response OK\n");
+}
+
+int main() {
+  printf("Testing CAN receive admission\n");
+  printf("=============================\n");
+
+  testResponseWindow();
+  testExtendedAddressing();
+  testSubscriptions();
+  testShedOrder();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nCAN receive admission tests passed\n");
+  return 0;
+}
@@ -0,0 +1,408 @@
+/*
+ * Test ISO-TP (ISO 15765-2) transport
+ * Runs tester and ECU transports against each other on a simulated 500 kbps
+ * bus: single/multi-frame transfers, block size and STmin pacing, error
+ * handling, concurrent ECU sessions, then measures throughput.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/test_isotp.cpp src/modules/can/isotp.cpp -o test_isotp
+ *   ./test_isotp
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "../src/modules/can/isotp.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+// ===== SIMULATED BUS =====
+
+// 8-byte 11-bit frame: 111 bits + ~19 stuff bits at 500 kbps
+static const uint32_t FRAME_US = 260;
+static uint32_t simMicros = 0;
+
+struct BusFrame {
+  CANMessage message;
+  int sender;
+  uint32_t sentAt;
+};
+
+static std::deque<BusFrame> bus;
+static std::vector<BusFrame> busLog;
+static bool logFrames = false;
+static bool busRefuses = false;
+
+struct Node {
+  int index;
+  ISOTPTransport transport;
+  std::vector<uint8_t> received;
+  int receivedSession;
+  int messages;
+  ISOTPResult lastResult;
+  int results;
+
+  explicit Node(int i)
+      : index(i),
+        transport([this](const CANMessage& m) {
+                    if (busRefuses) return false;
+                    bus.push_back({m, index, simMicros});
+                    return true;
+                  },
+                  [] { return simMicros; }),
+        receivedSession(-1), messages(0), lastResult(ISOTPResult::OK), results(0) {
+    transport.setReceiveCallback([this](int session, const uint8_t* data, uint16_t length) {
+      received.assign(data, data + length);
+      receivedSession = session;
+      messages++;
+    });
+    transport.setCompleteCallback([this](int, ISOTPResult result) {
+      lastResult = result;
+      results++;
+    });
+  }
+};
+
+static std::vector<Node*> nodes;
+
+static void resetBus() {
+  bus.clear();
+  busLog.clear();
+  simMicros = 0;
+  busRefuses = false;
+  for (Node* n : nodes) delete n;
+  nodes.clear();
+}
+
+static Node* addNode() {
+  Node* n = new Node(nodes.size());
+  nodes.push_back(n);
+  return n;
+}
+
+// Run bus until idle (or limit), delivering frames in order
+static void runBus(uint32_t limitUs = 5000000) {
+  uint32_t end = simMicros + limitUs;
+  while (static_cast<int32_t>(end - simMicros) > 0) {
+    if (!bus.empty()) {
+      BusFrame f = bus.front();
+      bus.pop_front();
+      simMicros += FRAME_US;
+      if (logFrames) busLog.push_back(f);
+      for (Node* n : nodes) {
+        if (n->index != f.sender) n->transport.onFrame(f.message);
+      }
+      continue;
+    }
+    for (Node* n : nodes) n->transport.poll();
+    if (bus.empty()) {
+      bool busy = false;
+      for (Node* n : nodes) {
+        for (int s = 0; s < ISOTP_MAX_SESSIONS; s++) busy |= n->transport.isBusy(s);
+      }
+      if (!busy) return;
+      simMicros += 50; // Idle bus, waiting for STmin or timeout
+    }
+  }
+}
+
+static std::vector<uint8_t> pattern(size_t length, uint8_t seed) {
+  std::vector<uint8_t> data(length);
+  for (size_t i = 0; i < length; i++) data[i] = static_cast<uint8_t>(seed + i * 7);
+  return data;
+}
+
+// Tester on 0x7E0/0x7E8, one ECU answering on 0x7E8
+static void makePair(Node*& tester, Node*& ecu, int& testerSession, int& ecuSession) {
+  tester = addNode();
+  ecu = addNode();
+  testerSession = tester->transport.openSession(0x7E0, 0x7E8);
+  ecuSession = ecu->transport.openSession(0x7E8, 0x7E0);
+}
+
+// ===== TESTS =====
+
+static void testSingleFrame() {
+  resetBus();
+  Node *tester, *ecu;
+  int ts, es;
+  makePair(tester, ecu, ts, es);
+
+  const uint8_t request[] = {0x01, 0x0C};
+  CHECK(tester->transport.send(ts, request, sizeof(request)), "single frame send");
+  runBus();
+  CHECK(ecu->messages == 1 && ecu->received.size() == 2 && ecu->received[1] == 0x0C,
+        "single frame received");
+  CHECK(bus.empty() && tester->transport.getStatistics().framesSent == 1, "one frame on bus");
+
+  // Functional request reaches an ECU listening on 0x7DF
+  Node* functionalEcu = addNode();
+  functionalEcu->transport.openSession(0x7E9, 0x7DF);
+  CHECK(tester->transport.sendFunctional(0x7DF, request, 2), "functional send");
+  CHECK(!tester->transport.sendFunctional(0x7DF, request, 8), "functional limited to one frame");
+  runBus();
+  CHECK(functionalEcu->messages == 1, "functional request received");
+  printf("  %-30s OK\n", "single frame / functional");
+}
+
+static void testVIN() {
+  resetBus();
+  Node *tester, *ecu;
+  int ts, es;
+  makePair(tester, ecu, ts, es);
+
+  const char* vin = "VBKJYJ400LC123456";
+  std::vector<uint8_t> response = {0x49, 0x02, 0x01};
+  response.insert(response.end(), vin, vin + 17);
+  CHECK(ecu->transport.send(es, response.data(), response.size()), "VIN first frame");
+  runBus();
+  CHECK(tester->messages == 1 && tester->received == response, "VIN reassembled");
+  CHECK(ecu->lastResult == ISOTPResult::OK, "VIN transmit completed");
+  // FF + FC + 2 CF
+  CHECK(ecu->transport.getStatistics().framesSent == 3, "VIN frame count");
+  CHECK(tester->transport.getStatistics().framesSent == 1, "one flow control");
+  printf("  %-30s OK (%u bus frames)\n", "VIN (20 bytes)",
+         ecu->transport.getStatistics().framesSent + tester->transport.getStatistics().framesSent);
+}
+
+static void testBlockSizeAndSTmin() {
+  resetBus();
+  Node *tester, *ecu;
+  int ts, es;
+  makePair(tester, ecu, ts, es);
+  tester->transport.setReceiveFlowControl(4, 0x02); // BS 4, STmin 2 ms
+
+  std::vector<uint8_t> data = pattern(ISOTP_MAX_MESSAGE_SIZE, 3);
+  logFrames = true;
+  CHECK(ecu->transport.send(es, data.data(), data.size()), "max size send");
+  runBus();
+  logFrames = false;
+  CHECK(tester->messages == 1 && tester->received == data, "max size reassembled");
+
+  uint32_t consecutive = 0, flowControls = 0, minGap = 0xFFFFFFFF;
+  uint32_t lastCF = 0;
+  bool haveLast = false;
+  for (const BusFrame& f : busLog) {
+    uint8_t pci = f.message.data[0] & 0xF0;
+    if (pci == OBD2CAN::FRAME_TYPE_FLOW_CONTROL) {
+      flowControls++;
+      haveLast = false; // New block may start immediately
+    } else if (pci == OBD2CAN::FRAME_TYPE_CONSECUTIVE) {
+      consecutive++;
+      if (haveLast && f.sentAt - lastCF < minGap) minGap = f.sentAt - lastCF;
+      lastCF = f.sentAt;
+      haveLast = true;
+    }
+  }
+  uint32_t expectedCF = (ISOTP_MAX_MESSAGE_SIZE - 6 + 6) / 7;
+  CHECK(consecutive == expectedCF, "consecutive frame count");
+  CHECK(flowControls == (expectedCF + 3) / 4, "one flow control per block (last block needs none)");
+  CHECK(minGap >= 2000, "STmin respected between consecutive frames");
+  printf("  %-30s OK (%u CF, %u FC, min CF gap %u us)\n", "block size 4 + STmin 2 ms",
+         consecutive, flowControls, minGap);
+
+  CHECK(ISOTPTransport::stMinToMicros(0xF5) == 500, "STmin 0xF5 = 500 us");
+  CHECK(ISOTPTransport::stMinToMicros(0x7F) == 127000, "STmin 0x7F = 127 ms");
+  CHECK(ISOTPTransport::stMinToMicros(0x90) == 127000, "reserved STmin = max");
+}
+
+static CANMessage frame(uint32_t id, std::initializer_list<uint8_t> bytes) {
+  CANMessage m;
+  m.id = id;
+  m.dlc = 8;
+  memset(m.data, 0x55, 8);
+  size_t i = 0;
+  for (uint8_t b : bytes) m.data[i++] = b;
+  return m;
+}
+
+static void testErrors() {
+  resetBus();
+  Node* tester = addNode();
+  int ts = tester->transport.openSession(0x7E0, 0x7E8);
+  CHECK(tester->transport.openSession(0x7E1, 0x7E8) < 0, "duplicate rxId rejected");
+
+  // Sequence error: FF then CF with SN 2
+  tester->transport.onFrame(frame(0x7E8, {0x10, 0x14, 1, 2, 3, 4, 5, 6}));
+  tester->transport.onFrame(frame(0x7E8, {0x22, 7, 8, 9, 10, 11, 12, 13}));
+  CHECK(tester->lastResult == ISOTPResult::WRONG_SEQUENCE && tester->messages == 0,
+        "wrong sequence aborts reassembly");
+  CHECK(!tester->transport.isBusy(ts), "session idle after abort");
+
+  // Overflow: first frame announces more than the buffer holds
+  bus.clear();
+  tester->transport.onFrame(frame(0x7E8, {0x1F, 0xFF, 1, 2, 3, 4, 5, 6}));
+  CHECK(!bus.empty() && bus.back().message.data[0] == 0x32, "FC overflow sent");
+  CHECK(tester->transport.getStatistics().overflows == 1, "overflow counted");
+
+  // N_Cr: first frame, then silence
+  bus.clear();
+  tester->transport.onFrame(frame(0x7E8, {0x10, 0x14, 1, 2, 3, 4, 5, 6}));
+  simMicros += ISOTP_TIMEOUT_MS * 1000 + 1;
+  tester->transport.poll();
+  CHECK(tester->lastResult == ISOTPResult::TIMEOUT_CR, "N_Cr timeout");
+
+  // New first frame during reassembly restarts it
+  tester->transport.onFrame(frame(0x7E8, {0x10, 0x14, 1, 2, 3, 4, 5, 6}));
+  tester->transport.onFrame(frame(0x7E8, {0x10, 0x08, 9, 9, 9, 9, 9, 9}));
+  CHECK(tester->lastResult == ISOTPResult::UNEXPECTED_PDU, "unexpected first frame reported");
+  tester->transport.onFrame(frame(0x7E8, {0x21, 8, 7, 0x55, 0x55, 0x55, 0x55, 0x55}));
+  CHECK(tester->messages == 1 && tester->received.size() == 8 && tester->received[7] == 7,
+        "restarted transfer completes");
+
+  // N_Bs: our first frame never gets flow control
+  std::vector<uint8_t> data = pattern(40, 1);
+  CHECK(tester->transport.send(ts, data.data(), data.size()), "send waiting for FC");
+  CHECK(!tester->transport.send(ts, data.data(), data.size()), "second send rejected while busy");
+  simMicros += ISOTP_TIMEOUT_MS * 1000 + 1;
+  tester->transport.poll();
+  CHECK(tester->lastResult == ISOTPResult::TIMEOUT_BS, "N_Bs timeout");
+
+  // FC.WAIT extends the wait, FC.OVERFLOW aborts
+  CHECK(tester->transport.send(ts, data.data(), data.size()), "send again");
+  tester->transport.onFrame(frame(0x7E8, {0x31, 0, 0}));
+  simMicros += ISOTP_TIMEOUT_MS * 1000 - 1;
+  tester->transport.poll();
+  CHECK(tester->transport.isBusy(ts), "FC.WAIT restarts N_Bs");
+  tester->transport.onFrame(frame(0x7E8, {0x32, 0, 0}));
+  CHECK(tester->lastResult == ISOTPResult::OVERFLOW, "FC.OVERFLOW aborts transmit");
+
+  // Driver refusing frames eventually fails the transfer
+  CHECK(tester->transport.send(ts, data.data(), data.size()), "send for refused CF");
+  busRefuses = true;
+  tester->transport.onFrame(frame(0x7E8, {0x30, 0, 0}));
+  simMicros += ISOTP_TIMEOUT_MS * 1000 + 1;
+  tester->transport.poll();
+  CHECK(tester->lastResult == ISOTPResult::SEND_FAILED, "refused consecutive frames fail");
+  busRefuses = false;
+
+  printf("  %-30s OK\n", "sequence/overflow/timeouts");
+}
+
+static void testConcurrentECUs() {
+  resetBus();
+  Node* tester = addNode();
+  CHECK(tester->transport.openOBD2Sessions() == 8, "eight OBD2 sessions");
+
+  std::vector<std::vector<uint8_t>> expected(8);
+  std::vector<std::vector<uint8_t>> got(8);
+  tester->transport.setReceiveCallback([&](int session, const uint8_t* data, uint16_t length) {
+    got[session].assign(data, data + length);
+  });
+
+  for (uint32_t ecu = 0; ecu < 8; ecu++) {
+    Node* node = addNode();
+    int s = node->transport.openSession(0x7E8 + ecu, 0x7E0 + ecu);
+    expected[ecu] = pattern(60 + ecu * 30, ecu);
+    CHECK(node->transport.send(s, expected[ecu].data(), expected[ecu].size()), "ECU first frame");
+  }
+  runBus();
+
+  bool allOk = true;
+  for (uint32_t ecu = 0; ecu < 8; ecu++) {
+    int session = tester->transport.findSession(0x7E8 + ecu);
+    if (session < 0 || got[session] != expected[ecu]) allOk = false;
+  }
+  CHECK(allOk, "interleaved responses from 8 ECUs reassembled");
+  printf("  %-30s OK (%u frames interleaved)\n", "8 concurrent ECU sessions",
+         tester->transport.getStatistics().framesReceived);
+}
+
+// ===== THROUGHPUT =====
+
+struct BenchResult {
+  double busBytesPerSec;
+  double efficiency;
+  double hostNsPerFrame;
+};
+
+static BenchResult benchTransfer(uint8_t blockSize, uint8_t stMin, int ecus, int rounds) {
+  resetBus();
+  Node* tester = addNode();
+  tester->transport.openOBD2Sessions();
+  tester->transport.setReceiveFlowControl(blockSize, stMin);
+
+  std::vector<Node*> senders;
+  std::vector<int> sessions;
+  for (int ecu = 0; ecu < ecus; ecu++) {
+    Node* node = addNode();
+    senders.push_back(node);
+    sessions.push_back(node->transport.openSession(0x7E8 + ecu, 0x7E0 + ecu));
+  }
+
+  std::vector<uint8_t> data = pattern(ISOTP_MAX_MESSAGE_SIZE, 9);
+  uint64_t payload = 0;
+  uint64_t busTime = 0;
+  uint64_t frames = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++) {
+    uint32_t t0 = simMicros;
+    for (int ecu = 0; ecu < ecus; ecu++) {
+      senders[ecu]->transport.send(sessions[ecu], data.data(), data.size());
+      payload += data.size();
+    }
+    runBus();
+    busTime += simMicros - t0;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  for (Node* n : nodes) frames += n->transport.getStatistics().framesSent;
+
+  CHECK(tester->transport.getStatistics().messagesReceived == static_cast<uint32_t>(rounds * ecus),
+        "benchmark transfers complete");
+
+  BenchResult result;
+  result.busBytesPerSec = payload * 1e6 / busTime;
+  // Upper bound: 7 payload bytes per back-to-back frame
+  result.efficiency = result.busBytesPerSec / (7.0 * 1e6 / FRAME_US);
+  result.hostNsPerFrame = std::chrono::duration<double, std::nano>(elapsed).count() / frames;
+  return result;
+}
+
+static void benchmark() {
+  printf("\nThroughput, %d byte messages on simulated 500 kbps bus:\n", ISOTP_MAX_MESSAGE_SIZE);
+  printf("  %-28s %12s %11s %14s\n", "config", "payload B/s", "bus eff.", "host ns/frame");
+  struct Config { const char* name; uint8_t bs; uint8_t stMin; int ecus; };
+  const Config configs[] = {
+    {"1 ECU, BS 0, STmin 0", 0, 0x00, 1},
+    {"1 ECU, BS 8, STmin 0", 8, 0x00, 1},
+    {"1 ECU, BS 0, STmin 500 us", 0, 0xF5, 1},
+    {"1 ECU, BS 0, STmin 1 ms", 0, 0x01, 1},
+    {"8 ECUs, BS 0, STmin 1 ms", 0, 0x01, 8},
+  };
+  for (const Config& c : configs) {
+    BenchResult r = benchTransfer(c.bs, c.stMin, c.ecus, 200);
+    printf("  %-28s %12.0f %10.1f%% %14.1f\n", c.name, r.busBytesPerSec, r.efficiency * 100,
+           r.hostNsPerFrame);
+  }
+}
+
+int main() {
+  printf("Testing ISO-TP transport\n");
+  printf("========================\n");
+
+  testSingleFrame();
+  testVIN();
+  testBlockSizeAndSTmin();
+  testErrors();
+  testConcurrentECUs();
+  benchmark();
+  resetBus();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nISO-TP tests passed\n");
+  return 0;
+}
@@ -0,0 +1,265 @@
+/*
+ * Test the J1979 Mode 01 formula table
+ * Checks that every PID 0x00-0x63 has a formula whose fields fit the
+ * descriptor's data bytes, that encode(decode(raw)) gives back every raw
+ * value of every field (the whole 8/16-bit range, sampled 32-bit bit
+ * fields), known J1979 examples, clamping and decimals conversion. Then
+ * measures encode/decode throughput against the float switch that
+ * OBD2Handler used before.
+ *
+ * Build & run (host):
+ *   g++ -std=c++11 -O2 -Isrc tests/test_obd2_pid_codec.cpp src/modules/obd2/obd2_pid_codec.cpp src/modules/obd2/obd2_pid_table.cpp -o test_obd2_pid_codec
+ *   ./test_obd2_pid_codec
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+
+#include "../src/modules/obd2/obd2_pid_codec.h"
+#include "../src/modules/obd2/obd2_pid_table.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static void testCoverage() {
+  int mismatched = 0;
+  for (unsigned pid = 0; pid < OBD2PIDTable::PID_COUNT; pid++) {
+    const OBD2PIDFormula* formula = OBD2PIDCodec::find(pid);
+    const OBD2PIDDescriptor* info = OBD2PIDTable::find(OBD2PIDTable::MODE_CURRENT_DATA, pid);
+    bool ok = formula != nullptr && formula->fieldCount >= 1;
+    for (uint8_t i = 0; ok && i < formula->fieldCount; i++) {
+      ok = formula->fields[i].start + formula->fields[i].bytes <= info->dataBytes;
+    }
+    // Bit-encoded PIDs are the ones the descriptor gives no unit
+    ok = ok && formula->fields[0].isBitField == (info->unit[0] == '\0');
+    if (!ok) {
+      printf("  PID %02X: formula missing or does not match its descriptor\n", pid);
+      mismatched++;
+    }
+  }
+  CHECK(mismatched == 0, "every PID has a formula within its data bytes");
+  CHECK(OBD2PIDCodec::find(0x64) == nullptr, "beyond the table");
+  CHECK(OBD2PIDCodec::field(0x0C, 1) == nullptr, "RPM has one field");
+  CHECK(OBD2PIDCodec::field(0x4F, 3) != nullptr, "PID 4F has four");
+  printf("  coverage                    PIDs 00-%02X, fields inside their data bytes\n",
+         static_cast<unsigned>(OBD2PIDTable::PID_COUNT - 1));
+}
+
+static void testRoundTrip() {
+  int fields = 0;
+  long values = 0;
+  int lossy = 0;
+  for (unsigned pid = 0; pid < OBD2PIDTable::PID_COUNT; pid++) {
+    const OBD2PIDFormula* formula = OBD2PIDCodec::find(pid);
+    for (uint8_t index = 0; index < formula->fieldCount; index++) {
+      const OBD2Field& field = formula->fields[index];
+      uint64_t count = uint64_t(1) << (8 * field.bytes);
+      uint64_t stride = field.bytes == 4 ? 0x10001 : 1;
+      fields++;
+      for (uint64_t raw = 0; raw < count; raw += stride) {
+        uint8_t data[OBD2PIDTable::MAX_DATA_BYTES] = {0};
+        for (uint8_t i = 0; i < field.bytes; i++) {
+          data[field.start + i] = (raw >> (8 * (field.bytes - 1 - i))) & 0xFF;
+        }
+        OBD2Value value;
+        uint8_t encoded[OBD2PIDTable::MAX_DATA_BYTES] = {0};
+        bool ok = OBD2PIDCodec::decode(pid, data, sizeof(data), value, index) &&
+                  OBD2PIDCodec::encode(pid, value, encoded, index) &&
+                  memcmp(data, encoded, sizeof(data)) == 0;
+        if (!ok && lossy++ < 5) {
+          printf("  PID %02X field %u raw %llu does not round trip\n", pid, index,
+                 static_cast<unsigned long long>(raw));
+        }
+        values++;
+      }
+    }
+  }
+  CHECK(lossy == 0, "encode(decode(raw)) == raw for every field");
+  printf("  round trip                  %d fields, %ld raw values exact\n", fields, values);
+}
+
+static bool decodes(uint8_t pid, const uint8_t* data, uint8_t length, int32_t scaled, uint8_t decimals,
+                    uint8_t index = 0) {
+  OBD2Value value;
+  return OBD2PIDCodec::decode(pid, data, length, value, index) && value.scaled == scaled &&
+         value.decimals == decimals;
+}
+
+static void testKnownValues() {
+  const uint8_t rpm[] = {0x1A, 0xF8};
+  CHECK(decodes(0x0C, rpm, 2, 172600, 2), "0C 1A F8 = 1726.00 RPM");
+  const uint8_t coolant[] = {0x7B};
+  CHECK(decodes(0x05, coolant, 1, 83, 0), "05 7B = 83 C");
+  const uint8_t timing[] = {0x00};
+  CHECK(decodes(0x0E, timing, 1, -640, 1), "0E 00 = -64.0 degrees");
+  const uint8_t load[] = {0xFF};
+  CHECK(decodes(0x04, load, 1, 1000, 1), "04 FF = 100.0 %");
+  const uint8_t maf[] = {0x01, 0x5E};
+  CHECK(decodes(0x10, maf, 2, 350, 2), "10 01 5E = 3.50 g/s");
+  const uint8_t evap[] = {0xFF, 0xFC};
+  CHECK(decodes(0x32, evap, 2, -100, 2), "32 FF FC = -1.00 Pa (signed)");
+  const uint8_t o2[] = {0x80, 0x00, 0x80, 0x00};
+  CHECK(decodes(0x34, o2, 4, 100000, 5), "34 ratio 1.00000");
+  CHECK(decodes(0x34, o2, 4, 0, 3, 1), "34 current 0.000 mA");
+  const uint8_t maximums[] = {1, 2, 3, 4};
+  CHECK(decodes(0x4F, maximums, 4, 40, 0, 3), "4F D = 40 kPa");
+  const uint8_t status[] = {0x81, 0x07, 0x65, 0x04};
+  CHECK(decodes(0x01, status, 4, static_cast<int32_t>(0x81076504u), 0), "monitor status bits");
+  OBD2Value unused;
+  CHECK(!OBD2PIDCodec::decode(0x0C, rpm, 1, unused), "short data rejected");
+
+  // Encode from any number of decimals
+  uint8_t data[4] = {0};
+  OBD2Value speed = {1726, 0};
+  CHECK(OBD2PIDCodec::encode(0x0C, speed, data) && data[0] == 0x1A && data[1] == 0xF8, "1726 RPM");
+  OBD2Value temperature = {-40000, 3};
+  CHECK(OBD2PIDCodec::encode(0x05, temperature, data) && data[0] == 0x00, "-40.000 C");
+  OBD2Value advance = {12, 0};
+  CHECK(OBD2PIDCodec::encode(0x0E, advance, data) && data[0] == 152, "12 degrees");
+  OBD2Value percent = {75, 0};
+  CHECK(OBD2PIDCodec::encode(0x2F, percent, data) && data[0] == 191, "75 % rounds to 191");
+
+  // Out of range values are clamped and reported
+  OBD2Value hot = {300, 0};
+  CHECK(!OBD2PIDCodec::encode(0x05, hot, data) && data[0] == 0xFF, "clamped high");
+  OBD2Value cold = {-50, 0};
+  CHECK(!OBD2PIDCodec::encode(0x05, cold, data) && data[0] == 0x00, "clamped low");
+  OBD2Value negative = {-9000, 0};
+  CHECK(!OBD2PIDCodec::encode(0x32, negative, data) && data[0] == 0x80 && data[1] == 0x00, "signed minimum");
+  OBD2Value tooPrecise = {1, 10};
+  CHECK(!OBD2PIDCodec::encode(0x0C, tooPrecise, data), "more decimals than an int64 can scale");
+
+  // Fields are written independently
+  uint8_t o2Data[4] = {0};
+  OBD2Value voltage = {450, 3};
+  OBD2Value trim = {0, 0};
+  CHECK(OBD2PIDCodec::encode(0x14, voltage, o2Data, 0) && OBD2PIDCodec::encode(0x14, trim, o2Data, 1) &&
+        o2Data[0] == 90 && o2Data[1] == 128, "14 A = 0.45 V, B = 0 %");
+
+  OBD2Value converted = OBD2PIDCodec::fromFloat(800.25f, 2);
+  CHECK(converted.scaled == 80025 && converted.decimals == 2, "fromFloat");
+  CHECK(OBD2PIDCodec::toFloat(converted) == 800.25f, "toFloat");
+  CHECK(OBD2PIDCodec::fromFloat(-1.5f, 0).scaled == -2, "fromFloat rounds half away from zero");
+  CHECK(OBD2PIDCodec::fromFloat(1e12f, 0).scaled == 0x7FFFFFFF, "fromFloat saturates");
+  printf("  known values                J1979 examples, clamping, decimals OK\n");
+}
+
+// ===== BENCHMARK =====
+
+// OBD2Handler::encodePIDData before the formula table
+static void switchEncode(uint8_t pid, float value, uint8_t* data) {
+  switch (pid) {
+    case 0x0C: {
+      uint16_t rpm = (uint16_t)(value * 4);
+      data[0] = (rpm >> 8) & 0xFF;
+      data[1] = rpm & 0xFF;
+      break;
+    }
+    case 0x0D:
+      data[0] = (uint8_t)value;
+      break;
+    case 0x04:
+    case 0x11:
+    case 0x2F:
+      data[0] = (uint8_t)(value * 2.55);
+      break;
+    case 0x05:
+    case 0x0F:
+    case 0x46:
+      data[0] = (uint8_t)(value + 40);
+      break;
+    case 0x0A:
+      data[0] = (uint8_t)(value / 3);
+      break;
+    case 0x42: {
+      uint16_t voltage = (uint16_t)(value * 1000);
+      data[0] = (voltage >> 8) & 0xFF;
+      data[1] = voltage & 0xFF;
+      break;
+    }
+    default:
+      data[0] = 0x00;
+      break;
+  }
+}
+
+static void benchmark() {
+  // The PIDs the old switch handled, so both sides do real work
+  static const uint8_t PIDS[] = {0x04, 0x05, 0x0A, 0x0C, 0x0D, 0x0F, 0x11, 0x2F, 0x42, 0x46};
+  const size_t pidCount = sizeof(PIDS) / sizeof(PIDS[0]);
+  const int rounds = 5000000;
+  volatile uint32_t sink = 0;
+  uint8_t data[4] = {0};
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    switchEncode(PIDS[i % pidCount], static_cast<float>(i & 0xFF), data);
+    sink = sink + data[0];
+  }
+  double switchNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    OBD2Value value = {i & 0xFF, 0};
+    OBD2PIDCodec::encode(PIDS[i % pidCount], value, data);
+    sink = sink + data[0];
+  }
+  double encodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    OBD2Value value;
+    data[0] = i & 0xFF;
+    OBD2PIDCodec::decode(PIDS[i % pidCount], data, sizeof(data), value);
+    sink = sink + value.scaled;
+  }
+  double decodeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+  // Every field of every PID, the mix a scan tool would see
+  start = std::chrono::steady_clock::now();
+  long decoded = 0;
+  for (int i = 0; i < rounds / 10; i++) {
+    uint8_t pid = i % OBD2PIDTable::PID_COUNT;
+    const OBD2PIDFormula* formula = OBD2PIDCodec::find(pid);
+    data[1] = i & 0xFF;
+    for (uint8_t index = 0; index < formula->fieldCount; index++) {
+      OBD2Value value;
+      OBD2PIDCodec::decode(pid, data, sizeof(data), value, index);
+      sink = sink + value.scaled;
+      decoded++;
+    }
+  }
+  double allNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / decoded;
+
+  printf("\n  %-44s %10s %12s\n", "Mode 01 encode/decode", "ns/value", "Mvalues/s");
+  printf("  %-44s %10.2f %12.1f\n", "float switch encode (10 PIDs, rest 0x00)", switchNs, 1000.0 / switchNs);
+  printf("  %-44s %10.2f %12.1f\n", "OBD2PIDCodec::encode (same PIDs)", encodeNs, 1000.0 / encodeNs);
+  printf("  %-44s %10.2f %12.1f\n", "OBD2PIDCodec::decode (same PIDs)", decodeNs, 1000.0 / decodeNs);
+  printf("  %-44s %10.2f %12.1f\n", "OBD2PIDCodec::decode (all fields 00-63)", allNs, 1000.0 / allNs);
+}
+
+int main() {
+  printf("Testing J1979 PID codec\n");
+  printf("=======================\n");
+
+  testCoverage();
+  testRoundTrip();
+  testKnownValues();
+  benchmark();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nJ1979 PID codec tests passed\n");
+  return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * Test the flash-resident PID descriptor table
+ * Checks that every Mode 01 PID 0x00-0x63 has a descriptor whose length
+ * matches the batch splitter's J1979 table, lookup by mode and PID, and a
+ * few known entries. Then compares a lookup in the table with the
+ * std::map<uint16_t, PIDData> lookup-and-copy it replaces.
+ *
+ * Build & run (host):
+ *   g++ -std=c++11 -O2 -Isrc tests/test_obd2_pid_table.cpp src/modules/obd2/obd2_pid_table.cpp src/modules/can/obd2_batch.cpp -o test_obd2_pid_table
+ *   ./test_obd2_pid_table
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+
+#include "../src/modules/obd2/obd2_pid_table.h"
+#include "../src/modules/can/obd2_batch.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+static void testCoverage() {
+  int mismatched = 0;
+  for (unsigned pid = 0; pid < OBD2PIDTable::PID_COUNT; pid++) {
+    const OBD2PIDDescriptor* info = OBD2PIDTable::find(OBD2PIDTable::MODE_CURRENT_DATA, pid);
+    if (info == nullptr || info->name == nullptr || info->unit == nullptr ||
+        info->dataBytes != OBD2Batch::mode01DataLength(pid)) {
+      printf("  PID %02X: descriptor missing or length differs from J1979\n", pid);
+      mismatched++;
+    }
+  }
+  CHECK(mismatched == 0, "every PID described with its J1979 length");
+  CHECK(OBD2PIDTable::find(OBD2PIDTable::MODE_CURRENT_DATA, 0x64) == nullptr, "beyond the table");
+  CHECK(OBD2PIDTable::find(0x03, 0x0C) == nullptr, "mode 03 has no PIDs");
+  CHECK(OBD2PIDTable::find(0x02, 0x0C) == nullptr, "mode 02 layout (frame number first) not described");
+  printf("  coverage                    PIDs 00-%02X, lengths match J1979\n",
+         static_cast<unsigned>(OBD2PIDTable::PID_COUNT - 1));
+}
+
+static void testKnownEntries() {
+  const OBD2PIDDescriptor* rpm = OBD2PIDTable::find(static_cast<uint16_t>(0x010C));
+  CHECK(rpm != nullptr && strcmp(rpm->name, "Engine RPM") == 0 && strcmp(rpm->unit, "RPM") == 0 &&
+        rpm->dataBytes == 2 && rpm->maxValue == 16383.75f, "engine RPM");
+  const OBD2PIDDescriptor* coolant = OBD2PIDTable::find(static_cast<uint16_t>(0x0105));
+  CHECK(coolant != nullptr && coolant->minValue == -40 && coolant->maxValue == 215, "coolant range");
+  const OBD2PIDDescriptor* timing = OBD2PIDTable::find(static_cast<uint16_t>(0x010E));
+  CHECK(timing != nullptr && timing->minValue == -64 && timing->maxValue == 63.5f, "timing advance range");
+  const OBD2PIDDescriptor* status = OBD2PIDTable::find(static_cast<uint16_t>(0x0101));
+  CHECK(status != nullptr && status->unit[0] == '\0' && status->dataBytes == 4, "bit-encoded PID");
+
+  CHECK(OBD2PIDTable::isSupportPID(0x00) && OBD2PIDTable::isSupportPID(0x40), "support PIDs");
+  CHECK(!OBD2PIDTable::isSupportPID(0x0C), "data PID");
+  printf("  known entries               OK\n");
+}
+
+// ===== BENCHMARK =====
+
+// What OBD2Handler kept per PID before the table
+struct MapEntry {
+  uint16_t pid;
+  std::string description;
+  uint8_t dataBytes;
+  std::string unit;
+  float minValue;
+  float maxValue;
+  bool supported;
+  unsigned long lastUpdate;
+  float currentValue;
+  uint8_t rawData[8];
+};
+
+static void benchmark() {
+  std::map<uint16_t, MapEntry> entries;
+  for (unsigned pid = 0; pid < OBD2PIDTable::PID_COUNT; pid++) {
+    const OBD2PIDDescriptor* info = OBD2PIDTable::find(OBD2PIDTable::MODE_CURRENT_DATA, pid);
+    MapEntry entry;
+    entry.pid = 0x0100 | pid;
+    entry.description = info->name;
+    entry.dataBytes = info->dataBytes;
+    entry.unit = info->unit;
+    entry.minValue = info->minValue;
+    entry.maxValue = info->maxValue;
+    entry.supported = true;
+    entry.lastUpdate = 0;
+    entry.currentValue = 0;
+    memset(entry.rawData, 0, sizeof(entry.rawData));
+    entries[entry.pid] = entry;
+  }
+
+  const int rounds = 2000000;
+  volatile uint32_t sink = 0;
+  // Old processPIDQuery: find() to check support, then getPIDInfo() copies the entry
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    uint16_t pid = 0x0100 | (i % OBD2PIDTable::PID_COUNT);
+    if (entries.find(pid) != entries.end()) {
+      MapEntry copy = entries.find(pid)->second;
+      sink = sink + copy.dataBytes;
+    }
+  }
+  double mapNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++) {
+    uint16_t pid = 0x0100 | (i % OBD2PIDTable::PID_COUNT);
+    const OBD2PIDDescriptor* info = OBD2PIDTable::find(pid);
+    if (info != nullptr) {
+      sink = sink + info->dataBytes;
+    }
+  }
+  double tableNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+
+  printf("\n  %-40s %10s %14s\n", "PID lookup (100 PIDs)", "ns/lookup", "heap bytes");
+  printf("  %-40s %10.2f %14s\n", "std::map find + PIDData copy", mapNs, "2 strings/PID");
+  printf("  %-40s %10.2f %14d\n", "OBD2PIDTable::find (flash, by index)", tableNs, 0);
+}
+
+int main() {
+  printf("Testing OBD2 PID descriptor table\n");
+  printf("=================================\n");
+
+  testCoverage();
+  testKnownEntries();
+  benchmark();
+
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nOBD2 PID table tests passed\n");
+  return 0;
+}
@@ -0,0 +1,603 @@
+/*
+ * Test pipelined OBD2 request scheduler
+ * Simulated 500 kbps bus with several emulated ECUs answering after their
+ * own processing delay. Checks response correlation, per-ECU ordering,
+ * deadlines, negative/pending responses, functional requests and multi-PID
+ * Mode 01 batching (a result for every PID, no heap use), then compares PIDs/s of the blocking one-at-a-time loop
+ * (sendOBD2Request + waitOBD2Response) against the scheduler.
+ *
+ * Build & run (host):
+ *   g++ -std=c++17 -O2 tests/test_obd2_request_scheduler.cpp src/modules/can/obd2_request_scheduler.cpp \
+ *       src/modules/can/obd2_batch.cpp src/modules/can/isotp.cpp -o test_obd2_request_scheduler
+ *   ./test_obd2_request_scheduler
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <new>
+#include <vector>
+
+#include "../src/modules/can/obd2_request_scheduler.h"
+
+static int failures = 0;
+
+#define CHECK(cond, msg) \
+  do { \
+    if (!(cond)) { \
+      printf("FAIL: %s (%s:%d)\n", msg, __FILE__, __LINE__); \
+      failures++; \
+    } \
+  } while (0)
+
+// Heap allocations, to check that batching allocates nothing per request
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+
+// Out of line so GCC does not pair the inlined free() with a new-expression
+__attribute__((noinline)) static void heapFree(void* p) { free(p); }
+
+void operator delete(void* p) noexcept { heapFree(p); }
+void operator delete(void* p, size_t) noexcept { heapFree(p); }
+
+// ===== SIMULATED BUS AND ECUS =====
+
+static const uint32_t FRAME_US = 260;       // 8-byte 11-bit frame at 500 kbps
+static uint32_t simMicros = 0;
+
+struct BusFrame {
+  CANMessage message;
+  int sender;                               // -1 = tester
+};
+
+static std::deque<BusFrame> bus;
+
+struct PendingReply {
+  uint32_t due;
+  std::vector<uint8_t> payload;
+};
+
+struct SimECU {
+  int index;
+  uint32_t latencyUs;
+  std::vector<uint8_t> pids;                // Supported Mode 01 PIDs
+  ISOTPTransport transport;
+  int physical;
+  std::deque<PendingReply> replies;
+  uint32_t requests;
+
+  SimECU(int i, uint32_t latency, std::vector<uint8_t> supported)
+      : index(i), latencyUs(latency), pids(supported),
+        transport([this](const CANMessage& m) {
+                    bus.push_back({m, index});
+                    return true;
+                  },
+                  [] { return simMicros; }),
+        requests(0) {
+    physical = transport.openSession(0x7E8 + i, 0x7E0 + i);
+    transport.openSession(0x7E8 + i, 0x7DF);
+    transport.setReceiveCallback([this](int session, const uint8_t* data, uint16_t length) {
+      handleRequest(session == physical, data, length);
+    });
+  }
+
+  void reply(uint32_t delay, std::vector<uint8_t> payload) {
+    replies.push_back({simMicros + delay, payload});
+  }
+
+  void handleRequest(bool isPhysical, const uint8_t* data, uint16_t length) {
+    requests++;
+    uint8_t sid = data[0];
+    if (sid == 0x01) {
+      std::vector<uint8_t> response = {0x41};
+      for (uint16_t i = 1; i < length; i++) {
+        if (std::find(pids.begin(), pids.end(), data[i]) == pids.end()) continue;
+        response.push_back(data[i]);
+        response.push_back(static_cast<uint8_t>(index * 16 + data[i]));
+        for (uint8_t b = 1; b < OBD2Batch::mode01DataLength(data[i]); b++) {
+          response.push_back(static_cast<uint8_t>((data[i] ^ 0xA5) + b));
+        }
+      }
+      if (response.size() > 1) {
+        reply(latencyUs, response);
+      } else if (isPhysical) {
+        reply(latencyUs, {0x7F, 0x01, 0x12});   // Sub-function not supported
+      }
+    } else if (sid == 0x09 && length >= 2 && data[1] == 0x02) {
+      const char* vin = "VBKJYJ400LC123456";
+      std::vector<uint8_t> response = {0x49, 0x02, 0x01};
+      response.insert(response.end(), vin, vin + 17);
+      reply(latencyUs, response);
+    } else if (sid == 0x22) {
+      reply(latencyUs, {0x7F, 0x22, 0x78});     // Response pending
+      reply(latencyUs + 300000, {0x62, data[1], data[2], 0x01});
+    }
+  }
+
+  void service() {
+    transport.poll();
+    while (!replies.empty() && static_cast<int32_t>(simMicros - replies.front().due) >= 0) {
+      if (transport.isBusy(physical)) break;
+      const std::vector<uint8_t>& p = replies.front().payload;
+      transport.send(physical, p.data(), p.size());
+      replies.pop_front();
+    }
+  }
+
+  uint32_t nextDue() const { return replies.front().due; }
+};
+
+static std::vector<SimECU*> ecus;
+
+static void createECUs(int count) {
+  for (SimECU* e : ecus) delete e;
+  ecus.clear();
+  bus.clear();
+  simMicros = 0;
+  // Engine, ABS, dash, body: 6-15 ms processing time
+  const uint32_t latency[] = {6000, 9000, 12000, 15000, 8000, 10000, 11000, 7000};
+  for (int i = 0; i < count; i++) {
+    std::vector<uint8_t> pids;
+    for (int p = 0; p < 6; p++) pids.push_back(static_cast<uint8_t>(0x04 + i * 6 + p));
+    ecus.push_back(new SimECU(i, latency[i], pids));
+  }
+}
+
+// Deliver one bus frame, or service ECUs and advance idle time
+typedef std::function<void(const CANMessage&)> TesterRx;
+
+static void step(const TesterRx& testerRx, const std::function<void()>& testerPoll) {
+  if (!bus.empty()) {
+    BusFrame f = bus.front();
+    bus.pop_front();
+    simMicros += FRAME_US;
+    if (f.sender >= 0) testerRx(f.message);
+    for (SimECU* e : ecus) {
+      if (e->index != f.sender) e->transport.onFrame(f.message);
+    }
+    return;
+  }
+  testerPoll();
+  for (SimECU* e : ecus) e->service();
+  if (bus.empty()) {
+    uint32_t next = simMicros + 100;
+    for (SimECU* e : ecus) {
+      if (!e->replies.empty() && static_cast<int32_t>(e->nextDue() - next) < 0) next = e->nextDue();
+    }
+    simMicros = std::max(simMicros + 1, next);
+  }
+}
+
+struct Tester {
+  ISOTPTransport transport;
+  OBD2RequestScheduler scheduler;
+
+  Tester()
+      : transport([](const CANMessage& m) {
+                    bus.push_back({m, -1});
+                    return true;
+                  },
+                  [] { return simMicros; }),
+        scheduler(transport, [] { return simMicros; }) {}
+
+  void run(uint32_t limitUs = 10000000) {
+    uint32_t end = simMicros + limitUs;
+    auto rx = [this](const CANMessage& m) { scheduler.onFrame(m); };
+    auto poll = [this] { scheduler.poll(); };
+    while (static_cast<int32_t>(end - simMicros) > 0) {
+      step(rx, poll);
+      if (scheduler.idle() && bus.empty()) return;
+    }
+  }
+};
+
+// ===== TESTS =====
+
+static void testCorrelation() {
+  createECUs(4);
+  Tester* t = new Tester();
+
+  std::vector<OBD2Response> got;
+  std::vector<std::vector<uint8_t>> payloads;
+  auto collect = [&](const OBD2Response& r) {
+    got.push_back(r);
+    payloads.push_back(std::vector<uint8_t>(r.data, r.data + r.length));
+  };
+
+  // ECU 0 supports 0x04-0x09, ECU 1 0x0A-0x0F, ...
+  t->scheduler.submit(0, 0x01, 0x05, collect);
+  t->scheduler.submit(0, 0x01, 0x06, collect);
+  t->scheduler.submit(1, 0x01, 0x0C, collect);
+  t->scheduler.submit(3, 0x01, 0x17, collect);
+  t->run();
+
+  CHECK(got.size() == 4, "four responses");
+  CHECK(t->scheduler.getStatistics().maxInFlight == 3, "one request in flight per ECU");
+  bool correlated = true;
+  for (size_t i = 0; i < got.size(); i++) {
+    const OBD2Response& r = got[i];
+    if (r.status != OBD2RequestStatus::OK || payloads[i][1] != r.pid ||
+        payloads[i][2] != static_cast<uint8_t>(r.ecu * 16 + r.pid)) {
+      correlated = false;
+    }
+  }
+  CHECK(correlated, "responses matched to their ECU and PID");
+
+  // Same-ECU requests keep submission order
+  int pos05 = -1, pos06 = -1;
+  for (size_t i = 0; i < got.size(); i++) {
+    if (got[i].pid == 0x05) pos05 = i;
+    if (got[i].pid == 0x06) pos06 = i;
+  }
+  CHECK(pos05 >= 0 && pos06 > pos05, "per-ECU order preserved");
+  CHECK(got[0].ecu == 0 && got[0].latencyUs >= 6000 && got[0].latencyUs < 8000,
+        "fastest ECU answers first");
+  printf("  %-32s OK (max in flight %u)\n", "correlation / ordering",
+         t->scheduler.getStatistics().maxInFlight);
+  delete t;
+}
+
+static void testDeadlinesAndNegative() {
+  createECUs(2);
+  Tester* t = new Tester();
+
+  OBD2Response timeout = {}, negative = {}, pending = {}, vin = {};
+  std::vector<uint8_t> vinData;
+  t->scheduler.submit(5, 0x01, 0x0C, [&](const OBD2Response& r) { timeout = r; });
+  t->scheduler.submit(0, 0x01, 0x30, [&](const OBD2Response& r) { negative = r; });
+  uint8_t did[] = {0x22, 0xF1, 0x90};
+  t->scheduler.submitRaw(1, did, 3, [&](const OBD2Response& r) { pending = r; });
+  t->scheduler.submit(0, 0x09, 0x02, [&](const OBD2Response& r) {
+    vin = r;
+    vinData.assign(r.data, r.data + r.length);
+  });
+  t->run();
+
+  CHECK(timeout.status == OBD2RequestStatus::TIMEOUT, "absent ECU times out");
+  CHECK(timeout.latencyUs >= OBD2_RESPONSE_TIMEOUT_MS * 1000 &&
+        timeout.latencyUs <= (OBD2_RESPONSE_TIMEOUT_MS + OBD2_WHEEL_TICK_MS) * 1000 + 1000,
+        "timeout fires within one wheel tick of the deadline");
+  CHECK(negative.status == OBD2RequestStatus::NEGATIVE && negative.nrc == 0x12, "negative response");
+  CHECK(pending.status == OBD2RequestStatus::OK && pending.latencyUs > 300000,
+        "NRC 0x78 extends the deadline past P2");
+  CHECK(t->scheduler.getStatistics().pendingExtensions == 1, "pending extension counted");
+  CHECK(vin.status == OBD2RequestStatus::OK && vinData.size() == 20 && vinData[3] == 'V',
+        "multi-frame VIN response");
+
+  // Cancel while pending: never reaches the bus
+  OBD2RequestStatus cancelled = OBD2RequestStatus::OK;
+  uint32_t sentBefore = t->scheduler.getStatistics().sent;
+  t->scheduler.submit(0, 0x01, 0x04, [](const OBD2Response&) {});
+  int id = t->scheduler.submit(0, 0x01, 0x05, [&](const OBD2Response& r) { cancelled = r.status; });
+  CHECK(t->scheduler.cancel(id), "cancel pending request");
+  CHECK(!t->scheduler.cancel(id), "stale request ID rejected");
+  t->run();
+  CHECK(cancelled == OBD2RequestStatus::CANCELLED, "cancel callback");
+  CHECK(t->scheduler.getStatistics().sent == sentBefore + 1, "cancelled request not sent");
+  printf("  %-32s OK\n", "timeout / NRC / pending / cancel");
+  delete t;
+}
+
+static void testFunctional() {
+  createECUs(4);
+  Tester* t = new Tester();
+
+  // Discovery: with no ECU known yet the request waits for the whole window
+  int answers = 0;
+  std::vector<uint8_t> multi = {0x01, 0x04, 0x0A, 0x10, 0x16}; // One PID per ECU
+  uint32_t start = simMicros;
+  t->scheduler.submitRaw(OBD2RequestScheduler::FUNCTIONAL, multi.data(), multi.size(),
+                         [&](const OBD2Response& r) { answers += r.status == OBD2RequestStatus::OK; });
+  t->run();
+  uint32_t discovery = simMicros - start;
+  CHECK(answers == 4, "functional request collects every ECU");
+  CHECK(t->scheduler.getKnownEcus() == 0x0F, "four ECUs discovered");
+  CHECK(discovery >= OBD2_RESPONSE_TIMEOUT_MS * 1000, "discovery waits for the response window");
+
+  // Known ECUs: completes as soon as all of them answered
+  answers = 0;
+  start = simMicros;
+  t->scheduler.submitRaw(OBD2RequestScheduler::FUNCTIONAL, multi.data(), multi.size(),
+                         [&](const OBD2Response& r) { answers += r.status == OBD2RequestStatus::OK; });
+  t->run();
+  uint32_t early = simMicros - start;
+  CHECK(answers == 4 && early < OBD2_RESPONSE_TIMEOUT_MS * 1000 / 4,
+        "functional request completes once all known ECUs answered");
+  printf("  %-32s OK (discovery %.1f ms, known ECUs %.1f ms)\n", "functional requests",
+         discovery / 1000.0, early / 1000.0);
+  delete t;
+}
+
+static void testBatchPacking() {
+  uint8_t requests[8][7];
+  uint8_t lengths[8];
+
+  uint8_t dashboard[] = {0x0C, 0x0D, 0x05, 0x11, 0x04, 0x0F};
+  size_t n = OBD2Batch::pack(dashboard, 6, requests, lengths, 8);
+  CHECK(n == 1 && lengths[0] == 7 && requests[0][0] == 0x01 &&
+        memcmp(&requests[0][1], dashboard, 6) == 0, "six PIDs fit one request");
+
+  uint8_t mixed[] = {0x0C, 0x00, 0x0D, 0x0C, 0x20, 0x05, 0x11, 0x04, 0x0F, 0x2F};
+  n = OBD2Batch::pack(mixed, sizeof(mixed), requests, lengths, 8);
+  CHECK(n == 3, "support PIDs packed apart from data PIDs");
+  CHECK(lengths[0] == 7 && lengths[1] == 3 && requests[1][1] == 0x00 && requests[1][2] == 0x20,
+        "support PIDs combined with each other");
+  CHECK(lengths[2] == 2 && requests[2][1] == 0x2F, "seventh data PID starts a new request");
+  CHECK(OBD2Batch::pack(mixed, sizeof(mixed), requests, lengths, 2) == 2, "pack respects capacity");
+
+  // 41 0C <2 bytes> 0D <1 byte> 05 <1 byte>, then an undefined PID 0x00 0x00
+  uint8_t response[] = {0x41, 0x0C, 0x1A, 0xF8, 0x0D, 0x3C, 0x05, 0x7B, 0x00, 0x00};
+  OBD2Batch::PIDValue values[6];
+  n = OBD2Batch::split(response, 8, values, 6);
+  CHECK(n == 3 && values[0].pid == 0x0C && values[0].length == 2 && values[0].data[1] == 0xF8 &&
+        values[1].pid == 0x0D && values[1].data[0] == 0x3C && values[2].pid == 0x05,
+        "split by J1979 data lengths");
+  CHECK(OBD2Batch::split(response, 3, values, 6) == 0, "truncated PID dropped");
+  CHECK(OBD2Batch::split(response, 10, values, 6) == 3, "unknown PID stops parsing");
+  response[0] = 0x42;
+  CHECK(OBD2Batch::split(response, 8, values, 6) == 0, "non-Mode 01 response rejected");
+  printf("  %-32s OK\n", "multi-PID pack / split");
+}
+
+static const uint8_t DASHBOARD[] = {0x0C, 0x0D, 0x05, 0x11, 0x04, 0x0F}; // RPM, speed, ECT, TPS, load, IAT
+
+static void testBatchRequests() {
+  createECUs(2);
+  ecus[0]->pids.assign(DASHBOARD, DASHBOARD + 6);
+  Tester* t = new Tester();
+
+  std::vector<OBD2PIDResult> got;
+  std::vector<std::vector<uint8_t>> values;
+  auto collect = [&](const OBD2PIDResult& r) {
+    got.push_back(r);
+    values.push_back(std::vector<uint8_t>(r.data, r.data + r.length));
+  };
+
+  uint32_t framesBefore = t->transport.getStatistics().framesSent;
+  CHECK(t->scheduler.submitBatch(0, DASHBOARD, 6, collect) == 1, "dashboard set is one request");
+  t->run();
+  CHECK(t->transport.getStatistics().framesSent - framesBefore == 2,
+        "one request frame plus flow control for the reply");
+  CHECK(got.size() == 6, "one result per PID");
+  bool ok = got.size() == 6;
+  for (size_t i = 0; ok && i < got.size(); i++) {
+    ok = got[i].status == OBD2RequestStatus::OK && got[i].pid == DASHBOARD[i] &&
+         got[i].length == OBD2Batch::mode01DataLength(DASHBOARD[i]) &&
+         values[i][0] == static_cast<uint8_t>(DASHBOARD[i]);
+  }
+  CHECK(ok, "per-PID values split from the combined response");
+
+  // Physical request: PIDs the ECU left out are reported, not dropped
+  got.clear();
+  values.clear();
+  uint8_t partial[] = {0x0C, 0x0A, 0x0D};
+  t->scheduler.submitBatch(0, partial, 3, collect);
+  t->run();
+  CHECK(got.size() == 3 && got[1].pid == 0x0A && got[1].status == OBD2RequestStatus::NOT_SUPPORTED &&
+        got[0].status == OBD2RequestStatus::OK && got[2].status == OBD2RequestStatus::OK,
+        "missing PID reported as NOT_SUPPORTED");
+
+  // Nothing supported: the NRC reaches every PID
+  got.clear();
+  values.clear();
+  uint8_t none[] = {0x42, 0x43};
+  t->scheduler.submitBatch(0, none, 2, collect);
+  t->run();
+  CHECK(got.size() == 2 && got[0].status == OBD2RequestStatus::NEGATIVE && got[1].nrc == 0x12,
+        "negative response fans out to every PID");
+
+  // Functional: each ECU reports only what it answered. ECU 1 answers once
+  // first so the functional request waits for both ECUs.
+  t->scheduler.submit(1, 0x01, 0x0A, [](const OBD2Response&) {});
+  t->run();
+  got.clear();
+  values.clear();
+  uint8_t spread[] = {0x05, 0x0A, 0x0B};  // ECU 0 has 0x05, ECU 1 has 0x0A/0x0B
+  t->scheduler.submitBatch(OBD2RequestScheduler::FUNCTIONAL, spread, 3, collect);
+  t->run();
+  int fromEcu0 = 0, fromEcu1 = 0;
+  for (const OBD2PIDResult& r : got) {
+    fromEcu0 += r.ecu == 0 && r.pid == 0x05 && r.status == OBD2RequestStatus::OK;
+    fromEcu1 += r.ecu == 1 && (r.pid == 0x0A || r.pid == 0x0B) && r.status == OBD2RequestStatus::OK;
+  }
+  CHECK(got.size() == 3 && fromEcu0 == 1 && fromEcu1 == 2, "functional batch results per ECU");
+
+  // Functional: a PID no ECU answers is still reported when the request closes
+  got.clear();
+  values.clear();
+  uint8_t unowned[] = {0x05, 0x42};
+  t->scheduler.submitBatch(OBD2RequestScheduler::FUNCTIONAL, unowned, 2, collect);
+  t->run();
+  CHECK(got.size() == 2 && got[0].pid == 0x05 && got[0].status == OBD2RequestStatus::OK &&
+        got[1].pid == 0x42 && got[1].status == OBD2RequestStatus::NOT_SUPPORTED &&
+        got[1].ecu == OBD2RequestScheduler::FUNCTIONAL, "unanswered functional PID reported");
+
+  got.clear();
+  values.clear();
+  t->scheduler.submitBatch(OBD2RequestScheduler::FUNCTIONAL, none, 2, collect);
+  t->run();
+  CHECK(got.size() == 2 && got[0].status == OBD2RequestStatus::TIMEOUT &&
+        got[1].status == OBD2RequestStatus::TIMEOUT, "silent functional batch times out per PID");
+
+  // The PIDs and callback live in the request slot
+  got.clear();
+  values.clear();
+  size_t allocationsBefore = allocations;
+  CHECK(t->scheduler.submitBatch(0, DASHBOARD, 6, collect) == 1, "dashboard set queued");
+  CHECK(allocations == allocationsBefore, "submitBatch allocates nothing");
+  t->run();
+  CHECK(got.size() == 6, "all six results delivered");
+
+  // A batch that does not fit is refused whole: nothing queued, no callback
+  got.clear();
+  values.clear();
+  uint8_t many[OBD2_REQUEST_SLOTS * OBD2Batch::MAX_PIDS_PER_REQUEST + 1];
+  for (size_t i = 0; i < sizeof(many); i++) {
+    many[i] = static_cast<uint8_t>(i + 1);
+  }
+  uint32_t rejectedBefore = t->scheduler.getStatistics().rejected;
+  CHECK(t->scheduler.submitBatch(0, many, sizeof(many), collect) == 0, "oversized batch refused");
+  for (int i = 0; i < OBD2_REQUEST_SLOTS - 1; i++) {
+    t->scheduler.submit(0, 0x01, 0x0C, [](const OBD2Response&) {});
+  }
+  CHECK(t->scheduler.submitBatch(0, many, 7, collect) == 0, "batch refused with one slot free");
+  CHECK(t->scheduler.pending() + t->scheduler.inFlight() == OBD2_REQUEST_SLOTS - 1,
+        "refused batches take no slot");
+  CHECK(t->scheduler.getStatistics().rejected - rejectedBefore == 2, "refusals counted");
+  t->run();
+  CHECK(got.empty(), "no results for a refused batch");
+  printf("  %-32s OK\n", "multi-PID requests");
+  delete t;
+}
+
+// ===== PIDs/s BEFORE AND AFTER =====
+
+// Previous behaviour: sendOBD2Request() on 0x7DF, then waitOBD2Response()
+// returns the first 0x7E8-0x7EF frame; one query on the bus at a time.
+static void runBlockingLoop(const std::vector<uint8_t>& pids, int rounds, uint32_t& elapsed,
+                            uint32_t& answered, uint32_t& misattributed) {
+  uint32_t start = simMicros;
+  answered = misattributed = 0;
+  for (int r = 0; r < rounds; r++) {
+    for (uint8_t pid : pids) {
+      CANMessage request;
+      request.id = OBD2CAN::FUNCTIONAL_REQUEST_ID;
+      request.dlc = 8;
+      uint8_t data[8] = {0x02, 0x01, pid, 0x55, 0x55, 0x55, 0x55, 0x55};
+      memcpy(request.data, data, 8);
+      bus.push_back({request, -1});
+
+      bool got = false;
+      uint32_t deadline = simMicros + OBD2_RESPONSE_TIMEOUT_MS * 1000;
+      auto rx = [&](const CANMessage& m) {
+        if (got || m.id < 0x7E8 || m.id > 0x7EF) return;
+        got = true;
+        answered++;
+        if (m.data[2] != pid) misattributed++; // Late answer to an earlier query
+      };
+      while (!got && static_cast<int32_t>(deadline - simMicros) > 0) step(rx, [] {});
+    }
+  }
+  // Let stragglers drain so the next measurement starts clean
+  uint32_t drainEnd = simMicros + 50000;
+  while (static_cast<int32_t>(drainEnd - simMicros) > 0) step([](const CANMessage&) {}, [] {});
+  elapsed = simMicros - start - 50000;
+}
+
+static void benchmark() {
+  const int ECU_COUNT = 4;
+  const int ROUNDS = 50;
+
+  printf("\nPIDs/s on simulated bus (%d ECUs, 6 PIDs each, 6-15 ms ECU latency, %d rounds):\n",
+         ECU_COUNT, ROUNDS);
+  printf("  %-36s %10s %10s %12s\n", "strategy", "PIDs/s", "answered", "mismatched");
+
+  createECUs(ECU_COUNT);
+  std::vector<uint8_t> dashboard;
+  for (SimECU* e : ecus) dashboard.insert(dashboard.end(), e->pids.begin(), e->pids.end());
+
+  uint32_t elapsed, answered, mismatched;
+  runBlockingLoop(dashboard, ROUNDS, elapsed, answered, mismatched);
+  double before = answered * 1e6 / elapsed;
+  printf("  %-36s %10.1f %10u %12u\n", "blocking loop (before)", before, answered, mismatched);
+
+  for (int limit : {1, OBD2_MAX_IN_FLIGHT}) {
+    createECUs(ECU_COUNT);
+    Tester* t = new Tester();
+    t->scheduler.setMaxInFlight(limit);
+    uint32_t ok = 0, wrong = 0;
+    uint32_t start = simMicros;
+    for (int r = 0; r < ROUNDS; r++) {
+      for (SimECU* e : ecus) {
+        for (uint8_t pid : e->pids) {
+          uint8_t ecu = e->index;
+          t->scheduler.submit(ecu, 0x01, pid, [&, ecu, pid](const OBD2Response& resp) {
+            bool match = resp.status == OBD2RequestStatus::OK && resp.ecu == ecu && resp.data[1] == pid;
+            ok += match;
+            wrong += !match;
+          });
+        }
+      }
+      t->run(); // Dashboard refresh: queue the whole set, wait for it
+    }
+    double rate = ok * 1e6 / (simMicros - start);
+    char name[64];
+    snprintf(name, sizeof(name), "scheduler, max %d in flight", limit);
+    printf("  %-36s %10.1f %10u %12u\n", name, rate, ok, wrong);
+    CHECK(ok == static_cast<uint32_t>(ROUNDS * ECU_COUNT * 6), "scheduler answered every PID");
+    CHECK(wrong == 0, "scheduler never mismatches responses");
+    if (limit == OBD2_MAX_IN_FLIGHT) {
+      CHECK(rate > before * 2, "pipelining at least doubles PIDs/s");
+      printf("  speedup vs blocking loop: %.1fx\n", rate / before);
+    }
+    delete t;
+  }
+
+  // Dashboard refresh on one ECU: six single-PID requests vs one packed request
+  printf("\nDashboard refresh (6 PIDs on the engine ECU, %d rounds):\n", ROUNDS);
+  printf("  %-36s %10s %10s %12s\n", "strategy", "ms/refresh", "frames", "round trips");
+  double single = 0;
+  for (int batched = 0; batched < 2; batched++) {
+    createECUs(1);
+    ecus[0]->pids.assign(DASHBOARD, DASHBOARD + 6);
+    Tester* t = new Tester();
+    uint32_t ok = 0;
+    uint32_t start = simMicros;
+    for (int r = 0; r < ROUNDS; r++) {
+      if (batched) {
+        t->scheduler.submitBatch(0, DASHBOARD, 6, [&](const OBD2PIDResult& res) {
+          ok += res.status == OBD2RequestStatus::OK;
+        });
+      } else {
+        for (uint8_t pid : DASHBOARD) {
+          t->scheduler.submit(0, 0x01, pid, [&](const OBD2Response& res) {
+            ok += res.status == OBD2RequestStatus::OK;
+          });
+        }
+      }
+      t->run();
+    }
+    uint32_t frames = t->transport.getStatistics().framesSent + ecus[0]->transport.getStatistics().framesSent;
+    double perRefresh = (simMicros - start) / 1000.0 / ROUNDS;
+    uint32_t trips = t->scheduler.getStatistics().sent / ROUNDS;
+    printf("  %-36s %10.2f %10.1f %12u\n", batched ? "one multi-PID request" : "six single-PID requests",
+           perRefresh, frames / static_cast<double>(ROUNDS), trips);
+    CHECK(ok == static_cast<uint32_t>(ROUNDS * 6), "every dashboard PID answered");
+    if (batched) {
+      CHECK(trips == 1, "batched refresh takes one round trip");
+      CHECK(perRefresh * 3 < single, "batched refresh at least 3x faster");
+      printf("  speedup: %.1fx\n", single / perRefresh);
+    } else {
+      single = perRefresh;
+    }
+    delete t;
+  }
+}
+
+int main() {
+  printf("Testing OBD2 request scheduler\n");
+  printf("==============================\n");
+
+  testCorrelation();
+  testDeadlinesAndNegative();
+  testFunctional();
+  testBatchPacking();
+  testBatchRequests();
+  benchmark();
+
+  for (SimECU* e : ecus) delete e;
+  if (failures) {
+    printf("\n%d check(s) FAILED\n", failures);
+    return 1;
+  }
+  printf("\nOBD2 request scheduler tests passed\n");
+  return 0;
+}
@@ -0,0 +1,349 @@
+#!/usr/bin/env python3
+"""
+DBC to C++ Code Generator
+
+Reads the message (BO_) and signal (SG_) definitions of a DBC file and
+writes a header of constexpr signal descriptors for CANSignal::extract/
+insert (src/modules/can/can_signal.h), a Values struct and decode() per
+message, and a dispatch() switch that routes a CANFrame to the decoder of
+its identifier. Values members are the smallest integer type that holds the
+physical range when factor and offset are integers, float otherwise.
+Multiplexed signals and signals longer than 32 bits are skipped with a
+warning; names that clash with the generated members are rejected.
+
+Author: Chigee OBD2 Project
+Date: 2025-09-14
+"""
+
+import os
+import re
+import sys
+import argparse
+from dataclasses import dataclass, field
+from typing import List, Optional
+
+EXTENDED_ID_FLAG = 0x80000000
+
+BO_PATTERN = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+SG_PATTERN = re.compile(
+    r'^SG_\s+(\w+)\s*(M|m\d+)?\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+    r'\(\s*([^,]+)\s*,\s*([^)]+)\)\s*\[\s*([^|]*)\|([^\]]*)\]\s*"([^"]*)"'
+)
+CPP_IDENTIFIER = re.compile(r'^[A-Za-z_]\w*$')
+
+# Names the generated code already uses inside a message struct and at
+# namespace scope; a signal or message with one of them would not compile
+RESERVED_SIGNAL_NAMES = {'ID', 'EXTENDED', 'DLC', 'KEY', 'Values', 'decode', 'encode'}
+RESERVED_MESSAGE_NAMES = {'dispatch', 'dispatchTo', 'CANFrame', 'CANSignal'}
+
+# Smallest first; unsigned before signed of the same width
+INTEGER_TYPES = [
+    ('uint8_t', 0, 2**8 - 1), ('int8_t', -2**7, 2**7 - 1),
+    ('uint16_t', 0, 2**16 - 1), ('int16_t', -2**15, 2**15 - 1),
+    ('uint32_t', 0, 2**32 - 1), ('int32_t', -2**31, 2**31 - 1),
+    ('int64_t', -2**63, 2**63 - 1),
+]
+# Integers a float factor/offset holds exactly
+FLOAT_EXACT_LIMIT = 2**24
+
+
+@dataclass
+class Signal:
+    """One SG_ line"""
+    name: str
+    start_bit: int
+    length: int
+    motorola: bool
+    signed: bool
+    factor: float
+    offset: float
+    minimum: float
+    maximum: float
+    unit: str
+    multiplex: Optional[str] = None
+
+
+@dataclass
+class Message:
+    """One BO_ block"""
+    frame_id: int
+    extended: bool
+    name: str
+    dlc: int
+    sender: str
+    signals: List[Signal] = field(default_factory=list)
+
+
+class DBCParser:
+    """Minimal DBC reader: messages and their signals, nothing else"""
+
+    def __init__(self):
+        self.messages: List[Message] = []
+        self.warnings: List[str] = []
+
+    def parse(self, path: str) -> List[Message]:
+        current = None
+        with open(path, encoding='utf-8', errors='replace') as dbc:
+            for number, line in enumerate(dbc, 1):
+                text = line.strip()
+                if text.startswith('BO_ '):
+                    current = self._parse_message(text, number)
+                elif text.startswith('SG_ ') and current is not None:
+                    self._parse_signal(text, number, current)
+                elif not text:
+                    current = None
+        return self.messages
+
+    def _parse_message(self, text: str, number: int) -> Optional[Message]:
+        match = BO_PATTERN.match(text)
+        if not match:
+            self.warnings.append(f"line {number}: unreadable BO_ definition")
+            return None
+        raw_id = int(match.group(1))
+        message = Message(
+            frame_id=raw_id & ~EXTENDED_ID_FLAG,
+            extended=bool(raw_id & EXTENDED_ID_FLAG),
+            name=match.group(2),
+            dlc=int(match.group(3)),
+            sender=match.group(4),
+        )
+        self.messages.append(message)
+        return message
+
+    def _parse_signal(self, text: str, number: int, message: Message):
+        match = SG_PATTERN.match(text)
+        if not match:
+            self.warnings.append(f"line {number}: unreadable SG_ definition")
+            return
+        signal = Signal(
+            name=match.group(1),
+            multiplex=match.group(2),
+            start_bit=int(match.group(3)),
+            length=int(match.group(4)),
+            motorola=match.group(5) == '0',
+            signed=match.group(6) == '-',
+            factor=float(match.group(7)),
+            offset=float(match.group(8)),
+            minimum=float(match.group(9) or 0),
+            maximum=float(match.group(10) or 0),
+            unit=match.group(11),
+        )
+        if signal.multiplex is not None and signal.multiplex != 'M':
+            self.warnings.append(f"{message.name}.{signal.name}: multiplexed signal skipped")
+        elif signal.length < 1 or signal.length > 32:
+            self.warnings.append(f"{message.name}.{signal.name}: {signal.length}-bit signal skipped")
+        elif signal.factor == 0:
+            self.warnings.append(f"{message.name}.{signal.name}: zero factor, skipped")
+        elif last_bit(signal) > 63:
+            self.warnings.append(f"{message.name}.{signal.name}: runs past byte 7, skipped")
+        else:
+            message.signals.append(signal)
+
+
+def last_bit(signal: Signal) -> int:
+    """Last bit in payload order, same arithmetic as CANSignal::Layout"""
+    if signal.motorola:
+        msb = (signal.start_bit // 8) * 8 + (7 - signal.start_bit % 8)
+        return msb + signal.length - 1
+    return signal.start_bit + signal.length - 1
+
+
+def integer_type(signal: Signal) -> Optional[str]:
+    """C++ type for an integer-scaled signal's physical range, None to keep float"""
+    if not all(v.is_integer() and abs(v) <= FLOAT_EXACT_LIMIT for v in (signal.factor, signal.offset)):
+        return None
+    if signal.signed:
+        raw_range = (-(1 << (signal.length - 1)), (1 << (signal.length - 1)) - 1)
+    else:
+        raw_range = (0, (1 << signal.length) - 1)
+    ends = [raw * int(signal.factor) + int(signal.offset) for raw in raw_range]
+    for name, lowest, highest in INTEGER_TYPES:
+        if lowest <= min(ends) and max(ends) <= highest:
+            return name
+    return None
+
+
+def name_clashes(messages: List[Message]) -> List[str]:
+    """Signal and message names that collide with the generated members"""
+    clashes = []
+    for message in messages:
+        if message.name in RESERVED_MESSAGE_NAMES:
+            clashes.append(message.name)
+        seen = set()
+        for signal in message.signals:
+            if signal.name in RESERVED_SIGNAL_NAMES or signal.name == message.name or signal.name in seen:
+                clashes.append(f"{message.name}.{signal.name}")
+            seen.add(signal.name)
+    return clashes
+
+
+def cpp_float(value: float) -> str:
+    text = repr(float(value))
+    if 'e' not in text and '.' not in text:
+        text += '.0'
+    return text + 'f'
+
+
+class HeaderWriter:
+    """Emits the generated header"""
+
+    def __init__(self, messages: List[Message], namespace: str, source: str, output_name: str,
+                 include: str):
+        self.messages = [m for m in messages if m.signals]
+        self.output_name = output_name
+        self.namespace = namespace
+        self.source = source
+        self.include = include
+
+    def render(self) -> str:
+        out = []
+        out.append('#pragma once')
+        out.append('')
+        out.append('/**')
+        out.append(f' * @file {self.output_name}')
+        out.append(f' * @brief Signal decoders generated from {self.source}')
+        out.append(' *')
+        out.append(' * Generated by tools/dbc_codegen.py. Do not edit; regenerate instead.')
+        out.append(' */')
+        out.append('')
+        out.append('#include <stdint.h>')
+        out.append(f'#include "{self.include}/can_frame.h"')
+        out.append(f'#include "{self.include}/can_signal.h"')
+        out.append('')
+        out.append(f'namespace {self.namespace} {{')
+        for message in self.messages:
+            out.append('')
+            out.extend(self._message(message))
+        out.append('')
+        out.extend(self._dispatch())
+        out.append('')
+        out.append(f'}} // namespace {self.namespace}')
+        out.append('')
+        return '\n'.join(out)
+
+    def _message(self, message: Message) -> List[str]:
+        id_text = f'0x{message.frame_id:08X}' if message.extended else f'0x{message.frame_id:03X}'
+        out = [f'// ===== {message.name} ({id_text}, {message.dlc} bytes, from {message.sender}) =====',
+               '',
+               f'struct {message.name} {{',
+               f'    static constexpr uint32_t ID = {id_text};',
+               f'    static constexpr bool EXTENDED = {"true" if message.extended else "false"};',
+               f'    static constexpr uint8_t DLC = {message.dlc};',
+               '    static constexpr uint32_t KEY = ID | (EXTENDED ? CANFrame::FLAG_EXTENDED : 0);']
+        for signal in message.signals:
+            order = 'Motorola' if signal.motorola else 'Intel'
+            unit = f' [{signal.unit}]' if signal.unit else ''
+            out.append('')
+            out.append(f'    // {signal.start_bit}|{signal.length} '
+                       f'{order} {"signed" if signal.signed else "unsigned"}, '
+                       f'range {signal.minimum:.10g} to {signal.maximum:.10g}{unit}')
+            out.append(f'    struct {signal.name} {{')
+            out.append(f'        static constexpr uint8_t startBit = {signal.start_bit};')
+            out.append(f'        static constexpr uint8_t length = {signal.length};')
+            out.append(f'        static constexpr bool motorola = {"true" if signal.motorola else "false"};')
+            out.append(f'        static constexpr bool isSigned = {"true" if signal.signed else "false"};')
+            out.append(f'        static constexpr float factor = {cpp_float(signal.factor)};')
+            out.append(f'        static constexpr float offset = {cpp_float(signal.offset)};')
+            out.append('    };')
+        out.append('')
+        out.append('    struct Values {')
+        for signal in message.signals:
+            out.append(f'        {integer_type(signal) or "float"} {signal.name};')
+        out.append('    };')
+        out.append('')
+        out.append('    static void decode(const uint8_t* data, Values& values) {')
+        for signal in message.signals:
+            value_type = integer_type(signal)
+            if value_type:
+                out.append(f'        values.{signal.name} = CANSignal::decodeInteger<{signal.name}, {value_type}>(data);')
+            else:
+                out.append(f'        values.{signal.name} = CANSignal::decode<{signal.name}>(data);')
+        out.append('    }')
+        out.append('')
+        out.append('    static void encode(uint8_t* data, const Values& values) {')
+        for signal in message.signals:
+            encoder = 'encodeInteger' if integer_type(signal) else 'encode'
+            out.append(f'        CANSignal::{encoder}<{signal.name}>(data, values.{signal.name});')
+        out.append('    }')
+        out.append('};')
+        return out
+
+    def _dispatch(self) -> List[str]:
+        out = ['// ===== DISPATCH =====',
+               '',
+               '/**',
+               ' * @brief Decode a known frame and pass its Values to handler(values)',
+               ' * @return false for unknown IDs, remote/error frames and short frames',
+               ' */',
+               'template <typename Handler>',
+               'inline bool dispatch(const CANFrame& frame, Handler& handler) {',
+               '    if (frame.isRemote() || frame.isError()) {',
+               '        return false;',
+               '    }',
+               '    switch (frame.idFlags & (CANFrame::ID_MASK | CANFrame::FLAG_EXTENDED)) {']
+        for message in self.messages:
+            out.extend([f'    case {message.name}::KEY: {{',
+                        f'        if (frame.dlc < {message.name}::DLC) {{',
+                        '            return false;',
+                        '        }',
+                        f'        {message.name}::Values values;',
+                        f'        {message.name}::decode(frame.data, values);',
+                        '        handler(values);',
+                        '        return true;',
+                        '    }'])
+        out.extend(['    default:',
+                    '        return false;',
+                    '    }',
+                    '}',
+                    '',
+                    '/**',
+                    ' * @brief Adapter for CANInterface::setFrameHandler(&dispatchTo<H>, &handler)',
+                    ' */',
+                    'template <typename Handler>',
+                    'bool dispatchTo(const CANFrame& frame, void* context) {',
+                    '    return dispatch(frame, *static_cast<Handler*>(context));',
+                    '}'])
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate constexpr CAN signal decoders from a DBC file')
+    parser.add_argument('dbc', help='Input DBC file')
+    parser.add_argument('-o', '--output', required=True, help='Output header')
+    parser.add_argument('--namespace', help='C++ namespace (default: DBC file name)')
+    parser.add_argument('--include', default='modules/can',
+                        help='Include path prefix of can_frame.h/can_signal.h as seen from the output')
+    args = parser.parse_args()
+
+    dbc = DBCParser()
+    messages = dbc.parse(args.dbc)
+    for warning in dbc.warnings:
+        print(f"warning: {warning}", file=sys.stderr)
+
+    namespace = args.namespace or re.sub(r'\W', '_', os.path.splitext(os.path.basename(args.dbc))[0])
+    names = [namespace] + [m.name for m in messages] + [s.name for m in messages for s in m.signals]
+    bad = [name for name in names if not CPP_IDENTIFIER.match(name)]
+    if bad:
+        print(f"error: not usable as C++ identifiers: {', '.join(bad)}", file=sys.stderr)
+        return 1
+    clashes = name_clashes(messages)
+    if clashes:
+        print(f"error: names clash with generated members or each other: {', '.join(clashes)}", file=sys.stderr)
+        return 1
+    keys = [(m.frame_id, m.extended) for m in messages if m.signals]
+    if len(keys) != len(set(keys)):
+        print("error: duplicate message identifiers", file=sys.stderr)
+        return 1
+
+    writer = HeaderWriter(messages, namespace, os.path.basename(args.dbc), os.path.basename(args.output),
+                          args.include.rstrip('/'))
+    with open(args.output, 'w', encoding='utf-8') as header:
+        header.write(writer.render())
+
+    signal_count = sum(len(m.signals) for m in writer.messages)
+    print(f"{args.output}: {len(writer.messages)} messages, {signal_count} signals")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())